@@ -0,0 +1,167 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifdef _WIN32
+#include "windirent.h"
+#else
+#include <dirent.h>
+#endif /* _WIN32 */
+#include "common.h"
+#include "batch.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+namespace grk {
+
+struct BatchResult {
+	BatchResult() : done(false), rc(0), ms(0) {
+	}
+	bool done;
+	int rc;
+	double ms;
+};
+
+BatchScheduler::BatchScheduler(uint32_t budget, uint64_t bytes_per_thread) :
+		m_budget(budget ? budget : std::thread::hardware_concurrency()),
+		m_bytes_per_thread(bytes_per_thread ? bytes_per_thread : 1) {
+	if (!m_budget)
+		m_budget = 1;
+}
+
+bool BatchScheduler::list_files(const std::string &dir,
+		std::vector<std::string> *files) {
+	auto d = opendir(dir.c_str());
+	if (!d) {
+		spdlog::error("Could not open Folder {}", dir);
+		return false;
+	}
+	struct dirent *content = nullptr;
+	while ((content = readdir(d)) != nullptr) {
+		if (strcmp(".", content->d_name) == 0
+				|| strcmp("..", content->d_name) == 0)
+			continue;
+		files->push_back(content->d_name);
+	}
+	closedir(d);
+
+	return true;
+}
+
+size_t BatchScheduler::run(const std::string &dir,
+		const std::vector<std::string> &files,
+		const std::function<int(const std::string&, uint32_t)> &job) {
+	size_t num_files = files.size();
+	std::vector<BatchResult> results(num_files);
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::atomic<size_t> next_claim(0);
+	size_t next_admit = 0;
+	size_t next_report = 0;
+	uint32_t available = m_budget;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	auto report = [&](size_t i) {
+		auto &res = results[i];
+		const char *status = res.rc == 1 ? "done" :
+								(res.rc == 2 ? "skipped" : "failed");
+		spdlog::info("[{}/{}] {}: {} in {} ms", i + 1, num_files, files[i],
+				status, res.ms);
+	};
+	auto worker = [&]() {
+		while (true) {
+			size_t i = next_claim++;
+			if (i >= num_files)
+				return;
+
+			// claim budget in proportion to file size
+			std::error_code ec;
+			auto path = std::filesystem::path(dir) / files[i];
+			auto size = std::filesystem::file_size(path, ec);
+			uint64_t units = ec ? 1 : 1 + size / m_bytes_per_thread;
+			if (units > m_budget)
+				units = m_budget;
+
+			// admit files in order, once their share of the budget is free
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cv.wait(lock, [&] {
+					return next_admit == i && available >= units;
+				});
+				available -= (uint32_t) units;
+				next_admit++;
+			}
+			cv.notify_all();
+
+			int rc = 0;
+			auto file_start = std::chrono::high_resolution_clock::now();
+			try {
+				rc = job(files[i], (uint32_t) units);
+			} catch (std::bad_alloc &ba) {
+				spdlog::error("Out of memory while processing {}", files[i]);
+			}
+			std::chrono::duration<double> elapsed =
+					std::chrono::high_resolution_clock::now() - file_start;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				available += (uint32_t) units;
+				results[i].rc = rc;
+				results[i].ms = elapsed.count() * 1000;
+				results[i].done = true;
+				while (next_report < num_files && results[next_report].done)
+					report(next_report++);
+			}
+			cv.notify_all();
+		}
+	};
+
+	size_t num_workers = std::min<size_t>(m_budget, num_files);
+	if (num_workers <= 1) {
+		worker();
+	} else {
+		std::vector<std::thread> workers;
+		for (size_t i = 0; i < num_workers; ++i)
+			workers.emplace_back(worker);
+		for (auto &w : workers)
+			w.join();
+	}
+
+	size_t num_done = 0, num_failed = 0;
+	double file_ms = 0;
+	for (auto &res : results) {
+		if (res.rc == 1)
+			num_done++;
+		else if (res.rc == 0)
+			num_failed++;
+		file_ms += res.ms;
+	}
+	std::chrono::duration<double> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+	spdlog::info("batch: {} files processed, {} failed, {} skipped "
+			"in {} ms using {} threads (total time per file: {} ms)",
+			num_done, num_failed, num_files - num_done - num_failed,
+			elapsed.count() * 1000, m_budget, file_ms);
+
+	return num_done;
+}
+
+}
@@ -0,0 +1,78 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace grk {
+
+/**
+ * Processes the files of an image directory concurrently.
+ *
+ * Files share a budget of threads, and each file claims a number of units
+ * from the budget proportional to its size: small files take a single unit,
+ * so that many of them are processed side by side, while large files take
+ * up to the whole budget. A job is handed the number of units it was granted,
+ * and is expected to run with no more threads of its own than that.
+ * Files are admitted in order, so large files are never starved by small
+ * ones, and per-file results are reported in order.
+ */
+class BatchScheduler {
+public:
+	/**
+	 * Create a batch scheduler
+	 *
+	 * @param budget 			number of threads shared by the batch,
+	 * 							or zero for the hardware concurrency
+	 * @param bytes_per_thread	file size that warrants one thread of the budget
+	 */
+	BatchScheduler(uint32_t budget, uint64_t bytes_per_thread);
+
+	/**
+	 * Process files from a directory
+	 *
+	 * @param dir		directory holding the files
+	 * @param files		file names, relative to dir
+	 * @param job		processes a single file with the given number of
+	 * 					threads, returning 0 on failure, 1 on success,
+	 * 					and 2 if the file was not suitable
+	 *
+	 * @return number of files successfully processed
+	 */
+	size_t run(const std::string &dir, const std::vector<std::string> &files,
+			const std::function<int(const std::string&, uint32_t)> &job);
+
+	/**
+	 * List the files in a directory, in directory order
+	 *
+	 * @param dir	directory
+	 * @param files	receives the file names
+	 *
+	 * @return true if the directory could be read
+	 */
+	static bool list_files(const std::string &dir,
+			std::vector<std::string> *files);
+private:
+	uint32_t m_budget;
+	uint64_t m_bytes_per_thread;
+};
+
+}
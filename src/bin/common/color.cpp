@@ -24,6 +24,14 @@
 #include <math.h>
 #include <assert.h>
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
 #include "grk_apps_config.h"
 #include "grok.h"
 #include "color.h"
@@ -32,36 +40,52 @@
 #ifdef GROK_HAVE_LIBLCMS
 #include <lcms2.h>
 #endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 //#define DEBUG_PROFILE
 
-static grk_image* image_create(uint32_t numcmpts, uint32_t w, uint32_t h,
-		uint32_t prec) {
-	if (!numcmpts)
-		return nullptr;
-
-	auto cmptparms = (grk_image_cmptparm*) calloc(numcmpts,
-			sizeof(grk_image_cmptparm));
-	if (!cmptparms)
-		return nullptr;
-	uint32_t compno = 0U;
-	for (compno = 0U; compno < numcmpts; ++compno) {
-		memset(cmptparms + compno, 0, sizeof(grk_image_cmptparm));
-		cmptparms[compno].dx = 1;
-		cmptparms[compno].dy = 1;
-		cmptparms[compno].w = w;
-		cmptparms[compno].h = h;
-		cmptparms[compno].x0 = 0U;
-		cmptparms[compno].y0 = 0U;
-		cmptparms[compno].prec = prec;
-		cmptparms[compno].sgnd = 0U;
+#ifdef __SSE2__
+/**
+ * Four int32 lanes widened to double precision, so that vectorized
+ * conversions truncate exactly as their scalar double counterparts do
+ */
+struct Double4 {
+	explicit Double4(__m128i v) :
+			lo(_mm_cvtepi32_pd(v)), hi(_mm_cvtepi32_pd(_mm_unpackhi_epi64(v, v))) {
 	}
-	auto img = grk_image_create(numcmpts, (grk_image_cmptparm*) cmptparms,
-			GRK_CLRSPC_SRGB,true);
-	free(cmptparms);
-	return img;
-
+	Double4(__m128d l, __m128d h) :
+			lo(l), hi(h) {
+	}
+	Double4 operator*(double c) const {
+		auto vc = _mm_set1_pd(c);
+		return Double4(_mm_mul_pd(lo, vc), _mm_mul_pd(hi, vc));
+	}
+	Double4 operator+(double c) const {
+		auto vc = _mm_set1_pd(c);
+		return Double4(_mm_add_pd(lo, vc), _mm_add_pd(hi, vc));
+	}
+	Double4 operator+(const Double4 &rhs) const {
+		return Double4(_mm_add_pd(lo, rhs.lo), _mm_add_pd(hi, rhs.hi));
+	}
+	Double4 operator-(const Double4 &rhs) const {
+		return Double4(_mm_sub_pd(lo, rhs.lo), _mm_sub_pd(hi, rhs.hi));
+	}
+	/* truncate toward zero, as a cast to int32_t does */
+	__m128i trunc(void) const {
+		return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+	}
+	__m128d lo, hi;
+};
+
+/* clamp to [0, upb] */
+static inline __m128i clamp(__m128i v, __m128i upb) {
+	v = _mm_and_si128(v, _mm_cmpgt_epi32(v, _mm_setzero_si128()));
+	auto over = _mm_cmpgt_epi32(v, upb);
+	return _mm_or_si128(_mm_and_si128(over, upb), _mm_andnot_si128(over, v));
 }
+#endif
 
 /*--------------------------------------------------------
  Matrix for sYCC, Amendment 1 to IEC 61966-2-1
@@ -105,244 +129,161 @@ static void sycc_to_rgb(int32_t offset, int32_t upb, int32_t y, int32_t cb, int3
 	*out_b = b;
 }
 
-static bool sycc444_to_rgb(grk_image *src_img) {
-	int32_t *d0, *d1, *d2, *r, *g, *b;
-	auto dest_img = image_create(3, src_img->comps[0].w, src_img->comps[0].h,
-			src_img->comps[0].prec);
-	if (!dest_img)
-		return false;
-
-	int32_t upb = (int32_t) src_img->comps[0].prec;
-	int32_t offset = 1 << (upb - 1);
-	upb = (1 << upb) - 1;
-
-	uint32_t w = src_img->comps[0].w;
-	uint32_t stride_diff = src_img->comps[0].stride - w;
-	uint32_t h =  src_img->comps[0].h;
-
-	auto y = src_img->comps[0].data;
-	auto cb = src_img->comps[1].data;
-	auto cr = src_img->comps[2].data;
-
-	d0 = r = dest_img->comps[0].data;
-	d1 = g = dest_img->comps[1].data;
-	d2 = b = dest_img->comps[2].data;
-
-	dest_img->comps[0].data = nullptr;
-	dest_img->comps[1].data = nullptr;
-	dest_img->comps[2].data = nullptr;
-
-	for (uint32_t j = 0; j < h; ++j){
-		for (uint32_t i = 0; i < w; ++i)
-			sycc_to_rgb(offset, upb, *y++, *cb++, *cr++, r++, g++, b++);
-		y  += stride_diff;
-		cb += stride_diff;
-		cr += stride_diff;
-		r  += stride_diff;
-		g  += stride_diff;
-		b  += stride_diff;
+/**
+ * Convert a row of full resolution sYCC samples to RGB.
+ * Output rows may alias input rows.
+ */
+static void sycc_to_rgb_row(int32_t offset, int32_t upb, const int32_t *y,
+		const int32_t *cb, const int32_t *cr, int32_t *r, int32_t *g,
+		int32_t *b, uint32_t w) {
+	uint32_t i = 0;
+#ifdef __SSE2__
+	auto voffset = _mm_set1_epi32(offset);
+	auto vupb = _mm_set1_epi32(upb);
+	for (; i + 4 <= w; i += 4) {
+		auto vy = _mm_loadu_si128((const __m128i*) (y + i));
+		auto vcb = _mm_sub_epi32(_mm_loadu_si128((const __m128i*) (cb + i)),
+				voffset);
+		auto vcr = _mm_sub_epi32(_mm_loadu_si128((const __m128i*) (cr + i)),
+				voffset);
+		Double4 dcb(vcb), dcr(vcr);
+		auto vr = _mm_add_epi32(vy, (dcr * 1.402).trunc());
+		auto vg = _mm_sub_epi32(vy, (dcb * 0.344 + dcr * 0.714).trunc());
+		auto vb = _mm_add_epi32(vy, (dcb * 1.772).trunc());
+		_mm_storeu_si128((__m128i*) (r + i), clamp(vr, vupb));
+		_mm_storeu_si128((__m128i*) (g + i), clamp(vg, vupb));
+		_mm_storeu_si128((__m128i*) (b + i), clamp(vb, vupb));
 	}
+#endif
+	for (; i < w; ++i)
+		sycc_to_rgb(offset, upb, y[i], cb[i], cr[i], r + i, g + i, b + i);
+}
 
-	grk_image_all_components_data_free(src_img);
-	src_img->comps[0].data = d0;
-	src_img->comps[0].owns_data = true;
-	src_img->comps[1].data = d1;
-	src_img->comps[1].owns_data = true;
-	src_img->comps[2].data = d2;
-	src_img->comps[2].owns_data = true;
-	src_img->color_space = GRK_CLRSPC_SRGB;
-
-	for (uint32_t i = 0; i < src_img->numcomps; ++i)
-		src_img->comps[i].stride = dest_img->comps[i].stride;
-	grk_image_destroy(dest_img);
-	dest_img = nullptr;
-
-	return true;
-}/* sycc444_to_rgb() */
-
-static bool sycc422_to_rgb(grk_image *src_img) {
-	auto dest_img = image_create(3, src_img->comps[0].w, src_img->comps[0].h,
-			src_img->comps[0].prec);
-	if (!dest_img)
-		return false;
-
-	uint32_t upb =  src_img->comps[0].prec;
-	uint32_t offset = 1 << (upb - 1);
-	upb = (1 << upb) - 1;
-
-	uint32_t w = src_img->comps[0].w;
-	uint32_t stride_diff = src_img->comps[0].stride - w;
-	uint32_t stride_diff_chroma = src_img->comps[1].stride - src_img->comps[1].w;
-	uint32_t h = src_img->comps[0].h;
-
-	int32_t *d0, *d1, *d2, *r, *g, *b;
-
-	auto y = src_img->comps[0].data;
-	auto cb = src_img->comps[1].data;
-	auto cr = src_img->comps[2].data;
-
-	d0 = r = dest_img->comps[0].data;
-	d1 = g = dest_img->comps[1].data;
-	d2 = b = dest_img->comps[2].data;
-
-	dest_img->comps[0].data = nullptr;
-	dest_img->comps[1].data = nullptr;
-	dest_img->comps[2].data = nullptr;
-
-	/* if img->x0 is odd, then first column shall use Cb/Cr = 0 */
-	uint32_t offx = src_img->x0 & 1U;
-	uint32_t loopmaxw = w - offx;
-
-	for (uint32_t i = 0U; i < h; ++i) {
-		if (offx > 0U)
-			sycc_to_rgb(offset, upb, *y++, 0, 0, r++, g++, b++);
-
-		uint32_t j;
-		for (j = 0U; j < (loopmaxw & ~(size_t) 1U); j += 2U) {
-			sycc_to_rgb(offset, upb, *y++, *cb, *cr, r++, g++, b++);
-			sycc_to_rgb(offset, upb, *y++, *cb++, *cr++, r++, g++, b++);
-		}
-		if (j < loopmaxw)
-			sycc_to_rgb(offset, upb, *y++, *cb++, *cr++, r++, g++, b++);
-
-		y  += stride_diff;
-		cb += stride_diff_chroma;
-		cr += stride_diff_chroma;
-		r  += stride_diff;
-		g  += stride_diff;
-		b  += stride_diff;
+/**
+ * Upsample a row of horizontally sub-sampled chroma to full width
+ *
+ * @param src	chroma row
+ * @param srcw	width of chroma row
+ * @param dest	full width row
+ * @param w		width of full row
+ * @param offx	1 if the first column has no chroma sample of its own
+ * @param first	value of first column, if offx is 1
+ */
+static void upsample_chroma_row(const int32_t *src, uint32_t srcw,
+		int32_t *dest, uint32_t w, uint32_t offx, int32_t first) {
+	if (offx) {
+		if (!w)
+			return;
+		*dest++ = first;
+		w--;
 	}
-	grk_image_all_components_data_free(src_img);
-
-	src_img->comps[0].data = d0;
-	src_img->comps[0].owns_data = true;
-	src_img->comps[1].data = d1;
-	src_img->comps[1].owns_data = true;
-	src_img->comps[2].data = d2;
-	src_img->comps[2].owns_data = true;
-
-	src_img->comps[1].w = src_img->comps[2].w = src_img->comps[0].w;
-	src_img->comps[1].h = src_img->comps[2].h = src_img->comps[0].h;
-	src_img->comps[1].dx = src_img->comps[2].dx = src_img->comps[0].dx;
-	src_img->comps[1].dy = src_img->comps[2].dy = src_img->comps[0].dy;
-	src_img->color_space = GRK_CLRSPC_SRGB;
-
-	for (uint32_t i = 0; i < src_img->numcomps; ++i)
-		src_img->comps[i].stride = dest_img->comps[i].stride;
-	grk_image_destroy(dest_img);
-	dest_img = nullptr;
-
-	return true;
-
-}/* sycc422_to_rgb() */
-
-static bool sycc420_to_rgb(grk_image *src_img) {
-	auto dest_img = image_create(3, src_img->comps[0].w, src_img->comps[0].h,
-			src_img->comps[0].prec);
-	if (!dest_img)
-		return false;
+	uint32_t i = 0;
+	for (; i + 1 < w; i += 2)
+		dest[i] = dest[i + 1] = src[i >> 1];
+	if (i < w)
+		dest[i] = src[std::min<uint32_t>(i >> 1, srcw - 1)];
+}
 
-	uint32_t upb = src_img->comps[0].prec;
-	uint32_t offset = 1 << (upb - 1);
+/**
+ * Convert sYCC image with 4:4:4, 4:2:2 or 4:2:0 chroma to RGB.
+ *
+ * Red replaces luma in place. Without sub-sampling, green and blue
+ * also replace chroma in place; otherwise, chroma is upsampled one row
+ * at a time into scratch rows, and green and blue are written to
+ * full resolution buffers that replace the chroma buffers.
+ */
+static bool sycc_to_rgb_image(grk_image *img, uint32_t numThreads) {
+	auto comps = img->comps;
+	uint32_t w = comps[0].w;
+	uint32_t h = comps[0].h;
+	uint32_t dx = comps[1].dx;
+	uint32_t dy = comps[1].dy;
+	bool subsampled = dx > 1 || dy > 1;
+
+	int32_t upb = (int32_t) comps[0].prec;
+	int32_t offset = 1 << (upb - 1);
 	upb = (1 << upb) - 1;
 
-	uint32_t w = src_img->comps[0].w;
-	uint32_t h = src_img->comps[0].h;
-
-
-	int32_t *src[3];
-	int32_t *dest[3];
-	int32_t *dest_ptr[3];
-	uint32_t stride_src[3];
-	uint32_t stride_src_diff[3];
-
-	uint32_t stride_dest = dest_img->comps[0].stride;
-	uint32_t stride_dest_diff = dest_img->comps[0].stride -  dest_img->comps[0].w;
-
-
-	for (uint32_t i = 0; i < 3; ++i){
-		src[i] = src_img->comps[i].data;
-		dest[i] = dest_ptr[i] = dest_img->comps[i].data;
-		dest_img->comps[i].data = nullptr;
-
-		stride_src[i] = src_img->comps[i].stride;
-		stride_src_diff[i] = src_img->comps[i].stride -  src_img->comps[i].w;
-	}
+	if (subsampled && (!comps[1].w || !comps[1].h || !comps[2].w || !comps[2].h))
+		return false;
 
-	/* if img->x0 is odd, then first column shall use Cb/Cr = 0 */
-	uint32_t offx = src_img->x0 & 1U;
-	uint32_t loopmaxw = w - offx;
-	/* if img->y0 is odd, then first line shall use Cb/Cr = 0 */
-	uint32_t  offy = src_img->y0 & 1U;
-	uint32_t loopmaxh = h - offy;
-
-	if (offy > 0U) {
-		for (size_t j = 0U; j < w; ++j)
-			sycc_to_rgb(offset, upb, *src[0]++, 0, 0, dest_ptr[0]++, dest_ptr[1]++, dest_ptr[2]++);
-		src[0]  += stride_src_diff[0];
-		for (uint32_t i = 0; i < 3; ++i)
-			dest_ptr[i]  += stride_dest_diff;
-	}
-	size_t i;
-	for (i = 0U; i < (loopmaxh & ~(size_t) 1U); i += 2U) {
-		auto ny = src[0] +  stride_src[0];
-		auto nr = dest_ptr[0] + stride_dest;
-		auto ng = dest_ptr[1] + stride_dest;
-		auto nb = dest_ptr[2] + stride_dest;
-
-		if (offx > 0U) {
-			sycc_to_rgb(offset, upb, *src[0]++, 0, 0, dest_ptr[0]++, dest_ptr[1]++, dest_ptr[2]++);
-			sycc_to_rgb(offset, upb, *ny++, *src[1], *src[2], nr++, ng++, nb++);
-		}
-		uint32_t j;
-		for (j = 0U; j < (loopmaxw & ~(size_t) 1U); j += 2U) {
-			sycc_to_rgb(offset, upb, *src[0]++, *src[1], *src[2], dest_ptr[0]++, dest_ptr[1]++, dest_ptr[2]++);
-			sycc_to_rgb(offset, upb, *src[0]++, *src[1], *src[2], dest_ptr[0]++, dest_ptr[1]++, dest_ptr[2]++);
-			sycc_to_rgb(offset, upb, *ny++, *src[1], *src[2], nr++, ng++, nb++);
-			sycc_to_rgb(offset, upb, *ny++, *src[1]++, *src[2]++, nr++, ng++, nb++);
-		}
-		if (j < loopmaxw) {
-			sycc_to_rgb(offset, upb, *src[0]++, *src[1], *src[2], dest_ptr[0]++, dest_ptr[1]++, dest_ptr[2]++);
-			sycc_to_rgb(offset, upb, *ny++, *src[1]++, *src[2]++, nr++, ng++, nb++);
-		}
-		src[0] += stride_src_diff[0] + stride_src[0];
-		src[1] += stride_src_diff[1];
-		src[2] += stride_src_diff[2];
-		for (uint32_t k = 0; k < 3; ++k)
-			dest_ptr[k]  += stride_dest_diff + stride_dest;
-	}
-	// last row has no sub-sampling
-	if (i < loopmaxh) {
-		uint32_t j;
-		for (j = 0U; j < (w & ~(size_t) 1U); j += 2U) {
-			sycc_to_rgb(offset, upb, *src[0]++, *src[1], *src[2], dest_ptr[0]++, dest_ptr[1]++, dest_ptr[2]++);
-			sycc_to_rgb(offset, upb, *src[0]++, *src[1]++, *src[2]++, dest_ptr[0]++, dest_ptr[1]++, dest_ptr[2]++);
+	/* if x0 (resp. y0) is odd, then first column (resp. line) shall use Cb/Cr = 0 */
+	uint32_t offx = (dx == 2) ? (img->x0 & 1U) : 0;
+	uint32_t offy = (dy == 2) ? (img->y0 & 1U) : 0;
+
+	grk_image_comp full[2];
+	if (subsampled) {
+		for (uint32_t i = 0; i < 2; ++i) {
+			full[i] = comps[0];
+			full[i].data = nullptr;
+			full[i].owns_data = false;
+			if (!grk_image_single_component_data_alloc(full + i)) {
+				if (i == 1)
+					grk_image_single_component_data_free(full);
+				return false;
+			}
 		}
-		if (j < w)
-			sycc_to_rgb(offset, upb, *src[0], *src[1], *src[2], dest_ptr[0], dest_ptr[1], dest_ptr[2]);
 	}
 
-	grk_image_all_components_data_free(src_img);
-	for (uint32_t k = 0; k < 3; ++k){
-		src_img->comps[k].data = dest[k];
-		src_img->comps[k].owns_data = true;
-		src_img->comps[k].stride = dest_img->comps[k].stride;
+	auto numStrips = grk::num_strips(w, h, numThreads);
+	grk::process_strips(h, numStrips,
+			[&](uint32_t strip, uint32_t y0, uint32_t y1) {
+				(void) strip;
+				std::vector<int32_t> chroma[2];
+				if (subsampled) {
+					chroma[0].resize(w);
+					chroma[1].resize(w);
+				}
+				for (uint32_t j = y0; j < y1; ++j) {
+					auto yRow = comps[0].data + (size_t) j * comps[0].stride;
+					const int32_t *c[2];
+					int32_t *out[2];
+					for (uint32_t i = 0; i < 2; ++i) {
+						auto comp = comps + 1 + i;
+						if (!subsampled) {
+							out[i] = comp->data + (size_t) j * comp->stride;
+							c[i] = out[i];
+							continue;
+						}
+						out[i] = full[i].data + (size_t) j * full[i].stride;
+						c[i] = chroma[i].data();
+						if (j < offy) {
+							std::fill(chroma[i].begin(), chroma[i].end(), 0);
+							continue;
+						}
+						uint32_t k = j - offy;
+						auto src = comp->data
+								+ (size_t) std::min<uint32_t>(k / dy, comp->h - 1)
+										* comp->stride;
+						/* second line of a 4:2:0 pair re-uses first chroma sample */
+						int32_t first = (dy == 2 && (k & 1)) ? src[0] : 0;
+						upsample_chroma_row(src, comp->w, chroma[i].data(), w,
+								offx, first);
+					}
+					sycc_to_rgb_row(offset, upb, yRow, c[0], c[1], yRow, out[0],
+							out[1], w);
+				}
+				return true;
+			});
+
+	if (subsampled) {
+		for (uint32_t i = 0; i < 2; ++i) {
+			auto comp = comps + 1 + i;
+			grk_image_single_component_data_free(comp);
+			comp->data = full[i].data;
+			comp->owns_data = true;
+			comp->stride = full[i].stride;
+			comp->w = comps[0].w;
+			comp->h = comps[0].h;
+			comp->dx = comps[0].dx;
+			comp->dy = comps[0].dy;
+		}
 	}
 
-	src_img->comps[1].w = src_img->comps[2].w = src_img->comps[0].w;
-	src_img->comps[1].h = src_img->comps[2].h = src_img->comps[0].h;
-	src_img->comps[1].dx = src_img->comps[2].dx = src_img->comps[0].dx;
-	src_img->comps[1].dy = src_img->comps[2].dy = src_img->comps[0].dy;
-	src_img->color_space = GRK_CLRSPC_SRGB;
-
-	grk_image_destroy(dest_img);
-	dest_img = nullptr;
-
 	return true;
+}/* sycc_to_rgb_image() */
 
-}/* sycc420_to_rgb() */
-
-bool color_sycc_to_rgb(grk_image *img) {
+bool color_sycc_to_rgb(grk_image *img, uint32_t numThreads) {
 	if (img->numcomps < 3) {
 		spdlog::warn(
 				"color_sycc_to_rgb: number of components {} is less than 3."
@@ -351,18 +292,16 @@ bool color_sycc_to_rgb(grk_image *img) {
 	}
 	bool rc;
 
-	if ((img->comps[0].dx == 1) && (img->comps[1].dx == 2)
+	if (((img->comps[0].dx == 1) && (img->comps[1].dx == 2)
 			&& (img->comps[2].dx == 2) && (img->comps[0].dy == 1)
-			&& (img->comps[1].dy == 2) && (img->comps[2].dy == 2)) { /* horizontal and vertical sub-sample */
-		rc = sycc420_to_rgb(img);
-	} else if ((img->comps[0].dx == 1) && (img->comps[1].dx == 2)
+			&& (img->comps[1].dy == 2) && (img->comps[2].dy == 2)) /* horizontal and vertical sub-sample */
+		|| ((img->comps[0].dx == 1) && (img->comps[1].dx == 2)
 			&& (img->comps[2].dx == 2) && (img->comps[0].dy == 1)
-			&& (img->comps[1].dy == 1) && (img->comps[2].dy == 1)) { /* horizontal sub-sample only */
-		rc = sycc422_to_rgb(img);
-	} else if ((img->comps[0].dx == 1) && (img->comps[1].dx == 1)
+			&& (img->comps[1].dy == 1) && (img->comps[2].dy == 1)) /* horizontal sub-sample only */
+		|| ((img->comps[0].dx == 1) && (img->comps[1].dx == 1)
 			&& (img->comps[2].dx == 1) && (img->comps[0].dy == 1)
-			&& (img->comps[1].dy == 1) && (img->comps[2].dy == 1)) { /* no sub-sample */
-		rc = sycc444_to_rgb(img);
+			&& (img->comps[1].dy == 1) && (img->comps[2].dy == 1))) { /* no sub-sample */
+		rc = sycc_to_rgb_image(img, numThreads);
 	} else {
 		spdlog::warn(
 				"color_sycc_to_rgb:  Invalid sub-sampling: ({},{}), ({},{}), ({},{})."
@@ -380,17 +319,192 @@ bool color_sycc_to_rgb(grk_image *img) {
 
 #if defined(GROK_HAVE_LIBLCMS)
 
+static grk_image* image_create(uint32_t numcmpts, uint32_t w, uint32_t h,
+		uint32_t prec) {
+	if (!numcmpts)
+		return nullptr;
+
+	auto cmptparms = (grk_image_cmptparm*) calloc(numcmpts,
+			sizeof(grk_image_cmptparm));
+	if (!cmptparms)
+		return nullptr;
+	uint32_t compno = 0U;
+	for (compno = 0U; compno < numcmpts; ++compno) {
+		memset(cmptparms + compno, 0, sizeof(grk_image_cmptparm));
+		cmptparms[compno].dx = 1;
+		cmptparms[compno].dy = 1;
+		cmptparms[compno].w = w;
+		cmptparms[compno].h = h;
+		cmptparms[compno].x0 = 0U;
+		cmptparms[compno].y0 = 0U;
+		cmptparms[compno].prec = prec;
+		cmptparms[compno].sgnd = 0U;
+	}
+	auto img = grk_image_create(numcmpts, (grk_image_cmptparm*) cmptparms,
+			GRK_CLRSPC_SRGB,true);
+	free(cmptparms);
+	return img;
+
+}
+
+/**
+ * Cache of ICC transforms to sRGB, keyed by profile contents, pixel formats
+ * and rendering intent, so that a batch of images sharing a profile
+ * only builds its transform once.
+ *
+ * Transforms are created without the lcms pixel cache, which makes them
+ * safe to share between threads.
+ */
+class IccTransformCache {
+public:
+	/**
+	 * Get transform for an input profile, creating it on first use
+	 *
+	 * @param in_prof		input profile
+	 * @param profile		input profile contents
+	 * @param len			length of profile contents
+	 * @param in_type		input pixel format
+	 * @param out_type		output pixel format
+	 * @param intent		rendering intent
+	 *
+	 * @return transform, or empty pointer if the transform cannot be created
+	 */
+	std::shared_ptr<void> get(cmsHPROFILE in_prof, const uint8_t *profile,
+			uint32_t len, cmsUInt32Number in_type, cmsUInt32Number out_type,
+			cmsUInt32Number intent) {
+		size_t hash = std::hash<std::string_view>()(
+				std::string_view((const char*) profile, len));
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto &entry : m_entries) {
+			if (entry.hash == hash && entry.in_type == in_type
+					&& entry.out_type == out_type && entry.intent == intent
+					&& entry.profile.size() == len
+					&& memcmp(entry.profile.data(), profile, len) == 0)
+				return entry.transform;
+		}
+		auto out_prof = cmsCreate_sRGBProfile();
+		auto transform = cmsCreateTransform(in_prof, in_type, out_prof,
+				out_type, intent, cmsFLAGS_NOCACHE);
+		cmsCloseProfile(out_prof);
+		if (!transform)
+			return nullptr;
+		// evict the oldest transform; images still using it keep it alive
+		if (m_entries.size() == maxEntries)
+			m_entries.erase(m_entries.begin());
+		IccTransformEntry entry;
+		entry.hash = hash;
+		entry.profile.assign(profile, profile + len);
+		entry.in_type = in_type;
+		entry.out_type = out_type;
+		entry.intent = intent;
+		entry.transform = std::shared_ptr<void>(transform, cmsDeleteTransform);
+		m_entries.push_back(entry);
+
+		return entry.transform;
+	}
+private:
+	struct IccTransformEntry {
+		size_t hash;
+		std::vector<uint8_t> profile;
+		cmsUInt32Number in_type;
+		cmsUInt32Number out_type;
+		cmsUInt32Number intent;
+		std::shared_ptr<void> transform;
+	};
+	static const size_t maxEntries = 8;
+	std::vector<IccTransformEntry> m_entries;
+	std::mutex m_mutex;
+};
+
+static IccTransformCache iccTransformCache;
+
+/**
+ * Apply ICC transform to an RGB image, in place, one interleaved row at a time
+ */
+template<typename T> static void apply_icc_rgb(cmsHTRANSFORM transform,
+		grk_image *image, uint32_t numStrips) {
+	uint32_t w = image->comps[0].w;
+	size_t stride = image->comps[0].stride;
+	auto r = image->comps[0].data;
+	auto g = image->comps[1].data;
+	auto b = image->comps[2].data;
+	grk::process_strips(image->comps[0].h, numStrips,
+			[=](uint32_t strip, uint32_t y0, uint32_t y1) {
+		(void) strip;
+		auto in = new T[(size_t) w * 3];
+		auto out = new T[(size_t) w * 3];
+		for (uint32_t j = y0; j < y1; ++j) {
+			size_t index = j * stride;
+			auto pin = in;
+			for (uint32_t i = 0; i < w; ++i) {
+				*pin++ = (T) r[index + i];
+				*pin++ = (T) g[index + i];
+				*pin++ = (T) b[index + i];
+			}
+			cmsDoTransform(transform, in, out, w);
+			auto pout = out;
+			for (uint32_t i = 0; i < w; ++i) {
+				r[index + i] = (int32_t) *pout++;
+				g[index + i] = (int32_t) *pout++;
+				b[index + i] = (int32_t) *pout++;
+			}
+		}
+		delete[] out;
+		delete[] in;
+
+		return true;
+	});
+}
+
+/**
+ * Apply ICC transform to a gray image, in place, one row at a time.
+ * The colour channels are only stored when forcing RGB
+ */
+static void apply_icc_gray(cmsHTRANSFORM transform, grk_image *image,
+		bool forceRGB, uint32_t numStrips) {
+	uint32_t w = image->comps[0].w;
+	size_t stride = image->comps[0].stride;
+	auto r = image->comps[0].data;
+	auto g = image->comps[1].data;
+	auto b = image->comps[2].data;
+	grk::process_strips(image->comps[0].h, numStrips,
+			[=](uint32_t strip, uint32_t y0, uint32_t y1) {
+		(void) strip;
+		auto in = new uint8_t[w];
+		auto out = new uint8_t[(size_t) w * 3];
+		for (uint32_t j = y0; j < y1; ++j) {
+			size_t index = j * stride;
+			for (uint32_t i = 0; i < w; ++i)
+				in[i] = (uint8_t) r[index + i];
+			cmsDoTransform(transform, in, out, w);
+			auto pout = out;
+			for (uint32_t i = 0; i < w; ++i) {
+				r[index + i] = (int32_t) *pout++;
+				if (forceRGB) {
+					g[index + i] = (int32_t) *pout++;
+					b[index + i] = (int32_t) *pout++;
+				} else {
+					pout += 2;
+				}
+			}
+		}
+		delete[] out;
+		delete[] in;
+
+		return true;
+	});
+}
+
 /*#define DEBUG_PROFILE*/
-void color_apply_icc_profile(grk_image *image, bool forceRGB) {
+void color_apply_icc_profile(grk_image *image, bool forceRGB,
+		uint32_t numThreads) {
 	cmsColorSpaceSignature in_space;
 	cmsColorSpaceSignature out_space;
 	cmsUInt32Number intent = 0;
-	cmsHTRANSFORM transform = nullptr;
+	std::shared_ptr<void> transform;
 	cmsHPROFILE in_prof = nullptr;
-	cmsHPROFILE out_prof = nullptr;
 	cmsUInt32Number in_type, out_type;
-	size_t nr_samples, max;
-	uint32_t prec, w, stride_diff, h;
+	uint32_t prec, w, h, numStrips;
 	GRK_COLOR_SPACE oldspace;
 	grk_image *new_image = nullptr;
 	if (image->numcomps == 0 || !grk::all_components_sanity_check(image,true))
@@ -411,7 +525,6 @@ void color_apply_icc_profile(grk_image *image, bool forceRGB) {
 	intent = cmsGetHeaderRenderingIntent(in_prof);
 
 	w = image->comps[0].w;
-	stride_diff = image->comps[0].stride - w;
 	h = image->comps[0].h;
 
 	if (!w || !h)
@@ -446,12 +559,10 @@ void color_apply_icc_profile(grk_image *image, bool forceRGB) {
 			in_type = TYPE_RGB_16;
 			out_type = TYPE_RGB_16;
 		}
-		out_prof = cmsCreate_sRGBProfile();
 		image->color_space = GRK_CLRSPC_SRGB;
 	} else if (out_space == cmsSigGrayData) { /* enumCS 17 */
 		in_type = TYPE_GRAY_8;
 		out_type = TYPE_RGB_8;
-		out_prof = cmsCreate_sRGBProfile();
 		if (forceRGB)
 			image->color_space = GRK_CLRSPC_SRGB;
 		else
@@ -459,7 +570,6 @@ void color_apply_icc_profile(grk_image *image, bool forceRGB) {
 	} else if (out_space == cmsSigYCbCrData) { /* enumCS 18 */
 		in_type = TYPE_YCbCr_16;
 		out_type = TYPE_RGB_16;
-		out_prof = cmsCreate_sRGBProfile();
 		image->color_space = GRK_CLRSPC_SRGB;
 	} else {
 #ifdef DEBUG_PROFILE
@@ -469,13 +579,13 @@ void color_apply_icc_profile(grk_image *image, bool forceRGB) {
                 (out_space>>24) & 0xff,(out_space>>16) & 0xff,
                 (out_space>>8) & 0xff, out_space & 0xff);
 #endif
-		return;
+		goto cleanup;
 	}
 
 #ifdef DEBUG_PROFILE
     spdlog::error("{}:{}:color_apply_icc_profile\n\tchannels({}) prec({}) w({}) h({})"
-            "\n\tprofile: in({}) out({})",__FILE__,__LINE__,image->numcomps,prec,
-            max_w,max_h, (void*)in_prof,(void*)out_prof);
+            "\n\tprofile: in({})",__FILE__,__LINE__,image->numcomps,prec,
+            max_w,max_h, (void*)in_prof);
 
     spdlog::error("\trender_intent ({})\n\t"
             "color_space: in({})({}{}{}{})   out:({})({}{}{}{})\n\t"
@@ -492,19 +602,16 @@ void color_apply_icc_profile(grk_image *image, bool forceRGB) {
             in_type,out_type
            );
 #else
-	(void) prec;
 	(void) in_space;
 #endif /* DEBUG_PROFILE */
 
-	transform = cmsCreateTransform(in_prof, in_type, out_prof, out_type, intent,
-			0);
+	transform = iccTransformCache.get(in_prof, image->icc_profile_buf,
+			image->icc_profile_len, in_type, out_type, intent);
 
 	cmsCloseProfile(in_prof);
 	in_prof = nullptr;
-	cmsCloseProfile(out_prof);
-	out_prof = nullptr;
 
-	if (transform == nullptr) {
+	if (!transform) {
 #ifdef DEBUG_PROFILE
         spdlog::error("{}:{}:color_apply_icc_profile\n\tcmsCreateTransform failed. "
                 "ICC Profile ignored.",__FILE__,__LINE__);
@@ -512,126 +619,23 @@ void color_apply_icc_profile(grk_image *image, bool forceRGB) {
 		image->color_space = oldspace;
 		return;
 	}
+	numStrips = grk::num_strips(w, h, numThreads);
 	if (image->numcomps > 2) { /* RGB, RGBA */
-		if (prec <= 8) {
-			uint8_t *in = nullptr, *inbuf = nullptr, *out = nullptr, *outbuf =
-					nullptr;
-			max = (size_t) w * h;
-			nr_samples = max * 3 * (cmsUInt32Number) sizeof(uint8_t);
-			in = inbuf = (uint8_t*) malloc(nr_samples);
-			if (!in) {
-				goto cleanup;
-			}
-			out = outbuf = (uint8_t*) malloc(nr_samples);
-			if (!out) {
-				free(inbuf);
-				goto cleanup;
-			}
-
-			auto r = image->comps[0].data;
-			auto g = image->comps[1].data;
-			auto b = image->comps[2].data;
-
-			size_t src_index = 0;
-			size_t dest_index = 0;
-			for (uint32_t j = 0; j < h; ++j){
-				for (uint32_t i = 0; i < w; ++i){
-					in[dest_index++] = (uint8_t)r[src_index];
-					in[dest_index++] = (uint8_t)g[src_index];
-					in[dest_index++] = (uint8_t)b[src_index];
-					src_index++;
-				}
-				src_index += stride_diff;
-			}
-
-			cmsDoTransform(transform, inbuf, outbuf, (cmsUInt32Number) max);
-
-			src_index = 0;
-			dest_index = 0;
-			for (uint32_t j = 0; j < h; ++j){
-				for (uint32_t i = 0; i < w; ++i){
-					r[dest_index] = (int32_t)out[src_index++];
-					g[dest_index] = (int32_t)out[src_index++];
-					b[dest_index] = (int32_t)out[src_index++];
-					dest_index++;
-				}
-				dest_index += stride_diff;
-			}
-			free(inbuf);
-			free(outbuf);
-		} else {
-			uint16_t *in = nullptr, *inbuf = nullptr, *out = nullptr,
-					*outbuf = nullptr;
-			max = (size_t)w * h;
-			nr_samples = max * 3 * (cmsUInt32Number) sizeof(uint16_t);
-			in = inbuf = (uint16_t*) malloc(nr_samples);
-			if (!in)
-				goto cleanup;
-			out = outbuf = (uint16_t*) malloc(nr_samples);
-			if (!out) {
-				free(inbuf);
-				goto cleanup;
-			}
-			auto r = image->comps[0].data;
-			auto g = image->comps[1].data;
-			auto b = image->comps[2].data;
-
-			size_t src_index = 0;
-			size_t dest_index = 0;
-			for (uint32_t j = 0; j < h; ++j){
-				for (uint32_t i = 0; i < w; ++i){
-					in[dest_index++] = (uint16_t)r[src_index];
-					in[dest_index++] = (uint16_t)g[src_index];
-					in[dest_index++] = (uint16_t)b[src_index];
-					src_index++;
-				}
-				src_index += stride_diff;
-			}
-
-			cmsDoTransform(transform, inbuf, outbuf, (cmsUInt32Number) max);
-
-			src_index = 0;
-			dest_index = 0;
-			for (uint32_t j = 0; j < h; ++j){
-				for (uint32_t i = 0; i < w; ++i){
-					r[dest_index] = (int32_t)out[src_index++];
-					g[dest_index] = (int32_t)out[src_index++];
-					b[dest_index] = (int32_t)out[src_index++];
-					dest_index++;
-				}
-				dest_index += stride_diff;
-			}
-			free(inbuf);
-			free(outbuf);
-		}
+		if (prec <= 8)
+			apply_icc_rgb<uint8_t>(transform.get(), image, numStrips);
+		else
+			apply_icc_rgb<uint16_t>(transform.get(), image, numStrips);
 	} else { /* GRAY, GRAYA */
-		uint8_t *in = nullptr, *inbuf = nullptr, *out = nullptr, *outbuf =
-				nullptr;
-
-		max = (size_t)w * h;
-		nr_samples = max * 3 * (cmsUInt32Number) sizeof(uint8_t);
 		grk_image_comp *comps = (grk_image_comp*) realloc(image->comps,
 				(image->numcomps + 2) * sizeof(grk_image_comp));
 		if (!comps)
 			goto cleanup;
 		image->comps = comps;
 
-		in = inbuf = (uint8_t*) malloc(nr_samples);
-		if (!in)
-			goto cleanup;
-		out = outbuf = (uint8_t*) malloc(nr_samples);
-		if (!out) {
-			free(inbuf);
-			goto cleanup;
-		}
-
 		new_image = image_create(2, image->comps[0].w, image->comps[0].h,
 				image->comps[0].prec);
-		if (!new_image) {
-			free(inbuf);
-			free(outbuf);
+		if (!new_image)
 			goto cleanup;
-		}
 
 		if (image->numcomps == 2)
 			image->comps[3] = image->comps[1];
@@ -653,52 +657,14 @@ void color_apply_icc_profile(grk_image *image, bool forceRGB) {
 		if (forceRGB)
 			image->numcomps += 2;
 
-		auto r = image->comps[0].data;
-
-		size_t src_index = 0;
-		size_t dest_index = 0;
-		for (uint32_t j = 0; j < h; ++j){
-			for (uint32_t i = 0; i < w; ++i){
-				in[dest_index++] = (uint8_t)r[src_index];
-				src_index++;
-			}
-			src_index += stride_diff;
-		}
-
-		cmsDoTransform(transform, inbuf, outbuf, (cmsUInt32Number) max);
-
-		auto g = image->comps[1].data;
-		auto b = image->comps[2].data;
-
-		src_index = 0;
-		dest_index = 0;
-		for (uint32_t j = 0; j < h; ++j){
-			for (uint32_t i = 0; i < w; ++i){
-				r[dest_index] = (int32_t)out[src_index++];
-				if (forceRGB) {
-					g[dest_index] = (int32_t)out[src_index++];
-					b[dest_index] = (int32_t)out[src_index++];
-				} else {
-					src_index+=2;
-				}
-				dest_index++;
-			}
-			dest_index += stride_diff;
-		}
-
-		free(inbuf);
-		free(outbuf);
+		apply_icc_gray(transform.get(), image, forceRGB, numStrips);
 	}/* if(image->numcomps */
 	cleanup: if (in_prof)
 		cmsCloseProfile(in_prof);
-	if (out_prof)
-		cmsCloseProfile(out_prof);
-	if (transform)
-		cmsDeleteTransform(transform);
 }/* color_apply_icc_profile() */
 
 // transform LAB colour space to sRGB @ 16 bit precision
-bool color_cielab_to_rgb(grk_image *src_img) {
+bool color_cielab_to_rgb(grk_image *src_img, uint32_t numThreads) {
 	// sanity checks
 	if (src_img->numcomps == 0 || !grk::all_components_sanity_check(src_img,true))
 		return false;
@@ -732,12 +698,10 @@ bool color_cielab_to_rgb(grk_image *src_img) {
 	uint32_t illuminant = GRK_CIE_D50;
 	cmsCIExyY WhitePoint;
 	defaultType = row[1] == GRK_DEFAULT_CIELAB_SPACE;
-	int32_t *L, *a, *b, *red, *green, *blue;
 	int32_t *src[3], *dst[3];
 	// range, offset and precision for L,a and b coordinates
 	double r_L, o_L, r_a, o_a, r_b, o_b, prec_L, prec_a, prec_b;
 	double minL, maxL, mina, maxa, minb, maxb;
-	cmsUInt16Number RGB[3];
 	auto dest_img = image_create(3, src_img->comps[0].w, src_img->comps[0].h,
 			src_img->comps[0].prec);
 	if (!dest_img)
@@ -795,28 +759,41 @@ bool color_cielab_to_rgb(grk_image *src_img) {
 		break;
 	}
 
+	uint32_t w = src_img->comps[0].w;
+	uint32_t h = src_img->comps[0].h;
+	uint32_t numStrips = grk::num_strips(w, h, numThreads);
+
 	// Lab input profile
 	cmsHPROFILE in = cmsCreateLab4Profile(
 			illuminant == GRK_CIE_D50 ? nullptr : &WhitePoint);
 	// sRGB output profile
 	cmsHPROFILE out = cmsCreate_sRGBProfile();
-	cmsHTRANSFORM transform = cmsCreateTransform(in, TYPE_Lab_DBL, out,
-			TYPE_RGB_16, INTENT_PERCEPTUAL, 0);
+	// one transform per strip, as transforms cache state between calls
+	std::vector<cmsHTRANSFORM> transforms;
+	for (uint32_t strip = 0; strip < numStrips; ++strip) {
+		auto transform = cmsCreateTransform(in, TYPE_Lab_DBL, out,
+				TYPE_RGB_16, INTENT_PERCEPTUAL, 0);
+		if (!transform)
+			break;
+		transforms.push_back(transform);
+	}
 
 	cmsCloseProfile(in);
 	cmsCloseProfile(out);
-	if (transform == nullptr) {
+	if (transforms.size() != numStrips) {
+		for (auto &t : transforms)
+			cmsDeleteTransform(t);
 		grk_image_destroy(dest_img);
 		return false;
 	}
 
-	L = src[0] = src_img->comps[0].data;
-	a = src[1] = src_img->comps[1].data;
-	b = src[2] = src_img->comps[2].data;
+	src[0] = src_img->comps[0].data;
+	src[1] = src_img->comps[1].data;
+	src[2] = src_img->comps[2].data;
 
-	red = dst[0] = dest_img->comps[0].data;
-	green = dst[1] = dest_img->comps[1].data;
-	blue = dst[2] = dest_img->comps[2].data;
+	dst[0] = dest_img->comps[0].data;
+	dst[1] = dest_img->comps[1].data;
+	dst[2] = dest_img->comps[2].data;
 
 	dest_img->comps[0].data = nullptr;
 	dest_img->comps[1].data = nullptr;
@@ -835,31 +812,45 @@ bool color_cielab_to_rgb(grk_image *src_img) {
 	maxb = minb + r_b;
 
 
-	uint32_t stride_diff = src_img->comps[0].stride - src_img->comps[0].w;
-	size_t dest_index = 0;
-	for (uint32_t j = 0; j < src_img->comps[0].h; ++j){
-		for (uint32_t k = 0; k < src_img->comps[0].w; ++k){
-			cmsCIELab Lab;
-			Lab.L = minL + (double) (*L) * (maxL - minL) / (pow(2, prec_L) - 1);
-			++L;
-			Lab.a = mina + (double) (*a) * (maxa - mina) / (pow(2, prec_a) - 1);
-			++a;
-			Lab.b = minb + (double) (*b) * (maxb - minb) / (pow(2, prec_b) - 1);
-			++b;
-
-			cmsDoTransform(transform, &Lab, RGB, 1);
-
-			red[dest_index] 	= RGB[0];
-			green[dest_index] 	= RGB[1];
-			blue[dest_index] 	= RGB[2];
-			dest_index++;
+	double range_L = maxL - minL, max_L = pow(2, prec_L) - 1;
+	double range_a = maxa - mina, max_a = pow(2, prec_a) - 1;
+	double range_b = maxb - minb, max_b = pow(2, prec_b) - 1;
+	size_t stride = src_img->comps[0].stride;
+
+	// transform one packed row at a time
+	grk::process_strips(h, numStrips,
+			[&](uint32_t strip, uint32_t y0, uint32_t y1) {
+		auto transform = transforms[strip];
+		auto Lab = new cmsCIELab[w];
+		auto RGB = new cmsUInt16Number[(size_t)w * 3];
+		for (uint32_t j = y0; j < y1; ++j) {
+			size_t index = j * stride;
+			auto L = src[0] + index;
+			auto a = src[1] + index;
+			auto b = src[2] + index;
+			for (uint32_t k = 0; k < w; ++k) {
+				Lab[k].L = minL + (double) L[k] * range_L / max_L;
+				Lab[k].a = mina + (double) a[k] * range_a / max_a;
+				Lab[k].b = minb + (double) b[k] * range_b / max_b;
+			}
+			cmsDoTransform(transform, Lab, RGB, w);
+			auto red = dst[0] + index;
+			auto green = dst[1] + index;
+			auto blue = dst[2] + index;
+			auto rgb = RGB;
+			for (uint32_t k = 0; k < w; ++k) {
+				red[k] = *rgb++;
+				green[k] = *rgb++;
+				blue[k] = *rgb++;
+			}
 		}
-		dest_index += stride_diff;
-		L += stride_diff;
-		a += stride_diff;
-		b += stride_diff;
-	}
-	cmsDeleteTransform(transform);
+		delete[] RGB;
+		delete[] Lab;
+
+		return true;
+	});
+	for (auto &t : transforms)
+		cmsDeleteTransform(t);
 	for (i = 0; i < 3; ++i){
 		auto comp = src_img->comps + i;
 		grk_image_single_component_data_free(comp);
@@ -874,7 +865,63 @@ bool color_cielab_to_rgb(grk_image *src_img) {
 
 #endif /* GROK_HAVE_LIBLCMS */
 
-bool color_cmyk_to_rgb(grk_image *image) {
+/**
+ * Convert a row of CMYK samples to RGB, in place
+ */
+static void cmyk_to_rgb_row(int32_t *c, int32_t *m, int32_t *y,
+		const int32_t *k, uint32_t w, float sC, float sM, float sY, float sK) {
+	uint32_t i = 0;
+#ifdef __SSE2__
+	auto one = _mm_set1_ps(1.0F);
+	auto v255 = _mm_set1_ps(255.0F);
+	auto vsC = _mm_set1_ps(sC);
+	auto vsM = _mm_set1_ps(sM);
+	auto vsY = _mm_set1_ps(sY);
+	auto vsK = _mm_set1_ps(sK);
+	for (; i + 4 <= w; i += 4) {
+		auto C = _mm_sub_ps(one,
+				_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i*) (c + i))),
+						vsC));
+		auto M = _mm_sub_ps(one,
+				_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i*) (m + i))),
+						vsM));
+		auto Y = _mm_sub_ps(one,
+				_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i*) (y + i))),
+						vsY));
+		auto K = _mm_sub_ps(one,
+				_mm_mul_ps(
+						_mm_cvtepi32_ps(
+								_mm_loadu_si128((const __m128i*) (k + i))),
+						vsK));
+		_mm_storeu_si128((__m128i*) (c + i),
+				_mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(v255, C), K)));
+		_mm_storeu_si128((__m128i*) (m + i),
+				_mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(v255, M), K)));
+		_mm_storeu_si128((__m128i*) (y + i),
+				_mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(v255, Y), K)));
+	}
+#endif
+	for (; i < w; ++i) {
+		/* CMYK values from 0 to 1 */
+		float C = (float) (c[i]) * sC;
+		float M = (float) (m[i]) * sM;
+		float Y = (float) (y[i]) * sY;
+		float K = (float) (k[i]) * sK;
+
+		/* Invert all CMYK values */
+		C = 1.0F - C;
+		M = 1.0F - M;
+		Y = 1.0F - Y;
+		K = 1.0F - K;
+
+		/* CMYK -> RGB : RGB results from 0 to 255 */
+		c[i] = (int32_t) (255.0F * C * K); /* R */
+		m[i] = (int32_t) (255.0F * M * K); /* G */
+		y[i] = (int32_t) (255.0F * Y * K); /* B */
+	}
+}
+
+bool color_cmyk_to_rgb(grk_image *image, uint32_t numThreads) {
 	uint32_t w = image->comps[0].w;
 	uint32_t h = image->comps[0].h;
 
@@ -886,30 +933,18 @@ bool color_cmyk_to_rgb(grk_image *image) {
 	float sY = 1.0F / (float) ((1 << image->comps[2].prec) - 1);
 	float sK = 1.0F / (float) ((1 << image->comps[3].prec) - 1);
 
-	uint32_t stride_diff = image->comps[0].stride - w;
-	size_t dest_index = 0;
-	for (uint32_t j = 0; j < h; ++j){
-		for (uint32_t i = 0; i < w; ++i){
-			/* CMYK values from 0 to 1 */
-			float C = (float) (image->comps[0].data[dest_index]) * sC;
-			float M = (float) (image->comps[1].data[dest_index]) * sM;
-			float Y = (float) (image->comps[2].data[dest_index]) * sY;
-			float K = (float) (image->comps[3].data[dest_index]) * sK;
-
-			/* Invert all CMYK values */
-			C = 1.0F - C;
-			M = 1.0F - M;
-			Y = 1.0F - Y;
-			K = 1.0F - K;
-
-			/* CMYK -> RGB : RGB results from 0 to 255 */
-			image->comps[0].data[dest_index] = (int32_t) (255.0F * C * K); /* R */
-			image->comps[1].data[dest_index] = (int32_t) (255.0F * M * K); /* G */
-			image->comps[2].data[dest_index] = (int32_t) (255.0F * Y * K); /* B */
-			dest_index++;
-		}
-		dest_index += stride_diff;
-	}
+	auto comps = image->comps;
+	grk::process_strips(h, grk::num_strips(w, h, numThreads),
+			[&](uint32_t strip, uint32_t y0, uint32_t y1) {
+				(void) strip;
+				for (uint32_t j = y0; j < y1; ++j)
+					cmyk_to_rgb_row(comps[0].data + (size_t) j * comps[0].stride,
+							comps[1].data + (size_t) j * comps[1].stride,
+							comps[2].data + (size_t) j * comps[2].stride,
+							comps[3].data + (size_t) j * comps[3].stride, w, sC,
+							sM, sY, sK);
+				return true;
+			});
 
 	grk_image_single_component_data_free(image->comps + 3);
 	image->comps[0].prec = 8;
@@ -927,8 +962,68 @@ bool color_cmyk_to_rgb(grk_image *image) {
 
 }/* color_cmyk_to_rgb() */
 
+/**
+ * Convert a row of eSYCC samples to RGB, in place
+ */
+static void esycc_to_rgb_row(int32_t *y, int32_t *cb, int32_t *cr, uint32_t w,
+		int32_t cb_offset, int32_t cr_offset, int32_t max_value) {
+	uint32_t i = 0;
+#ifdef __SSE2__
+	auto vcb_offset = _mm_set1_epi32(cb_offset);
+	auto vcr_offset = _mm_set1_epi32(cr_offset);
+	auto vmax = _mm_set1_epi32(max_value);
+	for (; i + 4 <= w; i += 4) {
+		Double4 dy(_mm_loadu_si128((const __m128i*) (y + i)));
+		Double4 dcb(
+				_mm_sub_epi32(_mm_loadu_si128((const __m128i*) (cb + i)),
+						vcb_offset));
+		Double4 dcr(
+				_mm_sub_epi32(_mm_loadu_si128((const __m128i*) (cr + i)),
+						vcr_offset));
+		auto r = (dy - dcb * 0.0000368 + dcr * 1.40199 + 0.5).trunc();
+		auto g = (dy * 1.0003 - dcb * 0.344125 - dcr * 0.7141128 + 0.5).trunc();
+		auto b = (dy * 0.999823 + dcb * 1.77204 - dcr * 0.000008 + 0.5).trunc();
+		_mm_storeu_si128((__m128i*) (y + i), clamp(r, vmax));
+		_mm_storeu_si128((__m128i*) (cb + i), clamp(g, vmax));
+		_mm_storeu_si128((__m128i*) (cr + i), clamp(b, vmax));
+	}
+#endif
+	for (; i < w; ++i) {
+		int32_t Y = y[i];
+		int32_t Cb = cb[i] - cb_offset;
+		int32_t Cr = cr[i] - cr_offset;
+
+		int32_t val = (int32_t) (Y - 0.0000368 * Cb
+				+ 1.40199 * Cr +  0.5);
+
+		if (val > max_value)
+			val = max_value;
+		else if (val < 0)
+			val = 0;
+		y[i] = val;
+
+		val = (int32_t) (1.0003 * Y - 0.344125 * Cb
+				- 0.7141128 * Cr + 0.5);
+
+		if (val > max_value)
+			val = max_value;
+		else if (val < 0)
+			val = 0;
+		cb[i] = val;
+
+		val = (int32_t) (0.999823 * Y + 1.77204 * Cb
+				- 0.000008 * Cr + 0.5);
+
+		if (val > max_value)
+			val = max_value;
+		else if (val < 0)
+			val = 0;
+		cr[i] = val;
+	}
+}
+
 // assuming unsigned data !
-bool color_esycc_to_rgb(grk_image *image) {
+bool color_esycc_to_rgb(grk_image *image, uint32_t numThreads) {
 	int32_t flip_value = (1 << (image->comps[0].prec - 1));
 	int32_t max_value = (1 << image->comps[0].prec) - 1;
 
@@ -938,53 +1033,20 @@ bool color_esycc_to_rgb(grk_image *image) {
 	uint32_t w = image->comps[0].w;
 	uint32_t h = image->comps[0].h;
 
-	bool sign1 = image->comps[1].sgnd;
-	bool sign2 = image->comps[2].sgnd;
-
-	uint32_t stride_diff = image->comps[0].stride - w;
-	size_t dest_index = 0;
-	for (uint32_t j = 0; j < h; ++j){
-		for (uint32_t i = 0; i < w; ++i){
-
-			int32_t y = image->comps[0].data[dest_index];
-			int32_t cb = image->comps[1].data[dest_index];
-			int32_t cr = image->comps[2].data[dest_index];
-
-			if (!sign1)
-				cb -= flip_value;
-			if (!sign2)
-				cr -= flip_value;
-
-			int32_t val = (int32_t) (y - 0.0000368 * cb
-					+ 1.40199 * cr +  0.5);
-
-			if (val > max_value)
-				val = max_value;
-			else if (val < 0)
-				val = 0;
-			image->comps[0].data[dest_index] = val;
-
-			val = (int32_t) (1.0003 * y - 0.344125 * cb
-					- 0.7141128 * cr + 0.5);
-
-			if (val > max_value)
-				val = max_value;
-			else if (val < 0)
-				val = 0;
-			image->comps[1].data[dest_index] = val;
-
-			val = (int32_t) (0.999823 * y + 1.77204 * cb
-					- 0.000008 * cr + 0.5);
-
-			if (val > max_value)
-				val = max_value;
-			else if (val < 0)
-				val = 0;
-			image->comps[2].data[dest_index] = val;
-			dest_index++;
-		}
-		dest_index += stride_diff;
-	}
+	int32_t cb_offset = image->comps[1].sgnd ? 0 : flip_value;
+	int32_t cr_offset = image->comps[2].sgnd ? 0 : flip_value;
+
+	auto comps = image->comps;
+	grk::process_strips(h, grk::num_strips(w, h, numThreads),
+			[&](uint32_t strip, uint32_t y0, uint32_t y1) {
+				(void) strip;
+				for (uint32_t j = y0; j < y1; ++j)
+					esycc_to_rgb_row(comps[0].data + (size_t) j * comps[0].stride,
+							comps[1].data + (size_t) j * comps[1].stride,
+							comps[2].data + (size_t) j * comps[2].stride, w,
+							cb_offset, cr_offset, max_value);
+				return true;
+			});
 	image->color_space = GRK_CLRSPC_SRGB;
 	return true;
 
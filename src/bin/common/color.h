@@ -21,11 +21,12 @@
 
 #pragma once
 
-extern bool color_sycc_to_rgb(grk_image *img);
+extern bool color_sycc_to_rgb(grk_image *img, uint32_t numThreads);
 #if defined(GROK_HAVE_LIBLCMS)
-extern bool color_cielab_to_rgb(grk_image *image);
-extern void color_apply_icc_profile(grk_image *image, bool forceRGB);
+extern bool color_cielab_to_rgb(grk_image *image, uint32_t numThreads);
+extern void color_apply_icc_profile(grk_image *image, bool forceRGB,
+		uint32_t numThreads);
 #endif
-extern bool color_cmyk_to_rgb(grk_image *image);
-extern bool color_esycc_to_rgb(grk_image *image);
+extern bool color_cmyk_to_rgb(grk_image *image, uint32_t numThreads);
+extern bool color_esycc_to_rgb(grk_image *image, uint32_t numThreads);
 
@@ -43,6 +43,8 @@
 #include <cstdlib>
 #include <cstring>
 #include <condition_variable>
+#include <thread>
+#include <vector>
 using namespace std::chrono_literals;
 
 #ifdef _MSC_VER
@@ -336,6 +338,47 @@ bool isSubsampled(grk_image *image) {
 	return false;
 }
 
+// minimum number of pixels in a strip processed by its own thread
+const uint64_t minPixelsPerStrip = 64 * 1024;
+
+uint32_t num_strips(uint32_t w, uint32_t h, uint32_t numThreads) {
+	if (!numThreads)
+		numThreads = std::thread::hardware_concurrency();
+	uint64_t maxStrips = ((uint64_t) w * h) / minPixelsPerStrip;
+	if (maxStrips < numThreads)
+		numThreads = (uint32_t) maxStrips;
+	if (numThreads > h)
+		numThreads = h;
+
+	return numThreads ? numThreads : 1;
+}
+
+bool process_strips(uint32_t h, uint32_t numStrips,
+		const std::function<bool(uint32_t strip, uint32_t y0, uint32_t y1)> &fn) {
+	if (numStrips <= 1)
+		return fn(0, 0, h);
+	std::vector<std::thread> threads;
+	std::vector<char> success(numStrips, 0);
+	uint32_t rows = (h + numStrips - 1) / numStrips;
+	for (uint32_t strip = 0; strip < numStrips; ++strip) {
+		uint32_t y0 = strip * rows;
+		uint32_t y1 = std::min<uint32_t>(y0 + rows, h);
+		if (y0 >= y1) {
+			success[strip] = 1;
+			continue;
+		}
+		threads.emplace_back([&fn, &success, strip, y0, y1] {
+			success[strip] = fn(strip, y0, y1) ? 1 : 0;
+		});
+	}
+	for (auto &t : threads)
+		t.join();
+
+	return std::all_of(success.begin(), success.end(), [](char s) {
+		return s != 0;
+	});
+}
+
 int population_count(uint32_t val)
 {
 #ifdef _MSC_VER
@@ -29,6 +29,7 @@
 #include <cassert>
 #include "grok.h"
 #include <algorithm>
+#include <functional>
 using namespace std;
 
 namespace grk {
@@ -84,6 +85,10 @@ char* actual_path(const char *outfile, bool *mem_allocated);
 template<typename T> inline T swap(T x) {
 	return (T) ((x >> 8) | ((x & 0x00ff) << 8));
 }
+// specialization for 16 bit signed: shift without sign extension
+template<> inline int16_t swap(int16_t x) {
+	return (int16_t) swap<uint16_t>((uint16_t) x);
+}
 // specialization for 32 bit unsigned
 template<> inline uint32_t swap(uint32_t x) {
 	return (uint32_t) ((x >> 24) | ((x & 0x00ff0000) >> 8)
@@ -175,6 +180,28 @@ uint32_t uint_adds(uint32_t a, uint32_t b);
 bool all_components_sanity_check(grk_image *image, bool equal_precision);
 bool isSubsampled(grk_image *  image);
 
+/**
+ * Number of strips that rows of an image are split into,
+ * one strip per thread
+ *
+ * @param w				image width
+ * @param h				image height
+ * @param numThreads	number of threads, or zero for hardware concurrency
+ */
+uint32_t num_strips(uint32_t w, uint32_t h, uint32_t numThreads);
+
+/**
+ * Split the rows of an image into strips and process them concurrently
+ *
+ * @param h				image height
+ * @param numStrips		number of strips, as returned by num_strips
+ * @param fn			processes rows [y0,y1) of strip number strip
+ *
+ * @return true if all strips were processed successfully
+ */
+bool process_strips(uint32_t h, uint32_t numStrips,
+		const std::function<bool(uint32_t strip, uint32_t y0, uint32_t y1)> &fn);
+
 int population_count(uint32_t val);
 int count_leading_zeros(uint32_t val);
 int count_trailing_zeros(uint32_t val);
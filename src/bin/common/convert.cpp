@@ -30,6 +30,15 @@
 #include "common.h"
 #include <algorithm>
 #include <limits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 /* Component clipping */
 void clip_component(grk_image_comp *component, uint32_t precision) {
@@ -147,6 +156,67 @@ template<> void interleavedToPlanar<1>(const int32_t *pSrc, int32_t *const*pDst,
 		size_t length){
 	memcpy(pDst[0], pSrc, length * sizeof(int32_t));
 }
+#ifdef __SSE2__
+/* 4x4 transpose of 32 bit lanes */
+static inline void transpose4(__m128i &v0, __m128i &v1, __m128i &v2,
+		__m128i &v3) {
+	auto t0 = _mm_unpacklo_epi32(v0, v1);
+	auto t1 = _mm_unpacklo_epi32(v2, v3);
+	auto t2 = _mm_unpackhi_epi32(v0, v1);
+	auto t3 = _mm_unpackhi_epi32(v2, v3);
+	v0 = _mm_unpacklo_epi64(t0, t1);
+	v1 = _mm_unpackhi_epi64(t0, t1);
+	v2 = _mm_unpacklo_epi64(t2, t3);
+	v3 = _mm_unpackhi_epi64(t2, t3);
+}
+/* shuffle 32 bit lanes of two vectors, as _mm_shuffle_ps does */
+#define SHUFFLE_EPI32(a, b, imm) _mm_castps_si128(_mm_shuffle_ps( \
+		_mm_castsi128_ps(a), _mm_castsi128_ps(b), imm))
+
+template<> void interleavedToPlanar<3>(const int32_t *pSrc, int32_t *const*pDst,
+		size_t length){
+	size_t i = 0;
+	for (; i + 4 <= length; i += 4) {
+		auto in0 = _mm_loadu_si128((const __m128i*) (pSrc + 3 * i));
+		auto in1 = _mm_loadu_si128((const __m128i*) (pSrc + 3 * i + 4));
+		auto in2 = _mm_loadu_si128((const __m128i*) (pSrc + 3 * i + 8));
+		/* in0 = r0 g0 b0 r1, in1 = g1 b1 r2 g2, in2 = b2 r3 g3 b3 */
+		auto r23 = SHUFFLE_EPI32(in1, in2, _MM_SHUFFLE(1, 1, 2, 2));
+		auto r = SHUFFLE_EPI32(in0, r23, _MM_SHUFFLE(2, 0, 3, 0));
+		auto g01 = SHUFFLE_EPI32(in0, in1, _MM_SHUFFLE(0, 0, 1, 1));
+		auto g23 = SHUFFLE_EPI32(in1, in2, _MM_SHUFFLE(2, 2, 3, 3));
+		auto g = SHUFFLE_EPI32(g01, g23, _MM_SHUFFLE(2, 0, 2, 0));
+		auto b01 = SHUFFLE_EPI32(in0, in1, _MM_SHUFFLE(1, 1, 2, 2));
+		auto b = SHUFFLE_EPI32(b01, in2, _MM_SHUFFLE(3, 0, 2, 0));
+		_mm_storeu_si128((__m128i*) (pDst[0] + i), r);
+		_mm_storeu_si128((__m128i*) (pDst[1] + i), g);
+		_mm_storeu_si128((__m128i*) (pDst[2] + i), b);
+	}
+	for (; i < length; i++) {
+		for (size_t j = 0; j < 3; ++j)
+			pDst[j][i] = pSrc[3 * i + j];
+	}
+}
+template<> void interleavedToPlanar<4>(const int32_t *pSrc, int32_t *const*pDst,
+		size_t length){
+	size_t i = 0;
+	for (; i + 4 <= length; i += 4) {
+		auto v0 = _mm_loadu_si128((const __m128i*) (pSrc + 4 * i));
+		auto v1 = _mm_loadu_si128((const __m128i*) (pSrc + 4 * i + 4));
+		auto v2 = _mm_loadu_si128((const __m128i*) (pSrc + 4 * i + 8));
+		auto v3 = _mm_loadu_si128((const __m128i*) (pSrc + 4 * i + 12));
+		transpose4(v0, v1, v2, v3);
+		_mm_storeu_si128((__m128i*) (pDst[0] + i), v0);
+		_mm_storeu_si128((__m128i*) (pDst[1] + i), v1);
+		_mm_storeu_si128((__m128i*) (pDst[2] + i), v2);
+		_mm_storeu_si128((__m128i*) (pDst[3] + i), v3);
+	}
+	for (; i < length; i++) {
+		for (size_t j = 0; j < 4; ++j)
+			pDst[j][i] = pSrc[4 * i + j];
+	}
+}
+#endif
 const cvtInterleavedToPlanar cvtInterleavedToPlanar_LUT[10] = {
 		nullptr,
 		interleavedToPlanar<1>,
@@ -168,6 +238,56 @@ template<size_t N> void planarToInterleaved(int32_t const *const*pSrc, int32_t *
 			pDst[N * i + j] = pSrc[j][i] + adjust;
 	}
 }
+#ifdef __SSE2__
+template<> void planarToInterleaved<3>(int32_t const *const*pSrc, int32_t *pDst,
+		size_t length, int32_t adjust){
+	size_t i = 0;
+	auto vadjust = _mm_set1_epi32(adjust);
+	for (; i + 4 <= length; i += 4) {
+		auto r = _mm_add_epi32(_mm_loadu_si128((const __m128i*) (pSrc[0] + i)), vadjust);
+		auto g = _mm_add_epi32(_mm_loadu_si128((const __m128i*) (pSrc[1] + i)), vadjust);
+		auto b = _mm_add_epi32(_mm_loadu_si128((const __m128i*) (pSrc[2] + i)), vadjust);
+		auto r1 = _mm_srli_si128(r, 4);
+		/* r0 g0 b0 r1 */
+		auto out0 = _mm_unpacklo_epi64(_mm_unpacklo_epi32(r, g),
+				_mm_unpacklo_epi32(b, r1));
+		/* g1 b1 r2 g2 */
+		auto out1 = _mm_unpacklo_epi64(
+				_mm_unpacklo_epi32(_mm_srli_si128(g, 4), _mm_srli_si128(b, 4)),
+				_mm_unpackhi_epi32(r, g));
+		/* b2 r3 g3 b3 */
+		auto out2 = SHUFFLE_EPI32(_mm_unpackhi_epi32(b, r1),
+				_mm_unpackhi_epi32(g, b), _MM_SHUFFLE(3, 2, 1, 0));
+		_mm_storeu_si128((__m128i*) (pDst + 3 * i), out0);
+		_mm_storeu_si128((__m128i*) (pDst + 3 * i + 4), out1);
+		_mm_storeu_si128((__m128i*) (pDst + 3 * i + 8), out2);
+	}
+	for (; i < length; i++) {
+		for (size_t j = 0; j < 3; ++j)
+			pDst[3 * i + j] = pSrc[j][i] + adjust;
+	}
+}
+template<> void planarToInterleaved<4>(int32_t const *const*pSrc, int32_t *pDst,
+		size_t length, int32_t adjust){
+	size_t i = 0;
+	auto vadjust = _mm_set1_epi32(adjust);
+	for (; i + 4 <= length; i += 4) {
+		auto v0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*) (pSrc[0] + i)), vadjust);
+		auto v1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*) (pSrc[1] + i)), vadjust);
+		auto v2 = _mm_add_epi32(_mm_loadu_si128((const __m128i*) (pSrc[2] + i)), vadjust);
+		auto v3 = _mm_add_epi32(_mm_loadu_si128((const __m128i*) (pSrc[3] + i)), vadjust);
+		transpose4(v0, v1, v2, v3);
+		_mm_storeu_si128((__m128i*) (pDst + 4 * i), v0);
+		_mm_storeu_si128((__m128i*) (pDst + 4 * i + 4), v1);
+		_mm_storeu_si128((__m128i*) (pDst + 4 * i + 8), v2);
+		_mm_storeu_si128((__m128i*) (pDst + 4 * i + 12), v3);
+	}
+	for (; i < length; i++) {
+		for (size_t j = 0; j < 4; ++j)
+			pDst[4 * i + j] = pSrc[j][i] + adjust;
+	}
+}
+#endif
 const cvtPlanarToInterleaved cvtPlanarToInterleaved_LUT[10] = {
 		nullptr,
 		planarToInterleaved<1>,
@@ -191,6 +311,37 @@ const cvtPlanarToInterleaved cvtPlanarToInterleaved_LUT[10] = {
  *
  */
 
+#ifdef __SSE2__
+/**
+ * Widen eight 16 bit samples to 32 bit, inverting the bits set in mask
+ */
+static inline void store_16u32s(__m128i v, __m128i mask, int32_t *pDst) {
+	v = _mm_xor_si128(v, mask);
+#ifdef __AVX2__
+	_mm256_storeu_si256((__m256i*) pDst, _mm256_cvtepu16_epi32(v));
+#else
+	auto zero = _mm_setzero_si128();
+	_mm_storeu_si128((__m128i*) pDst, _mm_unpacklo_epi16(v, zero));
+	_mm_storeu_si128((__m128i*) (pDst + 4), _mm_unpackhi_epi16(v, zero));
+#endif
+}
+/**
+ * Narrow eight 32 bit samples to their low 16 bits
+ */
+static inline __m128i load_32s16u(const int32_t *pSrc) {
+	auto v0 = _mm_loadu_si128((const __m128i*) pSrc);
+	auto v1 = _mm_loadu_si128((const __m128i*) (pSrc + 4));
+	/* sign extend the low 16 bits, so that the signed pack keeps them */
+	v0 = _mm_srai_epi32(_mm_slli_epi32(v0, 16), 16);
+	v1 = _mm_srai_epi32(_mm_slli_epi32(v1, 16), 16);
+	return _mm_packs_epi32(v0, v1);
+}
+/* swap bytes of 16 bit lanes */
+static inline __m128i swap_16u(__m128i v) {
+	return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+#endif
+
 /**
  * 1 bit unsigned to 32 bit
  */
@@ -320,7 +471,27 @@ static void convert_6u32s_C1R(const uint8_t *pSrc, int32_t *pDst, size_t length,
  */
 static void convert_8u32s_C1R(const uint8_t *pSrc, int32_t *pDst, size_t length,
 		bool invert) {
-	for (size_t i = 0; i < length; i++)
+	size_t i = 0;
+#if defined(__AVX2__)
+	auto mask = _mm256_set1_epi32(invert ? 0xFF : 0);
+	for (; i + 8 <= length; i += 8) {
+		auto v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (pSrc + i)));
+		_mm256_storeu_si256((__m256i*) (pDst + i), _mm256_xor_si256(v, mask));
+	}
+#elif defined(__SSE2__)
+	auto mask = _mm_set1_epi8(invert ? (char) 0xFF : 0);
+	auto zero = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 16) {
+		auto v = _mm_xor_si128(_mm_loadu_si128((const __m128i*) (pSrc + i)), mask);
+		auto lo = _mm_unpacklo_epi8(v, zero);
+		auto hi = _mm_unpackhi_epi8(v, zero);
+		_mm_storeu_si128((__m128i*) (pDst + i), _mm_unpacklo_epi16(lo, zero));
+		_mm_storeu_si128((__m128i*) (pDst + i + 4), _mm_unpackhi_epi16(lo, zero));
+		_mm_storeu_si128((__m128i*) (pDst + i + 8), _mm_unpacklo_epi16(hi, zero));
+		_mm_storeu_si128((__m128i*) (pDst + i + 12), _mm_unpackhi_epi16(hi, zero));
+	}
+#endif
+	for (; i < length; i++)
 		pDst[i] = INV(pSrc[i], 0xFF, invert);
 }
 
@@ -329,10 +500,16 @@ static void convert_8u32s_C1R(const uint8_t *pSrc, int32_t *pDst, size_t length,
  */
 void convert_16u32s_C1R(const uint8_t *pSrc, int32_t *pDst,
 		size_t length, bool invert) {
-	size_t i;
-	for (i = 0; i < length; i++) {
-		int32_t val0 = *pSrc++;
-		int32_t val1 = *pSrc++;
+	size_t i = 0;
+#ifdef __SSE2__
+	auto mask = _mm_set1_epi16(invert ? (short) 0xFFFF : 0);
+	for (; i + 8 <= length; i += 8)
+		store_16u32s(swap_16u(_mm_loadu_si128((const __m128i*) (pSrc + 2 * i))),
+				mask, pDst + i);
+#endif
+	for (; i < length; i++) {
+		int32_t val0 = pSrc[2 * i];
+		int32_t val1 = pSrc[2 * i + 1];
 		pDst[i] = INV(val0 << 8 | val1, 0xFFFF, invert);
 	}
 }
@@ -494,7 +671,22 @@ static void convert_32s6u_C1R(const int32_t *pSrc, uint8_t *pDst,
  */
 static void convert_32s8u_C1R(const int32_t *pSrc, uint8_t *pDst,
 		size_t length) {
-	for (size_t i = 0; i < length; ++i)
+	size_t i = 0;
+#ifdef __SSE2__
+	/* keep the low byte of each sample, as the scalar cast does,
+	 * so that the saturating packs below never saturate */
+	auto mask = _mm_set1_epi32(0xFF);
+	for (; i + 16 <= length; i += 16) {
+		auto v0 = _mm_and_si128(_mm_loadu_si128((const __m128i*) (pSrc + i)), mask);
+		auto v1 = _mm_and_si128(_mm_loadu_si128((const __m128i*) (pSrc + i + 4)), mask);
+		auto v2 = _mm_and_si128(_mm_loadu_si128((const __m128i*) (pSrc + i + 8)), mask);
+		auto v3 = _mm_and_si128(_mm_loadu_si128((const __m128i*) (pSrc + i + 12)), mask);
+		_mm_storeu_si128((__m128i*) (pDst + i),
+				_mm_packus_epi16(_mm_packs_epi32(v0, v1),
+						_mm_packs_epi32(v2, v3)));
+	}
+#endif
+	for (; i < length; ++i)
 		pDst[i] = (uint8_t) pSrc[i];
 }
 const cvtFrom32 cvtFrom32_LUT[9] = {
@@ -508,3 +700,1196 @@ const cvtFrom32 cvtFrom32_LUT[9] = {
 		nullptr,
 		convert_32s8u_C1R
 };
+
+/**
+ * convert 16 bpp to big endian 16 bit
+ */
+void convert_32s16u_C1R(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i = 0;
+#ifdef __SSE2__
+	for (; i + 8 <= length; i += 8)
+		_mm_storeu_si128((__m128i*) (pDst + 2 * i), swap_16u(load_32s16u(pSrc + i)));
+#endif
+	for (; i < length; i++) {
+		uint32_t val = (uint32_t) pSrc[i];
+		pDst[2 * i] = (uint8_t) (val >> 8);
+		pDst[2 * i + 1] = (uint8_t) val;
+	}
+}
+
+/*
+ * bit depth conversions for TIFF, which packs samples of any
+ * bit depth up to 16 into bytes, most significant bit first
+ */
+#define PUTBITS2(s, nb) \
+	trailing <<= remaining; \
+	trailing |= (uint32_t)((s) >> (nb - remaining)); \
+	*pDst++ = (uint8_t)trailing; \
+	trailing = (uint32_t)((s) & ((1U << (nb - remaining)) - 1U)); \
+	if (nb >= (remaining + 8)) { \
+		*pDst++ = (uint8_t)(trailing >> (nb - (remaining + 8))); \
+		trailing &= (uint32_t)((1U << (nb - (remaining + 8))) - 1U); \
+		remaining += 16 - nb; \
+	} else { \
+		remaining += 8 - nb; \
+	}
+
+#define PUTBITS(s, nb) \
+  if (nb >= remaining) { \
+		PUTBITS2(s, nb) \
+	} else { \
+		trailing <<= nb; \
+		trailing |= (uint32_t)(s); \
+		remaining -= nb; \
+	}
+#define FLUSHBITS() \
+	if (remaining != 8) { \
+		trailing <<= remaining; \
+		*pDst++ = (uint8_t)trailing; \
+	}
+
+#define GETBITS(dest, nb, mask, invert) { \
+	int needed = (nb); \
+	uint32_t dst = 0U; \
+	if (available == 0) { \
+		val = *pSrc++; \
+		available = 8; \
+	} \
+	while (needed > available) { \
+		dst = (dst << available) | (val & ((1U << available) - 1U)); \
+		needed -= available; \
+		val = *pSrc++; \
+		available = 8; \
+	} \
+	dst = (dst << needed) | ((val >> (available - needed)) & ((1U << needed) - 1U)); \
+	available -= needed; \
+	dest = INV((int32_t)dst, mask,invert); \
+}
+
+static void tif_32sto3u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i;
+
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = (uint32_t) pSrc[i + 1];
+		uint32_t src2 = (uint32_t) pSrc[i + 2];
+		uint32_t src3 = (uint32_t) pSrc[i + 3];
+		uint32_t src4 = (uint32_t) pSrc[i + 4];
+		uint32_t src5 = (uint32_t) pSrc[i + 5];
+		uint32_t src6 = (uint32_t) pSrc[i + 6];
+		uint32_t src7 = (uint32_t) pSrc[i + 7];
+
+		*pDst++ = (uint8_t) ((src0 << 5) | (src1 << 2) | (src2 >> 1));
+		*pDst++ = (uint8_t) ((src2 << 7) | (src3 << 4) | (src4 << 1)
+				| (src5 >> 2));
+		*pDst++ = (uint8_t) ((src5 << 6) | (src6 << 3) | (src7));
+	}
+
+	if (length & 7U) {
+		uint32_t trailing = 0U;
+		int remaining = 8U;
+		length &= 7U;
+		PUTBITS((uint32_t )pSrc[i + 0], 3)
+		if (length > 1U) {
+			PUTBITS((uint32_t )pSrc[i + 1], 3)
+			if (length > 2U) {
+				PUTBITS((uint32_t )pSrc[i + 2], 3)
+				if (length > 3U) {
+					PUTBITS((uint32_t )pSrc[i + 3], 3)
+					if (length > 4U) {
+						PUTBITS((uint32_t )pSrc[i + 4], 3)
+						if (length > 5U) {
+							PUTBITS((uint32_t )pSrc[i + 5], 3)
+							if (length > 6U) {
+								PUTBITS((uint32_t )pSrc[i + 6], 3)
+							}
+						}
+					}
+				}
+			}
+		}
+		FLUSHBITS()
+	}
+}
+
+static void tif_32sto5u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i;
+
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = (uint32_t) pSrc[i + 1];
+		uint32_t src2 = (uint32_t) pSrc[i + 2];
+		uint32_t src3 = (uint32_t) pSrc[i + 3];
+		uint32_t src4 = (uint32_t) pSrc[i + 4];
+		uint32_t src5 = (uint32_t) pSrc[i + 5];
+		uint32_t src6 = (uint32_t) pSrc[i + 6];
+		uint32_t src7 = (uint32_t) pSrc[i + 7];
+
+		*pDst++ = (uint8_t) ((src0 << 3) | (src1 >> 2));
+		*pDst++ = (uint8_t) ((src1 << 6) | (src2 << 1) | (src3 >> 4));
+		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 1));
+		*pDst++ = (uint8_t) ((src4 << 7) | (src5 << 2) | (src6 >> 3));
+		*pDst++ = (uint8_t) ((src6 << 5) | (src7));
+
+	}
+
+	if (length & 7U) {
+		uint32_t trailing = 0U;
+		int remaining = 8U;
+		length &= 7U;
+		PUTBITS((uint32_t )pSrc[i + 0], 5)
+		if (length > 1U) {
+			PUTBITS((uint32_t )pSrc[i + 1], 5)
+			if (length > 2U) {
+				PUTBITS((uint32_t )pSrc[i + 2], 5)
+				if (length > 3U) {
+					PUTBITS((uint32_t )pSrc[i + 3], 5)
+					if (length > 4U) {
+						PUTBITS((uint32_t )pSrc[i + 4], 5)
+						if (length > 5U) {
+							PUTBITS((uint32_t )pSrc[i + 5], 5)
+							if (length > 6U) {
+								PUTBITS((uint32_t )pSrc[i + 6], 5)
+							}
+						}
+					}
+				}
+			}
+		}
+		FLUSHBITS()
+	}
+}
+
+static void tif_32sto7u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i;
+
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = (uint32_t) pSrc[i + 1];
+		uint32_t src2 = (uint32_t) pSrc[i + 2];
+		uint32_t src3 = (uint32_t) pSrc[i + 3];
+		uint32_t src4 = (uint32_t) pSrc[i + 4];
+		uint32_t src5 = (uint32_t) pSrc[i + 5];
+		uint32_t src6 = (uint32_t) pSrc[i + 6];
+		uint32_t src7 = (uint32_t) pSrc[i + 7];
+
+		*pDst++ = (uint8_t) ((src0 << 1) | (src1 >> 6));
+		*pDst++ = (uint8_t) ((src1 << 2) | (src2 >> 5));
+		*pDst++ = (uint8_t) ((src2 << 3) | (src3 >> 4));
+		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 3));
+		*pDst++ = (uint8_t) ((src4 << 5) | (src5 >> 2));
+		*pDst++ = (uint8_t) ((src5 << 6) | (src6 >> 1));
+		*pDst++ = (uint8_t) ((src6 << 7) | (src7));
+	}
+
+	if (length & 7U) {
+		uint32_t trailing = 0U;
+		int remaining = 8U;
+		length &= 7U;
+		PUTBITS((uint32_t )pSrc[i + 0], 7)
+		if (length > 1U) {
+			PUTBITS((uint32_t )pSrc[i + 1], 7)
+			if (length > 2U) {
+				PUTBITS((uint32_t )pSrc[i + 2], 7)
+				if (length > 3U) {
+					PUTBITS((uint32_t )pSrc[i + 3], 7)
+					if (length > 4U) {
+						PUTBITS((uint32_t )pSrc[i + 4], 7)
+						if (length > 5U) {
+							PUTBITS((uint32_t )pSrc[i + 5], 7)
+							if (length > 6U) {
+								PUTBITS((uint32_t )pSrc[i + 6], 7)
+							}
+						}
+					}
+				}
+			}
+		}
+		FLUSHBITS()
+	}
+}
+
+static void tif_32sto9u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i;
+
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = (uint32_t) pSrc[i + 1];
+		uint32_t src2 = (uint32_t) pSrc[i + 2];
+		uint32_t src3 = (uint32_t) pSrc[i + 3];
+		uint32_t src4 = (uint32_t) pSrc[i + 4];
+		uint32_t src5 = (uint32_t) pSrc[i + 5];
+		uint32_t src6 = (uint32_t) pSrc[i + 6];
+		uint32_t src7 = (uint32_t) pSrc[i + 7];
+
+		*pDst++ = (uint8_t) ((src0 >> 1));
+		*pDst++ = (uint8_t) ((src0 << 7) | (src1 >> 2));
+		*pDst++ = (uint8_t) ((src1 << 6) | (src2 >> 3));
+		*pDst++ = (uint8_t) ((src2 << 5) | (src3 >> 4));
+		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 5));
+		*pDst++ = (uint8_t) ((src4 << 3) | (src5 >> 6));
+		*pDst++ = (uint8_t) ((src5 << 2) | (src6 >> 7));
+		*pDst++ = (uint8_t) ((src6 << 1) | (src7 >> 8));
+		*pDst++ = (uint8_t) (src7);
+	}
+
+	if (length & 7U) {
+		uint32_t trailing = 0U;
+		int remaining = 8U;
+		length &= 7U;
+		PUTBITS2((uint32_t )pSrc[i + 0], 9)
+		if (length > 1U) {
+			PUTBITS2((uint32_t )pSrc[i + 1], 9)
+			if (length > 2U) {
+				PUTBITS2((uint32_t )pSrc[i + 2], 9)
+				if (length > 3U) {
+					PUTBITS2((uint32_t )pSrc[i + 3], 9)
+					if (length > 4U) {
+						PUTBITS2((uint32_t )pSrc[i + 4], 9)
+						if (length > 5U) {
+							PUTBITS2((uint32_t )pSrc[i + 5], 9)
+							if (length > 6U) {
+								PUTBITS2((uint32_t )pSrc[i + 6], 9)
+							}
+						}
+					}
+				}
+			}
+		}
+		FLUSHBITS()
+	}
+}
+
+static void tif_32sto10u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i = 0;
+#ifdef __SSSE3__
+	/* pair samples into 20 bit values, then pairs of pairs into
+	 * 40 bit values, which are written big endian */
+	auto mask = _mm_set1_epi16(INV_MASK_10);
+	auto scale = _mm_setr_epi16(1 << 10, 1, 1 << 10, 1, 1 << 10, 1, 1 << 10, 1);
+	auto low = _mm_set1_epi64x(0xFFFFFFFF);
+	auto shuffle = _mm_setr_epi8(4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1,
+			-1, -1, -1);
+	for (; i + 8 <= length; i += 8) {
+		auto v = _mm_madd_epi16(_mm_and_si128(load_32s16u(pSrc + i), mask),
+				scale);
+		v = _mm_or_si128(_mm_slli_epi64(_mm_and_si128(v, low), 20),
+				_mm_srli_epi64(v, 32));
+		v = _mm_shuffle_epi8(v, shuffle);
+		_mm_storel_epi64((__m128i*) pDst, v);
+		auto tail = (uint16_t) _mm_extract_epi16(v, 4);
+		memcpy(pDst + 8, &tail, sizeof(tail));
+		pDst += 10;
+	}
+#endif
+	for (; i < (length & ~(size_t) 3U); i += 4U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = (uint32_t) pSrc[i + 1];
+		uint32_t src2 = (uint32_t) pSrc[i + 2];
+		uint32_t src3 = (uint32_t) pSrc[i + 3];
+
+		*pDst++ = (uint8_t) (src0 >> 2);
+		*pDst++ = (uint8_t) (((src0 & 0x3U) << 6) | (src1 >> 4));
+		*pDst++ = (uint8_t) (((src1 & 0xFU) << 4) | (src2 >> 6));
+		*pDst++ = (uint8_t) (((src2 & 0x3FU) << 2) | (src3 >> 8));
+		*pDst++ = (uint8_t) (src3);
+	}
+
+	if (length & 3U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = 0U;
+		uint32_t src2 = 0U;
+		length = length & 3U;
+
+		if (length > 1U) {
+			src1 = (uint32_t) pSrc[i + 1];
+			if (length > 2U) {
+				src2 = (uint32_t) pSrc[i + 2];
+			}
+		}
+		*pDst++ = (uint8_t) (src0 >> 2);
+		*pDst++ = (uint8_t) (((src0 & 0x3U) << 6) | (src1 >> 4));
+		if (length > 1U) {
+			*pDst++ = (uint8_t) (((src1 & 0xFU) << 4) | (src2 >> 6));
+			if (length > 2U) {
+				*pDst++ = (uint8_t) (((src2 & 0x3FU) << 2));
+			}
+		}
+	}
+}
+
+static void tif_32sto11u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i;
+
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = (uint32_t) pSrc[i + 1];
+		uint32_t src2 = (uint32_t) pSrc[i + 2];
+		uint32_t src3 = (uint32_t) pSrc[i + 3];
+		uint32_t src4 = (uint32_t) pSrc[i + 4];
+		uint32_t src5 = (uint32_t) pSrc[i + 5];
+		uint32_t src6 = (uint32_t) pSrc[i + 6];
+		uint32_t src7 = (uint32_t) pSrc[i + 7];
+
+		*pDst++ = (uint8_t) ((src0 >> 3));
+		*pDst++ = (uint8_t) ((src0 << 5) | (src1 >> 6));
+		*pDst++ = (uint8_t) ((src1 << 2) | (src2 >> 9));
+		*pDst++ = (uint8_t) ((src2 >> 1));
+		*pDst++ = (uint8_t) ((src2 << 7) | (src3 >> 4));
+		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 7));
+		*pDst++ = (uint8_t) ((src4 << 1) | (src5 >> 10));
+		*pDst++ = (uint8_t) ((src5 >> 2));
+		*pDst++ = (uint8_t) ((src5 << 6) | (src6 >> 5));
+		*pDst++ = (uint8_t) ((src6 << 3) | (src7 >> 8));
+		*pDst++ = (uint8_t) (src7);
+	}
+
+	if (length & 7U) {
+		uint32_t trailing = 0U;
+		int remaining = 8U;
+		length &= 7U;
+		PUTBITS2((uint32_t )pSrc[i + 0], 11)
+		if (length > 1U) {
+			PUTBITS2((uint32_t )pSrc[i + 1], 11)
+			if (length > 2U) {
+				PUTBITS2((uint32_t )pSrc[i + 2], 11)
+				if (length > 3U) {
+					PUTBITS2((uint32_t )pSrc[i + 3], 11)
+					if (length > 4U) {
+						PUTBITS2((uint32_t )pSrc[i + 4], 11)
+						if (length > 5U) {
+							PUTBITS2((uint32_t )pSrc[i + 5], 11)
+							if (length > 6U) {
+								PUTBITS2((uint32_t )pSrc[i + 6], 11)
+							}
+						}
+					}
+				}
+			}
+		}
+		FLUSHBITS()
+	}
+}
+static void tif_32sto12u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i = 0;
+#ifdef __SSSE3__
+	/* pair samples into 24 bit values, which are written big endian */
+	auto mask = _mm_set1_epi16(INV_MASK_12);
+	auto scale = _mm_setr_epi16(1 << 12, 1, 1 << 12, 1, 1 << 12, 1, 1 << 12, 1);
+	auto shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1,
+			-1, -1);
+	for (; i + 8 <= length; i += 8) {
+		auto v = _mm_madd_epi16(_mm_and_si128(load_32s16u(pSrc + i), mask),
+				scale);
+		v = _mm_shuffle_epi8(v, shuffle);
+		_mm_storel_epi64((__m128i*) pDst, v);
+		auto tail = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+		memcpy(pDst + 8, &tail, sizeof(tail));
+		pDst += 12;
+	}
+#endif
+	for (; i < (length & ~(size_t) 1U); i += 2U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = (uint32_t) pSrc[i + 1];
+
+		*pDst++ = (uint8_t) (src0 >> 4);
+		*pDst++ = (uint8_t) (((src0 & 0xFU) << 4) | (src1 >> 8));
+		*pDst++ = (uint8_t) (src1);
+	}
+
+	if (length & 1U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		*pDst++ = (uint8_t) (src0 >> 4);
+		*pDst++ = (uint8_t) (((src0 & 0xFU) << 4));
+	}
+}
+
+static void tif_32sto13u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i;
+
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = (uint32_t) pSrc[i + 1];
+		uint32_t src2 = (uint32_t) pSrc[i + 2];
+		uint32_t src3 = (uint32_t) pSrc[i + 3];
+		uint32_t src4 = (uint32_t) pSrc[i + 4];
+		uint32_t src5 = (uint32_t) pSrc[i + 5];
+		uint32_t src6 = (uint32_t) pSrc[i + 6];
+		uint32_t src7 = (uint32_t) pSrc[i + 7];
+
+		*pDst++ = (uint8_t) ((src0 >> 5));
+		*pDst++ = (uint8_t) ((src0 << 3) | (src1 >> 10));
+		*pDst++ = (uint8_t) ((src1 >> 2));
+		*pDst++ = (uint8_t) ((src1 << 6) | (src2 >> 7));
+		*pDst++ = (uint8_t) ((src2 << 1) | (src3 >> 12));
+		*pDst++ = (uint8_t) ((src3 >> 4));
+		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 9));
+		*pDst++ = (uint8_t) ((src4 >> 1));
+		*pDst++ = (uint8_t) ((src4 << 7) | (src5 >> 6));
+		*pDst++ = (uint8_t) ((src5 << 2) | (src6 >> 11));
+		*pDst++ = (uint8_t) ((src6 >> 3));
+		*pDst++ = (uint8_t) ((src6 << 5) | (src7 >> 8));
+		*pDst++ = (uint8_t) (src7);
+	}
+
+	if (length & 7U) {
+		uint32_t trailing = 0U;
+		int remaining = 8U;
+		length &= 7U;
+		PUTBITS2((uint32_t )pSrc[i + 0], 13)
+		if (length > 1U) {
+			PUTBITS2((uint32_t )pSrc[i + 1], 13)
+			if (length > 2U) {
+				PUTBITS2((uint32_t )pSrc[i + 2], 13)
+				if (length > 3U) {
+					PUTBITS2((uint32_t )pSrc[i + 3], 13)
+					if (length > 4U) {
+						PUTBITS2((uint32_t )pSrc[i + 4], 13)
+						if (length > 5U) {
+							PUTBITS2((uint32_t )pSrc[i + 5], 13)
+							if (length > 6U) {
+								PUTBITS2((uint32_t )pSrc[i + 6], 13)
+							}
+						}
+					}
+				}
+			}
+		}
+		FLUSHBITS()
+	}
+}
+
+static void tif_32sto14u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i;
+	for (i = 0; i < (length & ~(size_t) 3U); i += 4U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = (uint32_t) pSrc[i + 1];
+		uint32_t src2 = (uint32_t) pSrc[i + 2];
+		uint32_t src3 = (uint32_t) pSrc[i + 3];
+
+		*pDst++ = (uint8_t) (src0 >> 6);
+		*pDst++ = (uint8_t) (((src0 & 0x3FU) << 2) | (src1 >> 12));
+		*pDst++ = (uint8_t) (src1 >> 4);
+		*pDst++ = (uint8_t) (((src1 & 0xFU) << 4) | (src2 >> 10));
+		*pDst++ = (uint8_t) (src2 >> 2);
+		*pDst++ = (uint8_t) (((src2 & 0x3U) << 6) | (src3 >> 8));
+		*pDst++ = (uint8_t) (src3);
+	}
+
+	if (length & 3U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = 0U;
+		uint32_t src2 = 0U;
+		length = length & 3U;
+
+		if (length > 1U) {
+			src1 = (uint32_t) pSrc[i + 1];
+			if (length > 2U) {
+				src2 = (uint32_t) pSrc[i + 2];
+			}
+		}
+		*pDst++ = (uint8_t) (src0 >> 6);
+		*pDst++ = (uint8_t) (((src0 & 0x3FU) << 2) | (src1 >> 12));
+		if (length > 1U) {
+			*pDst++ = (uint8_t) (src1 >> 4);
+			*pDst++ = (uint8_t) (((src1 & 0xFU) << 4) | (src2 >> 10));
+			if (length > 2U) {
+				*pDst++ = (uint8_t) (src2 >> 2);
+				*pDst++ = (uint8_t) (((src2 & 0x3U) << 6));
+			}
+		}
+	}
+}
+
+static void tif_32sto15u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	size_t i;
+
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t src0 = (uint32_t) pSrc[i + 0];
+		uint32_t src1 = (uint32_t) pSrc[i + 1];
+		uint32_t src2 = (uint32_t) pSrc[i + 2];
+		uint32_t src3 = (uint32_t) pSrc[i + 3];
+		uint32_t src4 = (uint32_t) pSrc[i + 4];
+		uint32_t src5 = (uint32_t) pSrc[i + 5];
+		uint32_t src6 = (uint32_t) pSrc[i + 6];
+		uint32_t src7 = (uint32_t) pSrc[i + 7];
+
+		*pDst++ = (uint8_t) ((src0 >> 7));
+		*pDst++ = (uint8_t) ((src0 << 1) | (src1 >> 14));
+		*pDst++ = (uint8_t) ((src1 >> 6));
+		*pDst++ = (uint8_t) ((src1 << 2) | (src2 >> 13));
+		*pDst++ = (uint8_t) ((src2 >> 5));
+		*pDst++ = (uint8_t) ((src2 << 3) | (src3 >> 12));
+		*pDst++ = (uint8_t) ((src3 >> 4));
+		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 11));
+		*pDst++ = (uint8_t) ((src4 >> 3));
+		*pDst++ = (uint8_t) ((src4 << 5) | (src5 >> 10));
+		*pDst++ = (uint8_t) ((src5 >> 2));
+		*pDst++ = (uint8_t) ((src5 << 6) | (src6 >> 9));
+		*pDst++ = (uint8_t) ((src6 >> 1));
+		*pDst++ = (uint8_t) ((src6 << 7) | (src7 >> 8));
+		*pDst++ = (uint8_t) (src7);
+	}
+
+	if (length & 7U) {
+		uint32_t trailing = 0U;
+		int remaining = 8U;
+		length &= 7U;
+		PUTBITS2((uint32_t )pSrc[i + 0], 15)
+		if (length > 1U) {
+			PUTBITS2((uint32_t )pSrc[i + 1], 15)
+			if (length > 2U) {
+				PUTBITS2((uint32_t )pSrc[i + 2], 15)
+				if (length > 3U) {
+					PUTBITS2((uint32_t )pSrc[i + 3], 15)
+					if (length > 4U) {
+						PUTBITS2((uint32_t )pSrc[i + 4], 15)
+						if (length > 5U) {
+							PUTBITS2((uint32_t )pSrc[i + 5], 15)
+							if (length > 6U) {
+								PUTBITS2((uint32_t )pSrc[i + 6], 15)
+							}
+						}
+					}
+				}
+			}
+		}
+		FLUSHBITS()
+	}
+}
+
+static void tif_32sto16u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
+	auto dst = (uint16_t*) pDst;
+	size_t i = 0;
+#ifdef __SSE2__
+	for (; i + 8 <= length; i += 8)
+		_mm_storeu_si128((__m128i*) (dst + i), load_32s16u(pSrc + i));
+#endif
+	for (; i < length; ++i)
+		dst[i] = (uint16_t) pSrc[i];
+}
+
+static void tif_3uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	size_t i;
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		uint32_t val2 = *pSrc++;
+
+		pDst[i + 0] = INV((int32_t )((val0 >> 5)), INV_MASK_3, invert);
+		pDst[i + 1] = INV((int32_t )(((val0 & 0x1FU) >> 2)), INV_MASK_3,
+				invert);
+		pDst[i + 2] = INV((int32_t )(((val0 & 0x3U) << 1) | (val1 >> 7)),
+				INV_MASK_3, invert);
+		pDst[i + 3] = INV((int32_t )(((val1 & 0x7FU) >> 4)), INV_MASK_3,
+				invert);
+		pDst[i + 4] = INV((int32_t )(((val1 & 0xFU) >> 1)), INV_MASK_3, invert);
+		pDst[i + 5] = INV((int32_t )(((val1 & 0x1U) << 2) | (val2 >> 6)),
+				INV_MASK_3, invert);
+		pDst[i + 6] = INV((int32_t )(((val2 & 0x3FU) >> 3)), INV_MASK_3,
+				invert);
+		pDst[i + 7] = INV((int32_t )(((val2 & 0x7U))), INV_MASK_3, invert);
+
+	}
+	if (length & 7U) {
+		uint32_t val;
+		int available = 0;
+
+		length = length & 7U;
+
+		GETBITS(pDst[i + 0], 3, INV_MASK_3, invert)
+
+		if (length > 1U) {
+			GETBITS(pDst[i + 1], 3, INV_MASK_3, invert)
+			if (length > 2U) {
+				GETBITS(pDst[i + 2], 3, INV_MASK_3, invert)
+				if (length > 3U) {
+					GETBITS(pDst[i + 3], 3, INV_MASK_3, invert)
+					if (length > 4U) {
+						GETBITS(pDst[i + 4], 3, INV_MASK_3, invert)
+						if (length > 5U) {
+							GETBITS(pDst[i + 5], 3, INV_MASK_3, invert)
+							if (length > 6U) {
+								GETBITS(pDst[i + 6], 3, INV_MASK_3, invert)
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+static void tif_5uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	size_t i;
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		uint32_t val2 = *pSrc++;
+		uint32_t val3 = *pSrc++;
+		uint32_t val4 = *pSrc++;
+
+		pDst[i + 0] = INV((int32_t )((val0 >> 3)), INV_MASK_5, invert);
+		pDst[i + 1] = INV((int32_t )(((val0 & 0x7U) << 2) | (val1 >> 6)),
+				INV_MASK_5, invert);
+		pDst[i + 2] = INV((int32_t )(((val1 & 0x3FU) >> 1)), INV_MASK_5,
+				invert);
+		pDst[i + 3] = INV((int32_t )(((val1 & 0x1U) << 4) | (val2 >> 4)),
+				INV_MASK_5, invert);
+		pDst[i + 4] = INV((int32_t )(((val2 & 0xFU) << 1) | (val3 >> 7)),
+				INV_MASK_5, invert);
+		pDst[i + 5] = INV((int32_t )(((val3 & 0x7FU) >> 2)), INV_MASK_5,
+				invert);
+		pDst[i + 6] = INV((int32_t )(((val3 & 0x3U) << 3) | (val4 >> 5)),
+				INV_MASK_5, invert);
+		pDst[i + 7] = INV((int32_t )(((val4 & 0x1FU))), INV_MASK_5, invert);
+
+	}
+	if (length & 7U) {
+		uint32_t val;
+		int available = 0;
+
+		length = length & 7U;
+
+		GETBITS(pDst[i + 0], 5, INV_MASK_5, invert)
+
+		if (length > 1U) {
+			GETBITS(pDst[i + 1], 5, INV_MASK_5, invert)
+			if (length > 2U) {
+				GETBITS(pDst[i + 2], 5, INV_MASK_5, invert)
+				if (length > 3U) {
+					GETBITS(pDst[i + 3], 5, INV_MASK_5, invert)
+					if (length > 4U) {
+						GETBITS(pDst[i + 4], 5, INV_MASK_5, invert)
+						if (length > 5U) {
+							GETBITS(pDst[i + 5], 5, INV_MASK_5, invert)
+							if (length > 6U) {
+								GETBITS(pDst[i + 6], 5, INV_MASK_5, invert)
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+static void tif_7uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	size_t i;
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		uint32_t val2 = *pSrc++;
+		uint32_t val3 = *pSrc++;
+		uint32_t val4 = *pSrc++;
+		uint32_t val5 = *pSrc++;
+		uint32_t val6 = *pSrc++;
+
+		pDst[i + 0] = INV((int32_t )((val0 >> 1)), INV_MASK_7, invert);
+		pDst[i + 1] = INV((int32_t )(((val0 & 0x1U) << 6) | (val1 >> 2)),
+				INV_MASK_7, invert);
+		pDst[i + 2] = INV((int32_t )(((val1 & 0x3U) << 5) | (val2 >> 3)),
+				INV_MASK_7, invert);
+		pDst[i + 3] = INV((int32_t )(((val2 & 0x7U) << 4) | (val3 >> 4)),
+				INV_MASK_7, invert);
+		pDst[i + 4] = INV((int32_t )(((val3 & 0xFU) << 3) | (val4 >> 5)),
+				INV_MASK_7, invert);
+		pDst[i + 5] = INV((int32_t )(((val4 & 0x1FU) << 2) | (val5 >> 6)),
+				INV_MASK_7, invert);
+		pDst[i + 6] = INV((int32_t )(((val5 & 0x3FU) << 1) | (val6 >> 7)),
+				INV_MASK_7, invert);
+		pDst[i + 7] = INV((int32_t )(((val6 & 0x7FU))), INV_MASK_7, invert);
+
+	}
+	if (length & 7U) {
+		uint32_t val;
+		int available = 0;
+
+		length = length & 7U;
+
+		GETBITS(pDst[i + 0], 7, INV_MASK_7, invert)
+
+		if (length > 1U) {
+			GETBITS(pDst[i + 1], 7, INV_MASK_7, invert)
+			if (length > 2U) {
+				GETBITS(pDst[i + 2], 7, INV_MASK_7, invert)
+				if (length > 3U) {
+					GETBITS(pDst[i + 3], 7, INV_MASK_7, invert)
+					if (length > 4U) {
+						GETBITS(pDst[i + 4], 7, INV_MASK_7, invert)
+						if (length > 5U) {
+							GETBITS(pDst[i + 5], 7, INV_MASK_7, invert)
+							if (length > 6U) {
+								GETBITS(pDst[i + 6], 7, INV_MASK_7, invert)
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+static void tif_9uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	size_t i;
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		uint32_t val2 = *pSrc++;
+		uint32_t val3 = *pSrc++;
+		uint32_t val4 = *pSrc++;
+		uint32_t val5 = *pSrc++;
+		uint32_t val6 = *pSrc++;
+		uint32_t val7 = *pSrc++;
+		uint32_t val8 = *pSrc++;
+
+		pDst[i + 0] = INV((int32_t )((val0 << 1) | (val1 >> 7)), INV_MASK_9,
+				invert);
+		pDst[i + 1] = INV((int32_t )(((val1 & 0x7FU) << 2) | (val2 >> 6)),
+				INV_MASK_9, invert);
+		pDst[i + 2] = INV((int32_t )(((val2 & 0x3FU) << 3) | (val3 >> 5)),
+				INV_MASK_9, invert);
+		pDst[i + 3] = INV((int32_t )(((val3 & 0x1FU) << 4) | (val4 >> 4)),
+				INV_MASK_9, invert);
+		pDst[i + 4] = INV((int32_t )(((val4 & 0xFU) << 5) | (val5 >> 3)),
+				INV_MASK_9, invert);
+		pDst[i + 5] = INV((int32_t )(((val5 & 0x7U) << 6) | (val6 >> 2)),
+				INV_MASK_9, invert);
+		pDst[i + 6] = INV((int32_t )(((val6 & 0x3U) << 7) | (val7 >> 1)),
+				INV_MASK_9, invert);
+		pDst[i + 7] = INV((int32_t )(((val7 & 0x1U) << 8) | (val8)), INV_MASK_9,
+				invert);
+
+	}
+	if (length & 7U) {
+		uint32_t val;
+		int available = 0;
+
+		length = length & 7U;
+
+		GETBITS(pDst[i + 0], 9, INV_MASK_9, invert)
+
+		if (length > 1U) {
+			GETBITS(pDst[i + 1], 9, INV_MASK_9, invert)
+			if (length > 2U) {
+				GETBITS(pDst[i + 2], 9, INV_MASK_9, invert)
+				if (length > 3U) {
+					GETBITS(pDst[i + 3], 9, INV_MASK_9, invert)
+					if (length > 4U) {
+						GETBITS(pDst[i + 4], 9, INV_MASK_9, invert)
+						if (length > 5U) {
+							GETBITS(pDst[i + 5], 9, INV_MASK_9, invert)
+							if (length > 6U) {
+								GETBITS(pDst[i + 6], 9, INV_MASK_9, invert)
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+static void tif_10uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	size_t i = 0;
+#ifdef __SSSE3__
+	/* gather the two bytes holding each sample into a 16 bit lane,
+	 * then shift the sample to the top of the lane and back down */
+	auto shuffle = _mm_setr_epi8(1, 0, 2, 1, 3, 2, 4, 3, 6, 5, 7, 6, 8, 7, 9,
+			8);
+	auto scale = _mm_setr_epi16(1, 4, 16, 64, 1, 4, 16, 64);
+	auto mask = _mm_set1_epi16(invert ? INV_MASK_10 : 0);
+	/* 16 byte loads for 10 bytes of samples: stop short of the end */
+	for (; i + 13 <= length; i += 8) {
+		auto v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) pSrc),
+				shuffle);
+		store_16u32s(_mm_srli_epi16(_mm_mullo_epi16(v, scale), 6), mask,
+				pDst + i);
+		pSrc += 10;
+	}
+#endif
+	for (; i < (length & ~(size_t) 3U); i += 4U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		uint32_t val2 = *pSrc++;
+		uint32_t val3 = *pSrc++;
+		uint32_t val4 = *pSrc++;
+
+		pDst[i + 0] = INV((int32_t )((val0 << 2) | (val1 >> 6)), INV_MASK_10,
+				invert);
+		pDst[i + 1] = INV((int32_t )(((val1 & 0x3FU) << 4) | (val2 >> 4)),
+				INV_MASK_10, invert);
+		pDst[i + 2] = INV((int32_t )(((val2 & 0xFU) << 6) | (val3 >> 2)),
+				INV_MASK_10, invert);
+		pDst[i + 3] = INV((int32_t )(((val3 & 0x3U) << 8) | val4), INV_MASK_10,
+				invert);
+
+	}
+	if (length & 3U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		length = length & 3U;
+		pDst[i + 0] = INV((int32_t )((val0 << 2) | (val1 >> 6)), INV_MASK_10,
+				invert);
+
+		if (length > 1U) {
+			uint32_t val2 = *pSrc++;
+			pDst[i + 1] = INV((int32_t )(((val1 & 0x3FU) << 4) | (val2 >> 4)),
+					INV_MASK_10, invert);
+			if (length > 2U) {
+				uint32_t val3 = *pSrc++;
+				pDst[i + 2] = INV(
+						(int32_t )(((val2 & 0xFU) << 6) | (val3 >> 2)),
+						INV_MASK_10, invert);
+			}
+		}
+	}
+}
+
+static void tif_11uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	size_t i;
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		uint32_t val2 = *pSrc++;
+		uint32_t val3 = *pSrc++;
+		uint32_t val4 = *pSrc++;
+		uint32_t val5 = *pSrc++;
+		uint32_t val6 = *pSrc++;
+		uint32_t val7 = *pSrc++;
+		uint32_t val8 = *pSrc++;
+		uint32_t val9 = *pSrc++;
+		uint32_t val10 = *pSrc++;
+
+		pDst[i + 0] = INV((int32_t )((val0 << 3) | (val1 >> 5)), INV_MASK_11,
+				invert);
+		pDst[i + 1] = INV((int32_t )(((val1 & 0x1FU) << 6) | (val2 >> 2)),
+				INV_MASK_11, invert);
+		pDst[i + 2] = INV(
+				(int32_t )(((val2 & 0x3U) << 9) | (val3 << 1) | (val4 >> 7)),
+				INV_MASK_11, invert);
+		pDst[i + 3] = INV((int32_t )(((val4 & 0x7FU) << 4) | (val5 >> 4)),
+				INV_MASK_11, invert);
+		pDst[i + 4] = INV((int32_t )(((val5 & 0xFU) << 7) | (val6 >> 1)),
+				INV_MASK_11, invert);
+		pDst[i + 5] = INV(
+				(int32_t )(((val6 & 0x1U) << 10) | (val7 << 2) | (val8 >> 6)),
+				INV_MASK_11, invert);
+		pDst[i + 6] = INV((int32_t )(((val8 & 0x3FU) << 5) | (val9 >> 3)),
+				INV_MASK_11, invert);
+		pDst[i + 7] = INV((int32_t )(((val9 & 0x7U) << 8) | (val10)),
+				INV_MASK_11, invert);
+
+	}
+	if (length & 7U) {
+		uint32_t val;
+		int available = 0;
+
+		length = length & 7U;
+
+		GETBITS(pDst[i + 0], 11, INV_MASK_11, invert)
+
+		if (length > 1U) {
+			GETBITS(pDst[i + 1], 11, INV_MASK_11, invert)
+			if (length > 2U) {
+				GETBITS(pDst[i + 2], 11, INV_MASK_11, invert)
+				if (length > 3U) {
+					GETBITS(pDst[i + 3], 11, INV_MASK_11, invert)
+					if (length > 4U) {
+						GETBITS(pDst[i + 4], 11, INV_MASK_11, invert)
+						if (length > 5U) {
+							GETBITS(pDst[i + 5], 11, INV_MASK_11, invert)
+							if (length > 6U) {
+								GETBITS(pDst[i + 6], 11, INV_MASK_11, invert)
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+static void tif_12uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	size_t i = 0;
+#ifdef __SSSE3__
+	/* gather the two bytes holding each sample into a 16 bit lane,
+	 * then shift the sample to the top of the lane and back down */
+	auto shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11,
+			10);
+	auto scale = _mm_setr_epi16(1, 16, 1, 16, 1, 16, 1, 16);
+	auto mask = _mm_set1_epi16(invert ? INV_MASK_12 : 0);
+	/* 16 byte loads for 12 bytes of samples: stop short of the end */
+	for (; i + 11 <= length; i += 8) {
+		auto v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) pSrc),
+				shuffle);
+		store_16u32s(_mm_srli_epi16(_mm_mullo_epi16(v, scale), 4), mask,
+				pDst + i);
+		pSrc += 12;
+	}
+#endif
+	for (; i < (length & ~(size_t) 1U); i += 2U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		uint32_t val2 = *pSrc++;
+
+		pDst[i + 0] = INV((int32_t )((val0 << 4) | (val1 >> 4)), INV_MASK_12,
+				invert);
+		pDst[i + 1] = INV((int32_t )(((val1 & 0xFU) << 8) | val2), INV_MASK_12,
+				invert);
+	}
+	if (length & 1U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		pDst[i + 0] = INV((int32_t )((val0 << 4) | (val1 >> 4)), INV_MASK_12,
+				invert);
+	}
+}
+
+static void tif_13uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	size_t i;
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		uint32_t val2 = *pSrc++;
+		uint32_t val3 = *pSrc++;
+		uint32_t val4 = *pSrc++;
+		uint32_t val5 = *pSrc++;
+		uint32_t val6 = *pSrc++;
+		uint32_t val7 = *pSrc++;
+		uint32_t val8 = *pSrc++;
+		uint32_t val9 = *pSrc++;
+		uint32_t val10 = *pSrc++;
+		uint32_t val11 = *pSrc++;
+		uint32_t val12 = *pSrc++;
+
+		pDst[i + 0] = INV((int32_t )((val0 << 5) | (val1 >> 3)), INV_MASK_13,
+				invert);
+		pDst[i + 1] = INV(
+				(int32_t )(((val1 & 0x7U) << 10) | (val2 << 2) | (val3 >> 6)),
+				INV_MASK_13, invert);
+		pDst[i + 2] = INV((int32_t )(((val3 & 0x3FU) << 7) | (val4 >> 1)),
+				INV_MASK_13, invert);
+		pDst[i + 3] = INV(
+				(int32_t )(((val4 & 0x1U) << 12) | (val5 << 4) | (val6 >> 4)),
+				INV_MASK_13, invert);
+		pDst[i + 4] = INV(
+				(int32_t )(((val6 & 0xFU) << 9) | (val7 << 1) | (val8 >> 7)),
+				INV_MASK_13, invert);
+		pDst[i + 5] = INV((int32_t )(((val8 & 0x7FU) << 6) | (val9 >> 2)),
+				INV_MASK_13, invert);
+		pDst[i + 6] = INV(
+				(int32_t )(((val9 & 0x3U) << 11) | (val10 << 3) | (val11 >> 5)),
+				INV_MASK_13, invert);
+		pDst[i + 7] = INV((int32_t )(((val11 & 0x1FU) << 8) | (val12)),
+				INV_MASK_13, invert);
+
+	}
+	if (length & 7U) {
+		uint32_t val;
+		int available = 0;
+
+		length = length & 7U;
+
+		GETBITS(pDst[i + 0], 13, INV_MASK_13, invert)
+
+		if (length > 1U) {
+			GETBITS(pDst[i + 1], 13, INV_MASK_13, invert)
+			if (length > 2U) {
+				GETBITS(pDst[i + 2], 13, INV_MASK_13, invert)
+				if (length > 3U) {
+					GETBITS(pDst[i + 3], 13, INV_MASK_13, invert)
+					if (length > 4U) {
+						GETBITS(pDst[i + 4], 13, INV_MASK_13, invert)
+						if (length > 5U) {
+							GETBITS(pDst[i + 5], 13, INV_MASK_13, invert)
+							if (length > 6U) {
+								GETBITS(pDst[i + 6], 13, INV_MASK_13, invert)
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+static void tif_14uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	size_t i;
+	for (i = 0; i < (length & ~(size_t) 3U); i += 4U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		uint32_t val2 = *pSrc++;
+		uint32_t val3 = *pSrc++;
+		uint32_t val4 = *pSrc++;
+		uint32_t val5 = *pSrc++;
+		uint32_t val6 = *pSrc++;
+
+		pDst[i + 0] = INV((int32_t )((val0 << 6) | (val1 >> 2)), INV_MASK_14,
+				invert);
+		pDst[i + 1] = INV(
+				(int32_t )(((val1 & 0x3U) << 12) | (val2 << 4) | (val3 >> 4)),
+				INV_MASK_14, invert);
+		pDst[i + 2] = INV(
+				(int32_t )(((val3 & 0xFU) << 10) | (val4 << 2) | (val5 >> 6)),
+				INV_MASK_14, invert);
+		pDst[i + 3] = INV((int32_t )(((val5 & 0x3FU) << 8) | val6), INV_MASK_14,
+				invert);
+
+	}
+	if (length & 3U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		length = length & 3U;
+		pDst[i + 0] = INV((int32_t )((val0 << 6) | (val1 >> 2)), INV_MASK_14,
+				invert);
+
+		if (length > 1U) {
+			uint32_t val2 = *pSrc++;
+			uint32_t val3 = *pSrc++;
+			pDst[i + 1] =
+					INV(
+							(int32_t )(((val1 & 0x3U) << 12) | (val2 << 4)
+									| (val3 >> 4)), INV_MASK_14, invert);
+			if (length > 2U) {
+				uint32_t val4 = *pSrc++;
+				uint32_t val5 = *pSrc++;
+				pDst[i + 2] = INV(
+						(int32_t )(((val3 & 0xFU) << 10) | (val4 << 2)
+								| (val5 >> 6)), INV_MASK_14, invert);
+			}
+		}
+	}
+}
+
+static void tif_15uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	size_t i;
+	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
+		uint32_t val0 = *pSrc++;
+		uint32_t val1 = *pSrc++;
+		uint32_t val2 = *pSrc++;
+		uint32_t val3 = *pSrc++;
+		uint32_t val4 = *pSrc++;
+		uint32_t val5 = *pSrc++;
+		uint32_t val6 = *pSrc++;
+		uint32_t val7 = *pSrc++;
+		uint32_t val8 = *pSrc++;
+		uint32_t val9 = *pSrc++;
+		uint32_t val10 = *pSrc++;
+		uint32_t val11 = *pSrc++;
+		uint32_t val12 = *pSrc++;
+		uint32_t val13 = *pSrc++;
+		uint32_t val14 = *pSrc++;
+
+		pDst[i + 0] = INV((int32_t )((val0 << 7) | (val1 >> 1)), (1 << 15) - 1,
+				invert);
+		pDst[i + 1] = INV(
+				(int32_t )(((val1 & 0x1U) << 14) | (val2 << 6) | (val3 >> 2)),
+				INV_MASK_15, invert);
+		pDst[i + 2] = INV(
+				(int32_t )(((val3 & 0x3U) << 13) | (val4 << 5) | (val5 >> 3)),
+				INV_MASK_15, invert);
+		pDst[i + 3] = INV(
+				(int32_t )(((val5 & 0x7U) << 12) | (val6 << 4) | (val7 >> 4)),
+				INV_MASK_15, invert);
+		pDst[i + 4] = INV(
+				(int32_t )(((val7 & 0xFU) << 11) | (val8 << 3) | (val9 >> 5)),
+				INV_MASK_15, invert);
+		pDst[i + 5] =
+				INV(
+						(int32_t )(((val9 & 0x1FU) << 10) | (val10 << 2)
+								| (val11 >> 6)), INV_MASK_15, invert);
+		pDst[i + 6] =
+				INV(
+						(int32_t )(((val11 & 0x3FU) << 9) | (val12 << 1)
+								| (val13 >> 7)), INV_MASK_15, invert);
+		pDst[i + 7] = INV((int32_t )(((val13 & 0x7FU) << 8) | (val14)),
+				INV_MASK_15, invert);
+
+	}
+	if (length & 7U) {
+		uint32_t val;
+		int available = 0;
+
+		length = length & 7U;
+
+		GETBITS(pDst[i + 0], 15, INV_MASK_15, invert)
+
+		if (length > 1U) {
+			GETBITS(pDst[i + 1], 15, INV_MASK_15, invert)
+			if (length > 2U) {
+				GETBITS(pDst[i + 2], 15, INV_MASK_15, invert)
+				if (length > 3U) {
+					GETBITS(pDst[i + 3], 15, INV_MASK_15, invert)
+					if (length > 4U) {
+						GETBITS(pDst[i + 4], 15, INV_MASK_15, invert)
+						if (length > 5U) {
+							GETBITS(pDst[i + 5], 15, INV_MASK_15, invert)
+							if (length > 6U) {
+								GETBITS(pDst[i + 6], 15, INV_MASK_15, invert)
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+/* seems that libtiff decodes this to machine endianness */
+static void tif_16uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
+		bool invert) {
+	auto src = (const uint16_t*) pSrc;
+	size_t i = 0;
+#ifdef __SSE2__
+	auto mask = _mm_set1_epi16(invert ? (short) 0xFFFF : 0);
+	for (; i + 8 <= length; i += 8)
+		store_16u32s(_mm_loadu_si128((const __m128i*) (src + i)), mask, pDst + i);
+#endif
+	for (; i < length; i++)
+		pDst[i] = INV(src[i], 0xFFFF, invert);
+}
+const cvtTo32 cvtTifTo32_LUT[17] = {
+		nullptr,
+		convert_1u32s_C1R,
+		convert_2u32s_C1R,
+		tif_3uto32s,
+		convert_4u32s_C1R,
+		tif_5uto32s,
+		convert_6u32s_C1R,
+		tif_7uto32s,
+		convert_8u32s_C1R,
+		tif_9uto32s,
+		tif_10uto32s,
+		tif_11uto32s,
+		tif_12uto32s,
+		tif_13uto32s,
+		tif_14uto32s,
+		tif_15uto32s,
+		tif_16uto32s
+};
+const cvtFrom32 cvtTifFrom32_LUT[17] = {
+		nullptr,
+		convert_32s1u_C1R,
+		convert_32s2u_C1R,
+		tif_32sto3u,
+		convert_32s4u_C1R,
+		tif_32sto5u,
+		convert_32s6u_C1R,
+		tif_32sto7u,
+		convert_32s8u_C1R,
+		tif_32sto9u,
+		tif_32sto10u,
+		tif_32sto11u,
+		tif_32sto12u,
+		tif_32sto13u,
+		tif_32sto14u,
+		tif_32sto15u,
+		tif_32sto16u
+};
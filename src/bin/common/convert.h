@@ -54,6 +54,11 @@ typedef void(*cvtTo32)(const uint8_t* pSrc, int32_t* pDst, size_t length,bool in
 extern const cvtTo32 cvtTo32_LUT[9]; /* up to 8bpp */
 typedef void(*cvtFrom32)(const int32_t* pSrc, uint8_t* pDst, size_t length);
 extern const cvtFrom32 cvtFrom32_LUT[9]; /* up to 8bpp */
+/* TIFF bit depth conversions, up to 16bpp: 16 bit samples are
+ * in machine byte order, as libtiff decodes them */
+extern const cvtTo32 cvtTifTo32_LUT[17];
+extern const cvtFrom32 cvtTifFrom32_LUT[17];
+void convert_32s16u_C1R(const int32_t *pSrc, uint8_t *pDst, size_t length);
 
 void convert_16u32s_C1R(const uint8_t *pSrc, int32_t *pDst,
 		size_t length, bool invert);
@@ -1179,7 +1179,7 @@ bool BMPFormat::encode() {
 			goto cleanup;
 	}
 
-	if (!encodeStrip(0))
+	if (!encodeStripRGBX(0))
 		goto cleanup;
 
 	ret = 0;
@@ -1203,11 +1203,18 @@ bool BMPFormat::encodeHeader(grk_image *  image, const std::string &filename, ui
 	return encode();
 }
 
+/**
+ * BMP rows are stored bottom up, so the whole image
+ * is written by encodeHeader
+ */
 bool BMPFormat::encodeStrip(uint32_t rows){
-	return encodeStripRGBX(rows);
+	(void) rows;
+
+	return true;
 }
 
 bool BMPFormat::encodeStripRGBX(uint32_t rows){
+	(void) rows;
 	bool rc = false;
 	auto w = m_image->comps[0].w;
 	auto h = m_image->comps[0].h;
@@ -1288,8 +1295,11 @@ cleanup:
 }
 bool BMPFormat::encodeFinish(void){
 	delete[] m_destBuff;
+	m_destBuff = nullptr;
 	if (!m_writeToStdout && m_file) {
-		if (!grk::safe_fclose(m_file))
+		auto file = m_file;
+		m_file = nullptr;
+		if (!grk::safe_fclose(file))
 			return false;
 	}
 	return true;
@@ -28,4 +28,20 @@ public:
 	virtual bool encodeFinish(void) = 0;
 	virtual grk_image*  decode(const std::string &filename ,  grk_cparameters  *parameters)=0;
 
+	/**
+	 * Read image header for pull-based decoding, without reading any pixels.
+	 * The returned image has no component data; pixels are pulled one
+	 * tile at a time with decodeTile, in raster order.
+	 *
+	 * @return image header, or nullptr if the file can't be decoded this way
+	 */
+	virtual grk_image*  decodeHeader(const std::string &filename ,  grk_cparameters  *parameters)=0;
+
+	/**
+	 * Decode a region of the image into a buffer laid out for grk_compress_tile:
+	 * planar, one or two bytes per sample, depending on component precision.
+	 * Region is in component coordinates, relative to the image origin.
+	 */
+	virtual bool decodeTile(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint8_t *dest)=0;
+
 };
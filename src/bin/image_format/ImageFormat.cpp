@@ -27,3 +27,22 @@ uint32_t ImageFormat::maxY(uint32_t rows){
 	return std::min<uint32_t>(m_row_count + rows, m_image->comps[0].h);
 }
 
+
+grk_image* ImageFormat::decodeHeader(const std::string &filename,
+		grk_cparameters *parameters) {
+	(void) filename;
+	(void) parameters;
+
+	return nullptr;
+}
+
+bool ImageFormat::decodeTile(uint32_t x0, uint32_t y0, uint32_t x1,
+		uint32_t y1, uint8_t *dest) {
+	(void) x0;
+	(void) y0;
+	(void) x1;
+	(void) y1;
+	(void) dest;
+
+	return false;
+}
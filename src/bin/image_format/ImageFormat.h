@@ -23,6 +23,8 @@ class ImageFormat : public IImageFormat {
 public:
 	ImageFormat();
 	virtual ~ImageFormat() {}
+	grk_image*  decodeHeader(const std::string &filename ,  grk_cparameters  *parameters) override;
+	bool decodeTile(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint8_t *dest) override;
 protected:
 	grk_image *m_image;
 	std::string m_fileName;
@@ -31,6 +31,9 @@
 #include <cassert>
 #include "iccjpeg.h"
 #include "common.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 struct my_error_mgr {
 	struct jpeg_error_mgr pub; /* "public" fields */
@@ -54,7 +57,7 @@ METHODDEF(void) my_error_exit(j_common_ptr cinfo) {
 
 struct imageToJpegInfo {
 	imageToJpegInfo() :
-			outfile(nullptr), success(true), buffer(nullptr), buffer32s(
+			outfile(nullptr), success(true), buffer(nullptr), rows(
 					nullptr), color_space(JCS_UNKNOWN), writeToStdout(false), adjust(
 					0) {
 	}
@@ -62,21 +65,21 @@ struct imageToJpegInfo {
 	FILE *outfile;
 	bool success;
 	uint8_t *buffer;
-	int32_t *buffer32s;
+	JSAMPROW *rows;
 	J_COLOR_SPACE color_space;
 	bool writeToStdout;
 	int32_t adjust;
 };
 
 static int imagetojpeg(grk_image *image, const char *filename,
-		uint32_t compressionParam) {
+		uint32_t compressionParam, uint32_t numThreads) {
 	if (!image)
 		return 1;
 	imageToJpegInfo info;
 	info.writeToStdout = grk::useStdio(filename);
 	cvtPlanarToInterleaved cvtPxToCx = nullptr;
 	cvtFrom32 cvtTo8bpp = nullptr;
-	int32_t const *planes[3];
+	int32_t const *planes[4];
 	int32_t firstAlpha = -1;
 	size_t numAlphaChannels = 0;
 	uint32_t numcomps = image->numcomps;
@@ -88,9 +91,9 @@ static int imagetojpeg(grk_image *image, const char *filename,
 	// actual bits per sample
 	uint32_t prec = image->comps[0].prec;
 	uint32_t i = 0;
+	uint32_t bandRows = 0;
 
 	struct my_error_mgr jerr;
-	JSAMPROW row_pointer[1]; /* pointer to JSAMPLE row[s] */
 
 	/* Step 1: allocate and initialize JPEG compression object */
 
@@ -115,8 +118,10 @@ static int imagetojpeg(grk_image *image, const char *filename,
 	 * Note that this struct must live as long as the main JPEG parameter
 	 * struct, to avoid dangling-pointer problems.
 	 */
-	JDIMENSION image_width = image->x1 - image->x0; /* input image width */
-	JDIMENSION image_height = image->y1 - image->y0; /* input image height */
+	JDIMENSION image_width = image->comps[0].w; /* input image width */
+	JDIMENSION image_height = image->comps[0].h; /* input image height */
+	/* zero the object, so that it can be safely destroyed before creation */
+	memset(&cinfo, 0, sizeof(cinfo));
 
 	switch (image->color_space) {
 	case GRK_CLRSPC_SRGB: /**< sRGB */
@@ -226,8 +231,14 @@ static int imagetojpeg(grk_image *image, const char *filename,
 				" as last channels in image.");
 		numAlphaChannels = 0;
 	}
-	info.buffer = new uint8_t[width * numcomps];
-	info.buffer32s = new int32_t[width * numcomps];
+	// rows are packed in bands, each band split across the threads
+	bandRows = std::min<uint32_t>(image_height,
+			std::max<uint32_t>(numThreads ? numThreads :
+					std::thread::hardware_concurrency(), 1) * 16);
+	info.buffer = new uint8_t[(size_t) bandRows * width * numcomps];
+	info.rows = new JSAMPROW[bandRows];
+	for (i = 0; i < bandRows; ++i)
+		info.rows[i] = info.buffer + (size_t) i * width * numcomps;
 
 	/* We set up the normal JPEG error routines, then override error_exit. */
 	cinfo.err = jpeg_std_error(&jerr.pub);
@@ -312,23 +323,29 @@ static int imagetojpeg(grk_image *image, const char *filename,
 
 	/* Here we use the library's state variable cinfo.next_scanline as the
 	 * loop counter, so that we don't have to keep track ourselves.
-	 * To keep things simple, we pass one scanline per call; you can pass
-	 * more if you wish, though.
+	 * Each band of rows is packed concurrently, then passed to the
+	 * library in a single call.
 	 */
 
 	while (cinfo.next_scanline < cinfo.image_height) {
-		/* jpeg_write_scanlines expects an array of pointers to scanlines.
-		 * Here the array is only one element long, but you could pass
-		 * more than one scanline at a time if that's more convenient.
-		 */
-		cvtPxToCx(planes, info.buffer32s, (size_t) width, info.adjust);
-		cvtTo8bpp(info.buffer32s, (uint8_t*) info.buffer,
-				(size_t) width * numcomps);
-		row_pointer[0] = info.buffer;
-		planes[0] += stride;
-		planes[1] += stride;
-		planes[2] += stride;
-		(void) jpeg_write_scanlines(&cinfo, row_pointer, 1);
+		uint32_t y0 = cinfo.next_scanline;
+		uint32_t rows = std::min<uint32_t>(bandRows, image_height - y0);
+		grk::process_strips(rows, grk::num_strips(width, rows, numThreads),
+				[&](uint32_t strip, uint32_t s0, uint32_t s1) {
+					(void) strip;
+					std::vector<int32_t> buffer32s((size_t) width * numcomps);
+					for (uint32_t j = s0; j < s1; ++j) {
+						int32_t const *rowPlanes[4];
+						for (uint32_t c = 0; c < numcomps; ++c)
+							rowPlanes[c] = planes[c] + (size_t) (y0 + j) * stride;
+						cvtPxToCx(rowPlanes, buffer32s.data(), (size_t) width,
+								info.adjust);
+						cvtTo8bpp(buffer32s.data(), info.rows[j],
+								(size_t) width * numcomps);
+					}
+					return true;
+				});
+		(void) jpeg_write_scanlines(&cinfo, info.rows, rows);
 	}
 	/* Step 6: Finish compression */
 	jpeg_finish_compress(&cinfo);
@@ -340,7 +357,7 @@ static int imagetojpeg(grk_image *image, const char *filename,
 	jpeg_destroy_compress(&cinfo);
 
 	delete[] info.buffer;
-	delete[] info.buffer32s;
+	delete[] info.rows;
 	/* After finish_compress, we can close the output file. */
 	if (info.outfile && !info.writeToStdout) {
 		if (!grk::safe_fclose(info.outfile)) {
@@ -632,9 +649,16 @@ static grk_image* jpegtoimage(const char *filename,
 	return imageInfo.image;
 }/* jpegtoimage() */
 
+JPEGFormat::JPEGFormat() : JPEGFormat(0) {
+}
+
+JPEGFormat::JPEGFormat(uint32_t numThreads) : m_numThreads(numThreads) {
+}
+
 bool JPEGFormat::encodeHeader(grk_image *image, const std::string &filename,
 		uint32_t compressionParam) {
-	return imagetojpeg(image, filename.c_str(), compressionParam) ?
+	return imagetojpeg(image, filename.c_str(), compressionParam,
+			m_numThreads) ?
 			false : true;
 }
 bool JPEGFormat::encodeStrip(uint32_t rows){
@@ -20,8 +20,18 @@
 
 class JPEGFormat : public ImageFormat {
 public:
+	JPEGFormat();
+	/**
+	 * Create a JPEG format
+	 *
+	 * @param numThreads	number of threads used to pack rows,
+	 * 						or zero for the hardware concurrency
+	 */
+	explicit JPEGFormat(uint32_t numThreads);
 	bool encodeHeader(grk_image *  image, const std::string &filename, uint32_t compressionParam) override;
 	bool encodeStrip(uint32_t rows) override;
 	bool encodeFinish(void) override;
 	grk_image *  decode(const std::string &filename,  grk_cparameters  *parameters) override;
+private:
+	uint32_t m_numThreads;
 };
@@ -35,6 +35,10 @@
 #include <string>
 #include <cassert>
 #include <locale>
+#include <algorithm>
+#include <vector>
+#include <climits>
+#include <zlib.h>
 #include "common.h"
 
 #define PNG_MAGIC "\x89PNG\x0d\x0a\x1a\x0a"
@@ -368,16 +372,6 @@ user_error_fn(png_structp png_ptr, png_const_charp message)
     spdlog::error("libpng error: {}", message);
 }
 
-static void convert_32s16u_C1R(const int32_t *pSrc, uint8_t *pDst,
-		size_t length) {
-	size_t i;
-	for (i = 0; i < length; i++) {
-		uint32_t val = (uint32_t) pSrc[i];
-		*pDst++ = (uint8_t) (val >> 8);
-		*pDst++ = (uint8_t) val;
-	}
-}
-
 
 int PNGFormat::do_encode(const char *write_idf,
 		uint32_t compressionLevel) {
@@ -489,9 +483,9 @@ int PNGFormat::do_encode(const char *write_idf,
 	 * color_type == PNG_COLOR_TYPE_RGB_ALPHA) && bit_depth < 8
 	 *
 	 */
-	png_set_compression_level(png,
-			(int)((compressionLevel == GRK_DECOMPRESS_COMPRESSION_LEVEL_DEFAULT) ?
-					3 : compressionLevel));
+	m_compressionLevel = (int)((compressionLevel == GRK_DECOMPRESS_COMPRESSION_LEVEL_DEFAULT) ?
+					3 : compressionLevel);
+	png_set_compression_level(png, m_compressionLevel);
 
 	if (nr_comp >= 3) { /* RGB(A) */
 		color_type = PNG_COLOR_TYPE_RGB;
@@ -583,22 +577,10 @@ int PNGFormat::do_encode(const char *write_idf,
 			spdlog::error("Invalid PNG row size");
 			goto beach;
 		}
-		row_buf = (png_bytep) malloc(png_row_size);
-		if (row_buf == nullptr) {
-			spdlog::error("Can't allocate memory for PNG row");
-			goto beach;
-		}
-		row32s = (int32_t*) malloc(
-				(size_t) m_image->comps[0].w * (size_t) nr_comp
-						* sizeof(int32_t));
-		if (row32s == nullptr) {
-			spdlog::error("Can't allocate memory for interleaved 32s row");
-			goto beach;
-		}
+		m_rowBytes = png_row_size;
+		m_prevRow.assign(m_rowBytes, 0);
+		m_adler = adler32(0L, Z_NULL, 0);
 	}
-	for (uint32_t i = 0; i < nr_comp; ++i)
-		m_planes[i] = m_image->comps[i].data;
-
 
 	fails = false;
 
@@ -606,7 +588,11 @@ beach:
 	return fails;
 }
 
-PNGFormat::PNGFormat() : m_info(nullptr),
+PNGFormat::PNGFormat() : PNGFormat(0)
+{
+}
+
+PNGFormat::PNGFormat(uint32_t numThreads) : m_info(nullptr),
 						png(nullptr),
 						row_buf(nullptr),
 					row_buf_array(nullptr),
@@ -616,7 +602,11 @@ PNGFormat::PNGFormat() : m_info(nullptr),
 					fails(true),
 					prec(0),
 					nr_comp(0),
-					m_planes{nullptr}
+					m_planes{nullptr},
+					m_numThreads(numThreads),
+					m_compressionLevel(3),
+					m_rowBytes(0),
+					m_adler(0)
 {
 }
 
@@ -625,11 +615,120 @@ bool PNGFormat::encodeHeader(grk_image *img, const std::string &filename,
 	m_image = img;
 	return do_encode(filename.c_str(), compressionParam) ? false : true;
 }
+/**
+ * Sum of absolute values of a filtered row, read as signed bytes.
+ * libpng uses this to choose between filter types.
+ */
+static uint64_t png_filter_cost(const uint8_t *f, size_t len) {
+	uint64_t sum = 0;
+	for (size_t i = 0; i < len; ++i)
+		sum += f[i] < 128 ? f[i] : 256U - f[i];
+
+	return sum;
+}
+
+/**
+ * Filter a packed row with one of the four predicting PNG filter types
+ */
+static void png_filter(uint8_t type, const uint8_t *row, const uint8_t *prev,
+		size_t len, size_t bpp, uint8_t *f) {
+	size_t i = 0;
+	switch (type) {
+	case 1: /* Sub */
+		for (; i < bpp; ++i)
+			f[i] = row[i];
+		for (; i < len; ++i)
+			f[i] = (uint8_t) (row[i] - row[i - bpp]);
+		break;
+	case 2: /* Up */
+		for (; i < len; ++i)
+			f[i] = (uint8_t) (row[i] - prev[i]);
+		break;
+	case 3: /* Average */
+		for (; i < bpp; ++i)
+			f[i] = (uint8_t) (row[i] - (prev[i] >> 1));
+		for (; i < len; ++i)
+			f[i] = (uint8_t) (row[i] - ((row[i - bpp] + prev[i]) >> 1));
+		break;
+	default: /* Paeth */
+		for (; i < bpp; ++i)
+			f[i] = (uint8_t) (row[i] - prev[i]);
+		for (; i < len; ++i) {
+			int32_t a = row[i - bpp];
+			int32_t b = prev[i];
+			int32_t c = prev[i - bpp];
+			int32_t pa = abs(b - c);
+			int32_t pb = abs(a - c);
+			int32_t pc = abs(a + b - 2 * c);
+			int32_t pred = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+			f[i] = (uint8_t) (row[i] - pred);
+		}
+		break;
+	}
+}
+
+/**
+ * Filter a packed row. For bit depths of 8 and above, every filter type
+ * is tried and the one with the smallest cost is kept, as libpng does;
+ * otherwise, the row is left unfiltered.
+ *
+ * @param row			packed row
+ * @param prev			previous packed row, all zeros for the first row
+ * @param len			packed row length in bytes
+ * @param bpp			bytes per complete pixel, rounded up to 1
+ * @param allFilters	true to try every filter type
+ * @param out			receives the filter type byte and the filtered row
+ * @param scratch		scratch buffer of len + 1 bytes
+ */
+static void png_filter_row(const uint8_t *row, const uint8_t *prev,
+		size_t len, size_t bpp, bool allFilters, uint8_t *out,
+		uint8_t *scratch) {
+	out[0] = 0;
+	memcpy(out + 1, row, len);
+	if (!allFilters)
+		return;
+	uint64_t best = png_filter_cost(out + 1, len);
+	for (uint8_t type = 1; type <= 4; ++type) {
+		png_filter(type, row, prev, len, bpp, scratch + 1);
+		uint64_t cost = png_filter_cost(scratch + 1, len);
+		if (cost < best) {
+			best = cost;
+			scratch[0] = type;
+			std::swap_ranges(scratch, scratch + len + 1, out);
+		}
+	}
+}
+
+/**
+ * Two byte zlib stream header for a 32K window and a compression level
+ */
+static void png_zlib_header(int level, uint8_t *header) {
+	uint32_t flevel = level < 2 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3));
+	uint32_t val = (0x78U << 8) | (flevel << 6);
+	val += 31 - (val % 31);
+	header[0] = (uint8_t) (val >> 8);
+	header[1] = (uint8_t) val;
+}
+
+bool PNGFormat::writeIDAT(const uint8_t *data, size_t len) {
+	if (setjmp(png_jmpbuf(png)))
+		return false;
+	for (size_t offset = 0; offset < len; offset += PNG_UINT_31_MAX)
+		png_write_chunk(png, (png_const_bytep) "IDAT", data + offset,
+				std::min<size_t>(len - offset, PNG_UINT_31_MAX));
+
+	return true;
+}
+
+/**
+ * Rows are split into strips which are packed, filtered and deflated
+ * concurrently. Each strip is an independent raw deflate stream ending
+ * in a sync flush, so that the strips concatenate into a single zlib
+ * stream, whose checksum is combined from the checksums of the strips.
+ */
 bool PNGFormat::encodeStrip(uint32_t rows){
 	cvtPlanarToInterleaved cvtPxToCx = cvtPlanarToInterleaved_LUT[nr_comp];
 	cvtFrom32 cvt32sToPack = nullptr;
-	png_bytep row_buf_cpy = row_buf;
-	int32_t *buffer32s_cpy = row32s;
 
 	switch (prec) {
 	case 1:
@@ -647,20 +746,109 @@ bool PNGFormat::encodeStrip(uint32_t rows){
 		break;
 	}
 
+	uint32_t max = maxY(rows);
+	if (max <= m_row_count)
+		return true;
 	int32_t adjust = m_image->comps[0].sgnd ? 1 << (prec - 1) : 0;
 	size_t width = m_image->comps[0].w;
 	uint32_t stride = m_image->comps[0].stride;
-	uint32_t max = maxY(rows);
-	for (uint32_t y = m_row_count; y < max; ++y) {
-		cvtPxToCx(m_planes, buffer32s_cpy, width, adjust);
-		cvt32sToPack(buffer32s_cpy, row_buf_cpy, width * (size_t) nr_comp);
-		png_write_row(png, row_buf_cpy);
-		m_planes[0] += stride;
-		m_planes[1] += stride;
-		m_planes[2] += stride;
-		m_planes[3] += stride;
+	size_t bpp = std::max<size_t>((size_t) nr_comp * prec / 8, 1);
+	bool allFilters = prec >= 8;
+	uint32_t firstRow = m_row_count;
+	uint32_t numRows = max - firstRow;
+	auto pack = [&](uint32_t y, int32_t *buffer32s, uint8_t *dest) {
+		int32_t const *planes[4];
+		for (uint32_t c = 0; c < nr_comp; ++c)
+			planes[c] = m_image->comps[c].data + (size_t) y * stride;
+		cvtPxToCx(planes, buffer32s, width, adjust);
+		cvt32sToPack(buffer32s, dest, width * nr_comp);
+	};
+
+	auto numStrips = grk::num_strips((uint32_t) width, numRows, m_numThreads);
+	std::vector<std::vector<uint8_t>> deflated(numStrips);
+	std::vector<unsigned long> adlers(numStrips, adler32(0L, Z_NULL, 0));
+	std::vector<size_t> lengths(numStrips, 0);
+	bool rc = grk::process_strips(numRows, numStrips,
+			[&](uint32_t strip, uint32_t y0, uint32_t y1) {
+				std::vector<int32_t> buffer32s(width * nr_comp);
+				std::vector<uint8_t> rowBuf(2 * m_rowBytes);
+				std::vector<uint8_t> filtered(m_rowBytes + 1);
+				std::vector<uint8_t> scratch(m_rowBytes + 1);
+				auto prev = rowBuf.data();
+				auto cur = prev + m_rowBytes;
+				if (y0 == 0)
+					memcpy(prev, m_prevRow.data(), m_rowBytes);
+				else
+					pack(firstRow + y0 - 1, buffer32s.data(), prev);
+
+				z_stream zs;
+				memset(&zs, 0, sizeof(zs));
+				if (deflateInit2(&zs, m_compressionLevel, Z_DEFLATED, -15, 8,
+						allFilters ? Z_FILTERED : Z_DEFAULT_STRATEGY) != Z_OK)
+					return false;
+				auto &out = deflated[strip];
+				out.resize(deflateBound(&zs,
+								(uLong) ((m_rowBytes + 1) * (y1 - y0))) + 16);
+				zs.next_out = out.data();
+				zs.avail_out = (uInt) std::min<size_t>(out.size(), UINT_MAX);
+				auto compress = [&](const uint8_t *data, size_t len, int flush) {
+					zs.next_in = (Bytef*) data;
+					zs.avail_in = (uInt) len;
+					do {
+						if (zs.avail_out == 0) {
+							out.resize(out.size() * 2);
+							zs.next_out = out.data() + zs.total_out;
+							zs.avail_out = (uInt) std::min<size_t>(
+									out.size() - zs.total_out, UINT_MAX);
+						}
+						if (deflate(&zs, flush) == Z_STREAM_ERROR)
+							return false;
+					} while (zs.avail_in || zs.avail_out == 0);
+					return true;
+				};
+
+				bool success = true;
+				for (uint32_t y = y0; y < y1 && success; ++y) {
+					pack(firstRow + y, buffer32s.data(), cur);
+					png_filter_row(cur, prev, m_rowBytes, bpp, allFilters,
+							filtered.data(), scratch.data());
+					adlers[strip] = adler32(adlers[strip], filtered.data(),
+							(uInt) filtered.size());
+					success = compress(filtered.data(), filtered.size(),
+							Z_NO_FLUSH);
+					std::swap(prev, cur);
+				}
+				success = success && compress(nullptr, 0, Z_SYNC_FLUSH);
+				out.resize(zs.total_out);
+				deflateEnd(&zs);
+				lengths[strip] = (m_rowBytes + 1) * (y1 - y0);
+
+				return success;
+			});
+	if (!rc)
+		return false;
+
+	// keep the last row as the previous row for the next strip
+	std::vector<int32_t> buffer32s(width * nr_comp);
+	pack(max - 1, buffer32s.data(), m_prevRow.data());
+
+	if (firstRow == 0) {
+		uint8_t header[2];
+		png_zlib_header(m_compressionLevel, header);
+		if (!writeIDAT(header, sizeof(header)))
+			return false;
+	}
+	for (uint32_t strip = 0; strip < numStrips; ++strip) {
+		if (!lengths[strip])
+			continue;
+		m_adler = adler32_combine(m_adler, adlers[strip],
+				(z_off_t) lengths[strip]);
+		if (!writeIDAT(deflated[strip].data(), deflated[strip].size()))
+			return false;
+		// release memory as we go
+		std::vector<uint8_t>().swap(deflated[strip]);
 	}
-	m_row_count += rows;
+	m_row_count = max;
 
 	return true;
 }
@@ -673,7 +861,15 @@ bool PNGFormat::encodeFinish(void){
 		spdlog::warn("Full image was not written");
 
 	if (png) {
-		png_write_end(png, m_info);
+		if (m_row_count) {
+			// empty final deflate block, followed by zlib checksum
+			uint8_t trailer[6] = { 0x03, 0x00, (uint8_t) (m_adler >> 24),
+					(uint8_t) (m_adler >> 16), (uint8_t) (m_adler >> 8),
+					(uint8_t) m_adler };
+			png_write_chunk(png, (png_const_bytep) "IDAT", trailer,
+					sizeof(trailer));
+			png_write_chunk(png, (png_const_bytep) "IEND", nullptr, 0);
+		}
 		png_destroy_write_struct(&png, &m_info);
 	}
 	free(row_buf);
@@ -19,6 +19,7 @@
 #include "ImageFormat.h"
 #include <png.h>
 #include <string>
+#include <vector>
 
 
 void pngSetVerboseFlag(bool verbose);
@@ -26,6 +27,13 @@ void pngSetVerboseFlag(bool verbose);
 class PNGFormat : public ImageFormat {
 public:
 	PNGFormat();
+	/**
+	 * Create a PNG format
+	 *
+	 * @param numThreads	number of threads used to pack, filter and
+	 * 						deflate rows, or zero for the hardware concurrency
+	 */
+	explicit PNGFormat(uint32_t numThreads);
 	bool encodeHeader(grk_image *  m_image, const std::string &filename, uint32_t compressionParam) override;
 	bool encodeStrip(uint32_t rows) override;
 	bool encodeFinish(void) override;
@@ -34,6 +42,7 @@ public:
 private:
 	int do_encode(const char *write_idf,	uint32_t compressionLevel);
 	grk_image* do_decode(const char *read_idf, grk_cparameters *params);
+	bool writeIDAT(const uint8_t *data, size_t len);
 
 	png_infop m_info;
 	png_structp png;
@@ -46,5 +55,12 @@ private:
 	uint32_t prec;
 	uint32_t nr_comp;
 	int32_t const *m_planes[4];
+	uint32_t m_numThreads;
+	int m_compressionLevel;
+	size_t m_rowBytes;
+	/* last packed row of the previous strip, for the Up, Average and Paeth filters */
+	std::vector<uint8_t> m_prevRow;
+	/* Adler-32 checksum of all filtered rows written so far */
+	unsigned long m_adler;
 };
 
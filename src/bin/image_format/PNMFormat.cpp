@@ -519,344 +519,218 @@ static grk_image* pnmtoimage(const char *filename,
 	return image;
 }/* pnmtoimage() */
 
-static int imagetopnm(grk_image *image, const char *outfile, bool force_split) {
-	int *red = nullptr;
-	int *green = nullptr;
-	int *blue = nullptr;
-	int *alpha = nullptr;
-	uint32_t width, height,stride_diff, max;
-	uint32_t compno, ncomp, prec;
-	int adjustR, adjustG, adjustB, adjustA;
-	int two, want_gray, has_alpha, triple;
-	int v;
-	FILE *fdest = nullptr;
-	const char *tmp = outfile;
-	char *destname = nullptr;
-	int rc = 1;
-	bool writeToStdout = grk::useStdio(outfile);
-
-	alpha = nullptr;
-
-	if ((prec = image->comps[0].prec) > 16) {
+PNMFormat::PNMFormat(bool split) :
+		forceSplit(split),
+		m_writeToStdout(false),
+		m_interleaved(false),
+		m_hasAlpha(false),
+		m_numcomps(0) {
+}
+
+bool PNMFormat::encodeHeader(grk_image *image, const std::string &filename,
+		uint32_t compressionParam) {
+	(void) compressionParam;
+	m_image = image;
+	m_fileName = filename;
+	m_row_count = 0;
+	m_writeToStdout = grk::useStdio(filename.c_str());
+
+	uint32_t prec = image->comps[0].prec;
+	if (prec > 16) {
 		spdlog::error("{}:{}:imagetopnm\n\tprecision {} is larger than 16"
 				"\n\t: refused.", __FILE__, __LINE__, prec);
-		goto cleanup;
-	}
-	two = has_alpha = 0;
-	ncomp = image->numcomps;
-
-	if (!grk::all_components_sanity_check(image,true)) {
-		goto cleanup;
+		return false;
 	}
+	if (!grk::all_components_sanity_check(image,true))
+		return false;
 
-	while (*tmp)
-		++tmp;
-	tmp -= 2;
-	want_gray = (*tmp == 'g' || *tmp == 'G');
-
+	uint32_t ncomp = image->numcomps;
+	bool want_gray = filename.size() >= 2
+			&& (filename[filename.size() - 2] == 'g'
+					|| filename[filename.size() - 2] == 'G');
 	if (want_gray)
 		ncomp = 1;
 
-	if (writeToStdout){
-		if (force_split) {
-			spdlog::error("Unable to write split file to stdout");
-			goto cleanup;
-		}
+	if (m_writeToStdout && forceSplit) {
+		spdlog::error("Unable to write split file to stdout");
+		return false;
 	}
 
-	if ((!force_split)
+	m_interleaved = !forceSplit
 			&& (ncomp == 2 /* GRAYA */
 					|| (ncomp > 2 /* RGB, RGBA */
 					&& image->comps[0].dx == image->comps[1].dx
 							&& image->comps[1].dx == image->comps[2].dx
 							&& image->comps[0].dy == image->comps[1].dy
-							&& image->comps[1].dy == image->comps[2].dy
-					))) {
-
-		if (!grk::grk_open_for_output(&fdest, outfile,writeToStdout))
-			goto cleanup;
-
-		two = (prec > 8);
-		triple = (ncomp > 2);
-		width = image->comps[0].w;
-		stride_diff = image->comps[0].stride - width;
-		height = image->comps[0].h;
-		max = (1 << prec) - 1;
-		has_alpha = (ncomp == 4 || ncomp == 2);
-
-		red = image->comps[0].data;
-
-		if (triple) {
-			green = image->comps[1].data;
-			blue = image->comps[2].data;
-		} else
-			green = blue = nullptr;
-
-		if (has_alpha) {
-			const char *tt = (triple ? "RGB_ALPHA" : "GRAYSCALE_ALPHA");
+							&& image->comps[1].dy == image->comps[2].dy));
+	if (m_interleaved) {
+		m_hasAlpha = (ncomp == 4 || ncomp == 2);
+		m_channels.push_back(0);
+		if (ncomp > 2) {
+			m_channels.push_back(1);
+			m_channels.push_back(2);
+		}
+		if (m_hasAlpha)
+			m_channels.push_back(ncomp - 1);
+		FILE *fdest = nullptr;
+		if (!grk::grk_open_for_output(&fdest, filename.c_str(), m_writeToStdout))
+			return false;
+		m_files.push_back(fdest);
 
+		uint32_t width = image->comps[0].w;
+		uint32_t height = image->comps[0].h;
+		uint32_t max = (1 << prec) - 1;
+		if (m_hasAlpha) {
+			const char *tt = ((ncomp > 2) ? "RGB_ALPHA" : "GRAYSCALE_ALPHA");
 			fprintf(fdest, "P7\n# Grok-%s\nWIDTH %u\nHEIGHT %u\nDEPTH %u\n"
 					"MAXVAL %u\nTUPLTYPE %s\nENDHDR\n", grk_version(), width, height,
 					ncomp, max, tt);
-			alpha = image->comps[ncomp - 1].data;
-			adjustA = (
-					image->comps[ncomp - 1].sgnd ?
-							1 << (image->comps[ncomp - 1].prec - 1) : 0);
 		} else {
 			fprintf(fdest, "P6\n# Grok-%s\n%u %u\n%u\n", grk_version(), width, height,
 					max);
-			adjustA = 0;
-		}
-		adjustR = (image->comps[0].sgnd ? 1 << (image->comps[0].prec - 1) : 0);
-
-		if (triple) {
-			adjustG = (
-					image->comps[1].sgnd ? 1 << (image->comps[1].prec - 1) : 0);
-			adjustB = (
-					image->comps[2].sgnd ? 1 << (image->comps[2].prec - 1) : 0);
-		} else
-			adjustG = adjustB = 0;
-
-		if (two) {
-			const size_t bufSize = 4096;
-			uint16_t buf[bufSize];
-			uint16_t *outPtr = buf;
-			size_t outCount = 0;
-
-			for (uint32_t j = 0; j < height; ++j){
-				for (uint32_t i = 0; i < width; ++i){
-					v = *red++ + adjustR;
-					if (!grk::writeBytes<uint16_t>((uint16_t) v, buf, &outPtr,
-							&outCount, bufSize, true, fdest)) {
-						goto cleanup;
-					}
-					if (triple) {
-						v = *green++ + adjustG;
-						if (!grk::writeBytes<uint16_t>((uint16_t) v, buf, &outPtr,
-								&outCount, bufSize, true, fdest)) {
-							goto cleanup;
-						}
-						v = *blue++ + adjustB;
-						if (!grk::writeBytes<uint16_t>((uint16_t) v, buf, &outPtr,
-								&outCount, bufSize, true, fdest)) {
-							goto cleanup;
-						}
-					}/* if(triple) */
-
-					if (has_alpha) {
-						v = *alpha++ + adjustA;
-						if (!grk::writeBytes<uint16_t>((uint16_t) v, buf, &outPtr,
-								&outCount, bufSize, true, fdest)) {
-							goto cleanup;
-						}
-					}
-				}
-				red += stride_diff;
-				if (triple) {
-					green += stride_diff;
-					blue += stride_diff;
-				}
-				if (has_alpha)
-					alpha += stride_diff;
-			}
-			if (outCount) {
-				size_t res = fwrite(buf, sizeof(uint16_t), outCount, fdest);
-				if (res != outCount) {
-					goto cleanup;
-				}
-			}
-		} else {
-			const size_t bufSize = 4096;
-			uint8_t buf[bufSize];
-			uint8_t *outPtr = buf;
-			size_t outCount = 0;
-			for (uint32_t j = 0; j < height; ++j){
-				for (uint32_t i = 0; i < width; ++i){
-					v = *red++;
-					if (!grk::writeBytes<uint8_t>((uint8_t) v, buf, &outPtr,
-							&outCount, bufSize, true, fdest)) {
-						goto cleanup;
-					}
-					if (triple) {
-						v = *green++;
-						if (!grk::writeBytes<uint8_t>((uint8_t) v, buf, &outPtr,
-								&outCount, bufSize, true, fdest)) {
-							goto cleanup;
-						}
-						v = *blue++;
-						if (!grk::writeBytes<uint8_t>((uint8_t) v, buf, &outPtr,
-								&outCount, bufSize, true, fdest)) {
-							goto cleanup;
-						}
-					}
-					if (has_alpha) {
-						v = *alpha++;
-						if (!grk::writeBytes<uint8_t>((uint8_t) v, buf, &outPtr,
-								&outCount, bufSize, true, fdest)) {
-							goto cleanup;
-						}
-					}
-				}
-				red += stride_diff;
-				if (triple) {
-					green += stride_diff;
-					blue += stride_diff;
-				}
-				if (has_alpha)
-					alpha += stride_diff;
-			}
-			if (outCount) {
-				size_t res = fwrite(buf, sizeof(uint8_t), outCount, fdest);
-				if (res != outCount) {
-					goto cleanup;
-				}
-			}
-		}
-		if (writeToStdout) {
-			rc = 0;
-			goto cleanup;
 		}
+		return true;
 	}
 
-	if (writeToStdout)
-		ncomp = 1;
-
 	/* YUV or MONO: */
+	if (m_writeToStdout)
+		ncomp = 1;
 	if (image->numcomps > ncomp) {
 		spdlog::warn("[PGM file] Only the first component"
 					" is written out");
 	}
-	destname = (char*) malloc(strlen(outfile) + 8);
-	if (!destname) {
-		spdlog::error("imagetopnm: out of memory");
-		goto cleanup;
-	}
-
-	for (compno = 0; compno < ncomp; compno++) {
+	m_numcomps = ncomp;
+	for (uint32_t compno = 0; compno < ncomp; compno++) {
+		std::string destname = filename;
 		if (ncomp > 1) {
-			const size_t olen = strlen(outfile);
-			if (olen < 4) {
+			if (filename.size() < 4) {
 				spdlog::error(
 						" imagetopnm: output file name size less than 4.");
-				goto cleanup;
+				return false;
 			}
-			const size_t dotpos = olen - 4;
-
-			strncpy(destname, outfile, dotpos);
-			sprintf(destname + dotpos, "_%u.pgm", compno);
-		} else
-			sprintf(destname, "%s", outfile);
-
-		if (!fdest) {
-			if (!grk::grk_open_for_output(&fdest, destname,writeToStdout))
-				goto cleanup;
+			destname = filename.substr(0, filename.size() - 4) + "_"
+					+ std::to_string(compno) + ".pgm";
 		}
+		FILE *fdest = nullptr;
+		if (!grk::grk_open_for_output(&fdest, destname.c_str(), m_writeToStdout))
+			return false;
+		m_files.push_back(fdest);
 
-		width = image->comps[compno].w;
-		stride_diff = image->comps[compno].stride - width;
-		height = image->comps[compno].h;
-		prec = image->comps[compno].prec;
-		max = (1 << prec) - 1;
+		auto comp = image->comps + compno;
+		if (!comp->data)
+			return false;
+		fprintf(fdest, "P5\n#Grok-%s\n%u %u\n%u\n", grk_version(), comp->w,
+				comp->h, (1 << comp->prec) - 1);
+	}
+	m_rows_written.assign(ncomp, 0);
 
-		fprintf(fdest, "P5\n#Grok-%s\n%u %u\n%u\n", grk_version(), width, height, max);
+	return true;
+}
 
-		red = image->comps[compno].data;
-		if (!red) {
-			goto cleanup;
-		}
-		adjustR = (
-				image->comps[compno].sgnd ?
-						1 << (image->comps[compno].prec - 1) : 0);
-
-		if (prec > 8) {
-			const size_t bufSize = 4096;
-			uint16_t buf[bufSize];
-			uint16_t *outPtr = buf;
-			size_t outCount = 0;
-
-			for (uint32_t j = 0; j < height; ++j){
-				for (uint32_t i = 0; i < width; ++i){
-					v = *red++ + adjustR;
-					if (!grk::writeBytes<uint16_t>((uint16_t) v, buf, &outPtr,
-							&outCount, bufSize, true, fdest)) {
-						goto cleanup;
-					}
-					if (has_alpha) {
-						v = *alpha++;
-						if (!grk::writeBytes<uint16_t>((uint16_t) v, buf, &outPtr,
-								&outCount, bufSize, true, fdest)) {
-							goto cleanup;
-						}
-					}
-				}
-				red += stride_diff;
-				if (has_alpha)
-					alpha += stride_diff;
-			}
-			//flush
-			if (outCount) {
-				size_t res = fwrite(buf, sizeof(uint16_t), outCount, fdest);
-				if (res != outCount){
-					goto cleanup;
-				}
-			}
-		} else { /* prec <= 8 */
-			const size_t bufSize = 4096;
-			uint8_t buf[bufSize];
-			uint8_t *outPtr = buf;
-			size_t outCount = 0;
-			for (uint32_t j = 0; j < height; ++j){
-				for (uint32_t i = 0; i < width; ++i){
-					v = *red++ + adjustR;
-					if (!grk::writeBytes<uint8_t>((uint8_t) v, buf, &outPtr,
-							&outCount, bufSize, true, fdest)) {
-						goto cleanup;
-					}
-				}
-				red += stride_diff;
-				if (has_alpha)
-					alpha += stride_diff;
-			}
-			if (outCount) {
-				size_t res = fwrite(buf, sizeof(uint8_t), outCount, fdest);
-				if (res != outCount){
-					goto cleanup;
-				}
-			}
-		}
-		if (!writeToStdout && fdest) {
-			if (!grk::safe_fclose(fdest)){
-				goto cleanup;
-			}
+/**
+ * Write rows of interleaved samples: 16 bit samples are big endian
+ * and signed samples are shifted to unsigned, while 8 bit samples are
+ * written as is
+ */
+template<typename T> static bool write_interleaved(FILE *fdest, grk_image *image,
+		const std::vector<uint32_t> &channels, uint32_t y0, uint32_t y1,
+		std::vector<uint8_t> *row) {
+	uint32_t width = image->comps[0].w;
+	size_t ncomp = channels.size();
+	bool two = sizeof(T) == 2;
+	int32_t adjust[4] = { 0, 0, 0, 0 };
+	int32_t const *planes[4];
+	for (size_t k = 0; k < ncomp; ++k) {
+		auto comp = image->comps + channels[k];
+		if (two)
+			adjust[k] = comp->sgnd ? 1 << (comp->prec - 1) : 0;
+		planes[k] = comp->data + (size_t) y0 * comp->stride;
+	}
+	row->resize((size_t) width * ncomp * sizeof(T));
+	for (uint32_t j = y0; j < y1; ++j) {
+		auto out = (T*) row->data();
+		for (uint32_t i = 0; i < width; ++i) {
+			for (size_t k = 0; k < ncomp; ++k)
+				*out++ = grk::endian<T>((T) (planes[k][i] + adjust[k]), true);
 		}
-		fdest = nullptr;
-	} /* for (compno */
-
-	rc = 0;
-cleanup:
-	if (destname)
-		free(destname);
-	if (!writeToStdout && fdest) {
-		if (!grk::safe_fclose(fdest))
-			rc = 1;
+		if (fwrite(row->data(), 1, row->size(), fdest) != row->size())
+			return false;
+		for (size_t k = 0; k < ncomp; ++k)
+			planes[k] += image->comps[channels[k]].stride;
 	}
-	return rc;
-}/* imagetopnm() */
 
-bool PNMFormat::encodeHeader(grk_image *image, const std::string &filename,
-		uint32_t compressionParam) {
-	(void) compressionParam;
-	return imagetopnm(image, filename.c_str(), forceSplit) ? false : true;
+	return true;
 }
-bool PNMFormat::encodeStrip(uint32_t rows){
 
+/**
+ * Write rows of a single component, shifting signed samples to unsigned
+ */
+template<typename T> static bool write_plane(FILE *fdest, grk_image_comp *comp,
+		uint32_t y0, uint32_t y1, std::vector<uint8_t> *row) {
+	int32_t adjust = comp->sgnd ? 1 << (comp->prec - 1) : 0;
+	auto plane = comp->data + (size_t) y0 * comp->stride;
+	row->resize((size_t) comp->w * sizeof(T));
+	for (uint32_t j = y0; j < y1; ++j) {
+		auto out = (T*) row->data();
+		for (uint32_t i = 0; i < comp->w; ++i)
+			out[i] = grk::endian<T>((T) (plane[i] + adjust), true);
+		if (fwrite(row->data(), 1, row->size(), fdest) != row->size())
+			return false;
+		plane += comp->stride;
+	}
 
 	return true;
 }
-bool PNMFormat::encodeFinish(void){
+
+bool PNMFormat::encodeStrip(uint32_t rows){
+	uint32_t max = maxY(rows);
+	uint32_t height = m_image->comps[0].h;
+	if (m_interleaved) {
+		bool rc = m_image->comps[0].prec > 8 ?
+				write_interleaved<uint16_t>(m_files[0], m_image, m_channels,
+						m_row_count, max, &m_row) :
+				write_interleaved<uint8_t>(m_files[0], m_image, m_channels,
+						m_row_count, max, &m_row);
+		if (!rc)
+			return false;
+	} else {
+		for (uint32_t compno = 0; compno < m_numcomps; ++compno) {
+			auto comp = m_image->comps + compno;
+			// sub-sampled components advance in proportion to the first component
+			uint32_t compMax = (max == height) ?
+					comp->h : (uint32_t)(((uint64_t) max * comp->h) / height);
+			compMax = std::min<uint32_t>(compMax, comp->h);
+			uint32_t y0 = m_rows_written[compno];
+			if (compMax <= y0)
+				continue;
+			bool rc = comp->prec > 8 ?
+					write_plane<uint16_t>(m_files[compno], comp, y0, compMax,
+							&m_row) :
+					write_plane<uint8_t>(m_files[compno], comp, y0, compMax,
+							&m_row);
+			if (!rc)
+				return false;
+			m_rows_written[compno] = compMax;
+		}
+	}
+	m_row_count = max;
 
 	return true;
 }
+bool PNMFormat::encodeFinish(void){
+	bool rc = true;
+	if (m_row_count < m_image->comps[0].h) {
+		spdlog::warn("Full image was not written");
+		rc = false;
+	}
+	for (auto &f : m_files) {
+		if (!m_writeToStdout && f && !grk::safe_fclose(f))
+			rc = false;
+	}
+	m_files.clear();
+
+	return rc;
+}
 grk_image* PNMFormat::decode(const std::string &filename,
 		grk_cparameters *parameters) {
 	return pnmtoimage(filename.c_str(), parameters);
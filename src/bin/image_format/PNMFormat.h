@@ -17,16 +17,28 @@
 #pragma once
 
 #include "ImageFormat.h"
+#include <vector>
 
 class PNMFormat : public ImageFormat {
 public:
-	explicit PNMFormat(bool split) : forceSplit(split) {}
+	explicit PNMFormat(bool split);
 	bool encodeHeader(grk_image *  image, const std::string &filename, uint32_t compressionParam) override;
 	bool encodeStrip(uint32_t rows) override;
 	bool encodeFinish(void) override;
 	grk_image *  decode(const std::string &filename,  grk_cparameters  *parameters) override;
 private:
 	bool forceSplit;
+	bool m_writeToStdout;
+	/** interleaved PPM/PAM, otherwise one PGM file per component */
+	bool m_interleaved;
+	bool m_hasAlpha;
+	/** components interleaved in each pixel */
+	std::vector<uint32_t> m_channels;
+	/** number of PGM files */
+	uint32_t m_numcomps;
+	std::vector<FILE*> m_files;
+	std::vector<uint32_t> m_rows_written;
+	std::vector<uint8_t> m_row;
 
 };
 
@@ -21,69 +21,284 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include "grk_apps_config.h"
 #include "grok.h"
 #include "RAWFormat.h"
 #include "convert.h"
 #include "common.h"
 
+RAWFormat::RAWFormat(bool isBig) :
+		bigEndian(isBig),
+		m_writeToStdout(false),
+		m_numFrames(0),
+		m_frameLength(0),
+		m_layout(),
+		m_map(nullptr),
+		m_mapLength(0) {
+}
+
+RAWFormat::~RAWFormat() {
+#ifndef _WIN32
+	if (m_map)
+		munmap(m_map, m_mapLength);
+#endif
+	// file is only left open when frames are read from it
+	if (m_file && m_numFrames)
+		fclose(m_file);
+}
+
 bool RAWFormat::encodeHeader(grk_image *image, const std::string &filename,
 		uint32_t compressionParam) {
 	(void) compressionParam;
-	return imagetoraw(image, filename.c_str(), bigEndian) ? true : false;
+	m_image = image;
+	m_fileName = filename;
+	m_row_count = 0;
+	m_writeToStdout = grk::useStdio(filename.c_str());
+
+	if ((image->numcomps * image->x1 * image->y1) == 0) {
+		spdlog::error("imagetoraw: invalid raw image parameters");
+		return false;
+	}
+
+	unsigned int compno;
+	unsigned int numcomps = image->numcomps;
+	if (numcomps > 4) {
+		spdlog::warn("imagetoraw: number of components {} is "
+					"greater than 4. Truncating to 4", numcomps);
+		numcomps = 4;
+	}
+
+	for (compno = 1; compno < numcomps; ++compno) {
+		if (image->comps[0].dx != image->comps[compno].dx)
+			break;
+		if (image->comps[0].dy != image->comps[compno].dy)
+			break;
+		if (image->comps[0].prec != image->comps[compno].prec)
+			break;
+		if (image->comps[0].sgnd != image->comps[compno].sgnd)
+			break;
+	}
+	if (compno != numcomps) {
+		spdlog::error(
+				"imagetoraw: All components shall have the same subsampling, same bit depth, same sign.");
+		return false;
+	}
+
+	spdlog::info("imagetoraw: raw image characteristics: {} components",
+				image->numcomps);
+
+	// components are stored one after the other: record where each one starts
+	uint64_t offset = 0;
+	for (compno = 0; compno < image->numcomps; compno++) {
+		auto comp = image->comps + compno;
+		spdlog::info("Component {} characteristics: {}x{}x{} {}", compno,
+					comp->w, comp->h,
+					comp->prec,
+					comp->sgnd == 1 ? "signed" : "unsigned");
+
+		if (!comp->data) {
+			spdlog::error("imagetoraw: component {} is null.", compno);
+			return false;
+		}
+		if (comp->prec > 16) {
+			if (comp->prec <= 32)
+				spdlog::error(
+						"imagetoraw: more than 16 bits per component no handled yet");
+			else
+				spdlog::error("imagetoraw: invalid precision: {}",
+						comp->prec);
+			return false;
+		}
+		m_offsets.push_back(offset);
+		offset += (uint64_t) comp->w * comp->h * (comp->prec <= 8 ? 1 : 2);
+	}
+	m_rows_written.assign(image->numcomps, 0);
+
+	return grk::grk_open_for_output(&m_file, filename.c_str(), m_writeToStdout);
 }
-bool RAWFormat::encodeStrip(uint32_t rows){
 
+/**
+ * Write rows of a component, clipped to its range
+ */
+template<typename T> static bool write(FILE *rawFile, bool big_endian,
+		grk_image_comp *comp, uint32_t y0, uint32_t y1,
+		std::vector<uint8_t> *row) {
+	bool sgnd = comp->sgnd;
+	auto prec = comp->prec;
+	int32_t lower = sgnd ? -(1 << (prec - 1)) : 0;
+	int32_t upper = sgnd ? -lower - 1 : (1 << prec) - 1;
+	auto ptr = comp->data + (size_t) y0 * comp->stride;
+	row->resize((size_t) comp->w * sizeof(T));
+	for (uint32_t j = y0; j < y1; ++j) {
+		auto out = (T*) row->data();
+		for (uint32_t i = 0; i < comp->w; ++i) {
+			int32_t curr = ptr[i];
+			if (curr > upper)
+				curr = upper;
+			else if (curr < lower)
+				curr = lower;
+			out[i] = grk::endian<T>((T) curr, big_endian);
+		}
+		if (fwrite(row->data(), 1, row->size(), rawFile) != row->size())
+			return false;
+		ptr += comp->stride;
+	}
 
 	return true;
 }
-bool RAWFormat::encodeFinish(void){
+
+static bool seek(FILE *fp, uint64_t offset) {
+#ifdef _WIN32
+	return _fseeki64(fp, (int64_t) offset, SEEK_SET) == 0;
+#else
+	return fseeko(fp, (off_t) offset, SEEK_SET) == 0;
+#endif
+}
+
+bool RAWFormat::writeRows(uint32_t max) {
+	uint32_t height = m_image->comps[0].h;
+	for (uint32_t compno = 0; compno < m_image->numcomps; ++compno) {
+		auto comp = m_image->comps + compno;
+		uint32_t compMax = (max == height) ?
+				comp->h : std::min<uint32_t>(max, comp->h);
+		uint32_t y0 = m_rows_written[compno];
+		if (compMax <= y0)
+			continue;
+		size_t sampleSize = comp->prec <= 8 ? 1 : 2;
+		if (!m_writeToStdout
+				&& !seek(m_file,
+						m_offsets[compno]
+								+ (uint64_t) y0 * comp->w * sampleSize)) {
+			spdlog::error("imagetoraw: failed to seek in {}", m_fileName);
+			return false;
+		}
+		bool rc;
+		if (comp->prec <= 8) {
+			if (comp->sgnd)
+				rc = write<int8_t>(m_file, bigEndian, comp, y0, compMax, &m_row);
+			else
+				rc = write<uint8_t>(m_file, bigEndian, comp, y0, compMax, &m_row);
+		} else {
+			if (comp->sgnd)
+				rc = write<int16_t>(m_file, bigEndian, comp, y0, compMax, &m_row);
+			else
+				rc = write<uint16_t>(m_file, bigEndian, comp, y0, compMax, &m_row);
+		}
+		if (!rc) {
+			spdlog::error("imagetoraw: failed to write bytes for {}",
+					m_fileName);
+			return false;
+		}
+		m_rows_written[compno] = compMax;
+	}
 
 	return true;
 }
+
+bool RAWFormat::encodeStrip(uint32_t rows){
+	uint32_t max = maxY(rows);
+	// components are planar, so a stream that cannot seek
+	// is only written once all rows are available
+	if (!m_writeToStdout && !writeRows(max))
+		return false;
+	m_row_count = max;
+
+	return true;
+}
+bool RAWFormat::encodeFinish(void){
+	bool rc = true;
+	if (m_row_count < m_image->comps[0].h) {
+		spdlog::warn("Full image was not written");
+		rc = false;
+	} else if (m_writeToStdout) {
+		rc = writeRows(m_row_count);
+	}
+	if (!m_writeToStdout && m_file) {
+		if (!grk::safe_fclose(m_file))
+			rc = false;
+	}
+	m_file = nullptr;
+
+	return rc;
+}
 grk_image* RAWFormat::decode(const std::string &filename,
 		grk_cparameters *parameters) {
 	return rawtoimage(filename.c_str(), parameters, bigEndian);
 }
 
+/**
+ * Read rows of samples, de-interleaving them if there is more
+ * than one component
+ *
+ * @param ptrs		first row of each component
+ * @param stride	stride of component rows
+ */
+template<typename T> static bool read(FILE *rawFile, bool big_endian,
+		int32_t **ptrs, uint32_t numcomps, uint32_t stride, uint32_t w,
+		uint32_t h, std::vector<uint8_t> *row) {
+	size_t rowLen = (size_t) w * numcomps;
+	row->resize(rowLen * sizeof(T));
+	for (uint32_t j = 0; j < h; ++j) {
+		if (fread(row->data(), sizeof(T), rowLen, rawFile) != rowLen)
+			return false;
+		auto inPtr = (const T*) row->data();
+		for (uint32_t i = 0; i < w; ++i) {
+			for (uint32_t k = 0; k < numcomps; ++k)
+				ptrs[k][(size_t) j * stride + i] = grk::endian<T>(*inPtr++,
+						big_endian);
+		}
+	}
+
+	return true;
+}
+
 template<typename T> static bool read(FILE *rawFile, bool big_endian,
-		int32_t *ptr, uint64_t nloop) {
-	const size_t bufSize = 4096;
-	T buf[bufSize];
-
-	for (uint64_t i = 0; i < nloop; i += bufSize) {
-		size_t target = (i + bufSize > nloop) ? (nloop - i) : bufSize;
-		size_t ct = fread(buf, sizeof(T), target, rawFile);
-		if (ct != target)
+		grk_image *image, bool interleaved, std::vector<uint8_t> *row) {
+	if (interleaved) {
+		std::vector<int32_t*> ptrs;
+		for (uint32_t compno = 0; compno < image->numcomps; compno++)
+			ptrs.push_back(image->comps[compno].data);
+		auto comp = image->comps;
+		return read<T>(rawFile, big_endian, ptrs.data(), image->numcomps,
+				comp->stride, comp->w, comp->h, row);
+	}
+	for (uint32_t compno = 0; compno < image->numcomps; compno++) {
+		auto comp = image->comps + compno;
+		if (!read<T>(rawFile, big_endian, &comp->data, 1, comp->stride, comp->w,
+				comp->h, row))
 			return false;
-		T *inPtr = buf;
-		for (size_t j = 0; j < ct; j++)
-			*(ptr++) = grk::endian<T>(*inPtr++, big_endian);
 	}
 
 	return true;
 }
 
-grk_image* RAWFormat::rawtoimage(const char *filename,
-		grk_cparameters *parameters, bool big_endian) {
-	bool readFromStdin = grk::useStdio(filename);
+static uint32_t ceildiv(uint32_t a, uint32_t b) {
+	return (uint32_t) (((uint64_t) a + b - 1) / b);
+}
+
+grk_image* RAWFormat::createImage(grk_cparameters *parameters,
+		bool allocData) {
 	grk_raw_cparameters *raw_cp = &parameters->raw_cp;
 	uint32_t subsampling_dx = parameters->subsampling_dx;
 	uint32_t subsampling_dy = parameters->subsampling_dy;
 
-	FILE *f = nullptr;
-	uint32_t i, compno, numcomps, w, h;
+	uint32_t i, numcomps, w, h;
+	uint32_t x0, y0, x1, y1;
 	GRK_COLOR_SPACE color_space;
-	grk_image_cmptparm *cmptparm;
 	grk_image *image = nullptr;
-	unsigned short ch;
-	bool success = true;
 
 	if (!(raw_cp->width && raw_cp->height && raw_cp->numcomps && raw_cp->prec)) {
 		spdlog::error("invalid raw image parameters");
 		spdlog::error("Please use the Format option -F:");
 		spdlog::error(
-				"-F <width>,<height>,<ncomp>,<bitdepth>,{s,u}@<dx1>x<dy1>:...:<dxn>x<dyn>");
+				"-F <width>,<height>,<ncomp>,<bitdepth>,{s,u}[,{p,i}]@<dx1>x<dy1>:...:<dxn>x<dyn>");
 		spdlog::error(
 				"If subsampling is omitted, 1x1 is assumed for all components");
 		spdlog::error(
@@ -91,18 +306,10 @@ grk_image* RAWFormat::rawtoimage(const char *filename,
 		spdlog::error("         for raw 512x512 image with 4:2:0 subsampling");
 		return nullptr;
 	}
-
-	if (readFromStdin) {
-		if (!grk::grok_set_binary_mode(stdin))
-			return nullptr;
-		f = stdin;
-	} else {
-		f = fopen(filename, "rb");
-		if (!f) {
-			spdlog::error("Failed to open {} for reading", filename);
-			success = false;
-			goto cleanup;
-		}
+	if (raw_cp->prec > 16) {
+		spdlog::error(
+				"Grok cannot encode raw components with bit depth higher than 16 bits.");
+		return nullptr;
 	}
 	numcomps = raw_cp->numcomps;
 	if (numcomps == 1) {
@@ -116,81 +323,87 @@ grk_image* RAWFormat::rawtoimage(const char *filename,
 	}
 	w = raw_cp->width;
 	h = raw_cp->height;
-	cmptparm = (grk_image_cmptparm*) calloc(numcomps,
-			sizeof(grk_image_cmptparm));
-	if (!cmptparm) {
-		spdlog::error("Failed to allocate image components parameters");
-		success = false;
-		goto cleanup;
-	}
+	x0 = parameters->image_offset_x0;
+	y0 = parameters->image_offset_y0;
+	x1 = x0 + (w - 1) * subsampling_dx + 1;
+	y1 = y0 + (h - 1) * subsampling_dy + 1;
+	std::vector<grk_image_cmptparm> cmptparm(numcomps);
 	/* initialize image components */
 	for (i = 0; i < numcomps; i++) {
+		auto comp = raw_cp->comps + i;
 		cmptparm[i].prec = raw_cp->prec;
 		cmptparm[i].sgnd = raw_cp->sgnd;
-		cmptparm[i].dx = subsampling_dx * raw_cp->comps[i].dx;
-		cmptparm[i].dy = subsampling_dy * raw_cp->comps[i].dy;
+		cmptparm[i].dx = subsampling_dx * comp->dx;
+		cmptparm[i].dy = subsampling_dy * comp->dy;
 		cmptparm[i].w = w;
 		cmptparm[i].h = h;
-
-		if (raw_cp->comps[i].dx * raw_cp->comps[i].dy != 1){
-			spdlog::error("Subsampled raw images are not currently supported");
-			success = false;
-			goto cleanup;
+		// sub-sampled components cover the image at their own resolution
+		if (comp->dx != 1)
+			cmptparm[i].w = ceildiv(x1, cmptparm[i].dx)
+					- ceildiv(x0, cmptparm[i].dx);
+		if (comp->dy != 1)
+			cmptparm[i].h = ceildiv(y1, cmptparm[i].dy)
+					- ceildiv(y0, cmptparm[i].dy);
+		if (raw_cp->interleaved && comp->dx * comp->dy != 1) {
+			spdlog::error("Interleaved raw components must not be sub-sampled");
+			return nullptr;
 		}
 	}
 	/* create the image */
-	image = grk_image_create(numcomps, &cmptparm[0], color_space,true);
-	free(cmptparm);
-	if (!image) {
-		success = false;
-		goto cleanup;
-	}
+	image = grk_image_create(numcomps, cmptparm.data(), color_space, allocData);
+	if (!image)
+		return nullptr;
 	/* set image offset and reference grid */
-	image->x0 = parameters->image_offset_x0;
-	image->y0 = parameters->image_offset_y0;
-	image->x1 = parameters->image_offset_x0 + (w - 1) * subsampling_dx + 1;
-	image->y1 = parameters->image_offset_y0 + (h - 1) * subsampling_dy + 1;
+	image->x0 = x0;
+	image->y0 = y0;
+	image->x1 = x1;
+	image->y1 = y1;
 
-	if (raw_cp->prec <= 8) {
-		for (compno = 0; compno < numcomps; compno++) {
-			int32_t *ptr = image->comps[compno].data;
-			for (uint32_t j = 0; j < h; ++j){
-				bool rc;
-				if (raw_cp->sgnd)
-					rc = read<int8_t>(f, big_endian, ptr, w);
-				else
-					rc = read<uint8_t>(f, big_endian, ptr, w);
-				if (!rc) {
-					spdlog::error(
-							"Error reading raw file. End of file probably reached.");
-					success = false;
-					goto cleanup;
-				}
-				ptr += image->comps[compno].stride ;
-
-			}
+	return image;
+}
+
+grk_image* RAWFormat::rawtoimage(const char *filename,
+		grk_cparameters *parameters, bool big_endian) {
+	bool readFromStdin = grk::useStdio(filename);
+	grk_raw_cparameters *raw_cp = &parameters->raw_cp;
+
+	FILE *f = nullptr;
+	grk_image *image = nullptr;
+	unsigned short ch;
+	bool success = true;
+	bool rc;
+
+	image = createImage(parameters, true);
+	if (!image)
+		return nullptr;
+	if (readFromStdin) {
+		if (!grk::grok_set_binary_mode(stdin)) {
+			success = false;
+			goto cleanup;
 		}
-	} else if (raw_cp->prec <= 16) {
-		for (compno = 0; compno < numcomps; compno++) {
-			auto ptr = image->comps[compno].data;
-			for (uint32_t j = 0; j < h; ++j){
-				bool rc;
-				if (raw_cp->sgnd)
-					rc = read<int16_t>(f, big_endian, ptr, w);
-				else
-					rc = read<uint16_t>(f, big_endian, ptr, w);
-				if (!rc) {
-					spdlog::error(
-							"Error reading raw file. End of file probably reached.");
-					success = false;
-					goto cleanup;
-				}
-				ptr += image->comps[compno].stride ;
-			}
+		f = stdin;
+	} else {
+		f = fopen(filename, "rb");
+		if (!f) {
+			spdlog::error("Failed to open {} for reading", filename);
+			success = false;
+			goto cleanup;
 		}
+	}
+
+	if (raw_cp->prec <= 8) {
+		if (raw_cp->sgnd)
+			rc = read<int8_t>(f, big_endian, image, raw_cp->interleaved, &m_row);
+		else
+			rc = read<uint8_t>(f, big_endian, image, raw_cp->interleaved, &m_row);
 	} else {
-		spdlog::error(
-				"Grok cannot encode raw components with bit depth higher than 16 bits.");
+		if (raw_cp->sgnd)
+			rc = read<int16_t>(f, big_endian, image, raw_cp->interleaved, &m_row);
+		else
+			rc = read<uint16_t>(f, big_endian, image, raw_cp->interleaved, &m_row);
+	}
+	if (!rc) {
+		spdlog::error("Error reading raw file. End of file probably reached.");
 		success = false;
 		goto cleanup;
 	}
@@ -211,133 +424,85 @@ grk_image* RAWFormat::rawtoimage(const char *filename,
 	return image;
 }
 
-template<typename T> static bool write(FILE *rawFile, bool big_endian,
-		int32_t *ptr, uint32_t w, uint32_t stride, uint32_t h, int32_t lower, int32_t upper) {
-	const size_t bufSize = 4096;
-	T buf[bufSize];
-	T *outPtr = buf;
-	size_t outCount = 0;
-	auto stride_diff = stride - w;
-	for (uint32_t j = 0; j < h; ++j) {
-		for (uint32_t i = 0; i <  w; ++i) {
-			int32_t curr = *ptr++;
-			if (curr > upper)
-				curr = upper;
-			else if (curr < lower)
-				curr = lower;
-			if (!grk::writeBytes<T>((T) curr, buf, &outPtr, &outCount, bufSize,
-					big_endian, rawFile))
-				return false;
-		}
-		ptr += stride_diff;
-	}
-	//flush
-	if (outCount) {
-		size_t res = fwrite(buf, sizeof(T), outCount, rawFile);
-		if (res != outCount)
-			return false;
-	}
-
-	return true;
-}
-
-int RAWFormat::imagetoraw(grk_image *image, const char *outfile,
-		bool big_endian) {
-	bool writeToStdout = grk::useStdio(outfile);
-	FILE *rawFile = nullptr;
-	unsigned int compno, numcomps;
-	int fails = 1;
-	if ((image->numcomps * image->x1 * image->y1) == 0) {
-		spdlog::error("imagetoraw: invalid raw image parameters");
-		goto beach;
+grk_image* RAWFormat::decodeHeader(const std::string &filename,
+		grk_cparameters *parameters) {
+	// a sequence must be seekable
+	if (grk::useStdio(filename.c_str()))
+		return nullptr;
+	auto image = createImage(parameters, false);
+	if (!image)
+		return nullptr;
+	m_frameLength = 0;
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+		auto comp = image->comps + compno;
+		m_frameLength += (uint64_t) comp->w * comp->h
+				* (comp->prec <= 8 ? 1 : 2);
 	}
+	m_layout.interleaved = parameters->raw_cp.interleaved;
+	m_layout.big_endian = bigEndian;
+	m_fileName = filename;
 
-	numcomps = image->numcomps;
-	if (numcomps > 4) {
-		spdlog::warn("imagetoraw: number of components {} is "
-					"greater than 4. Truncating to 4", numcomps);
-		numcomps = 4;
+	std::error_code ec;
+	uint64_t fileLength = std::filesystem::file_size(filename, ec);
+	if (ec || fileLength < m_frameLength) {
+		spdlog::error("Raw file {} is smaller than one frame of {} bytes",
+				filename, m_frameLength);
+		grk_image_destroy(image);
+		return nullptr;
 	}
-
-	for (compno = 1; compno < numcomps; ++compno) {
-		if (image->comps[0].dx != image->comps[compno].dx)
-			break;
-		if (image->comps[0].dy != image->comps[compno].dy)
-			break;
-		if (image->comps[0].prec != image->comps[compno].prec)
-			break;
-		if (image->comps[0].sgnd != image->comps[compno].sgnd)
-			break;
+	m_numFrames = fileLength / m_frameLength;
+	if (fileLength % m_frameLength)
+		spdlog::warn("Raw file {}: {} bytes after last frame are ignored",
+				filename, fileLength % m_frameLength);
+#ifndef _WIN32
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd >= 0) {
+		void *ptr = mmap(nullptr, fileLength, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (ptr != MAP_FAILED) {
+			// frames are compressed one after the other
+			(void) madvise(ptr, fileLength, MADV_SEQUENTIAL);
+			m_map = (uint8_t*) ptr;
+			m_mapLength = fileLength;
+			return image;
+		}
 	}
-	if (compno != numcomps) {
-		spdlog::error(
-				"imagetoraw: All components shall have the same subsampling, same bit depth, same sign.");
-		goto beach;
+#endif
+	// fall back to reading one frame at a time
+	m_file = fopen(filename.c_str(), "rb");
+	if (!m_file) {
+		spdlog::error("Failed to open {} for reading", filename);
+		grk_image_destroy(image);
+		return nullptr;
 	}
-	if (!grk::grk_open_for_output(&rawFile, outfile,writeToStdout))
-		goto beach;
 
-	spdlog::info("imagetoraw: raw image characteristics: {} components",
-				image->numcomps);
+	return image;
+}
 
-	for (compno = 0; compno < image->numcomps; compno++) {
-		auto comp = image->comps + compno;
-		spdlog::info("Component {} characteristics: {}x{}x{} {}", compno,
-					comp->w, comp->h,
-					comp->prec,
-					comp->sgnd == 1 ? "signed" : "unsigned");
+uint64_t RAWFormat::numFrames(void) const {
+	return m_numFrames;
+}
 
-		if (!comp->data) {
-			spdlog::error("imagetotif: component {} is null.", compno);
-			
-			goto beach;
-		}
-		auto w = comp->w;
-		auto h = comp->h;
-		auto stride = comp->stride;
-		bool sgnd = comp->sgnd;
-		auto prec = comp->prec;
+uint64_t RAWFormat::frameLength(void) const {
+	return m_frameLength;
+}
 
-		int32_t lower = sgnd ? -(1 << (prec - 1)) : 0;
-		int32_t upper =
-				sgnd ? -lower - 1 : (1 << comp->prec) - 1;
-		int32_t *ptr = comp->data;
+const grk_raw_frame_layout* RAWFormat::frameLayout(void) const {
+	return &m_layout;
+}
 
-		bool rc;
-		if (prec <= 8) {
-			if (sgnd)
-				rc = write<int8_t>(rawFile, big_endian, ptr, w, stride, h, lower,
-						upper);
-			else
-				rc = write<uint8_t>(rawFile, big_endian, ptr, w, stride, h, lower,
-						upper);
-			if (!rc)
-				spdlog::error("imagetoraw: failed to write bytes for {}",
-						outfile);
-		} else if (prec <= 16) {
-			if (sgnd)
-				rc = write<int16_t>(rawFile, big_endian, ptr, w, stride, h, lower,
-						upper);
-			else
-				rc = write<uint16_t>(rawFile, big_endian, ptr, w, stride, h, lower,
-						upper);
-			if (!rc)
-				spdlog::error("fimagetoraw: ailed to write bytes for {}",
-						outfile);
-		} else if (comp->prec <= 32) {
-			spdlog::error(
-					"imagetoraw: more than 16 bits per component no handled yet");
-			goto beach;
-		} else {
-			spdlog::error("imagetoraw: invalid precision: {}",
-					comp->prec);
-			goto beach;
-		}
-	}
-	fails = 0;
-	beach: if (!writeToStdout && rawFile) {
-		if (!grk::safe_fclose(rawFile))
-			fails = 1;
+const uint8_t* RAWFormat::frame(uint64_t frameno) {
+	if (frameno >= m_numFrames)
+		return nullptr;
+	if (m_map)
+		return m_map + frameno * m_frameLength;
+	if (!m_file || !seek(m_file, frameno * m_frameLength))
+		return nullptr;
+	m_frame.resize(m_frameLength);
+	if (fread(m_frame.data(), 1, m_frameLength, m_file) != m_frameLength) {
+		spdlog::error("Failed to read frame {} from {}", frameno, m_fileName);
+		return nullptr;
 	}
-	return fails;
+
+	return m_frame.data();
 }
@@ -17,19 +17,57 @@
 #pragma once
 
 #include "ImageFormat.h"
+#include <vector>
 
-class RAWFormat : ImageFormat {
+class RAWFormat : public ImageFormat {
 public:
-	explicit RAWFormat(bool isBig) : bigEndian(isBig) {}
+	explicit RAWFormat(bool isBig);
+	~RAWFormat();
 	bool encodeHeader(grk_image *  image, const std::string &filename, uint32_t compressionParam) override;
 	bool encodeStrip(uint32_t rows) override;
 	bool encodeFinish(void) override;
 	grk_image *  decode(const std::string &filename,  grk_cparameters  *parameters) override;
+
+	/**
+	 * Open a file holding a sequence of raw frames, to be compressed
+	 * frame by frame with grk_compress_raw_frame. The file is memory
+	 * mapped if possible.
+	 *
+	 * @return image header, with no component data
+	 */
+	grk_image *  decodeHeader(const std::string &filename,  grk_cparameters  *parameters) override;
+
+	/** number of frames in sequence opened by decodeHeader */
+	uint64_t numFrames(void) const;
+
+	/** length of each frame in bytes */
+	uint64_t frameLength(void) const;
+
+	/** layout of each frame */
+	const grk_raw_frame_layout* frameLayout(void) const;
+
+	/**
+	 * Get raw samples of a frame
+	 *
+	 * @return samples, valid until the next call, or nullptr if frame can't be read
+	 */
+	const uint8_t* frame(uint64_t frameno);
 private:
 	bool bigEndian;
+	bool m_writeToStdout;
+	/** file offset of each component */
+	std::vector<uint64_t> m_offsets;
+	std::vector<uint32_t> m_rows_written;
+	std::vector<uint8_t> m_row;
+	uint64_t m_numFrames;
+	uint64_t m_frameLength;
+	grk_raw_frame_layout m_layout;
+	/** memory mapped sequence, or nullptr if frames are read into m_frame */
+	uint8_t *m_map;
+	uint64_t m_mapLength;
+	std::vector<uint8_t> m_frame;
+	grk_image *  createImage(grk_cparameters  *parameters, bool allocData);
 	grk_image *  rawtoimage(const char *filename,  grk_cparameters  *parameters, bool big_endian);
-	int imagetoraw(grk_image * image, 
-					const char *outfile,
-					bool big_endian);
+	bool writeRows(uint32_t max);
 
 };
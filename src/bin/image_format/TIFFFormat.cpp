@@ -34,6 +34,7 @@
 
 #include <tiffio.h>
 #include "color.h"
+#include <algorithm>
 #include <cassert>
 #include <memory>
 #include <string>
@@ -151,1059 +152,6 @@ static std::string getColourFormatString(uint16_t tiPhoto){
  TIFF IMAGE FORMAT
 
  <<-- <<-- <<-- <<-- */
-#define PUTBITS2(s, nb) \
-	trailing <<= remaining; \
-	trailing |= (uint32_t)((s) >> (nb - remaining)); \
-	*pDst++ = (uint8_t)trailing; \
-	trailing = (uint32_t)((s) & ((1U << (nb - remaining)) - 1U)); \
-	if (nb >= (remaining + 8)) { \
-		*pDst++ = (uint8_t)(trailing >> (nb - (remaining + 8))); \
-		trailing &= (uint32_t)((1U << (nb - (remaining + 8))) - 1U); \
-		remaining += 16 - nb; \
-	} else { \
-		remaining += 8 - nb; \
-	}
-
-#define PUTBITS(s, nb) \
-  if (nb >= remaining) { \
-		PUTBITS2(s, nb) \
-	} else { \
-		trailing <<= nb; \
-		trailing |= (uint32_t)(s); \
-		remaining -= nb; \
-	}
-#define FLUSHBITS() \
-	if (remaining != 8) { \
-		trailing <<= remaining; \
-		*pDst++ = (uint8_t)trailing; \
-	}
-
-#define GETBITS(dest, nb, mask, invert) { \
-	int needed = (nb); \
-	uint32_t dst = 0U; \
-	if (available == 0) { \
-		val = *pSrc++; \
-		available = 8; \
-	} \
-	while (needed > available) { \
-		dst |= val & ((1U << available) - 1U); \
-		needed -= available; \
-		dst <<= needed; \
-		val = *pSrc++; \
-		available = 8; \
-	} \
-	dst |= (val >> (available - needed)) & ((1U << needed) - 1U); \
-	available -= needed; \
-	dest = INV((int32_t)dst, mask,invert); \
-}
-
-static void tif_32sto3u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
-	size_t i;
-
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = (uint32_t) pSrc[i + 1];
-		uint32_t src2 = (uint32_t) pSrc[i + 2];
-		uint32_t src3 = (uint32_t) pSrc[i + 3];
-		uint32_t src4 = (uint32_t) pSrc[i + 4];
-		uint32_t src5 = (uint32_t) pSrc[i + 5];
-		uint32_t src6 = (uint32_t) pSrc[i + 6];
-		uint32_t src7 = (uint32_t) pSrc[i + 7];
-
-		*pDst++ = (uint8_t) ((src0 << 5) | (src1 << 2) | (src2 >> 1));
-		*pDst++ = (uint8_t) ((src2 << 7) | (src3 << 4) | (src4 << 1)
-				| (src5 >> 2));
-		*pDst++ = (uint8_t) ((src5 << 6) | (src6 << 3) | (src7));
-	}
-
-	if (length & 7U) {
-		uint32_t trailing = 0U;
-		int remaining = 8U;
-		length &= 7U;
-		PUTBITS((uint32_t )pSrc[i + 0], 3)
-		if (length > 1U) {
-			PUTBITS((uint32_t )pSrc[i + 1], 3)
-			if (length > 2U) {
-				PUTBITS((uint32_t )pSrc[i + 2], 3)
-				if (length > 3U) {
-					PUTBITS((uint32_t )pSrc[i + 3], 3)
-					if (length > 4U) {
-						PUTBITS((uint32_t )pSrc[i + 4], 3)
-						if (length > 5U) {
-							PUTBITS((uint32_t )pSrc[i + 5], 3)
-							if (length > 6U) {
-								PUTBITS((uint32_t )pSrc[i + 6], 3)
-							}
-						}
-					}
-				}
-			}
-		}
-		FLUSHBITS()
-	}
-}
-
-static void tif_32sto5u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
-	size_t i;
-
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = (uint32_t) pSrc[i + 1];
-		uint32_t src2 = (uint32_t) pSrc[i + 2];
-		uint32_t src3 = (uint32_t) pSrc[i + 3];
-		uint32_t src4 = (uint32_t) pSrc[i + 4];
-		uint32_t src5 = (uint32_t) pSrc[i + 5];
-		uint32_t src6 = (uint32_t) pSrc[i + 6];
-		uint32_t src7 = (uint32_t) pSrc[i + 7];
-
-		*pDst++ = (uint8_t) ((src0 << 3) | (src1 >> 2));
-		*pDst++ = (uint8_t) ((src1 << 6) | (src2 << 1) | (src3 >> 4));
-		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 1));
-		*pDst++ = (uint8_t) ((src4 << 7) | (src5 << 2) | (src6 >> 3));
-		*pDst++ = (uint8_t) ((src6 << 5) | (src7));
-
-	}
-
-	if (length & 7U) {
-		uint32_t trailing = 0U;
-		int remaining = 8U;
-		length &= 7U;
-		PUTBITS((uint32_t )pSrc[i + 0], 5)
-		if (length > 1U) {
-			PUTBITS((uint32_t )pSrc[i + 1], 5)
-			if (length > 2U) {
-				PUTBITS((uint32_t )pSrc[i + 2], 5)
-				if (length > 3U) {
-					PUTBITS((uint32_t )pSrc[i + 3], 5)
-					if (length > 4U) {
-						PUTBITS((uint32_t )pSrc[i + 4], 5)
-						if (length > 5U) {
-							PUTBITS((uint32_t )pSrc[i + 5], 5)
-							if (length > 6U) {
-								PUTBITS((uint32_t )pSrc[i + 6], 5)
-							}
-						}
-					}
-				}
-			}
-		}
-		FLUSHBITS()
-	}
-}
-
-static void tif_32sto7u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
-	size_t i;
-
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = (uint32_t) pSrc[i + 1];
-		uint32_t src2 = (uint32_t) pSrc[i + 2];
-		uint32_t src3 = (uint32_t) pSrc[i + 3];
-		uint32_t src4 = (uint32_t) pSrc[i + 4];
-		uint32_t src5 = (uint32_t) pSrc[i + 5];
-		uint32_t src6 = (uint32_t) pSrc[i + 6];
-		uint32_t src7 = (uint32_t) pSrc[i + 7];
-
-		*pDst++ = (uint8_t) ((src0 << 1) | (src1 >> 6));
-		*pDst++ = (uint8_t) ((src1 << 2) | (src2 >> 5));
-		*pDst++ = (uint8_t) ((src2 << 3) | (src3 >> 4));
-		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 3));
-		*pDst++ = (uint8_t) ((src4 << 5) | (src5 >> 2));
-		*pDst++ = (uint8_t) ((src5 << 6) | (src6 >> 1));
-		*pDst++ = (uint8_t) ((src6 << 7) | (src7));
-	}
-
-	if (length & 7U) {
-		uint32_t trailing = 0U;
-		int remaining = 8U;
-		length &= 7U;
-		PUTBITS((uint32_t )pSrc[i + 0], 7)
-		if (length > 1U) {
-			PUTBITS((uint32_t )pSrc[i + 1], 7)
-			if (length > 2U) {
-				PUTBITS((uint32_t )pSrc[i + 2], 7)
-				if (length > 3U) {
-					PUTBITS((uint32_t )pSrc[i + 3], 7)
-					if (length > 4U) {
-						PUTBITS((uint32_t )pSrc[i + 4], 7)
-						if (length > 5U) {
-							PUTBITS((uint32_t )pSrc[i + 5], 7)
-							if (length > 6U) {
-								PUTBITS((uint32_t )pSrc[i + 6], 7)
-							}
-						}
-					}
-				}
-			}
-		}
-		FLUSHBITS()
-	}
-}
-
-static void tif_32sto9u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
-	size_t i;
-
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = (uint32_t) pSrc[i + 1];
-		uint32_t src2 = (uint32_t) pSrc[i + 2];
-		uint32_t src3 = (uint32_t) pSrc[i + 3];
-		uint32_t src4 = (uint32_t) pSrc[i + 4];
-		uint32_t src5 = (uint32_t) pSrc[i + 5];
-		uint32_t src6 = (uint32_t) pSrc[i + 6];
-		uint32_t src7 = (uint32_t) pSrc[i + 7];
-
-		*pDst++ = (uint8_t) ((src0 >> 1));
-		*pDst++ = (uint8_t) ((src0 << 7) | (src1 >> 2));
-		*pDst++ = (uint8_t) ((src1 << 6) | (src2 >> 3));
-		*pDst++ = (uint8_t) ((src2 << 5) | (src3 >> 4));
-		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 5));
-		*pDst++ = (uint8_t) ((src4 << 3) | (src5 >> 6));
-		*pDst++ = (uint8_t) ((src5 << 2) | (src6 >> 7));
-		*pDst++ = (uint8_t) ((src6 << 1) | (src7 >> 8));
-		*pDst++ = (uint8_t) (src7);
-	}
-
-	if (length & 7U) {
-		uint32_t trailing = 0U;
-		int remaining = 8U;
-		length &= 7U;
-		PUTBITS2((uint32_t )pSrc[i + 0], 9)
-		if (length > 1U) {
-			PUTBITS2((uint32_t )pSrc[i + 1], 9)
-			if (length > 2U) {
-				PUTBITS2((uint32_t )pSrc[i + 2], 9)
-				if (length > 3U) {
-					PUTBITS2((uint32_t )pSrc[i + 3], 9)
-					if (length > 4U) {
-						PUTBITS2((uint32_t )pSrc[i + 4], 9)
-						if (length > 5U) {
-							PUTBITS2((uint32_t )pSrc[i + 5], 9)
-							if (length > 6U) {
-								PUTBITS2((uint32_t )pSrc[i + 6], 9)
-							}
-						}
-					}
-				}
-			}
-		}
-		FLUSHBITS()
-	}
-}
-
-static void tif_32sto10u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 3U); i += 4U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = (uint32_t) pSrc[i + 1];
-		uint32_t src2 = (uint32_t) pSrc[i + 2];
-		uint32_t src3 = (uint32_t) pSrc[i + 3];
-
-		*pDst++ = (uint8_t) (src0 >> 2);
-		*pDst++ = (uint8_t) (((src0 & 0x3U) << 6) | (src1 >> 4));
-		*pDst++ = (uint8_t) (((src1 & 0xFU) << 4) | (src2 >> 6));
-		*pDst++ = (uint8_t) (((src2 & 0x3FU) << 2) | (src3 >> 8));
-		*pDst++ = (uint8_t) (src3);
-	}
-
-	if (length & 3U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = 0U;
-		uint32_t src2 = 0U;
-		length = length & 3U;
-
-		if (length > 1U) {
-			src1 = (uint32_t) pSrc[i + 1];
-			if (length > 2U) {
-				src2 = (uint32_t) pSrc[i + 2];
-			}
-		}
-		*pDst++ = (uint8_t) (src0 >> 2);
-		*pDst++ = (uint8_t) (((src0 & 0x3U) << 6) | (src1 >> 4));
-		if (length > 1U) {
-			*pDst++ = (uint8_t) (((src1 & 0xFU) << 4) | (src2 >> 6));
-			if (length > 2U) {
-				*pDst++ = (uint8_t) (((src2 & 0x3FU) << 2));
-			}
-		}
-	}
-}
-
-static void tif_32sto11u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
-	size_t i;
-
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = (uint32_t) pSrc[i + 1];
-		uint32_t src2 = (uint32_t) pSrc[i + 2];
-		uint32_t src3 = (uint32_t) pSrc[i + 3];
-		uint32_t src4 = (uint32_t) pSrc[i + 4];
-		uint32_t src5 = (uint32_t) pSrc[i + 5];
-		uint32_t src6 = (uint32_t) pSrc[i + 6];
-		uint32_t src7 = (uint32_t) pSrc[i + 7];
-
-		*pDst++ = (uint8_t) ((src0 >> 3));
-		*pDst++ = (uint8_t) ((src0 << 5) | (src1 >> 6));
-		*pDst++ = (uint8_t) ((src1 << 2) | (src2 >> 9));
-		*pDst++ = (uint8_t) ((src2 >> 1));
-		*pDst++ = (uint8_t) ((src2 << 7) | (src3 >> 4));
-		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 7));
-		*pDst++ = (uint8_t) ((src4 << 1) | (src5 >> 10));
-		*pDst++ = (uint8_t) ((src5 >> 2));
-		*pDst++ = (uint8_t) ((src5 << 6) | (src6 >> 5));
-		*pDst++ = (uint8_t) ((src6 << 3) | (src7 >> 8));
-		*pDst++ = (uint8_t) (src7);
-	}
-
-	if (length & 7U) {
-		uint32_t trailing = 0U;
-		int remaining = 8U;
-		length &= 7U;
-		PUTBITS2((uint32_t )pSrc[i + 0], 11)
-		if (length > 1U) {
-			PUTBITS2((uint32_t )pSrc[i + 1], 11)
-			if (length > 2U) {
-				PUTBITS2((uint32_t )pSrc[i + 2], 11)
-				if (length > 3U) {
-					PUTBITS2((uint32_t )pSrc[i + 3], 11)
-					if (length > 4U) {
-						PUTBITS2((uint32_t )pSrc[i + 4], 11)
-						if (length > 5U) {
-							PUTBITS2((uint32_t )pSrc[i + 5], 11)
-							if (length > 6U) {
-								PUTBITS2((uint32_t )pSrc[i + 6], 11)
-							}
-						}
-					}
-				}
-			}
-		}
-		FLUSHBITS()
-	}
-}
-static void tif_32sto12u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 1U); i += 2U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = (uint32_t) pSrc[i + 1];
-
-		*pDst++ = (uint8_t) (src0 >> 4);
-		*pDst++ = (uint8_t) (((src0 & 0xFU) << 4) | (src1 >> 8));
-		*pDst++ = (uint8_t) (src1);
-	}
-
-	if (length & 1U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		*pDst++ = (uint8_t) (src0 >> 4);
-		*pDst++ = (uint8_t) (((src0 & 0xFU) << 4));
-	}
-}
-
-static void tif_32sto13u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
-	size_t i;
-
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = (uint32_t) pSrc[i + 1];
-		uint32_t src2 = (uint32_t) pSrc[i + 2];
-		uint32_t src3 = (uint32_t) pSrc[i + 3];
-		uint32_t src4 = (uint32_t) pSrc[i + 4];
-		uint32_t src5 = (uint32_t) pSrc[i + 5];
-		uint32_t src6 = (uint32_t) pSrc[i + 6];
-		uint32_t src7 = (uint32_t) pSrc[i + 7];
-
-		*pDst++ = (uint8_t) ((src0 >> 5));
-		*pDst++ = (uint8_t) ((src0 << 3) | (src1 >> 10));
-		*pDst++ = (uint8_t) ((src1 >> 2));
-		*pDst++ = (uint8_t) ((src1 << 6) | (src2 >> 7));
-		*pDst++ = (uint8_t) ((src2 << 1) | (src3 >> 12));
-		*pDst++ = (uint8_t) ((src3 >> 4));
-		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 9));
-		*pDst++ = (uint8_t) ((src4 >> 1));
-		*pDst++ = (uint8_t) ((src4 << 7) | (src5 >> 6));
-		*pDst++ = (uint8_t) ((src5 << 2) | (src6 >> 11));
-		*pDst++ = (uint8_t) ((src6 >> 3));
-		*pDst++ = (uint8_t) ((src6 << 5) | (src7 >> 8));
-		*pDst++ = (uint8_t) (src7);
-	}
-
-	if (length & 7U) {
-		uint32_t trailing = 0U;
-		int remaining = 8U;
-		length &= 7U;
-		PUTBITS2((uint32_t )pSrc[i + 0], 13)
-		if (length > 1U) {
-			PUTBITS2((uint32_t )pSrc[i + 1], 13)
-			if (length > 2U) {
-				PUTBITS2((uint32_t )pSrc[i + 2], 13)
-				if (length > 3U) {
-					PUTBITS2((uint32_t )pSrc[i + 3], 13)
-					if (length > 4U) {
-						PUTBITS2((uint32_t )pSrc[i + 4], 13)
-						if (length > 5U) {
-							PUTBITS2((uint32_t )pSrc[i + 5], 13)
-							if (length > 6U) {
-								PUTBITS2((uint32_t )pSrc[i + 6], 13)
-							}
-						}
-					}
-				}
-			}
-		}
-		FLUSHBITS()
-	}
-}
-
-static void tif_32sto14u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 3U); i += 4U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = (uint32_t) pSrc[i + 1];
-		uint32_t src2 = (uint32_t) pSrc[i + 2];
-		uint32_t src3 = (uint32_t) pSrc[i + 3];
-
-		*pDst++ = (uint8_t) (src0 >> 6);
-		*pDst++ = (uint8_t) (((src0 & 0x3FU) << 2) | (src1 >> 12));
-		*pDst++ = (uint8_t) (src1 >> 4);
-		*pDst++ = (uint8_t) (((src1 & 0xFU) << 4) | (src2 >> 10));
-		*pDst++ = (uint8_t) (src2 >> 2);
-		*pDst++ = (uint8_t) (((src2 & 0x3U) << 6) | (src3 >> 8));
-		*pDst++ = (uint8_t) (src3);
-	}
-
-	if (length & 3U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = 0U;
-		uint32_t src2 = 0U;
-		length = length & 3U;
-
-		if (length > 1U) {
-			src1 = (uint32_t) pSrc[i + 1];
-			if (length > 2U) {
-				src2 = (uint32_t) pSrc[i + 2];
-			}
-		}
-		*pDst++ = (uint8_t) (src0 >> 6);
-		*pDst++ = (uint8_t) (((src0 & 0x3FU) << 2) | (src1 >> 12));
-		if (length > 1U) {
-			*pDst++ = (uint8_t) (src1 >> 4);
-			*pDst++ = (uint8_t) (((src1 & 0xFU) << 4) | (src2 >> 10));
-			if (length > 2U) {
-				*pDst++ = (uint8_t) (src2 >> 2);
-				*pDst++ = (uint8_t) (((src2 & 0x3U) << 6));
-			}
-		}
-	}
-}
-
-static void tif_32sto15u(const int32_t *pSrc, uint8_t *pDst, size_t length) {
-	size_t i;
-
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t src0 = (uint32_t) pSrc[i + 0];
-		uint32_t src1 = (uint32_t) pSrc[i + 1];
-		uint32_t src2 = (uint32_t) pSrc[i + 2];
-		uint32_t src3 = (uint32_t) pSrc[i + 3];
-		uint32_t src4 = (uint32_t) pSrc[i + 4];
-		uint32_t src5 = (uint32_t) pSrc[i + 5];
-		uint32_t src6 = (uint32_t) pSrc[i + 6];
-		uint32_t src7 = (uint32_t) pSrc[i + 7];
-
-		*pDst++ = (uint8_t) ((src0 >> 7));
-		*pDst++ = (uint8_t) ((src0 << 1) | (src1 >> 14));
-		*pDst++ = (uint8_t) ((src1 >> 6));
-		*pDst++ = (uint8_t) ((src1 << 2) | (src2 >> 13));
-		*pDst++ = (uint8_t) ((src2 >> 5));
-		*pDst++ = (uint8_t) ((src2 << 3) | (src3 >> 12));
-		*pDst++ = (uint8_t) ((src3 >> 4));
-		*pDst++ = (uint8_t) ((src3 << 4) | (src4 >> 11));
-		*pDst++ = (uint8_t) ((src4 >> 3));
-		*pDst++ = (uint8_t) ((src4 << 5) | (src5 >> 10));
-		*pDst++ = (uint8_t) ((src5 >> 2));
-		*pDst++ = (uint8_t) ((src5 << 6) | (src6 >> 9));
-		*pDst++ = (uint8_t) ((src6 >> 1));
-		*pDst++ = (uint8_t) ((src6 << 7) | (src7 >> 8));
-		*pDst++ = (uint8_t) (src7);
-	}
-
-	if (length & 7U) {
-		uint32_t trailing = 0U;
-		int remaining = 8U;
-		length &= 7U;
-		PUTBITS2((uint32_t )pSrc[i + 0], 15)
-		if (length > 1U) {
-			PUTBITS2((uint32_t )pSrc[i + 1], 15)
-			if (length > 2U) {
-				PUTBITS2((uint32_t )pSrc[i + 2], 15)
-				if (length > 3U) {
-					PUTBITS2((uint32_t )pSrc[i + 3], 15)
-					if (length > 4U) {
-						PUTBITS2((uint32_t )pSrc[i + 4], 15)
-						if (length > 5U) {
-							PUTBITS2((uint32_t )pSrc[i + 5], 15)
-							if (length > 6U) {
-								PUTBITS2((uint32_t )pSrc[i + 6], 15)
-							}
-						}
-					}
-				}
-			}
-		}
-		FLUSHBITS()
-	}
-}
-
-static void tif_32sto16u(const int32_t *pSrc, uint16_t *pDst, size_t length) {
-	for (size_t i = 0; i < length; ++i)
-		pDst[i] = (uint16_t) pSrc[i];
-}
-
-static void tif_3uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		uint32_t val2 = *pSrc++;
-
-		pDst[i + 0] = INV((int32_t )((val0 >> 5)), INV_MASK_3, invert);
-		pDst[i + 1] = INV((int32_t )(((val0 & 0x1FU) >> 2)), INV_MASK_3,
-				invert);
-		pDst[i + 2] = INV((int32_t )(((val0 & 0x3U) << 1) | (val1 >> 7)),
-				INV_MASK_3, invert);
-		pDst[i + 3] = INV((int32_t )(((val1 & 0x7FU) >> 4)), INV_MASK_3,
-				invert);
-		pDst[i + 4] = INV((int32_t )(((val1 & 0xFU) >> 1)), INV_MASK_3, invert);
-		pDst[i + 5] = INV((int32_t )(((val1 & 0x1U) << 2) | (val2 >> 6)),
-				INV_MASK_3, invert);
-		pDst[i + 6] = INV((int32_t )(((val2 & 0x3FU) >> 3)), INV_MASK_3,
-				invert);
-		pDst[i + 7] = INV((int32_t )(((val2 & 0x7U))), INV_MASK_3, invert);
-
-	}
-	if (length & 7U) {
-		uint32_t val;
-		int available = 0;
-
-		length = length & 7U;
-
-		GETBITS(pDst[i + 0], 3, INV_MASK_3, invert)
-
-		if (length > 1U) {
-			GETBITS(pDst[i + 1], 3, INV_MASK_3, invert)
-			if (length > 2U) {
-				GETBITS(pDst[i + 2], 3, INV_MASK_3, invert)
-				if (length > 3U) {
-					GETBITS(pDst[i + 3], 3, INV_MASK_3, invert)
-					if (length > 4U) {
-						GETBITS(pDst[i + 4], 3, INV_MASK_3, invert)
-						if (length > 5U) {
-							GETBITS(pDst[i + 5], 3, INV_MASK_3, invert)
-							if (length > 6U) {
-								GETBITS(pDst[i + 6], 3, INV_MASK_3, invert)
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-}
-static void tif_5uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		uint32_t val2 = *pSrc++;
-		uint32_t val3 = *pSrc++;
-		uint32_t val4 = *pSrc++;
-
-		pDst[i + 0] = INV((int32_t )((val0 >> 3)), INV_MASK_5, invert);
-		pDst[i + 1] = INV((int32_t )(((val0 & 0x7U) << 2) | (val1 >> 6)),
-				INV_MASK_5, invert);
-		pDst[i + 2] = INV((int32_t )(((val1 & 0x3FU) >> 1)), INV_MASK_5,
-				invert);
-		pDst[i + 3] = INV((int32_t )(((val1 & 0x1U) << 4) | (val2 >> 4)),
-				INV_MASK_5, invert);
-		pDst[i + 4] = INV((int32_t )(((val2 & 0xFU) << 1) | (val3 >> 7)),
-				INV_MASK_5, invert);
-		pDst[i + 5] = INV((int32_t )(((val3 & 0x7FU) >> 2)), INV_MASK_5,
-				invert);
-		pDst[i + 6] = INV((int32_t )(((val3 & 0x3U) << 3) | (val4 >> 5)),
-				INV_MASK_5, invert);
-		pDst[i + 7] = INV((int32_t )(((val4 & 0x1FU))), INV_MASK_5, invert);
-
-	}
-	if (length & 7U) {
-		uint32_t val;
-		int available = 0;
-
-		length = length & 7U;
-
-		GETBITS(pDst[i + 0], 5, INV_MASK_5, invert)
-
-		if (length > 1U) {
-			GETBITS(pDst[i + 1], 5, INV_MASK_5, invert)
-			if (length > 2U) {
-				GETBITS(pDst[i + 2], 5, INV_MASK_5, invert)
-				if (length > 3U) {
-					GETBITS(pDst[i + 3], 5, INV_MASK_5, invert)
-					if (length > 4U) {
-						GETBITS(pDst[i + 4], 5, INV_MASK_5, invert)
-						if (length > 5U) {
-							GETBITS(pDst[i + 5], 5, INV_MASK_5, invert)
-							if (length > 6U) {
-								GETBITS(pDst[i + 6], 5, INV_MASK_5, invert)
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-}
-static void tif_7uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		uint32_t val2 = *pSrc++;
-		uint32_t val3 = *pSrc++;
-		uint32_t val4 = *pSrc++;
-		uint32_t val5 = *pSrc++;
-		uint32_t val6 = *pSrc++;
-
-		pDst[i + 0] = INV((int32_t )((val0 >> 1)), INV_MASK_7, invert);
-		pDst[i + 1] = INV((int32_t )(((val0 & 0x1U) << 6) | (val1 >> 2)),
-				INV_MASK_7, invert);
-		pDst[i + 2] = INV((int32_t )(((val1 & 0x3U) << 5) | (val2 >> 3)),
-				INV_MASK_7, invert);
-		pDst[i + 3] = INV((int32_t )(((val2 & 0x7U) << 4) | (val3 >> 4)),
-				INV_MASK_7, invert);
-		pDst[i + 4] = INV((int32_t )(((val3 & 0xFU) << 3) | (val4 >> 5)),
-				INV_MASK_7, invert);
-		pDst[i + 5] = INV((int32_t )(((val4 & 0x1FU) << 2) | (val5 >> 6)),
-				INV_MASK_7, invert);
-		pDst[i + 6] = INV((int32_t )(((val5 & 0x3FU) << 1) | (val6 >> 7)),
-				INV_MASK_7, invert);
-		pDst[i + 7] = INV((int32_t )(((val6 & 0x7FU))), INV_MASK_7, invert);
-
-	}
-	if (length & 7U) {
-		uint32_t val;
-		int available = 0;
-
-		length = length & 7U;
-
-		GETBITS(pDst[i + 0], 7, INV_MASK_7, invert)
-
-		if (length > 1U) {
-			GETBITS(pDst[i + 1], 7, INV_MASK_7, invert)
-			if (length > 2U) {
-				GETBITS(pDst[i + 2], 7, INV_MASK_7, invert)
-				if (length > 3U) {
-					GETBITS(pDst[i + 3], 7, INV_MASK_7, invert)
-					if (length > 4U) {
-						GETBITS(pDst[i + 4], 7, INV_MASK_7, invert)
-						if (length > 5U) {
-							GETBITS(pDst[i + 5], 7, INV_MASK_7, invert)
-							if (length > 6U) {
-								GETBITS(pDst[i + 6], 7, INV_MASK_7, invert)
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-}
-static void tif_9uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		uint32_t val2 = *pSrc++;
-		uint32_t val3 = *pSrc++;
-		uint32_t val4 = *pSrc++;
-		uint32_t val5 = *pSrc++;
-		uint32_t val6 = *pSrc++;
-		uint32_t val7 = *pSrc++;
-		uint32_t val8 = *pSrc++;
-
-		pDst[i + 0] = INV((int32_t )((val0 << 1) | (val1 >> 7)), INV_MASK_9,
-				invert);
-		pDst[i + 1] = INV((int32_t )(((val1 & 0x7FU) << 2) | (val2 >> 6)),
-				INV_MASK_9, invert);
-		pDst[i + 2] = INV((int32_t )(((val2 & 0x3FU) << 3) | (val3 >> 5)),
-				INV_MASK_9, invert);
-		pDst[i + 3] = INV((int32_t )(((val3 & 0x1FU) << 4) | (val4 >> 4)),
-				INV_MASK_9, invert);
-		pDst[i + 4] = INV((int32_t )(((val4 & 0xFU) << 5) | (val5 >> 3)),
-				INV_MASK_9, invert);
-		pDst[i + 5] = INV((int32_t )(((val5 & 0x7U) << 6) | (val6 >> 2)),
-				INV_MASK_9, invert);
-		pDst[i + 6] = INV((int32_t )(((val6 & 0x3U) << 7) | (val7 >> 1)),
-				INV_MASK_9, invert);
-		pDst[i + 7] = INV((int32_t )(((val7 & 0x1U) << 8) | (val8)), INV_MASK_9,
-				invert);
-
-	}
-	if (length & 7U) {
-		uint32_t val;
-		int available = 0;
-
-		length = length & 7U;
-
-		GETBITS(pDst[i + 0], 9, INV_MASK_9, invert)
-
-		if (length > 1U) {
-			GETBITS(pDst[i + 1], 9, INV_MASK_9, invert)
-			if (length > 2U) {
-				GETBITS(pDst[i + 2], 9, INV_MASK_9, invert)
-				if (length > 3U) {
-					GETBITS(pDst[i + 3], 9, INV_MASK_9, invert)
-					if (length > 4U) {
-						GETBITS(pDst[i + 4], 9, INV_MASK_9, invert)
-						if (length > 5U) {
-							GETBITS(pDst[i + 5], 9, INV_MASK_9, invert)
-							if (length > 6U) {
-								GETBITS(pDst[i + 6], 9, INV_MASK_9, invert)
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-}
-
-static void tif_10uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 3U); i += 4U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		uint32_t val2 = *pSrc++;
-		uint32_t val3 = *pSrc++;
-		uint32_t val4 = *pSrc++;
-
-		pDst[i + 0] = INV((int32_t )((val0 << 2) | (val1 >> 6)), INV_MASK_10,
-				invert);
-		pDst[i + 1] = INV((int32_t )(((val1 & 0x3FU) << 4) | (val2 >> 4)),
-				INV_MASK_10, invert);
-		pDst[i + 2] = INV((int32_t )(((val2 & 0xFU) << 6) | (val3 >> 2)),
-				INV_MASK_10, invert);
-		pDst[i + 3] = INV((int32_t )(((val3 & 0x3U) << 8) | val4), INV_MASK_10,
-				invert);
-
-	}
-	if (length & 3U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		length = length & 3U;
-		pDst[i + 0] = INV((int32_t )((val0 << 2) | (val1 >> 6)), INV_MASK_10,
-				invert);
-
-		if (length > 1U) {
-			uint32_t val2 = *pSrc++;
-			pDst[i + 1] = INV((int32_t )(((val1 & 0x3FU) << 4) | (val2 >> 4)),
-					INV_MASK_10, invert);
-			if (length > 2U) {
-				uint32_t val3 = *pSrc++;
-				pDst[i + 2] = INV(
-						(int32_t )(((val2 & 0xFU) << 6) | (val3 >> 2)),
-						INV_MASK_10, invert);
-			}
-		}
-	}
-}
-
-static void tif_11uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		uint32_t val2 = *pSrc++;
-		uint32_t val3 = *pSrc++;
-		uint32_t val4 = *pSrc++;
-		uint32_t val5 = *pSrc++;
-		uint32_t val6 = *pSrc++;
-		uint32_t val7 = *pSrc++;
-		uint32_t val8 = *pSrc++;
-		uint32_t val9 = *pSrc++;
-		uint32_t val10 = *pSrc++;
-
-		pDst[i + 0] = INV((int32_t )((val0 << 3) | (val1 >> 5)), INV_MASK_11,
-				invert);
-		pDst[i + 1] = INV((int32_t )(((val1 & 0x1FU) << 6) | (val2 >> 2)),
-				INV_MASK_11, invert);
-		pDst[i + 2] = INV(
-				(int32_t )(((val2 & 0x3U) << 9) | (val3 << 1) | (val4 >> 7)),
-				INV_MASK_11, invert);
-		pDst[i + 3] = INV((int32_t )(((val4 & 0x7FU) << 4) | (val5 >> 4)),
-				INV_MASK_11, invert);
-		pDst[i + 4] = INV((int32_t )(((val5 & 0xFU) << 7) | (val6 >> 1)),
-				INV_MASK_11, invert);
-		pDst[i + 5] = INV(
-				(int32_t )(((val6 & 0x1U) << 10) | (val7 << 2) | (val8 >> 6)),
-				INV_MASK_11, invert);
-		pDst[i + 6] = INV((int32_t )(((val8 & 0x3FU) << 5) | (val9 >> 3)),
-				INV_MASK_11, invert);
-		pDst[i + 7] = INV((int32_t )(((val9 & 0x7U) << 8) | (val10)),
-				INV_MASK_11, invert);
-
-	}
-	if (length & 7U) {
-		uint32_t val;
-		int available = 0;
-
-		length = length & 7U;
-
-		GETBITS(pDst[i + 0], 11, INV_MASK_11, invert)
-
-		if (length > 1U) {
-			GETBITS(pDst[i + 1], 11, INV_MASK_11, invert)
-			if (length > 2U) {
-				GETBITS(pDst[i + 2], 11, INV_MASK_11, invert)
-				if (length > 3U) {
-					GETBITS(pDst[i + 3], 11, INV_MASK_11, invert)
-					if (length > 4U) {
-						GETBITS(pDst[i + 4], 11, INV_MASK_11, invert)
-						if (length > 5U) {
-							GETBITS(pDst[i + 5], 11, INV_MASK_11, invert)
-							if (length > 6U) {
-								GETBITS(pDst[i + 6], 11, INV_MASK_11, invert)
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-}
-static void tif_12uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 1U); i += 2U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		uint32_t val2 = *pSrc++;
-
-		pDst[i + 0] = INV((int32_t )((val0 << 4) | (val1 >> 4)), INV_MASK_12,
-				invert);
-		pDst[i + 1] = INV((int32_t )(((val1 & 0xFU) << 8) | val2), INV_MASK_12,
-				invert);
-	}
-	if (length & 1U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		pDst[i + 0] = INV((int32_t )((val0 << 4) | (val1 >> 4)), INV_MASK_12,
-				invert);
-	}
-}
-
-static void tif_13uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		uint32_t val2 = *pSrc++;
-		uint32_t val3 = *pSrc++;
-		uint32_t val4 = *pSrc++;
-		uint32_t val5 = *pSrc++;
-		uint32_t val6 = *pSrc++;
-		uint32_t val7 = *pSrc++;
-		uint32_t val8 = *pSrc++;
-		uint32_t val9 = *pSrc++;
-		uint32_t val10 = *pSrc++;
-		uint32_t val11 = *pSrc++;
-		uint32_t val12 = *pSrc++;
-
-		pDst[i + 0] = INV((int32_t )((val0 << 5) | (val1 >> 3)), INV_MASK_13,
-				invert);
-		pDst[i + 1] = INV(
-				(int32_t )(((val1 & 0x7U) << 10) | (val2 << 2) | (val3 >> 6)),
-				INV_MASK_13, invert);
-		pDst[i + 2] = INV((int32_t )(((val3 & 0x3FU) << 7) | (val4 >> 1)),
-				INV_MASK_13, invert);
-		pDst[i + 3] = INV(
-				(int32_t )(((val4 & 0x1U) << 12) | (val5 << 4) | (val6 >> 4)),
-				INV_MASK_13, invert);
-		pDst[i + 4] = INV(
-				(int32_t )(((val6 & 0xFU) << 9) | (val7 << 1) | (val8 >> 7)),
-				INV_MASK_13, invert);
-		pDst[i + 5] = INV((int32_t )(((val8 & 0x7FU) << 6) | (val9 >> 2)),
-				INV_MASK_13, invert);
-		pDst[i + 6] = INV(
-				(int32_t )(((val9 & 0x3U) << 11) | (val10 << 3) | (val11 >> 5)),
-				INV_MASK_13, invert);
-		pDst[i + 7] = INV((int32_t )(((val11 & 0x1FU) << 8) | (val12)),
-				INV_MASK_13, invert);
-
-	}
-	if (length & 7U) {
-		uint32_t val;
-		int available = 0;
-
-		length = length & 7U;
-
-		GETBITS(pDst[i + 0], 13, INV_MASK_13, invert)
-
-		if (length > 1U) {
-			GETBITS(pDst[i + 1], 13, INV_MASK_13, invert)
-			if (length > 2U) {
-				GETBITS(pDst[i + 2], 13, INV_MASK_13, invert)
-				if (length > 3U) {
-					GETBITS(pDst[i + 3], 13, INV_MASK_13, invert)
-					if (length > 4U) {
-						GETBITS(pDst[i + 4], 13, INV_MASK_13, invert)
-						if (length > 5U) {
-							GETBITS(pDst[i + 5], 13, INV_MASK_13, invert)
-							if (length > 6U) {
-								GETBITS(pDst[i + 6], 13, INV_MASK_13, invert)
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-}
-
-static void tif_14uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 3U); i += 4U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		uint32_t val2 = *pSrc++;
-		uint32_t val3 = *pSrc++;
-		uint32_t val4 = *pSrc++;
-		uint32_t val5 = *pSrc++;
-		uint32_t val6 = *pSrc++;
-
-		pDst[i + 0] = INV((int32_t )((val0 << 6) | (val1 >> 2)), INV_MASK_14,
-				invert);
-		pDst[i + 1] = INV(
-				(int32_t )(((val1 & 0x3U) << 12) | (val2 << 4) | (val3 >> 4)),
-				INV_MASK_14, invert);
-		pDst[i + 2] = INV(
-				(int32_t )(((val3 & 0xFU) << 10) | (val4 << 2) | (val5 >> 6)),
-				INV_MASK_14, invert);
-		pDst[i + 3] = INV((int32_t )(((val5 & 0x3FU) << 8) | val6), INV_MASK_14,
-				invert);
-
-	}
-	if (length & 3U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		length = length & 3U;
-		pDst[i + 0] = (int32_t) ((val0 << 6) | (val1 >> 2));
-
-		if (length > 1U) {
-			uint32_t val2 = *pSrc++;
-			uint32_t val3 = *pSrc++;
-			pDst[i + 1] =
-					INV(
-							(int32_t )(((val1 & 0x3U) << 12) | (val2 << 4)
-									| (val3 >> 4)), INV_MASK_14, invert);
-			if (length > 2U) {
-				uint32_t val4 = *pSrc++;
-				uint32_t val5 = *pSrc++;
-				pDst[i + 2] = INV(
-						(int32_t )(((val3 & 0xFU) << 10) | (val4 << 2)
-								| (val5 >> 6)), INV_MASK_14, invert);
-			}
-		}
-	}
-}
-
-static void tif_15uto32s(const uint8_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	size_t i;
-	for (i = 0; i < (length & ~(size_t) 7U); i += 8U) {
-		uint32_t val0 = *pSrc++;
-		uint32_t val1 = *pSrc++;
-		uint32_t val2 = *pSrc++;
-		uint32_t val3 = *pSrc++;
-		uint32_t val4 = *pSrc++;
-		uint32_t val5 = *pSrc++;
-		uint32_t val6 = *pSrc++;
-		uint32_t val7 = *pSrc++;
-		uint32_t val8 = *pSrc++;
-		uint32_t val9 = *pSrc++;
-		uint32_t val10 = *pSrc++;
-		uint32_t val11 = *pSrc++;
-		uint32_t val12 = *pSrc++;
-		uint32_t val13 = *pSrc++;
-		uint32_t val14 = *pSrc++;
-
-		pDst[i + 0] = INV((int32_t )((val0 << 7) | (val1 >> 1)), (1 << 15) - 1,
-				invert);
-		pDst[i + 1] = INV(
-				(int32_t )(((val1 & 0x1U) << 14) | (val2 << 6) | (val3 >> 2)),
-				INV_MASK_15, invert);
-		pDst[i + 2] = INV(
-				(int32_t )(((val3 & 0x3U) << 13) | (val4 << 5) | (val5 >> 3)),
-				INV_MASK_15, invert);
-		pDst[i + 3] = INV(
-				(int32_t )(((val5 & 0x7U) << 12) | (val6 << 4) | (val7 >> 4)),
-				INV_MASK_15, invert);
-		pDst[i + 4] = INV(
-				(int32_t )(((val7 & 0xFU) << 11) | (val8 << 3) | (val9 >> 5)),
-				INV_MASK_15, invert);
-		pDst[i + 5] =
-				INV(
-						(int32_t )(((val9 & 0x1FU) << 10) | (val10 << 2)
-								| (val11 >> 6)), INV_MASK_15, invert);
-		pDst[i + 6] =
-				INV(
-						(int32_t )(((val11 & 0x3FU) << 9) | (val12 << 1)
-								| (val13 >> 7)), INV_MASK_15, invert);
-		pDst[i + 7] = INV((int32_t )(((val13 & 0x7FU) << 8) | (val14)),
-				INV_MASK_15, invert);
-
-	}
-	if (length & 7U) {
-		uint32_t val;
-		int available = 0;
-
-		length = length & 7U;
-
-		GETBITS(pDst[i + 0], 15, INV_MASK_15, invert)
-
-		if (length > 1U) {
-			GETBITS(pDst[i + 1], 15, INV_MASK_15, invert)
-			if (length > 2U) {
-				GETBITS(pDst[i + 2], 15, INV_MASK_15, invert)
-				if (length > 3U) {
-					GETBITS(pDst[i + 3], 15, INV_MASK_15, invert)
-					if (length > 4U) {
-						GETBITS(pDst[i + 4], 15, INV_MASK_15, invert)
-						if (length > 5U) {
-							GETBITS(pDst[i + 5], 15, INV_MASK_15, invert)
-							if (length > 6U) {
-								GETBITS(pDst[i + 6], 15, INV_MASK_15, invert)
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-}
-
-/* seems that libtiff decodes this to machine endianness */
-static void tif_16uto32s(const uint16_t *pSrc, int32_t *pDst, size_t length,
-		bool invert) {
-	for (size_t i = 0; i < length; i++)
-		pDst[i] = INV(pSrc[i], 0xFFFF, invert);
-}
 
 static void set_resolution(double *res, float resx, float resy, short resUnit) {
 	// resolution is in pels / metre
@@ -1226,7 +174,17 @@ static void set_resolution(double *res, float resx, float resy, short resUnit) {
 	}
 }
 
-const size_t maxNumComponents = 10;
+
+/**
+ * Get converter from packed TIFF samples to int32
+ *
+ * @param prec	sample precision
+ *
+ * @return converter, or nullptr if precision is not supported
+ */
+static cvtTo32 getCvtTifTo32s(uint32_t prec){
+	return prec <= 16 ? cvtTifTo32_LUT[prec] : nullptr;
+}
 
 static bool readTiffPixelsUnsigned(TIFF *tif,
 									grk_image_comp *comps,
@@ -1254,52 +212,9 @@ static bool readTiffPixelsUnsigned(TIFF *tif,
 	size_t luma_block = chroma_subsample_x * chroma_subsample_y;
     size_t unitSize = luma_block + 2;
 
-	switch (comps[0].prec) {
-	case 1:
-	case 2:
-	case 4:
-	case 6:
-	case 8:
-		cvtTifTo32s = cvtTo32_LUT[comps[0].prec];
-		break;
-		/* others are specific to TIFF */
-	case 3:
-		cvtTifTo32s = tif_3uto32s;
-		break;
-	case 5:
-		cvtTifTo32s = tif_5uto32s;
-		break;
-	case 7:
-		cvtTifTo32s = tif_7uto32s;
-		break;
-	case 9:
-		cvtTifTo32s = tif_9uto32s;
-		break;
-	case 10:
-		cvtTifTo32s = tif_10uto32s;
-		break;
-	case 11:
-		cvtTifTo32s = tif_11uto32s;
-		break;
-	case 12:
-		cvtTifTo32s = tif_12uto32s;
-		break;
-	case 13:
-		cvtTifTo32s = tif_13uto32s;
-		break;
-	case 14:
-		cvtTifTo32s = tif_14uto32s;
-		break;
-	case 15:
-		cvtTifTo32s = tif_15uto32s;
-		break;
-	case 16:
-		cvtTifTo32s = (cvtTo32) tif_16uto32s;
-		break;
-	default:
-		/* never here */
-		break;
-	}
+	cvtTifTo32s = getCvtTifTo32s(comps[0].prec);
+	if (!cvtTifTo32s)
+		return false;
 	cvtToPlanar = cvtInterleavedToPlanar_LUT[numcomps];
 	if (tiPC == PLANARCONFIG_SEPARATE) {
 		cvtToPlanar = cvtInterleavedToPlanar_LUT[1]; /* override */
@@ -1463,8 +378,17 @@ const uint32_t rec_601_luma[3] {299, 587, 114};
  * libtiff/tif_getimage.c : 1,2,4,8,16 bitspersample accepted
  * CINEMA                 : 12 bit precision
  */
+/**
+ * Read TIFF image
+ *
+ * @param filename		file name
+ * @param parameters	compress parameters
+ * @param headerTif		if not null, only the header is read: the image is
+ * 						created without component data, and the open TIFF
+ * 						handle is returned here, for the pixels to be read later
+ */
 static grk_image* tiftoimage(const char *filename,
-		grk_cparameters *parameters) {
+		grk_cparameters *parameters, TIFF **headerTif) {
 	TIFF *tif = nullptr;
 	bool found_assocalpha = false;
 	size_t alpha_count = 0;
@@ -1667,7 +591,8 @@ static grk_image* tiftoimage(const char *filename,
 		cmptparm[j].w = w;
 		cmptparm[j].h = h;
 	}
-	image = grk_image_create(numcomps, &cmptparm[0], color_space,true);
+	image = grk_image_create(numcomps, &cmptparm[0], color_space,
+			headerTif == nullptr);
 	if (!image)
 		goto cleanup;
 
@@ -1776,7 +701,11 @@ static grk_image* tiftoimage(const char *filename,
 		memcpy(image->xmp_buf, xmp_buf, xmp_len);
 	}
 	// 9. read pixel data
-	if (isSigned) {
+	if (headerTif) {
+		*headerTif = tif;
+		tif = nullptr;
+		success = true;
+	} else if (isSigned) {
 		if (tiBps == 8)
 			success =  readTiffPixelsSigned<int8_t>(tif, image->comps, numcomps, tiSpp,
 						tiPC);
@@ -1810,63 +739,105 @@ static grk_image* tiftoimage(const char *filename,
 }/* tiftoimage() */
 
 
-static int imagetotif(grk_image *image, const char *outfile,
+TIFFFormat::TIFFFormat() : TIFFFormat(0, 0, 0)
+{}
+
+TIFFFormat::TIFFFormat(uint32_t tileWidth, uint32_t tileHeight,
+		uint32_t numThreads) : m_tif(nullptr),
+							m_buf(nullptr),
+							m_bytesToWrite(0),
+							m_buffer32s(nullptr),
+							m_cvtPxToCx(nullptr),
+							m_cvt32sToTif(nullptr),
+							m_planes{nullptr},
+							m_numcomps(0),
+							m_adjust(0),
+							m_chroma_subsample_x(1),
+							m_chroma_subsample_y(1),
+							m_units(0),
+							m_subsampled(false),
+							m_stride(0),
+							m_rowsPerStrip(0),
+							m_strip(0),
+							m_rowsInStrip(0),
+							m_rows_received(0),
+							m_tileWidth(tileWidth),
+							m_tileHeight(tileHeight),
+							m_numThreads(numThreads),
+							m_tiled(false),
+							m_tileRow(0),
+							m_inputTiled(false),
+							m_chunkWidth(0),
+							m_chunkHeight(0),
+							m_tiSpp(0),
+							m_tiPC(0),
+							m_tiBps(0),
+							m_invert(false)
+{}
+
+TIFFFormat::~TIFFFormat() {
+	cleanup();
+}
+
+void TIFFFormat::cleanup(void) {
+	if (m_buf)
+		_TIFFfree((void*) m_buf);
+	m_buf = nullptr;
+	if (m_tif)
+		TIFFClose(m_tif);
+	m_tif = nullptr;
+	free(m_buffer32s);
+	m_buffer32s = nullptr;
+}
+
+bool TIFFFormat::encodeHeader(grk_image *image, const std::string &filename,
 		uint32_t compression) {
 	int tiPhoto;
-	TIFF *tif = nullptr;
-	tdata_t buf = nullptr;
-	tsize_t strip_size;
-	int32_t const *planes[maxNumComponents];
-	int32_t *buffer32s = nullptr;
-	cvtPlanarToInterleaved cvtPxToCx = nullptr;
-	cvtFrom32 cvt32sToTif = nullptr;
-	bool success = false;
 	int32_t firstExtraChannel = -1;
 	uint32_t num_colour_channels = 0;
 	size_t numExtraChannels = 0;
-	planes[0] = image->comps[0].data;
-	uint32_t numcomps = image->numcomps;
 	bool sgnd = image->comps[0].sgnd;
 	uint32_t width = image->comps[0].w;
 	uint32_t height = image->comps[0].h;
 	uint32_t bps =  image->comps[0].prec;
-	uint32_t chroma_subsample_x = 1;
-	uint32_t chroma_subsample_y = 1;
-    size_t units = image->comps->w;
-   	bool subsampled = grk::isSubsampled(image);
-   	tsize_t stride, rowsPerStrip;
-	tmsize_t bytesToWrite = 0;
-	uint32_t strip = 0;
+	const char *outfile = filename.c_str();
 
 	assert(image);
 	assert(outfile);
 
-	int32_t adjust =
+	m_image = image;
+	m_fileName = filename;
+	m_row_count = 0;
+	m_rows_received = 0;
+	m_numcomps = image->numcomps;
+	m_units = image->comps->w;
+	m_subsampled = grk::isSubsampled(image);
+	m_adjust =
 			(image->comps[0].sgnd && image->comps[0].prec < 8) ?
 					1 << (image->comps[0].prec - 1) : 0;
 	if (image->color_space == GRK_CLRSPC_CMYK) {
-		if (numcomps < 4U) {
+		if (m_numcomps < 4U) {
 			spdlog::error(
 					"imagetotif: CMYK images shall be composed of at least 4 planes.");
 			
-			return 1;
+			return false;
 		}
 		tiPhoto = PHOTOMETRIC_SEPARATED;
-		if (numcomps > 4U) {
+		if (m_numcomps > 4U) {
 			spdlog::warn("imagetotif: number of components {} is "
-						"greater than 4. Truncating to 4", numcomps);
-			numcomps = 4U;
+						"greater than 4. Truncating to 4", m_numcomps);
+			m_numcomps = 4U;
 		}
-	} else if (numcomps > 2U) {
+	} else if (m_numcomps > 2U) {
 		switch (image->color_space){
 		case GRK_CLRSPC_EYCC:
 		case GRK_CLRSPC_SYCC:
-			if (subsampled && numcomps != 3){
+			if (m_subsampled && m_numcomps != 3){
 				spdlog::error("imagetotif: subsampled YCbCr image with alpha not supported.");
-				goto cleanup;
+				return false;
 			}
-			chroma_subsample_x = image->comps[1].dx;
-			chroma_subsample_y = image->comps[1].dy;
+			m_chroma_subsample_x = image->comps[1].dx;
+			m_chroma_subsample_y = image->comps[1].dy;
 			tiPhoto = PHOTOMETRIC_YCBCR;
 			break;
 		case GRK_CLRSPC_DEFAULT_CIE:
@@ -1883,75 +854,33 @@ static int imagetotif(grk_image *image, const char *outfile,
 
 	if (bps == 0) {
 		spdlog::error("imagetotif: image precision is zero.");
-		goto cleanup;
+		return false;
 	}
 
-	if (numcomps > maxNumComponents){
+	if (m_numcomps > maxNumComponents){
 		spdlog::error(
-				"imagetotif: number of components {} must be <= %u", numcomps,maxNumComponents);
-		goto cleanup;
+				"imagetotif: number of components {} must be <= {}", m_numcomps,maxNumComponents);
+		return false;
 	}
 
 	if (!grk::all_components_sanity_check(image,true))
-		goto cleanup;
+		return false;
 
-	cvtPxToCx = cvtPlanarToInterleaved_LUT[numcomps];
-	switch (bps) {
-	case 1:
-	case 2:
-	case 4:
-	case 6:
-	case 8:
-		cvt32sToTif = cvtFrom32_LUT[bps];
-		break;
-	case 3:
-		cvt32sToTif = tif_32sto3u;
-		break;
-	case 5:
-		cvt32sToTif = tif_32sto5u;
-		break;
-	case 7:
-		cvt32sToTif = tif_32sto7u;
-		break;
-	case 9:
-		cvt32sToTif = tif_32sto9u;
-		break;
-	case 10:
-		cvt32sToTif = tif_32sto10u;
-		break;
-	case 11:
-		cvt32sToTif = tif_32sto11u;
-		break;
-	case 12:
-		cvt32sToTif = tif_32sto12u;
-		break;
-	case 13:
-		cvt32sToTif = tif_32sto13u;
-		break;
-	case 14:
-		cvt32sToTif = tif_32sto14u;
-		break;
-	case 15:
-		cvt32sToTif = tif_32sto15u;
-		break;
-	case 16:
-		cvt32sToTif = (cvtFrom32) tif_32sto16u;
-		break;
-	default:
-		break;
-	}
+	m_cvtPxToCx = cvtPlanarToInterleaved_LUT[m_numcomps];
+	if (bps <= 16)
+		m_cvt32sToTif = cvtTifFrom32_LUT[bps];
 	// extra channels
-	for (uint32_t i = 0U; i < numcomps; ++i) {
+	for (uint32_t i = 0U; i < m_numcomps; ++i) {
 		if (image->comps[i].type != GRK_COMPONENT_TYPE_COLOUR) {
 			if (firstExtraChannel == -1)
 				firstExtraChannel = (int32_t)i;
 			numExtraChannels++;
 		}
-		planes[i] = image->comps[i].data;
+		m_planes[i] = image->comps[i].data;
 	}
 	// TIFF assumes that alpha channels occur as last channels in image.
 	if (numExtraChannels > 0) {
-		num_colour_channels = (uint32_t)(numcomps - (uint32_t)numExtraChannels);
+		num_colour_channels = (uint32_t)(m_numcomps - (uint32_t)numExtraChannels);
 		if ((uint32_t)firstExtraChannel < num_colour_channels) {
 			spdlog::warn("imagetotif: TIFF requires that non-colour channels occur as "
 						"last channels in image. "
@@ -1959,45 +888,63 @@ static int imagetotif(grk_image *image, const char *outfile,
 			numExtraChannels = 0;
 		}
 	}
-	buffer32s = (int32_t*) malloc((size_t) width * numcomps * sizeof(int32_t));
-	if (buffer32s == nullptr)
-		goto cleanup;
+	m_buffer32s = (int32_t*) malloc((size_t) width * m_numcomps * sizeof(int32_t));
+	if (m_buffer32s == nullptr)
+		return false;
 
-	tif = TIFFOpen(outfile, "wb");
-	if (!tif) {
+	m_tif = TIFFOpen(outfile, "wb");
+	if (!m_tif) {
 		spdlog::error("imagetotif:failed to open {} for writing", outfile);
-		goto cleanup;
+		cleanup();
+		return false;
 	}
+	auto tif = m_tif;
 	// calculate rows per strip, base on target 8K strip size
-	if (subsampled){
-	    units = (width + chroma_subsample_x - 1) / chroma_subsample_x;
-		stride = ((width * chroma_subsample_y + units * 2) * bps + 7)/8;
-		rowsPerStrip = (chroma_subsample_y * 8 * 1024 * 1024) / stride;
+	if (m_subsampled){
+	    m_units = (width + m_chroma_subsample_x - 1) / m_chroma_subsample_x;
+		m_stride = ((width * m_chroma_subsample_y + m_units * 2) * bps + 7)/8;
+		m_rowsPerStrip = (m_chroma_subsample_y * 8 * 1024 * 1024) / m_stride;
 	} else {
-	   	stride = (width * numcomps * bps + 7U) / 8U;
-	   	rowsPerStrip = (8 * 1024 * 1024) / stride;
+	   	m_stride = (width * m_numcomps * bps + 7U) / 8U;
+	   	m_rowsPerStrip = (8 * 1024 * 1024) / m_stride;
+	}
+   	if (m_rowsPerStrip & 1)
+   		m_rowsPerStrip++;
+	if (m_rowsPerStrip > height)
+   		m_rowsPerStrip = height;
+	m_tiled = m_tileWidth && m_tileHeight;
+	if (m_tiled && m_subsampled) {
+		spdlog::warn("imagetotif: tiles are not supported for sub-sampled "
+				"YCbCr images. Writing strips instead.");
+		m_tiled = false;
+	}
+	if (m_tiled) {
+		// TIFF tile dimensions must be multiples of 16
+		m_tileWidth = (std::min<uint32_t>(m_tileWidth, width) + 15) & ~15U;
+		m_tileHeight = (std::min<uint32_t>(m_tileHeight, height) + 15) & ~15U;
 	}
-   	if (rowsPerStrip & 1)
-   		rowsPerStrip++;
-	if (rowsPerStrip > height)
-   		rowsPerStrip = height;
 
 
 	TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, width);
 	TIFFSetField(tif, TIFFTAG_IMAGELENGTH, height);
 	TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT,
 			sgnd ? SAMPLEFORMAT_INT : SAMPLEFORMAT_UINT);
-	TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, numcomps);
+	TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, m_numcomps);
 	TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, bps);
 	TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
 	TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
 	TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, tiPhoto);
-	TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
+	if (m_tiled) {
+		TIFFSetField(tif, TIFFTAG_TILEWIDTH, m_tileWidth);
+		TIFFSetField(tif, TIFFTAG_TILELENGTH, m_tileHeight);
+	} else {
+		TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, m_rowsPerStrip);
+	}
     if( tiPhoto == PHOTOMETRIC_YCBCR )	{
        	float refBlackWhite[6] = {0.0,255.0,128.0,255.0,128.0,255.0};
        	float YCbCrCoefficients[3] = {0.299f,0.587f,0.114f};
 
-		TIFFSetField( tif, TIFFTAG_YCBCRSUBSAMPLING, chroma_subsample_x, chroma_subsample_y);
+		TIFFSetField( tif, TIFFTAG_YCBCRSUBSAMPLING, m_chroma_subsample_x, m_chroma_subsample_y);
 		TIFFSetField(tif, TIFFTAG_REFERENCEBLACKWHITE, refBlackWhite);
 		TIFFSetField(tif, TIFFTAG_YCBCRCOEFFICIENTS, YCbCrCoefficients);
 		TIFFSetField(tif, TIFFTAG_YCBCRPOSITIONING, YCBCRPOSITION_CENTERED);
@@ -2031,8 +978,10 @@ static int imagetotif(grk_image *image, const char *outfile,
 		iptc_len += (4 - (iptc_len & 0x03));
 		if (iptc_len != image->iptc_len) {
 			new_iptf_buf = (uint8_t*) calloc(iptc_len, 1);
-			if (!new_iptf_buf)
-				goto cleanup;
+			if (!new_iptf_buf) {
+				cleanup();
+				return false;
+			}
 			memcpy(new_iptf_buf, image->iptc_buf, image->iptc_len);
 			iptc_buf = new_iptf_buf;
 		}
@@ -2042,7 +991,7 @@ static int imagetotif(grk_image *image, const char *outfile,
 			TIFFSwabArrayOfLong((uint32_t*) iptc_buf, iptc_len / 4);
 		TIFFSetField(tif, TIFFTAG_RICHTIFFIPTC, (uint32_t) iptc_len / 4,
 				(void*) iptc_buf);
-		free(buf);
+		free(new_iptf_buf);
 	}
 
 	if (image->capture_resolution[0] > 0 && image->capture_resolution[1] > 0) {
@@ -2058,7 +1007,7 @@ static int imagetotif(grk_image *image, const char *outfile,
 	if (numExtraChannels) {
 		std::unique_ptr<uint16[]> out(new uint16[numExtraChannels]);
 		numExtraChannels = 0;
-		for (uint32_t i = 0U; i < numcomps; ++i) {
+		for (uint32_t i = 0U; i < m_numcomps; ++i) {
 			auto comp = image->comps + i;
 			if (comp->type != GRK_COMPONENT_TYPE_COLOUR) {
 				if (comp->type == GRK_COMPONENT_TYPE_OPACITY ||
@@ -2074,94 +1023,341 @@ static int imagetotif(grk_image *image, const char *outfile,
 		TIFFSetField(tif, TIFFTAG_EXTRASAMPLES, numExtraChannels, out.get());
 	}
 
-	strip_size = TIFFStripSize(tif);
-	buf = _TIFFmalloc(strip_size);
-	if (buf == nullptr)
-		goto cleanup;
+	m_tileRow = 0;
+	if (m_tiled)
+		return true;
+	m_buf = _TIFFmalloc(TIFFStripSize(tif));
+	if (m_buf == nullptr) {
+		cleanup();
+		return false;
+	}
+	m_strip = 0;
+	m_rowsInStrip = 0;
+	m_bytesToWrite = 0;
 
+	return true;
+}
 
-    if (subsampled){
-    	auto bufptr = (int8_t*)buf;
-    	for (uint32_t h = 0; h < height; h+=chroma_subsample_y) {
-    		if (h > 0 &&  (h % rowsPerStrip == 0)){
-    			tmsize_t written =
-    					TIFFWriteEncodedStrip(tif, strip++, (void*) buf, bytesToWrite);
-    			assert(written == bytesToWrite);
-    			(void)written;
-    			bufptr = (int8_t*)buf;
-    			bytesToWrite = 0;
-    		}
-    		size_t xpos = 0;
-    		for (uint32_t u = 0; u < units; ++u){
-				for (size_t sub_h = 0; sub_h < chroma_subsample_y; ++sub_h) {
+bool TIFFFormat::writeStrip(void) {
+	if (!m_bytesToWrite)
+		return true;
+	tmsize_t written = TIFFWriteEncodedStrip(m_tif, m_strip++, (void*) m_buf,
+			m_bytesToWrite);
+	m_bytesToWrite = 0;
+	m_rowsInStrip = 0;
+
+	return written != -1;
+}
+
+/**
+ * Pack a row of tiles and write it. Tiles are packed concurrently, then
+ * encoded and written in order, as a TIFF handle can't be shared
+ * between threads.
+ */
+bool TIFFFormat::writeTileRow(uint32_t tileRow) {
+	uint32_t width = m_image->comps[0].w;
+	uint32_t height = m_image->comps[0].h;
+	uint32_t y0 = tileRow * m_tileHeight;
+	uint32_t rows = std::min<uint32_t>(m_tileHeight, height - y0);
+	uint32_t tilesAcross = (width + m_tileWidth - 1) / m_tileWidth;
+	size_t tileSize = (size_t) TIFFTileSize(m_tif);
+	size_t tileRowStride = (size_t) TIFFTileRowSize(m_tif);
+	std::unique_ptr<uint8_t[]> tiles(new uint8_t[tileSize * tilesAcross]);
+	auto numStrips = std::min<uint32_t>(
+			grk::num_strips(width, rows, m_numThreads), tilesAcross);
+
+	grk::process_strips(tilesAcross, numStrips,
+			[&](uint32_t strip, uint32_t t0, uint32_t t1) {
+				(void) strip;
+				std::unique_ptr<int32_t[]> buffer32s(
+						new int32_t[(size_t) m_tileWidth * m_numcomps]);
+				for (uint32_t t = t0; t < t1; ++t) {
+					uint32_t x0 = t * m_tileWidth;
+					uint32_t cols = std::min<uint32_t>(m_tileWidth, width - x0);
+					auto dest = tiles.get() + tileSize * t;
+					memset(dest, 0, tileSize);
+					for (uint32_t j = 0; j < rows; ++j) {
+						int32_t const *planes[maxNumComponents];
+						for (uint32_t k = 0; k < m_numcomps; ++k) {
+							auto comp = m_image->comps + k;
+							planes[k] = comp->data
+									+ (size_t) (y0 + j) * comp->stride + x0;
+						}
+						m_cvtPxToCx(planes, buffer32s.get(), cols, m_adjust);
+						m_cvt32sToTif(buffer32s.get(), dest + tileRowStride * j,
+								(size_t) cols * m_numcomps);
+					}
+				}
+				return true;
+			});
+
+	for (uint32_t t = 0; t < tilesAcross; ++t) {
+		auto tile = TIFFComputeTile(m_tif, t * m_tileWidth, y0, 0, 0);
+		if (TIFFWriteEncodedTile(m_tif, tile, tiles.get() + tileSize * t,
+				(tmsize_t) tileSize) == -1)
+			return false;
+	}
+
+	return true;
+}
+
+bool TIFFFormat::encodeStrip(uint32_t rows){
+	if (!m_tif)
+		return false;
+	uint32_t height = m_image->comps[0].h;
+	uint32_t width = m_image->comps[0].w;
+	m_rows_received = std::min<uint32_t>(m_rows_received + rows, height);
+
+	if (m_tiled) {
+		// a row of tiles is written once all of its rows have arrived
+		while (m_row_count < height) {
+			uint32_t end = std::min<uint32_t>(m_row_count + m_tileHeight,
+					height);
+			if (end > m_rows_received)
+				break;
+			if (!writeTileRow(m_tileRow++))
+				return false;
+			m_row_count = end;
+		}
+	} else if (m_subsampled) {
+		// a group of luma rows shares one chroma row, so only complete groups
+		// are packed, unless the image ends partway through a group
+		for (; m_row_count < m_rows_received; m_row_count +=
+				m_chroma_subsample_y) {
+			uint32_t h = m_row_count;
+			if (h + m_chroma_subsample_y > m_rows_received
+					&& m_rows_received < height)
+				break;
+			if (h > 0 && (h % m_rowsPerStrip == 0)) {
+				if (!writeStrip())
+					return false;
+			}
+			auto bufptr = (int8_t*) m_buf + m_bytesToWrite;
+			size_t xpos = 0;
+			for (uint32_t u = 0; u < m_units; ++u) {
+				for (size_t sub_h = 0; sub_h < m_chroma_subsample_y; ++sub_h) {
 					size_t sub_x;
-					for (sub_x =0; sub_x < chroma_subsample_x; ++sub_x){
-						bool accept = h+sub_h<height && xpos+sub_x < width;
-                		*bufptr++ = accept ? (int8_t)planes[0][xpos + sub_x + sub_h * image->comps[0].stride] : 0;
-                		bytesToWrite++;
+					for (sub_x = 0; sub_x < m_chroma_subsample_x; ++sub_x) {
+						bool accept = h + sub_h < height && xpos + sub_x < width;
+						*bufptr++ =
+								accept ? (int8_t) m_planes[0][xpos + sub_x
+												+ sub_h * m_image->comps[0].stride] :
+										0;
+						m_bytesToWrite++;
 					}
 				}
 				//2. chroma
-				*bufptr++ = (int8_t)*planes[1]++;
-				*bufptr++ = (int8_t)*planes[2]++;
-				bytesToWrite += 2;
-            	xpos+=chroma_subsample_x;
-    		}
-    		planes[0] += image->comps[0].stride * chroma_subsample_y;
-    		planes[1] += image->comps[1].stride - image->comps[1].w;
-    		planes[2] += image->comps[2].stride - image->comps[2].w;
-    	}
-    } else {
-    	tmsize_t h = 0;
-    	tmsize_t h_start = 0;
-    	while (h < height){
-    		tmsize_t byesToWrite = 0;
-			for (h = h_start; h < h_start + rowsPerStrip && (h < height); h++) {
-				cvtPxToCx(planes, buffer32s, (size_t) width, adjust);
-				cvt32sToTif(buffer32s, (uint8_t*) buf + byesToWrite, (size_t) width * numcomps);
-				for (uint32_t k = 0; k < numcomps; ++k)
-					planes[k] += image->comps[k].stride;
-				byesToWrite +=  stride;
+				*bufptr++ = (int8_t) m_planes[1][std::min<size_t>(u, m_image->comps[1].w - 1)];
+				*bufptr++ = (int8_t) m_planes[2][std::min<size_t>(u, m_image->comps[2].w - 1)];
+				m_bytesToWrite += 2;
+				xpos += m_chroma_subsample_x;
+			}
+			m_planes[0] += m_image->comps[0].stride * m_chroma_subsample_y;
+			m_planes[1] += m_image->comps[1].stride;
+			m_planes[2] += m_image->comps[2].stride;
+		}
+		m_row_count = std::min<uint32_t>(m_row_count, height);
+	} else {
+		for (; m_row_count < m_rows_received; ++m_row_count) {
+			m_cvtPxToCx(m_planes, m_buffer32s, (size_t) width, m_adjust);
+			m_cvt32sToTif(m_buffer32s, (uint8_t*) m_buf + m_bytesToWrite,
+					(size_t) width * m_numcomps);
+			for (uint32_t k = 0; k < m_numcomps; ++k)
+				m_planes[k] += m_image->comps[k].stride;
+			m_bytesToWrite += m_stride;
+			if (++m_rowsInStrip == m_rowsPerStrip) {
+				if (!writeStrip())
+					return false;
 			}
-			tmsize_t written =  TIFFWriteEncodedStrip(tif, strip++,(void*) buf, byesToWrite);
-			assert(written == byesToWrite);
-			(void)written;
-			h_start += (h - h_start);
-    	}
-    }
-	//cleanup
-	if (bytesToWrite) {
-	  tmsize_t written =  TIFFWriteEncodedStrip(tif, strip++, (void*) buf, bytesToWrite);
-	  (void)written;
-	  assert(written == bytesToWrite);
+		}
 	}
 
-	success = true;
-	cleanup: if (buf)
-		_TIFFfree((void*) buf);
-	if (tif)
+	return true;
+}
+bool TIFFFormat::encodeFinish(void){
+	bool rc = m_tif != nullptr;
+	if (m_tif) {
+		if (m_row_count < m_image->comps[0].h) {
+			spdlog::warn("Full image was not written");
+			rc = false;
+		}
+		if (!writeStrip())
+			rc = false;
+	}
+	cleanup();
+
+	return rc;
+}
+grk_image* TIFFFormat::decode(const std::string &filename,
+		grk_cparameters *parameters) {
+	return tiftoimage(filename.c_str(), parameters, nullptr);
+}
+
+grk_image* TIFFFormat::decodeHeader(const std::string &filename,
+		grk_cparameters *parameters) {
+	// cinema profiles rescale the whole image after it is read
+	if (GRK_IS_CINEMA(parameters->rsiz))
+		return nullptr;
+	TIFF *tif = nullptr;
+	auto image = tiftoimage(filename.c_str(), parameters, &tif);
+	if (!image)
+		return nullptr;
+	uint16_t tiPhoto = 0;
+	uint16_t chroma_subsample_x = 1;
+	uint16_t chroma_subsample_y = 1;
+	TIFFGetFieldDefaulted(tif, TIFFTAG_PHOTOMETRIC, &tiPhoto);
+	TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &m_tiSpp);
+	TIFFGetFieldDefaulted(tif, TIFFTAG_PLANARCONFIG, &m_tiPC);
+	TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &m_tiBps);
+	if (tiPhoto == PHOTOMETRIC_YCBCR)
+		TIFFGetFieldDefaulted(tif, TIFFTAG_YCBCRSUBSAMPLING,
+				&chroma_subsample_x, &chroma_subsample_y);
+	// sub-sampled chroma is packed together with luma, so it is read whole
+	if (chroma_subsample_x != 1 || chroma_subsample_y != 1
+			|| m_tiSpp != image->numcomps || !getCvtTifTo32s(m_tiBps)) {
 		TIFFClose(tif);
-	if (buffer32s)
-		free(buffer32s);
+		grk_image_destroy(image);
+		return nullptr;
+	}
+	m_tif = tif;
+	m_image = image;
+	m_invert = tiPhoto == PHOTOMETRIC_MINISWHITE;
+	m_inputTiled = TIFFIsTiled(tif);
+	if (m_inputTiled) {
+		TIFFGetField(tif, TIFFTAG_TILEWIDTH, &m_chunkWidth);
+		TIFFGetField(tif, TIFFTAG_TILELENGTH, &m_chunkHeight);
+	} else {
+		uint32_t rowsPerStrip = 0;
+		TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+		m_chunkWidth = image->comps[0].w;
+		m_chunkHeight = std::min<uint32_t>(rowsPerStrip, image->comps[0].h);
+	}
+	if (!m_chunkWidth || !m_chunkHeight) {
+		cleanup();
+		grk_image_destroy(image);
+		m_image = nullptr;
+		return nullptr;
+	}
+	m_chunks.clear();
 
-	return success ? 0 : 1;
-}/* imagetotif() */
+	return image;
+}
 
-bool TIFFFormat::encodeHeader(grk_image *image, const std::string &filename,
-		uint32_t compressionParam) {
-	return imagetotif(image, filename.c_str(), compressionParam) ? false : true;
+/**
+ * Get the decoded strip or tile holding a sample, reading it from the file
+ * if it has not already been read
+ */
+const TIFFFormat::TiffChunk* TIFFFormat::getChunk(uint32_t x, uint32_t y,
+		uint32_t plane) {
+	bool separate = m_tiPC == PLANARCONFIG_SEPARATE;
+	uint16_t sample = separate ? (uint16_t) plane : 0;
+	uint32_t index =
+			m_inputTiled ?
+					TIFFComputeTile(m_tif, x, y, 0, sample) :
+					TIFFComputeStrip(m_tif, y, sample);
+	auto iter = m_chunks.find(index);
+	if (iter != m_chunks.end())
+		return &iter->second;
+
+	TiffChunk chunk;
+	chunk.x0 = (x / m_chunkWidth) * m_chunkWidth;
+	chunk.y0 = (y / m_chunkHeight) * m_chunkHeight;
+	chunk.x1 = std::min<uint32_t>(chunk.x0 + m_chunkWidth, m_image->comps[0].w);
+	chunk.y1 = std::min<uint32_t>(chunk.y0 + m_chunkHeight, m_image->comps[0].h);
+	uint32_t samples = separate ? 1 : m_tiSpp;
+	uint32_t rows = chunk.y1 - chunk.y0;
+	size_t rowStride = ((size_t) m_chunkWidth * samples * m_tiBps + 7U) / 8U;
+	tmsize_t chunkSize = m_inputTiled ? TIFFTileSize(m_tif) : TIFFStripSize(m_tif);
+	std::unique_ptr<uint8_t[]> buf(new uint8_t[(size_t) chunkSize]);
+	tmsize_t ssize = m_inputTiled ?
+			TIFFReadEncodedTile(m_tif, index, buf.get(), chunkSize) :
+			TIFFReadEncodedStrip(m_tif, index, buf.get(), chunkSize);
+	if (ssize < 1 || (size_t) ssize < rowStride * rows) {
+		spdlog::error("tiftoimage: Bad value for ssize({}) "
+				"vs. chunk size({}).", (long long) ssize,
+				(long long) (rowStride * rows));
+		return nullptr;
+	}
+
+	size_t area = (size_t) m_chunkWidth * rows;
+	chunk.data.resize(area * samples);
+	std::unique_ptr<int32_t[]> buffer32s(
+			new int32_t[(size_t) m_chunkWidth * samples]);
+	auto cvtTifTo32s = getCvtTifTo32s(m_tiBps);
+	auto cvtToPlanar = cvtInterleavedToPlanar_LUT[samples];
+	bool sgnd = m_image->comps[0].sgnd;
+	int32_t *planes[maxNumComponents];
+	for (uint32_t j = 0; j < rows; ++j) {
+		auto src = buf.get() + rowStride * j;
+		size_t len = (size_t) m_chunkWidth * samples;
+		if (sgnd && m_tiBps == 8) {
+			for (size_t i = 0; i < len; ++i)
+				buffer32s[i] = ((const int8_t*) src)[i];
+		} else if (sgnd) {
+			for (size_t i = 0; i < len; ++i)
+				buffer32s[i] = ((const int16_t*) src)[i];
+		} else {
+			cvtTifTo32s(src, buffer32s.get(), len, m_invert);
+		}
+		for (uint32_t s = 0; s < samples; ++s)
+			planes[s] = chunk.data.data() + area * s + (size_t) m_chunkWidth * j;
+		cvtToPlanar(buffer32s.get(), planes, m_chunkWidth);
+	}
+
+	return &(m_chunks[index] = std::move(chunk));
 }
-bool TIFFFormat::encodeStrip(uint32_t rows){
 
+template<typename T> bool TIFFFormat::copyTile(uint32_t x0, uint32_t y0,
+		uint32_t x1, uint32_t y1, uint32_t compno, T *dest) {
+	uint32_t sample = m_tiPC == PLANARCONFIG_SEPARATE ? 0 : compno;
+	for (uint32_t y = y0; y < y1; ++y) {
+		for (uint32_t x = x0; x < x1;) {
+			auto chunk = getChunk(x, y, compno);
+			if (!chunk)
+				return false;
+			uint32_t end = std::min<uint32_t>(x1, chunk->x1);
+			size_t area = (size_t) m_chunkWidth * (chunk->y1 - chunk->y0);
+			auto src = chunk->data.data() + area * sample
+					+ (size_t) (y - chunk->y0) * m_chunkWidth + (x - chunk->x0);
+			for (; x < end; ++x)
+				*dest++ = (T) *src++;
+		}
+	}
 
 	return true;
 }
-bool TIFFFormat::encodeFinish(void){
+
+bool TIFFFormat::decodeTile(uint32_t x0, uint32_t y0, uint32_t x1,
+		uint32_t y1, uint8_t *dest) {
+	if (!m_tif || !m_image)
+		return false;
+	// tiles are requested in raster order, so chunks above
+	// this tile will not be needed again
+	for (auto iter = m_chunks.begin(); iter != m_chunks.end();) {
+		if (iter->second.y1 <= y0)
+			iter = m_chunks.erase(iter);
+		else
+			++iter;
+	}
+	size_t area = (size_t) (x1 - x0) * (y1 - y0);
+	for (uint32_t compno = 0; compno < m_image->numcomps; ++compno) {
+		auto comp = m_image->comps + compno;
+		bool rc;
+		if (comp->prec > 8) {
+			rc = comp->sgnd ?
+					copyTile<int16_t>(x0, y0, x1, y1, compno, (int16_t*) dest) :
+					copyTile<uint16_t>(x0, y0, x1, y1, compno, (uint16_t*) dest);
+			dest += area * sizeof(uint16_t);
+		} else {
+			rc = comp->sgnd ?
+					copyTile<int8_t>(x0, y0, x1, y1, compno, (int8_t*) dest) :
+					copyTile<uint8_t>(x0, y0, x1, y1, compno, dest);
+			dest += area;
+		}
+		if (!rc)
+			return false;
+	}
 
 	return true;
 }
-grk_image* TIFFFormat::decode(const std::string &filename,
-		grk_cparameters *parameters) {
-	return tiftoimage(filename.c_str(), parameters);
-}
 
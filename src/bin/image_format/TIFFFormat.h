@@ -16,15 +16,85 @@
 
 #pragma once
 #include "ImageFormat.h"
+#include "convert.h"
+#include <tiffio.h>
+#include <map>
+#include <vector>
 
 
  /* TIFF conversion*/
 void tiffSetErrorAndWarningHandlers(bool verbose);
 
+const size_t maxNumComponents = 10;
+
 class TIFFFormat: public ImageFormat {
 public:
+	TIFFFormat();
+	/**
+	 * Create a TIFF writer
+	 *
+	 * @param tileWidth		width of TIFF tiles, or zero to write strips
+	 * @param tileHeight	height of TIFF tiles, or zero to write strips
+	 * @param numThreads	number of threads used to pack tiles,
+	 * 						or zero for hardware concurrency
+	 */
+	TIFFFormat(uint32_t tileWidth, uint32_t tileHeight, uint32_t numThreads);
+	~TIFFFormat();
 	bool encodeHeader(grk_image *  image, const std::string &filename, uint32_t compressionParam) override;
 	bool encodeStrip(uint32_t rows) override;
 	bool encodeFinish(void) override;
 	grk_image *  decode(const std::string &filename,  grk_cparameters  *parameters) override;
+	grk_image *  decodeHeader(const std::string &filename,  grk_cparameters  *parameters) override;
+	bool decodeTile(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint8_t *dest) override;
+private:
+	/** decoded strip or tile of the input file, as planar samples */
+	struct TiffChunk {
+		uint32_t x0, y0, x1, y1;
+		std::vector<int32_t> data;
+	};
+	const TiffChunk* getChunk(uint32_t x, uint32_t y, uint32_t plane);
+	template<typename T> bool copyTile(uint32_t x0, uint32_t y0, uint32_t x1,
+			uint32_t y1, uint32_t compno, T *dest);
+
+	bool writeStrip(void);
+	bool writeTileRow(uint32_t tileRow);
+	void cleanup(void);
+
+	TIFF *m_tif;
+	/** packed rows of the current strip */
+	tdata_t m_buf;
+	tmsize_t m_bytesToWrite;
+	int32_t *m_buffer32s;
+	cvtPlanarToInterleaved m_cvtPxToCx;
+	cvtFrom32 m_cvt32sToTif;
+	int32_t const *m_planes[maxNumComponents];
+	uint32_t m_numcomps;
+	int32_t m_adjust;
+	uint32_t m_chroma_subsample_x;
+	uint32_t m_chroma_subsample_y;
+	size_t m_units;
+	bool m_subsampled;
+	tsize_t m_stride;
+	tsize_t m_rowsPerStrip;
+	uint32_t m_strip;
+	tsize_t m_rowsInStrip;
+	/** rows handed to encodeStrip so far */
+	uint32_t m_rows_received;
+	uint32_t m_tileWidth;
+	uint32_t m_tileHeight;
+	uint32_t m_numThreads;
+	/** write tiles rather than strips */
+	bool m_tiled;
+	/** next row of tiles to write */
+	uint32_t m_tileRow;
+
+	/** decoded chunks of the current row of tiles, by chunk index */
+	std::map<uint32_t, TiffChunk> m_chunks;
+	bool m_inputTiled;
+	uint32_t m_chunkWidth;
+	uint32_t m_chunkHeight;
+	uint16_t m_tiSpp;
+	uint16_t m_tiPC;
+	uint16_t m_tiBps;
+	bool m_invert;
 };
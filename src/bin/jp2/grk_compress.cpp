@@ -37,6 +37,7 @@
 #endif /* _WIN32 */
 
 #include "common.h"
+#include "batch.h"
 using namespace grk;
 
 #include "grk_apps_config.h"
@@ -65,6 +66,8 @@ using namespace grk;
 #include <cstddef>
 #include <cstdlib>
 #include <sstream>
+#include <iomanip>
+#include <memory>
 #define TCLAP_NAMESTARTSTRING "-"
 #include "tclap/CmdLine.h"
 #include <chrono>
@@ -190,12 +193,17 @@ static void encode_help_display(void) {
 	fprintf(stdout, "    Required only if [ImgDir] is used\n");
 	fprintf(stdout,	"[-K|-InFor] <pbm|pgm|ppm|pnm|pam|pgx|png|bmp|tif|raw|rawl>\n");
 	fprintf(stdout, "    Input format. Will override file tag.\n");
-	fprintf(stdout,	"[-F|-Raw] <width>,<height>,<ncomp>,<bitdepth>,{s,u}@<dx1>x<dy1>:...:<dxn>x<dyn>\n");
+	fprintf(stdout,	"[-F|-Raw] <width>,<height>,<ncomp>,<bitdepth>,{s,u}[,{p,i}]@<dx1>x<dy1>:...:<dxn>x<dyn>\n");
 	fprintf(stdout, "    Characteristics of the raw input image\n");
 	fprintf(stdout,	"    If subsampling is omitted, 1x1 is assumed for all components\n");
+	fprintf(stdout,	"    Components are planar (p), which is the default, or\n");
+	fprintf(stdout,	"    interleaved sample by sample (i), which requires 1x1 subsampling\n");
 	fprintf(stdout, "      Example: -F 512,512,3,8,u@1x1:2x2:2x2\n");
 	fprintf(stdout,	"               for raw 512x512 image with 4:2:0 subsampling\n");
 	fprintf(stdout,	"    Required only if RAW or RAWL input file is provided.\n");
+	fprintf(stdout,	"    A file holding a sequence of raw frames is compressed\n");
+	fprintf(stdout,	"    frame by frame, to one output file per frame, named\n");
+	fprintf(stdout,	"    by appending the frame number to the output file name.\n");
 	fprintf(stdout, "\n");
 	fprintf(stdout, "Optional Parameters:\n");
 	fprintf(stdout, "\n");
@@ -824,9 +832,10 @@ static int parse_cmdline_encoder_ex(int argc, char **argv,
 			}
 			memcpy(substr1, rawFormatArg.getValue().c_str(), len);
 			substr1[len] = '\0';
-			char signo;
-			if (sscanf(substr1, "%d,%d,%d,%d,%c", &width, &height, &ncomp,
-					&bitdepth, &signo) == 5) {
+			char signo, layout = 'p';
+			int nfields = sscanf(substr1, "%d,%d,%d,%d,%c,%c", &width, &height,
+					&ncomp, &bitdepth, &signo, &layout);
+			if (nfields == 5 || nfields == 6) {
 				if (signo == 's') {
 					raw_signed = true;
 				} else if (signo == 'u') {
@@ -834,6 +843,8 @@ static int parse_cmdline_encoder_ex(int argc, char **argv,
 				} else {
 					wrong = true;
 				}
+				if (layout != 'p' && layout != 'i')
+					wrong = true;
 			} else {
 				wrong = true;
 			}
@@ -847,6 +858,7 @@ static int parse_cmdline_encoder_ex(int argc, char **argv,
 				raw_cp->numcomps = (uint16_t) ncomp;
 				raw_cp->prec = (uint32_t) bitdepth;
 				raw_cp->sgnd = raw_signed;
+				raw_cp->interleaved = layout == 'i';
 				raw_cp->comps = (grk_raw_comp_cparameters*) malloc(
 						((uint32_t) (ncomp))
 								* sizeof(grk_raw_comp_cparameters));
@@ -888,7 +900,7 @@ static int parse_cmdline_encoder_ex(int argc, char **argv,
 				spdlog::error("\n invalid raw image parameters");
 				spdlog::error("Please use the Format option -F:");
 				spdlog::error(
-						"-F <width>,<height>,<ncomp>,<bitdepth>,{s,u}@<dx1>x<dy1>:...:<dxn>x<dyn>");
+						"-F <width>,<height>,<ncomp>,<bitdepth>,{s,u}[,{p,i}]@<dx1>x<dy1>:...:<dxn>x<dyn>");
 				spdlog::error(
 						"If subsampling is omitted, 1x1 is assumed for all components");
 				spdlog::error(
@@ -1652,27 +1664,31 @@ static int plugin_main(int argc, char **argv, CompressInitParams *initParams);
 
 // returns 0 if failed, 1 if succeeded, 
 // and 2 if file is not suitable for compression
-static int compress(const std::string &image_filename, CompressInitParams *initParams) {
+// uncompressed bytes that warrant one thread of the batch budget
+const uint64_t batch_bytes_per_thread = 8 * 1024 * 1024;
+
+static int compress(const std::string &image_filename, CompressInitParams *initParams,
+		grk_cparameters *parameters) {
 	//clear for next file compress
-	initParams->parameters.write_capture_resolution_from_file = false;
+	parameters->write_capture_resolution_from_file = false;
 	// don't reset format if reading from STDIN
-	if (initParams->parameters.infile[0])
-		initParams->parameters.decod_format = GRK_UNK_FMT;
+	if (parameters->infile[0])
+		parameters->decod_format = GRK_UNK_FMT;
 
 	if (initParams->img_fol.set_imgdir) {
 		if (get_next_file(image_filename, &initParams->img_fol,
 				initParams->out_fol.set_imgdir ?
 						&initParams->out_fol : &initParams->img_fol,
-				&initParams->parameters)) {
+				parameters)) {
 			return 2;
 		}
 	}
 	grk_plugin_encode_user_callback_info callbackInfo;
 	memset(&callbackInfo, 0, sizeof(grk_plugin_encode_user_callback_info));
-	callbackInfo.encoder_parameters = &initParams->parameters;
+	callbackInfo.encoder_parameters = parameters;
 	callbackInfo.image = nullptr;
-	callbackInfo.output_file_name = initParams->parameters.outfile;
-	callbackInfo.input_file_name = initParams->parameters.infile;
+	callbackInfo.output_file_name = parameters->outfile;
+	callbackInfo.input_file_name = parameters->infile;
 
 	return plugin_compress_callback(&callbackInfo) ? 1 : 0;
 }
@@ -1705,30 +1721,29 @@ int main(int argc, char **argv) {
 		for (uint32_t i = 0; i < initParams.parameters.repeats; ++i) {
 			if (!initParams.img_fol.set_imgdir) {
 				initParams.parameters = parametersCache;
-				if (compress("", &initParams) == 0) {
+				if (compress("", &initParams, &initParams.parameters) == 0) {
 					success = 1;
 					goto cleanup;
 				}
 				num_compressed_files++;
 			} else {
-				auto dir = opendir(initParams.img_fol.imgdirpath);
-				if (!dir) {
-					spdlog::error("Could not open Folder {}",
-							initParams.img_fol.imgdirpath);
+				std::vector<std::string> files;
+				if (!BatchScheduler::list_files(initParams.img_fol.imgdirpath,
+						&files)) {
 					success = 1;
 					goto cleanup;
 				}
-				struct dirent *content = nullptr;
-				while ((content = readdir(dir)) != nullptr) {
-					if (strcmp(".", content->d_name) == 0
-							|| strcmp("..", content->d_name) == 0)
-						continue;
-					initParams.parameters = parametersCache;
-					if (compress(content->d_name, &initParams) == 1){
-						num_compressed_files++;
-					}
-				}
-				closedir(dir);
+				// each file is compressed with its own copy of the cached settings,
+				// limited to its share of the thread budget
+				BatchScheduler batch(parametersCache.numThreads,
+						batch_bytes_per_thread);
+				num_compressed_files += batch.run(initParams.img_fol.imgdirpath,
+						files, [&initParams, &parametersCache](const std::string &file,
+								uint32_t threads) {
+							auto parameters = parametersCache;
+							parameters.numThreads = threads;
+							return compress(file, &initParams, &parameters);
+						});
 			}
 		}
 		auto finish = std::chrono::high_resolution_clock::now();
@@ -1750,6 +1765,113 @@ int main(int argc, char **argv) {
 
 grk_img_fol img_fol_plugin, out_fol_plugin;
 
+/**
+ * Compress an image tile by tile, in raster order, pulling the samples
+ * of each tile from the source file just before the tile is compressed
+ *
+ * @param codec			compression codec
+ * @param parameters	compression parameters
+ * @param image			image header, with no component data
+ * @param source		source file, opened with decodeHeader
+ *
+ * @return true if successful
+ */
+static bool compress_tiles(grk_codec codec, grk_cparameters *parameters,
+		grk_image *image, IImageFormat *source) {
+	uint64_t tw = parameters->t_width;
+	uint64_t th = parameters->t_height;
+	if (!tw || !th)
+		return false;
+	uint32_t numTilesX = (uint32_t) ((image->x1 - parameters->tx0 + tw - 1) / tw);
+	uint32_t numTilesY = (uint32_t) ((image->y1 - parameters->ty0 + th - 1) / th);
+	uint64_t pixelBytes = 0;
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno)
+		pixelBytes += (image->comps[compno].prec + 7U) / 8U;
+	std::unique_ptr<uint8_t[]> buf(new uint8_t[tw * th * pixelBytes]);
+	for (uint32_t tileY = 0; tileY < numTilesY; ++tileY) {
+		uint32_t y0 = (uint32_t) std::max<uint64_t>(parameters->ty0 + tileY * th,
+				image->y0);
+		uint32_t y1 = (uint32_t) std::min<uint64_t>(
+				parameters->ty0 + (tileY + 1) * th, image->y1);
+		for (uint32_t tileX = 0; tileX < numTilesX; ++tileX) {
+			uint32_t x0 = (uint32_t) std::max<uint64_t>(
+					parameters->tx0 + tileX * tw, image->x0);
+			uint32_t x1 = (uint32_t) std::min<uint64_t>(
+					parameters->tx0 + (tileX + 1) * tw, image->x1);
+			if (!source->decodeTile(x0 - image->x0, y0 - image->y0,
+					x1 - image->x0, y1 - image->y0, buf.get())) {
+				spdlog::error("Unable to read tile {} from {}",
+						tileY * numTilesX + tileX, parameters->infile);
+				return false;
+			}
+			uint64_t size = (uint64_t) (x1 - x0) * (y1 - y0) * pixelBytes;
+			if (!grk_compress_tile(codec, (uint16_t) (tileY * numTilesX + tileX),
+					buf.get(), size))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Output file name of a frame of a sequence: the frame number
+ * is inserted before the file extension
+ */
+static std::string frame_file_name(const std::string &outfile,
+		uint64_t frameno) {
+	auto dot = outfile.find_last_of('.');
+	auto sep = outfile.find_last_of("/\\");
+	if (dot == std::string::npos || (sep != std::string::npos && dot < sep))
+		dot = outfile.length();
+	std::ostringstream name;
+	name << outfile.substr(0, dot) << "_" << std::setw(5) << std::setfill('0')
+			<< frameno << outfile.substr(dot);
+
+	return name.str();
+}
+
+/**
+ * Compress each frame of a raw sequence straight from the raw file.
+ * The first frame is written to the codec's stream, and each
+ * following frame to its own file.
+ *
+ * @param codec			compression codec, initialized with grk_init_compress
+ * @param sequenceFile	output file name of the sequence
+ * @param source		raw sequence, opened with decodeHeader
+ *
+ * @return true if successful
+ */
+static bool compress_raw_frames(grk_codec codec,
+		const std::string &sequenceFile, RAWFormat *source) {
+	uint64_t numFrames = source->numFrames();
+	for (uint64_t frameno = 0; frameno < numFrames; ++frameno) {
+		auto data = source->frame(frameno);
+		if (!data)
+			return false;
+		grk_stream *stream = nullptr;
+		if (frameno > 0) {
+			auto frameFile = frame_file_name(sequenceFile, frameno);
+			stream = grk_stream_create_file_stream(frameFile.c_str(),
+					1024 * 1024, false);
+			if (!stream) {
+				spdlog::error("failed to create stream for {}", frameFile);
+				return false;
+			}
+		}
+		bool rc = grk_compress_raw_frame(codec, data, source->frameLength(),
+				source->frameLayout(), stream);
+		if (stream)
+			grk_stream_destroy(stream);
+		if (!rc) {
+			spdlog::error("failed to compress frame {}", frameno);
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static bool plugin_compress_callback(
 		grk_plugin_encode_user_callback_info *info) {
 	grk_cparameters *parameters = info->encoder_parameters;
@@ -1761,6 +1883,9 @@ static bool plugin_compress_callback(
 	char temp_ofname[GRK_PATH_LEN];
 	bool createdImage = false;
 	bool inMemoryCompression = false;
+	std::unique_ptr<IImageFormat> source;
+	std::unique_ptr<RAWFormat> rawSource;
+	std::string sequenceFile;
 
 	// get output file
 	outfile[0] = 0;
@@ -1836,8 +1961,18 @@ static bool plugin_compress_callback(
 
 #ifdef GROK_HAVE_LIBTIFF
 		case GRK_TIF_FMT: {
+			// when tiling without a plugin, tiles are read from the file
+			// as they are compressed, instead of loading the whole image
+			if (parameters->tile_size_on && !info->tile) {
+				source.reset(new TIFFFormat());
+				image = source->decodeHeader(info->input_file_name,
+						info->encoder_parameters);
+				if (!image)
+					source.reset();
+			}
 			TIFFFormat tif;
-			image = tif.decode(info->input_file_name, info->encoder_parameters);
+			if (!image)
+				image = tif.decode(info->input_file_name, info->encoder_parameters);
 			if (!image) {
 				bSuccess = false;
 				goto cleanup;
@@ -1846,20 +1981,26 @@ static bool plugin_compress_callback(
 			break;
 #endif /* GROK_HAVE_LIBTIFF */
 
-		case GRK_RAW_FMT: {
-			RAWFormat raw(true);
-			image = raw.decode(info->input_file_name, info->encoder_parameters);
-			if (!image) {
-				spdlog::error("Unable to load raw file");
-				bSuccess = false;
-				goto cleanup;
-			}
-		}
-			break;
-
+		case GRK_RAW_FMT:
 		case GRK_RAWL_FMT: {
-			RAWFormat raw(false);
-			image = raw.decode(info->input_file_name, info->encoder_parameters);
+			bool bigEndian = info->encoder_parameters->decod_format == GRK_RAW_FMT;
+			// without a plugin, the frames of a sequence are compressed
+			// straight from the file; a single frame is read as an image,
+			// so that its rate control is not subject to a frame budget
+			if (!info->tile) {
+				rawSource.reset(new RAWFormat(bigEndian));
+				image = rawSource->decodeHeader(info->input_file_name,
+						info->encoder_parameters);
+				if (image && rawSource->numFrames() < 2) {
+					grk_image_destroy(image);
+					image = nullptr;
+				}
+				if (!image)
+					rawSource.reset();
+			}
+			RAWFormat raw(bigEndian);
+			if (!image)
+				image = raw.decode(info->input_file_name, info->encoder_parameters);
 			if (!image) {
 				spdlog::error("Unable to load raw file");
 				bSuccess = false;
@@ -2035,6 +2176,18 @@ static bool plugin_compress_callback(
 					msamplespersec, limit);
 	}
 
+	// each frame of a raw sequence is written to its own file
+	if (rawSource) {
+		sequenceFile = outfile;
+		spdlog::info("Compressing {} frames from {}",
+				rawSource->numFrames(), info->input_file_name);
+		if (grk::strcpy_s(outfile, sizeof(outfile),
+				frame_file_name(sequenceFile, 0).c_str()) != 0) {
+			bSuccess = false;
+			goto cleanup;
+		}
+	}
+
 	if (info->compressBuffer) {
 		// let stream clean up compress buffer
 		stream = grk_stream_create_mem_stream(info->compressBuffer,
@@ -2076,26 +2229,37 @@ static bool plugin_compress_callback(
 		goto cleanup;
 	}
 
-	/* compress the image */
-	bSuccess = grk_start_compress(codec);
-	if (!bSuccess) {
-		spdlog::error("failed to compress image: grk_start_compress");
-		bSuccess = false;
-		goto cleanup;
-	}
+	if (rawSource) {
+		bSuccess = compress_raw_frames(codec, sequenceFile, rawSource.get());
+		if (!bSuccess) {
+			spdlog::error("failed to compress image: grk_compress_raw_frame");
+			goto cleanup;
+		}
+	} else {
+		/* compress the image */
+		bSuccess = grk_start_compress(codec);
+		if (!bSuccess) {
+			spdlog::error("failed to compress image: grk_start_compress");
+			bSuccess = false;
+			goto cleanup;
+		}
 
-	bSuccess = grk_compress_with_plugin(codec, info->tile);
-	if (!bSuccess) {
-		spdlog::error("failed to compress image: grk_compress");
-		bSuccess = false;
-		goto cleanup;
-	}
+		if (source)
+			bSuccess = compress_tiles(codec, parameters, image, source.get());
+		else
+			bSuccess = grk_compress_with_plugin(codec, info->tile);
+		if (!bSuccess) {
+			spdlog::error("failed to compress image: grk_compress");
+			bSuccess = false;
+			goto cleanup;
+		}
 
-	bSuccess = bSuccess && grk_end_compress(codec);
-	if (!bSuccess) {
-		spdlog::error("failed to compress image: grk_end_compress");
-		bSuccess = false;
-		goto cleanup;
+		bSuccess = bSuccess && grk_end_compress(codec);
+		if (!bSuccess) {
+			spdlog::error("failed to compress image: grk_end_compress");
+			bSuccess = false;
+			goto cleanup;
+		}
 	}
 	if (info->compressBuffer) {
 		auto fp = fopen(outfile, "wb");
@@ -40,6 +40,7 @@
 #endif /* _WIN32 */
 
 #include "common.h"
+#include "batch.h"
 using namespace grk;
 
 #include "grok.h"
@@ -64,6 +65,7 @@ using namespace grk;
 #include "color.h"
 #include "grok_string.h"
 #include <climits>
+#include <memory>
 #include <string>
 #define TCLAP_NAMESTARTSTRING "-"
 #include "tclap/CmdLine.h"
@@ -176,6 +178,14 @@ static void decode_help_display(void) {
 			"    \"Quality\" of compression. Currently only implemented for PNG format.\n"
 			"	Default value is set to 9 (Z_BEST_COMPRESSION).\n"
 			"	Other options are 0 (Z_NO_COMPRESSION) and 1 (Z_BEST_SPEED)\n");
+	fprintf(stdout,
+			"  [-T | -TiledTIFF] <J2K | tile width,tile height>\n"
+			"    Write TIFF tiles rather than strips. J2K uses the code stream tile\n"
+			"    size; otherwise, tile dimensions are given explicitly.\n"
+			"    TIFF tile dimensions are rounded up to multiples of 16, and TIFF\n"
+			"    tiles start at the image origin, so J2K only maps code stream tiles\n"
+			"    one to one onto TIFF tiles when the tile grid starts at the image\n"
+			"    origin and the reduced tile size is a multiple of 16.\n");
 	fprintf(stdout, "  [-t | -TileIndex] <tile index>\n"
 			"    Index of tile to be decoded\n");
 	fprintf(stdout,
@@ -474,6 +484,8 @@ int parse_cmdline_decoder(int argc, char **argv,
 				"Compression Type", false, "", "string", cmd);
 		ValueArg<uint32_t> compressionLevelArg("L", "CompressionLevel",
 				"Compression Level", false, UINT_MAX, "unsigned integer", cmd);
+		ValueArg<string> tiffTilesArg("T", "TiledTIFF", "Tiled TIFF output",
+				false, "", "string", cmd);
 		ValueArg<uint32_t> durationArg("z", "Duration", "Duration in seconds",
 				false, 0, "unsigned integer", cmd);
 
@@ -524,6 +536,19 @@ int parse_cmdline_decoder(int argc, char **argv,
 		if (compressionLevelArg.isSet()) {
 			parameters->compressionLevel = compressionLevelArg.getValue();
 		}
+		if (tiffTilesArg.isSet()) {
+			auto tiles = tiffTilesArg.getValue();
+			if (tiles == "J2K" || tiles == "j2k") {
+				parameters->tiff_tiles_from_codestream = true;
+			} else if (sscanf(tiles.c_str(), "%u,%u",
+					&parameters->tiff_tile_width,
+					&parameters->tiff_tile_height) != 2
+					|| !parameters->tiff_tile_width
+					|| !parameters->tiff_tile_height) {
+				spdlog::error("Invalid TIFF tile dimensions {}", tiles);
+				return 1;
+			}
+		}
 		// process
 		if (inputFileArg.isSet()) {
 			const char *infile = inputFileArg.getValue().c_str();
@@ -870,132 +895,63 @@ static grk_image* convert_gray_to_rgb(grk_image *original) {
 
 /* -------------------------------------------------------------------------- */
 
-static grk_image* upsample_image_components(grk_image *original) {
-	grk_image *new_image = nullptr;
-	grk_image_cmptparm *new_components = nullptr;
-	bool upsample_need = false;
-	uint32_t compno;
-
-	if (!original || !original->comps)
-		return nullptr;
-
-	for (compno = 0U; compno < original->numcomps; ++compno) {
-		if (!(original->comps + compno))
-			return nullptr;
-		if ((original->comps[compno].dx > 1U)
-				|| (original->comps[compno].dy > 1U)) {
-			upsample_need = true;
-			break;
-		}
-	}
-	if (!upsample_need) {
-		return original;
-	}
-	/* Upsample is needed */
-	new_components = (grk_image_cmptparm*) malloc(
-			original->numcomps * sizeof(grk_image_cmptparm));
-	if (new_components == nullptr) {
-		spdlog::error(
-				"grk_decompress: failed to allocate memory for upsampled components.");
-		grk_image_destroy(original);
-		return nullptr;
-	}
-
-	for (compno = 0U; compno < original->numcomps; ++compno) {
-		auto new_cmp = &(new_components[compno]);
-		auto org_cmp = &(original->comps[compno]);
+/**
+ * Upsample sub-sampled components to the image grid, in place:
+ * only the sub-sampled components are reallocated
+ */
+static bool upsample_image_components(grk_image *image) {
+	if (!image || !image->comps)
+		return false;
 
-		new_cmp->prec = org_cmp->prec;
-		new_cmp->sgnd = org_cmp->sgnd;
-		new_cmp->x0 = original->x0;
-		new_cmp->y0 = original->y0;
-		new_cmp->dx = 1;
-		new_cmp->dy = 1;
-		new_cmp->w = org_cmp->w; /* should be original->x1 - original->x0 for dx==1 */
-		new_cmp->h = org_cmp->h; /* should be original->y1 - original->y0 for dy==0 */
+	for (uint32_t compno = 0U; compno < image->numcomps; ++compno) {
+		auto org_cmp = image->comps + compno;
+		if (org_cmp->dx <= 1U && org_cmp->dy <= 1U)
+			continue;
 
+		grk_image_comp up = *org_cmp;
+		up.data = nullptr;
+		up.owns_data = false;
+		up.x0 = image->x0;
+		up.y0 = image->y0;
+		up.dx = 1;
+		up.dy = 1;
 		if (org_cmp->dx > 1U)
-			new_cmp->w = original->x1 - original->x0;
+			up.w = image->x1 - image->x0;
 		if (org_cmp->dy > 1U)
-			new_cmp->h = original->y1 - original->y0;
-	}
-
-	new_image = grk_image_create(original->numcomps, new_components,
-			original->color_space,true);
-	free(new_components);
-	if (new_image == nullptr) {
-		spdlog::error(
-				"grk_decompress: failed to allocate memory for upsampled components.");
-		grk_image_destroy(original);
-		return nullptr;
-	}
-
-	new_image->x0 = original->x0;
-	new_image->x1 = original->x1;
-	new_image->y0 = original->y0;
-	new_image->y1 = original->y1;
-
-	for (compno = 0U; compno < original->numcomps; ++compno) {
-		grk_image_comp *new_cmp = &(new_image->comps[compno]);
-		grk_image_comp *org_cmp = &(original->comps[compno]);
-
-		new_cmp->type = org_cmp->type;
+			up.h = image->y1 - image->y0;
+		auto new_cmp = &up;
 
-		if ((org_cmp->dx > 1U) || (org_cmp->dy > 1U)) {
-			auto src = org_cmp->data;
-			auto dst = new_cmp->data;
-
-			/* need to take into account dx & dy */
-			uint32_t xoff = org_cmp->dx * org_cmp->x0 - original->x0;
-			uint32_t yoff = org_cmp->dy * org_cmp->y0 - original->y0;
-			if ((xoff >= org_cmp->dx) || (yoff >= org_cmp->dy)) {
-				spdlog::error(
-						"grk_decompress: Invalid image/component parameters found when upsampling");
-				grk_image_destroy(original);
-				grk_image_destroy(new_image);
-				return nullptr;
-			}
-
-			uint32_t y;
-			for (y = 0U; y < yoff; ++y) {
-				memset(dst, 0U, new_cmp->w * sizeof(int32_t));
-				dst += new_cmp->stride;
-			}
-
-			if (new_cmp->h > (org_cmp->dy - 1U)) { /* check subtraction overflow for really small images */
-				for (; y < new_cmp->h - (org_cmp->dy - 1U); y += org_cmp->dy) {
-					uint32_t x, dy;
-					uint32_t xorg = 0;
-					for (x = 0U; x < xoff; ++x)
-						dst[x] = 0;
-
-					if (new_cmp->w > (org_cmp->dx - 1U)) { /* check subtraction overflow for really small images */
-						for (; x < new_cmp->w - (org_cmp->dx - 1U);	x += org_cmp->dx, ++xorg) {
-							for (uint32_t dx = 0U; dx < org_cmp->dx; ++dx)
-								dst[x + dx] = src[xorg];
-						}
-					}
-					for (; x < new_cmp->w; ++x)
-						dst[x] = src[xorg];
-					dst += new_cmp->stride;
+		/* need to take into account dx & dy */
+		uint32_t xoff = org_cmp->dx * org_cmp->x0 - image->x0;
+		uint32_t yoff = org_cmp->dy * org_cmp->y0 - image->y0;
+		if ((xoff >= org_cmp->dx) || (yoff >= org_cmp->dy)) {
+			spdlog::error(
+					"grk_decompress: Invalid image/component parameters found when upsampling");
+			return false;
+		}
+		if (!grk_image_single_component_data_alloc(new_cmp)) {
+			spdlog::error(
+					"grk_decompress: failed to allocate memory for upsampled components.");
+			return false;
+		}
 
-					for (dy = 1U; dy < org_cmp->dy; ++dy) {
-						memcpy(dst, dst - new_cmp->stride, new_cmp->w * sizeof(int32_t));
-						dst += new_cmp->stride;
-					}
-					src += org_cmp->stride;
-				}
-			}
-			if (y < new_cmp->h) {
-				uint32_t x;
-				uint32_t xorg;
+		auto src = org_cmp->data;
+		auto dst = new_cmp->data;
+		uint32_t y;
+		for (y = 0U; y < yoff; ++y) {
+			memset(dst, 0U, new_cmp->w * sizeof(int32_t));
+			dst += new_cmp->stride;
+		}
 
-				xorg = 0U;
+		if (new_cmp->h > (org_cmp->dy - 1U)) { /* check subtraction overflow for really small images */
+			for (; y < new_cmp->h - (org_cmp->dy - 1U); y += org_cmp->dy) {
+				uint32_t x, dy;
+				uint32_t xorg = 0;
 				for (x = 0U; x < xoff; ++x)
 					dst[x] = 0;
 
 				if (new_cmp->w > (org_cmp->dx - 1U)) { /* check subtraction overflow for really small images */
-					for (; x < new_cmp->w - (org_cmp->dx - 1U); x += org_cmp->dx, ++xorg) {
+					for (; x < new_cmp->w - (org_cmp->dx - 1U);	x += org_cmp->dx, ++xorg) {
 						for (uint32_t dx = 0U; dx < org_cmp->dx; ++dx)
 							dst[x + dx] = src[xorg];
 					}
@@ -1003,18 +959,42 @@ static grk_image* upsample_image_components(grk_image *original) {
 				for (; x < new_cmp->w; ++x)
 					dst[x] = src[xorg];
 				dst += new_cmp->stride;
-				++y;
-				for (; y < new_cmp->h; ++y) {
+
+				for (dy = 1U; dy < org_cmp->dy; ++dy) {
 					memcpy(dst, dst - new_cmp->stride, new_cmp->w * sizeof(int32_t));
 					dst += new_cmp->stride;
 				}
+				src += org_cmp->stride;
+			}
+		}
+		if (y < new_cmp->h) {
+			uint32_t x;
+			uint32_t xorg;
+
+			xorg = 0U;
+			for (x = 0U; x < xoff; ++x)
+				dst[x] = 0;
+
+			if (new_cmp->w > (org_cmp->dx - 1U)) { /* check subtraction overflow for really small images */
+				for (; x < new_cmp->w - (org_cmp->dx - 1U); x += org_cmp->dx, ++xorg) {
+					for (uint32_t dx = 0U; dx < org_cmp->dx; ++dx)
+						dst[x + dx] = src[xorg];
+				}
+			}
+			for (; x < new_cmp->w; ++x)
+				dst[x] = src[xorg];
+			dst += new_cmp->stride;
+			++y;
+			for (; y < new_cmp->h; ++y) {
+				memcpy(dst, dst - new_cmp->stride, new_cmp->w * sizeof(int32_t));
+				dst += new_cmp->stride;
 			}
-		} else {
-			memcpy(new_cmp->data, org_cmp->data, org_cmp->stride * org_cmp->h * sizeof(int32_t));
 		}
+		grk_image_single_component_data_free(org_cmp);
+		*org_cmp = up;
 	}
-	grk_image_destroy(original);
-	return new_image;
+
+	return true;
 }
 
 bool store_file_to_disk = true;
@@ -1057,13 +1037,17 @@ static int pre_decode(grk_plugin_decode_callback_info *info);
 static int post_decode(grk_plugin_decode_callback_info *info);
 static int plugin_main(int argc, char **argv, DecompressInitParams *initParams);
 
+// compressed bytes that warrant one thread of the batch budget
+const uint64_t batch_bytes_per_thread = 1024 * 1024;
+
 // returns 0 for failure, 1 for success, and 2 if file is not suitable for decoding
-int decompress(const char *fileName, DecompressInitParams *initParams) {
+int decompress(const char *fileName, DecompressInitParams *initParams,
+		grk_decompress_parameters *parameters) {
 	if (initParams->img_fol.set_imgdir) {
 		if (get_next_file(fileName, &initParams->img_fol,
 				initParams->out_fol.set_imgdir ?
 						&initParams->out_fol : &initParams->img_fol,
-				&initParams->parameters)) {
+				parameters)) {
 			return 2;
 		}
 	}
@@ -1073,7 +1057,7 @@ int decompress(const char *fileName, DecompressInitParams *initParams) {
 	info.decod_format = GRK_UNK_FMT;
 	info.cod_format = GRK_UNK_FMT;
 	info.decode_flags = GRK_DECODE_ALL;
-	info.decoder_parameters = &initParams->parameters;
+	info.decoder_parameters = parameters;
 
 	if (pre_decode(&info)) {
 		return 0;
@@ -1107,28 +1091,30 @@ int main(int argc, char **argv) {
 		auto start = std::chrono::high_resolution_clock::now();
 		for (uint32_t i = 0; i < initParams.parameters.repeats; ++i) {
 			if (!initParams.img_fol.set_imgdir) {
-				if (!decompress("", &initParams)) {
+				if (!decompress("", &initParams, &initParams.parameters)) {
 					rc = EXIT_FAILURE;
 					goto cleanup;
 				}
 				num_decompressed_images++;
 			} else {
-				auto dir = opendir(initParams.img_fol.imgdirpath);
-				if (!dir) {
-					spdlog::error("Could not open Folder {}",
-							initParams.img_fol.imgdirpath);
+				std::vector<std::string> files;
+				if (!BatchScheduler::list_files(initParams.img_fol.imgdirpath,
+						&files)) {
 					rc = EXIT_FAILURE;
 					goto cleanup;
 				}
-				struct dirent *content = nullptr;
-				while ((content = readdir(dir)) != nullptr) {
-					if (strcmp(".", content->d_name) == 0
-							|| strcmp("..", content->d_name) == 0)
-						continue;
-					if (decompress(content->d_name, &initParams) == 1)
-						num_decompressed_images++;
-				}
-				closedir(dir);
+				// each file is decompressed with its own copy of the parameters,
+				// limited to its share of the thread budget
+				BatchScheduler batch(initParams.parameters.numThreads,
+						batch_bytes_per_thread);
+				num_decompressed_images += (uint32_t)batch.run(
+						initParams.img_fol.imgdirpath, files,
+						[&initParams](const std::string &file, uint32_t threads) {
+							auto parameters = initParams.parameters;
+							parameters.numThreads = threads;
+							return decompress(file.c_str(), &initParams,
+									&parameters);
+						});
 			}
 		}
 		auto finish = std::chrono::high_resolution_clock::now();
@@ -1413,6 +1399,7 @@ int pre_decode(grk_plugin_decode_callback_info *info) {
 		}
 		grk_set_error_handler(error_callback, nullptr);
 
+		parameters->core.numThreads = parameters->numThreads;
 		if (!grk_init_decompress(info->l_codec, &(parameters->core))) {
 			spdlog::error("grk_decompress: failed to set up the decoder");
 			goto cleanup;
@@ -1513,6 +1500,170 @@ int pre_decode(grk_plugin_decode_callback_info *info) {
 /*
  Post-process decompressed image and store in selected image format
  */
+/**
+ * Number of rows of component 0 in the band of tile rows that ends at the
+ * k-th tile row boundary below the image origin, taking into account
+ * resolution reduction. Writers are fed one band at a time.
+ */
+static uint32_t band_end(grk_plugin_decode_callback_info *info,
+		grk_image *image, uint32_t k) {
+	auto comp = image->comps;
+	uint32_t reduce = info->decoder_parameters->core.cp_reduce;
+	uint64_t y = info->header_info.ty0
+			+ (uint64_t) k * info->header_info.t_height;
+	y = (y + comp->dy - 1) / comp->dy;
+	uint64_t end = (y + (1ULL << reduce) - 1) >> reduce;
+	uint64_t origin = ((uint64_t) comp->y0 + (1ULL << reduce) - 1) >> reduce;
+
+	return (uint32_t) std::min<uint64_t>(end > origin ? end - origin : 0,
+			comp->h);
+}
+
+#ifdef GROK_HAVE_LIBTIFF
+/**
+ * Whether TIFF tiles of the given size, starting at the image origin,
+ * line up with the reduced code stream tile boundaries along one axis
+ *
+ * @param grid_origin	tile grid origin on the reference grid
+ * @param tile_size		code stream tile size on the reference grid
+ * @param comp_origin	component origin, before reduction
+ * @param comp_size		component size, after reduction
+ * @param sub			component sub-sampling factor
+ * @param reduce		resolution reduction
+ * @param tiff_tile		TIFF tile size
+ */
+static bool tiff_tiles_aligned(uint32_t grid_origin, uint32_t tile_size,
+		uint32_t comp_origin, uint32_t comp_size, uint32_t sub, uint32_t reduce,
+		uint32_t tiff_tile) {
+	uint64_t origin = ((uint64_t) comp_origin + (1ULL << reduce) - 1) >> reduce;
+	uint64_t expected = tiff_tile;
+	for (uint64_t k = 1;; ++k) {
+		uint64_t y = grid_origin + k * tile_size;
+		y = (y + sub - 1) / sub;
+		uint64_t end = (y + (1ULL << reduce) - 1) >> reduce;
+		if (end <= origin)
+			continue;
+		end -= origin;
+		if (end >= comp_size)
+			break;
+		if (end != expected)
+			return false;
+		expected += tiff_tile;
+	}
+
+	return expected >= comp_size;
+}
+#endif
+
+/**
+ * Store decoded image, handing rows to the writer in bands
+ * aligned to tile rows, so that the writer packs and flushes
+ * each band as it goes.
+ *
+ * The image has already been fully decoded and colour converted
+ * when it is stored, so banding only bounds the writer's own
+ * packing buffers: peak memory still holds the whole image.
+ */
+static bool store_image(grk_plugin_decode_callback_info *info,
+		grk_image *image, GRK_SUPPORTED_FILE_FMT cod_format,
+		const std::string &outfileStr) {
+	auto parameters = info->decoder_parameters;
+	std::unique_ptr<IImageFormat> imageFormat;
+	uint32_t compressionParam = 0;
+	switch (cod_format) {
+	case GRK_PXM_FMT:
+		imageFormat.reset(new PNMFormat(parameters->split_pnm));
+		break;
+	case GRK_PGX_FMT:
+		imageFormat.reset(new PGXFormat());
+		break;
+	case GRK_BMP_FMT:
+		imageFormat.reset(new BMPFormat());
+		break;
+#ifdef GROK_HAVE_LIBTIFF
+	case GRK_TIF_FMT:
+	{
+		uint32_t tileWidth = parameters->tiff_tile_width;
+		uint32_t tileHeight = parameters->tiff_tile_height;
+		if (parameters->tiff_tiles_from_codestream
+				&& info->header_info.t_width && info->header_info.t_height) {
+			uint32_t reduce = parameters->core.cp_reduce;
+			tileWidth = (uint32_t) (((uint64_t) info->header_info.t_width
+					+ (1ULL << reduce) - 1) >> reduce);
+			tileHeight = (uint32_t) (((uint64_t) info->header_info.t_height
+					+ (1ULL << reduce) - 1) >> reduce);
+			// TIFF rounds tile dimensions up to multiples of 16
+			auto comp = image->comps;
+			uint32_t tiffWidth = (std::min<uint32_t>(tileWidth, comp->w) + 15)
+					& ~15U;
+			uint32_t tiffHeight = (std::min<uint32_t>(tileHeight, comp->h) + 15)
+					& ~15U;
+			if (!grk::isSubsampled(image)
+					&& (!tiff_tiles_aligned(info->header_info.tx0,
+							info->header_info.t_width, comp->x0, comp->w,
+							comp->dx, reduce, tiffWidth)
+							|| !tiff_tiles_aligned(info->header_info.ty0,
+									info->header_info.t_height, comp->y0,
+									comp->h, comp->dy, reduce, tiffHeight)))
+				spdlog::warn("TIFF tiles of {}x{} do not line up with the code "
+						"stream tiles, which will span several TIFF tiles.",
+						tiffWidth, tiffHeight);
+		}
+		imageFormat.reset(new TIFFFormat(tileWidth, tileHeight,
+						parameters->numThreads));
+		compressionParam = parameters->compression;
+	}
+		break;
+#endif
+	case GRK_RAW_FMT:
+		imageFormat.reset(new RAWFormat(true));
+		break;
+	case GRK_RAWL_FMT:
+		imageFormat.reset(new RAWFormat(false));
+		break;
+#ifdef GROK_HAVE_LIBJPEG
+	case GRK_JPG_FMT:
+		imageFormat.reset(new JPEGFormat(parameters->numThreads));
+		compressionParam = parameters->compressionLevel;
+		break;
+#endif
+#ifdef GROK_HAVE_LIBPNG
+	case GRK_PNG_FMT:
+		imageFormat.reset(new PNGFormat(parameters->numThreads));
+		compressionParam = parameters->compressionLevel;
+		break;
+#endif
+	default:
+		return false;
+	}
+	if (!imageFormat->encodeHeader(image, outfileStr, compressionParam))
+		return false;
+
+	bool rc = true;
+	uint32_t height = image->comps[0].h;
+	uint32_t written = 0;
+	uint32_t k = 0;
+	bool banded = info->header_info.t_height && image->comps[0].dy == 1
+			&& image->y0 >= info->header_info.ty0;
+	if (banded)
+		k = (image->y0 - info->header_info.ty0) / info->header_info.t_height
+				+ 1;
+	while (written < height) {
+		uint32_t end = banded ? band_end(info, image, k++) : height;
+		if (end <= written)
+			continue;
+		if (!imageFormat->encodeStrip(end - written)) {
+			rc = false;
+			break;
+		}
+		written = end;
+	}
+	if (!imageFormat->encodeFinish())
+		rc = false;
+
+	return rc;
+}
+
 int post_decode(grk_plugin_decode_callback_info *info) {
 	if (!info)
 		return -1;
@@ -1551,15 +1702,15 @@ int post_decode(grk_plugin_decode_callback_info *info) {
 	}
 	if (image->color_space == GRK_CLRSPC_SYCC) {
 		if (!isTiff || info->decoder_parameters->force_rgb) {
-			if (!color_sycc_to_rgb(image))
+			if (!color_sycc_to_rgb(image, parameters->numThreads))
 				spdlog::warn("grk_decompress: sYCC to RGB colour conversion failed");
 		}
 	} else if (image->color_space == GRK_CLRSPC_EYCC) {
-		if (!color_esycc_to_rgb(image))
+		if (!color_esycc_to_rgb(image, parameters->numThreads))
 			spdlog::warn("grk_decompress: eYCC to RGB colour conversion failed");
 	} else if (image->color_space == GRK_CLRSPC_CMYK) {
 		if (!isTiff || info->decoder_parameters->force_rgb) {
-			if (!color_cmyk_to_rgb(image))
+			if (!color_cmyk_to_rgb(image, parameters->numThreads))
 				spdlog::warn("grk_decompress: CMYK to RGB colour conversion failed");
 		}
 	}
@@ -1592,7 +1743,7 @@ int post_decode(grk_plugin_decode_callback_info *info) {
 							"output file {}.\n"
 							"The output image will therefore be converted to sRGB before saving.",
 							infile, outfile);
-				if (color_cielab_to_rgb(image)){
+				if (color_cielab_to_rgb(image, parameters->numThreads)){
 					delete[] image->icc_profile_buf;
 					image->icc_profile_buf = nullptr;
 					image->icc_profile_len = 0;
@@ -1624,7 +1775,8 @@ int post_decode(grk_plugin_decode_callback_info *info) {
 							" image before saving.",
 							infile, outfile);
 				color_apply_icc_profile(image,
-						info->decoder_parameters->force_rgb);
+						info->decoder_parameters->force_rgb,
+						parameters->numThreads);
 				delete[] image->icc_profile_buf;
 				image->icc_profile_buf = nullptr;
 				image->icc_profile_len = 0;
@@ -1656,8 +1808,7 @@ int post_decode(grk_plugin_decode_callback_info *info) {
 		}
 	}
 	if (parameters->upsample) {
-		image = upsample_image_components(image);
-		if (image == nullptr) {
+		if (!upsample_image_components(image)) {
 			spdlog::error(
 					"grk_decompress: failed to upsample image components.");
 			goto cleanup;
@@ -1686,109 +1837,9 @@ int post_decode(grk_plugin_decode_callback_info *info) {
 
 	if (store_file_to_disk) {
 		std::string outfileStr = outfile ? std::string(outfile) : "";
-		switch (cod_format) {
-		case GRK_PXM_FMT:
-		{
-			PNMFormat pnm(parameters->split_pnm);
-			if (!pnm.encodeHeader(image, outfileStr, 0)) {
-				spdlog::error("Outfile {} not generated", outfileStr);
-				goto cleanup;
-			}
-		}
-			break;
-		case GRK_PGX_FMT:
-		{
-			PGXFormat pgx;
-			if (!pgx.encodeHeader(image, outfileStr, 0)) {
-				spdlog::error("Outfile {} not generated", outfileStr);
-				goto cleanup;
-			}
-		}
-			break;
-		case GRK_BMP_FMT:
-		{
-			BMPFormat bmp;
-			if (!bmp.encodeHeader(image, outfileStr, 0)) {
-				spdlog::error("Outfile {} not generated", outfileStr);
-				goto cleanup;
-			}
-		}
-			break;
-#ifdef GROK_HAVE_LIBTIFF
-		case GRK_TIF_FMT:
-		{
-			TIFFFormat tif;
-			if (!tif.encodeHeader(image, outfileStr, parameters->compression)) {
-				spdlog::error("Outfile {} not generated", outfileStr);
-				goto cleanup;
-			}
-		}
-			break;
-#endif
-		case GRK_RAW_FMT:
-		{
-			RAWFormat raw(true);
-			if (raw.encodeHeader(image, outfileStr, 0)) {
-				spdlog::error(
-						"Error generating raw file. Outfile {} not generated",
-						outfileStr);
-				goto cleanup;
-			}
-		}
-			break;
-		case GRK_RAWL_FMT:
-		{
-			RAWFormat raw(false);
-			if (raw.encodeHeader(image, outfileStr, 0)) {
-				spdlog::error(
-						"Error generating rawl file. Outfile {} not generated",
-						outfileStr);
-				goto cleanup;
-			}
-		}
-			break;
-#ifdef GROK_HAVE_LIBJPEG 
-		case GRK_JPG_FMT:
-		{
-			JPEGFormat jpeg;
-			if (!jpeg.encodeHeader(image, outfileStr, parameters->compressionLevel)) {
-				spdlog::error(
-						"Error generating jpeg file. Outfile {} not generated",
-						outfileStr);
-				goto cleanup;
-			}
-		}
-			break;
-#endif
-
-#ifdef GROK_HAVE_LIBPNG
-		case GRK_PNG_FMT:
-		{
-			PNGFormat png;
-			if (!png.encodeHeader(image, outfileStr, parameters->compressionLevel)){
-				spdlog::error("Error generating png file. Outfile {} not generated",
-						outfileStr);
-				goto cleanup;
-			}
-
-			if (!png.encodeStrip(image->comps[0].h)){
-				spdlog::error("Error generating png file. Outfile {} not generated",
-						outfileStr);
-				goto cleanup;
-			}
-
-			if (!png.encodeFinish()){
-				spdlog::error("Error generating png file. Outfile {} not generated",
-						outfileStr);
-				goto cleanup;
-			}
-		}
-			break;
-#endif
-		default:
+		if (!store_image(info, image, cod_format, outfileStr)) {
 			spdlog::error("Outfile {} not generated", outfileStr);
 			goto cleanup;
-			break;
 		}
 	}
 	failed = false;
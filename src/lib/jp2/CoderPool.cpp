@@ -0,0 +1,145 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "grok_includes.h"
+#include "T1Factory.h"
+#include "CoderPool.h"
+
+namespace grk {
+
+bool CoderPool::T1Key::operator<(const T1Key &rhs) const {
+	if (isEncoder != rhs.isEncoder)
+		return isEncoder < rhs.isEncoder;
+	if (isHT != rhs.isHT)
+		return isHT < rhs.isHT;
+	if (maxCblkW != rhs.maxCblkW)
+		return maxCblkW < rhs.maxCblkW;
+	return maxCblkH < rhs.maxCblkH;
+}
+
+CoderPool::~CoderPool() {
+	clear();
+}
+
+CoderPool::T1Key CoderPool::t1_key(bool isEncoder, bool isHT,
+		uint32_t maxCblkW, uint32_t maxCblkH) {
+	T1Key key;
+	key.isEncoder = isEncoder;
+	key.isHT = isHT;
+	key.maxCblkW = maxCblkW;
+	key.maxCblkH = maxCblkH;
+
+	return key;
+}
+
+void CoderPool::acquire_t1(bool isEncoder, TileCodingParams *tcp,
+		uint32_t maxCblkW, uint32_t maxCblkH,
+		std::vector<T1Interface*> *coders) {
+	size_t num_threads = ThreadPool::get()->num_threads();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto iter = m_t1.find(t1_key(isEncoder, tcp->isHT, maxCblkW, maxCblkH));
+		if (iter != m_t1.end()) {
+			*coders = std::move(iter->second);
+			m_t1.erase(iter);
+		}
+	}
+	while (coders->size() < num_threads)
+		coders->push_back(
+				T1Factory::get_t1(isEncoder, tcp, maxCblkW, maxCblkH));
+}
+
+void CoderPool::release_t1(bool isEncoder, bool isHT,
+		uint32_t maxCblkW, uint32_t maxCblkH,
+		std::vector<T1Interface*> *coders) {
+	if (coders->empty())
+		return;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_t1.emplace(t1_key(isEncoder, isHT, maxCblkW, maxCblkH),
+			std::move(*coders));
+	coders->clear();
+}
+
+void* CoderPool::acquire_scratch(size_t len) {
+	void *buf = nullptr;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto iter = m_scratch.lower_bound(len);
+	if (iter != m_scratch.end()) {
+		buf = iter->second;
+		len = iter->first;
+		m_scratch.erase(iter);
+	} else {
+		// no free buffer is large enough: replace the largest free buffer
+		if (!m_scratch.empty()) {
+			auto largest = std::prev(m_scratch.end());
+			grk_aligned_free(largest->second);
+			m_scratch.erase(largest);
+		}
+		buf = grk_aligned_malloc(len);
+		if (!buf)
+			return nullptr;
+	}
+	m_scratch_in_use[buf] = len;
+
+	return buf;
+}
+
+void CoderPool::release_scratch(void *buf) {
+	if (!buf)
+		return;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto iter = m_scratch_in_use.find(buf);
+	assert(iter != m_scratch_in_use.end());
+	m_scratch.emplace(iter->second, buf);
+	m_scratch_in_use.erase(iter);
+}
+
+void* CoderPool::acquire_slab(void) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_slabs.empty()) {
+			auto slab = m_slabs.back();
+			m_slabs.pop_back();
+			return slab;
+		}
+	}
+	return grk_aligned_malloc(sparse_array_slab_size);
+}
+
+void CoderPool::release_slab(void *slab) {
+	if (!slab)
+		return;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_slabs.push_back(slab);
+}
+
+void CoderPool::clear() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto &c : m_t1) {
+		for (auto &t1 : c.second)
+			delete t1;
+	}
+	m_t1.clear();
+	for (auto &b : m_scratch)
+		grk_aligned_free(b.second);
+	m_scratch.clear();
+	for (auto &s : m_slabs)
+		grk_aligned_free(s);
+	m_slabs.clear();
+}
+
+}
@@ -0,0 +1,122 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace grk {
+
+class T1Interface;
+struct TileCodingParams;
+
+/**
+ * Size in bytes of the slabs that sparse array blocks are carved from
+ */
+const size_t sparse_array_slab_size = 256 * 1024;
+
+/**
+ * Coding resources that do not depend on the image being coded:
+ * per-thread T1 coders, wavelet scratch buffers and sparse array slabs.
+ *
+ * The pool belongs to a codec and outlives the code streams that the codec
+ * creates, so these resources are reused by every tile of every image,
+ * until the codec is destroyed. All methods are thread safe.
+ */
+class CoderPool {
+public:
+	~CoderPool();
+
+	/**
+	 * Acquire one T1 coder for each thread of the thread pool.
+	 * Coders are taken from the pool if available, otherwise they are created.
+	 *
+	 * @param isEncoder	true for encoder
+	 * @param tcp		tile coding parameters
+	 * @param maxCblkW	maximum code block width
+	 * @param maxCblkH	maximum code block height
+	 * @param coders	coders, on return
+	 */
+	void acquire_t1(bool isEncoder, TileCodingParams *tcp, uint32_t maxCblkW,
+			uint32_t maxCblkH, std::vector<T1Interface*> *coders);
+
+	/**
+	 * Return coders acquired with acquire_t1 to the pool
+	 *
+	 * @param isEncoder	true for encoder
+	 * @param isHT		true for HT coders
+	 * @param maxCblkW	maximum code block width
+	 * @param maxCblkH	maximum code block height
+	 * @param coders	coders, empty on return
+	 */
+	void release_t1(bool isEncoder, bool isHT, uint32_t maxCblkW,
+			uint32_t maxCblkH, std::vector<T1Interface*> *coders);
+
+	/**
+	 * Acquire aligned scratch buffer
+	 *
+	 * @param len	minimum length of buffer in bytes
+	 * @return buffer, or nullptr if out of memory
+	 */
+	void* acquire_scratch(size_t len);
+
+	/**
+	 * Return buffer acquired with acquire_scratch to the pool
+	 */
+	void release_scratch(void *buf);
+
+	/**
+	 * Acquire aligned slab of sparse_array_slab_size bytes
+	 *
+	 * @return slab, or nullptr if out of memory
+	 */
+	void* acquire_slab(void);
+
+	/**
+	 * Return slab acquired with acquire_slab to the pool
+	 */
+	void release_slab(void *slab);
+
+	/**
+	 * Destroy all pooled coders and buffers that are not in use
+	 */
+	void clear();
+
+private:
+	struct T1Key {
+		bool isEncoder;
+		bool isHT;
+		uint32_t maxCblkW;
+		uint32_t maxCblkH;
+		bool operator<(const T1Key &rhs) const;
+	};
+	T1Key t1_key(bool isEncoder, bool isHT, uint32_t maxCblkW,
+			uint32_t maxCblkH);
+
+	std::mutex m_mutex;
+	std::multimap<T1Key, std::vector<T1Interface*> > m_t1;
+	// free buffers, keyed by length
+	std::multimap<size_t, void*> m_scratch;
+	// length of every buffer that is in use
+	std::map<void*, size_t> m_scratch_in_use;
+	// free sparse array slabs
+	std::vector<void*> m_slabs;
+};
+
+}
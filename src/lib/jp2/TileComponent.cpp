@@ -392,15 +392,19 @@ bool TileComponent::is_subband_area_of_interest(uint32_t resno,
 	if (whole_tile_decoding)
 		return true;
 
-    /* Note: those values for filter_margin are in part the result of */
-    /* experimentation. The value 2 for QMFBID=1 (5x3 filter) can be linked */
-    /* to the maximum left/right extension given in tables F.2 and F.3 of the */
-    /* standard. The value 3 for QMFBID=0 (9x7 filter) is more suspicious, */
-    /* since F.2 and F.3 would lead to 4 instead, so the current 3 might be */
-    /* needed to be bumped to 4, in case inconsistencies are found while */
-    /* decoding parts of irreversible coded images. */
-    /* See dwt_decode_partial_53 and dwt_decode_partial_97 as well */
-    uint32_t filter_margin = (m_tccp->qmfbid == 1) ? 2 : 3;
+    /* Compute the margin, in band coordinates, of the samples that influence */
+    /* the window of interest. Each synthesis level spreads the dependency by */
+    /* the filter support in interleaved coordinates (2 for the 5x3 filter, */
+    /* 4 for the 9x7 filter, as per tables F.2 and F.3 of the standard), */
+    /* and the interleaved margin halves when mapped down to the sub-bands. */
+    /* Margins therefore grow from the highest decoded level downwards, */
+    /* converging to 2 (5x3) and 4 (9x7). */
+    /* See decode_partial_tile, whose windows always cover these margins */
+    uint32_t filter_support = (m_tccp->qmfbid == 1) ? 2 : 4;
+    uint32_t filter_margin = 0;
+    for (uint32_t level = max<uint32_t>(resno, 1);
+    		level < resolutions_to_decompress; ++level)
+    	filter_margin = (filter_margin + filter_support + 1) >> 1;
 
     /* Compute the intersection of the area of interest, expressed in tile component coordinates */
     /* with the tile coordinates */
@@ -456,11 +460,11 @@ bool TileComponent::is_subband_area_of_interest(uint32_t resno,
 }
 
 
-void TileComponent::alloc_sparse_array(uint32_t numres){
+void TileComponent::alloc_sparse_array(uint32_t numres, CoderPool *pool){
     auto tr_max = &(resolutions[numres - 1]);
 	uint32_t w = (uint32_t)(tr_max->x1 - tr_max->x0);
 	uint32_t h = (uint32_t)(tr_max->y1 - tr_max->y0);
-	auto sa = new sparse_array(w, h, min<uint32_t>(w, 64), min<uint32_t>(h, 64));
+	auto sa = new sparse_array(w, h, min<uint32_t>(w, 64), min<uint32_t>(h, 64), pool);
     for (uint32_t resno = 0; resno < numres; ++resno) {
         auto res = &resolutions[resno];
 
@@ -527,6 +531,10 @@ void TileComponent::create_buffer(grk_image *output_image,
 	grk_rect_u32::operator=(*(grk_rect_u32*)res);
 	auto maxRes = resolutions + numresolutions - 1;
 
+	// encoder buffer only depends on tile geometry, so it
+	// can be kept when a tile is compressed again for the next frame
+	if (m_is_encoder && buf)
+		return;
 	delete buf;
 	buf = new TileComponentBuffer<int32_t>(output_image, dx,dy,
 											grk_rect(maxRes->x0, maxRes->y0, maxRes->x1, maxRes->y1),
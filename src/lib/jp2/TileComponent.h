@@ -44,7 +44,7 @@ struct TileComponent : public grk_rect_u32 {
 			TileComponentCodingParams* tccp,
 			grk_plugin_tile *current_plugin_tile);
 
-	 void alloc_sparse_array(uint32_t numres);
+	 void alloc_sparse_array(uint32_t numres, CoderPool *pool);
 	 void release_mem();
 
 	 bool is_subband_area_of_interest(uint32_t resno,
@@ -76,6 +76,7 @@ template<typename T> struct TileComponentBuffer {
 						bool whole_tile) :
 							m_unreduced_bounds(unreduced_dim),
 							m_bounds(reduced_dim),
+							m_tile_bounds(reduced_dim),
 							num_resolutions(numresolutions),
 							m_encode(output_image==nullptr),
 							whole_tile_decoding(whole_tile)
@@ -97,6 +98,7 @@ template<typename T> struct TileComponentBuffer {
 			m_unreduced_bounds.intersection(unreduced_dim);
 			assert(m_unreduced_bounds.is_valid());
 		}
+		m_window_bounds = m_bounds;
 
 		/* fill resolutions vector */
         assert(reduced_num_resolutions>0);
@@ -104,20 +106,45 @@ template<typename T> struct TileComponentBuffer {
         for (uint32_t resno = 0; resno < reduced_num_resolutions; ++resno)
         	resolutions.push_back(tile_comp_resolutions+resno);
 
-        if ( use_band_buffers()) {
-        	// lowest resolution equals 0th band
-        	 res_buffers.push_back(new res_buf<T>(nullptr, tile_comp_resolutions->bands[0].to_u32()) );
-
-        	 for (uint32_t resno = 1; resno < reduced_num_resolutions; ++resno)
-        		 res_buffers.push_back(new res_buf<T>( tile_comp_resolutions+resno, m_bounds.to_u32()) );
-        } else {
-        	res_buffers.push_back(new res_buf<T>( nullptr, m_bounds.to_u32()) );
-        }
+        create_res_buffers();
 	}
 	~TileComponentBuffer(){
 		for (auto& b : res_buffers)
 			delete b;
 	}
+	/**
+	 * Cover the entire tile component rather than just the decode window,
+	 * so that the window can be decoded with the whole tile transform.
+	 * Must be called before the buffer is allocated.
+	 */
+	void set_whole_tile(void){
+		whole_tile_decoding = true;
+		m_bounds = m_tile_bounds;
+		for (auto& b : res_buffers)
+			delete b;
+		res_buffers.clear();
+		create_res_buffers();
+	}
+	/**
+	 * Crop a decoded whole tile to the decode window. Samples are moved
+	 * in place to the start of the buffer; the stride is unchanged.
+	 */
+	void crop_to_window(void){
+		if (m_bounds == m_window_bounds)
+			return;
+		auto buf = tile_buf();
+		size_t buf_stride = buf->stride;
+		auto dest = buf->data;
+		auto src = buf->data + (uint64_t)(m_window_bounds.y0 - m_bounds.y0) * buf_stride
+						+ (m_window_bounds.x0 - m_bounds.x0);
+		size_t len = (size_t)m_window_bounds.width() * sizeof(T);
+		for (int64_t y = m_window_bounds.y0; y < m_window_bounds.y1; ++y) {
+			memmove(dest, src, len);
+			dest += buf_stride;
+			src += buf_stride;
+		}
+		m_bounds = m_window_bounds;
+	}
 	/**
 	 * Get pointer to code block region in tile buffer
 	 *
@@ -319,6 +346,13 @@ template<typename T> struct TileComponentBuffer {
 		return m_bounds;
 	}
 
+	/**
+	 * Get bounds of decode window, in reduced tile component coordinates
+	 */
+	grk_rect window_bounds() const{
+		return m_window_bounds;
+	}
+
 	grk_rect unreduced_bounds() const{
 		return m_unreduced_bounds;
 	}
@@ -342,6 +376,18 @@ template<typename T> struct TileComponentBuffer {
 
 private:
 
+	void create_res_buffers(void){
+        if ( use_band_buffers()) {
+        	// lowest resolution equals 0th band
+        	 res_buffers.push_back(new res_buf<T>(nullptr, resolutions[0]->bands[0].to_u32()) );
+
+        	 for (uint32_t resno = 1; resno < resolutions.size(); ++resno)
+        		 res_buffers.push_back(new res_buf<T>( resolutions[resno], m_bounds.to_u32()) );
+        } else {
+        	res_buffers.push_back(new res_buf<T>( nullptr, m_bounds.to_u32()) );
+        }
+	}
+
 	bool use_band_buffers() const{
 		//return !m_encode && whole_tile_decoding && resolutions.size() > 1;
 		return false;
@@ -362,6 +408,12 @@ private:
 	/* encode: unreduced tile component coordinates of entire tile */
 	grk_rect m_bounds;
 
+	/* reduced tile component coordinates of entire tile */
+	grk_rect m_tile_bounds;
+
+	/* decode: reduced tile component coordinates of region  */
+	grk_rect m_window_bounds;
+
 	std::vector<grk_resolution*> resolutions;
 	std::vector<res_buf<T>* > res_buffers;
 	uint32_t num_resolutions;
@@ -46,10 +46,14 @@ TileProcessor::TileProcessor(CodeStream *codeStream) :
 				plt_markers(nullptr),
 				m_cp(&codeStream->m_cp),
 				m_resno_decoded(nullptr),
+				m_coderPool(codeStream->m_coderPool),
 				tp_pos(0),
 				m_tcp(nullptr),
+				m_tier1(nullptr),
+				m_encoder(&codeStream->m_encoder),
 				m_corrupt_packet(false)
 {
+	memset(m_prev_layer_thresh, 0, sizeof(m_prev_layer_thresh));
 
 	tile = (grk_tile*) grk_calloc(1, sizeof(grk_tile));
 	if (!tile)
@@ -70,6 +74,7 @@ TileProcessor::~TileProcessor() {
 	}
 	delete plt_markers;
 	delete[] m_resno_decoded;
+	delete m_tier1;
 }
 
 /*
@@ -148,40 +153,8 @@ void TileProcessor::makelayer_feasible(uint32_t layno, uint16_t thresh,
 							}
 						}
 
-						layer->numpasses = cumulative_included_passes_in_block
-								- cblk->numPassesInPreviousPackets;
-
-						if (!layer->numpasses) {
-							layer->disto = 0;
-							continue;
-						}
-
-						// update layer
-						if (cblk->numPassesInPreviousPackets == 0) {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate;
-							layer->data = cblk->paddedCompressedData;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec;
-						} else {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate
-											- cblk->passes[cblk->numPassesInPreviousPackets
-													- 1].rate;
-							layer->data =
-									cblk->paddedCompressedData
-											+ cblk->passes[cblk->numPassesInPreviousPackets
-													- 1].rate;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec
-											- cblk->passes[cblk->numPassesInPreviousPackets
-													- 1].distortiondec;
-						}
-
+						cumulative_included_passes_in_block = update_layer(cblk,
+								layer, cumulative_included_passes_in_block);
 						tile->distolayer[layno] += layer->disto;
 						if (final)
 							cblk->numPassesInPreviousPackets =
@@ -275,19 +248,16 @@ bool TileProcessor::pcrd_bisect_feasible(uint32_t *all_packets_len) {
 
 		if (layer_needs_rate_control(layno)) {
 			auto t2 = new T2Encode(this);
-			// thresh from previous iteration - starts off uninitialized
-			// used to bail out if difference with current thresh is small enough
-			uint32_t prevthresh = 0;
 			double distotarget = tile->distotile
 					- ((K * maxSE)
 							/ pow(10.0, tcp->distoratio[layno] / 10.0));
+			// true once upperBound has been tested and found to meet the target
+			bool upperFeasible = false;
 
-			for (uint32_t i = 0; i < 128; ++i) {
-				uint32_t thresh = (lowerBound + upperBound) >> 1;
-				if (prevthresh != 0 && prevthresh == thresh)
-					break;
+			// true if layer formed with this threshold meets the target;
+			// larger thresholds include fewer passes
+			auto feasible = [&](uint32_t thresh) {
 				makelayer_feasible(layno, (uint16_t) thresh, false);
-				prevthresh = thresh;
 				if (m_cp->m_coding_params.m_enc.m_fixed_quality) {
 					double distoachieved =
 							layno == 0 ?
@@ -295,25 +265,76 @@ bool TileProcessor::pcrd_bisect_feasible(uint32_t *all_packets_len) {
 									cumdisto[layno - 1]
 											+ tile->distolayer[layno];
 
-					if (distoachieved < distotarget) {
+					return distoachieved < distotarget;
+				}
+				return t2->encode_packets_simulate(m_tile_index,
+						layno + 1, all_packets_len, maxlen,
+						tp_pos, nullptr);
+			};
+
+			// warm start: bracket the threshold around the threshold chosen for
+			// this layer in the previous frame, before bisecting the bracket
+			uint32_t warm = m_prev_layer_thresh[layno];
+			if (warm > lowerBound && warm < upperBound) {
+				uint32_t step = 16;
+				if (feasible(warm)) {
+					upperBound = warm;
+					upperFeasible = true;
+					while (upperBound > lowerBound + step) {
+						uint32_t thresh = upperBound - step;
+						if (!feasible(thresh)) {
+							lowerBound = thresh;
+							break;
+						}
 						upperBound = thresh;
-						continue;
+						step <<= 1;
 					}
-					lowerBound = thresh;
 				} else {
-					if (!t2->encode_packets_simulate(m_tile_index,
-							layno + 1, all_packets_len, maxlen,
-							tp_pos, nullptr)) {
+					lowerBound = warm;
+					while (lowerBound + step < upperBound) {
+						uint32_t thresh = lowerBound + step;
+						if (feasible(thresh)) {
+							upperBound = thresh;
+							upperFeasible = true;
+							break;
+						}
+						lowerBound = thresh;
+						step <<= 1;
+					}
+				}
+			}
+
+			auto bisect = [&]() {
+				// thresh from previous iteration - starts off uninitialized
+				// used to bail out if difference with current thresh is small enough
+				uint32_t prevthresh = 0;
+				for (uint32_t i = 0; i < 128; ++i) {
+					uint32_t thresh = (lowerBound + upperBound) >> 1;
+					if (prevthresh != 0 && prevthresh == thresh)
+						break;
+					prevthresh = thresh;
+					if (feasible(thresh)) {
+						upperBound = thresh;
+						upperFeasible = true;
+					} else {
 						lowerBound = thresh;
-						continue;
 					}
-					upperBound = thresh;
 				}
+			};
+			bisect();
+			// upper bound inherited from the previous layer has not been tested:
+			// if it does not meet the target, then search above it
+			if (!upperFeasible && upperBound < max_slope
+					&& !feasible(upperBound)) {
+				lowerBound = upperBound;
+				upperBound = max_slope;
+				bisect();
 			}
 			// choose conservative value for goodthresh
 			/* Threshold for Marcela Index */
 			// start by including everything in this layer
 			uint32_t goodthresh = upperBound;
+			m_prev_layer_thresh[layno] = (uint16_t)goodthresh;
 			delete t2;
 
 			makelayer_feasible(layno, (uint16_t) goodthresh, true);
@@ -564,39 +585,8 @@ void TileProcessor::make_layer_simple(uint32_t layno, double thresh,
 							}
 						}
 
-						layer->numpasses = cumulative_included_passes_in_block
-								- cblk->numPassesInPreviousPackets;
-						if (!layer->numpasses) {
-							layer->disto = 0;
-							continue;
-						}
-
-						// update layer
-						if (cblk->numPassesInPreviousPackets == 0) {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate;
-							layer->data = cblk->paddedCompressedData;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec;
-						} else {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate
-											- cblk->passes[cblk->numPassesInPreviousPackets
-													- 1].rate;
-							layer->data =
-									cblk->paddedCompressedData
-											+ cblk->passes[cblk->numPassesInPreviousPackets
-													- 1].rate;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec
-											- cblk->passes[cblk->numPassesInPreviousPackets
-													- 1].distortiondec;
-						}
-
+						cumulative_included_passes_in_block = update_layer(cblk,
+								layer, cumulative_included_passes_in_block);
 						tile->distolayer[layno] += layer->disto;
 						if (final)
 							cblk->numPassesInPreviousPackets =
@@ -608,6 +598,49 @@ void TileProcessor::make_layer_simple(uint32_t layno, double thresh,
 	}
 }
 
+/*
+ Set code block contribution to a layer, given the total number of passes
+ included so far. Returns the total number of passes actually included.
+
+ HT code blocks carry one cleanup pass candidate per pass, so only
+ the last included pass is sent, and its number of skipped bit planes
+ sets the zero bit planes signalled for the block. Since the block coder
+ does not generate refinement passes, an HT code block is included once,
+ in the first layer that selects any of its passes.
+ */
+uint32_t TileProcessor::update_layer(grk_cblk_enc *cblk, grk_layer *layer,
+		uint32_t cumulative_included_passes_in_block) {
+	bool isHT = m_tcp->isHT;
+	if (isHT && cblk->numPassesInPreviousPackets)
+		cumulative_included_passes_in_block = cblk->numPassesInPreviousPackets;
+	layer->numpasses = cumulative_included_passes_in_block
+			- cblk->numPassesInPreviousPackets;
+	if (!layer->numpasses) {
+		layer->disto = 0;
+		return cumulative_included_passes_in_block;
+	}
+	auto last = cblk->passes + cumulative_included_passes_in_block - 1;
+	if (isHT) {
+		layer->len = last->rate;
+		layer->data = cblk->paddedCompressedData;
+		for (auto pass = cblk->passes; pass != last; ++pass)
+			layer->data += pass->rate;
+		layer->disto = last->distortiondec;
+		cblk->numbps = 1U + last->skippedBitPlanes;
+	} else if (cblk->numPassesInPreviousPackets == 0) {
+		layer->len = last->rate;
+		layer->data = cblk->paddedCompressedData;
+		layer->disto = last->distortiondec;
+	} else {
+		auto prev = cblk->passes + cblk->numPassesInPreviousPackets - 1;
+		layer->len = last->rate - prev->rate;
+		layer->data = cblk->paddedCompressedData + prev->rate;
+		layer->disto = last->distortiondec - prev->distortiondec;
+	}
+
+	return cumulative_included_passes_in_block;
+}
+
 // Add all remaining passes to this layer
 void TileProcessor::makelayer_final(uint32_t layno) {
 	tile->distolayer[layno] = 0;
@@ -631,42 +664,12 @@ void TileProcessor::makelayer_final(uint32_t layno) {
 							cumulative_included_passes_in_block =
 									cblk->numPassesTotal;
 
-						layer->numpasses = cumulative_included_passes_in_block
-								- cblk->numPassesInPreviousPackets;
-
-						if (!layer->numpasses) {
-							layer->disto = 0;
-							continue;
-						}
-						// update layer
-						if (cblk->numPassesInPreviousPackets == 0) {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate;
-							layer->data = cblk->paddedCompressedData;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec;
-						} else {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate
-											- cblk->passes[cblk->numPassesInPreviousPackets
-													- 1].rate;
-							layer->data =
-									cblk->paddedCompressedData
-											+ cblk->passes[cblk->numPassesInPreviousPackets
-													- 1].rate;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec
-											- cblk->passes[cblk->numPassesInPreviousPackets
-													- 1].distortiondec;
-						}
+						cumulative_included_passes_in_block = update_layer(cblk,
+								layer, cumulative_included_passes_in_block);
 						tile->distolayer[layno] += layer->disto;
 						cblk->numPassesInPreviousPackets =
 								cumulative_included_passes_in_block;
-						assert(cblk->numPassesInPreviousPackets
+						assert(m_tcp->isHT || cblk->numPassesInPreviousPackets
 										== cblk->numPassesTotal);
 					}
 				}
@@ -828,54 +831,119 @@ bool TileProcessor::compress_tile_part(BufferedStream *stream,
 	return t2_encode(stream, tile_bytes_written);
 }
 
-/** Returns whether a tile component should be fully decoded,
- * taking into account win_* members.
+/**
+ * Estimated relative costs of the decompression stages compared by
+ * is_whole_tilecomp_decoding, in units of one sample of the whole tile
+ * inverse wavelet transform. T1 cost per sample grows with the coded
+ * rate; the windowed inverse wavelet transform, which goes through
+ * the sparse array, is several times slower per sample than the
+ * whole tile transform. These are rough tuning values, not measurements,
+ * and only need to order the two paths correctly.
+ */
+const double t1_cost_per_sample = 2.0;
+const double t1_cost_per_coded_bit = 7.0;
+const double partial_dwt_cost_per_sample = 3.5;
+
+void TileProcessor::estimate_decode_cost(uint32_t compno,
+										double *whole_cost,
+										double *window_cost) {
+	auto tilec = tile->comps + compno;
+	auto window = tilec->buf->window_bounds();
+
+	// coded bits per sample over the whole tile
+	uint64_t tile_samples = 0;
+	for (uint32_t i = 0; i < tile->numcomps; ++i) {
+		auto res = tile->comps[i].resolutions + tile->comps[i].numresolutions - 1;
+		tile_samples += (uint64_t)res->width() * res->height();
+	}
+	double bits_per_sample = (m_tcp->m_tile_data && tile_samples) ?
+			(double)m_tcp->m_tile_data->data_len * 8 / (double)tile_samples : 0;
+	double t1_cost = t1_cost_per_sample + t1_cost_per_coded_bit * bits_per_sample;
+
+	uint64_t cblk_samples = 0;
+	uint64_t window_cblk_samples = 0;
+	for (uint32_t resno = 0; resno < tilec->resolutions_to_decompress; ++resno) {
+		auto res = tilec->resolutions + resno;
+		for (uint32_t bandno = 0; bandno < res->numbands; ++bandno) {
+			auto band = res->bands + bandno;
+			for (uint64_t precno = 0; precno < (uint64_t)res->pw * res->ph; ++precno) {
+				auto precinct = band->precincts + precno;
+				for (uint64_t cblkno = 0; cblkno < precinct->num_code_blocks; ++cblkno) {
+					auto cblk = precinct->dec + cblkno;
+					uint64_t area = cblk->area();
+					cblk_samples += area;
+					if (tilec->is_subband_area_of_interest(resno, band->bandno,
+							cblk->x0, cblk->y0, cblk->x1, cblk->y1))
+						window_cblk_samples += area;
+				}
+			}
+		}
+	}
+	*whole_cost = t1_cost * (double)cblk_samples
+			+ (double)tilec->width() * tilec->height();
+	*window_cost = t1_cost * (double)window_cblk_samples
+			+ partial_dwt_cost_per_sample * (double)window.area();
+}
+
+/** Returns whether a tile component should be fully decoded and then cropped
+ * to the decode window, rather than decoded through the windowed path.
+ *
+ * The decision weighs the code blocks that each path must decode against the
+ * cost of the respective inverse wavelet transforms. Components coupled by
+ * a multiple component transform must share a path, since the transform
+ * requires identical buffer geometry, so their costs are pooled.
  *
  * @param compno Component number
  * @return true if the tile component should be fully decoded
  */
 bool TileProcessor::is_whole_tilecomp_decoding(uint32_t compno) {
+	uint32_t first = compno;
+	uint32_t last = compno + 1;
+	if (m_tcp->mct && tile->numcomps >= 3 && compno < 3) {
+		// the first component decides for the group
+		if (compno > 0)
+			return tile->comps[0].whole_tile_decoding;
+		last = 3;
+	}
+	double whole_cost = 0, window_cost = 0;
+	for (uint32_t i = first; i < last; ++i) {
+		double whole, window;
+		estimate_decode_cost(i, &whole, &window);
+		whole_cost += whole;
+		window_cost += window;
+	}
+	bool whole = whole_cost <= window_cost;
 	auto tilec = tile->comps + compno;
-	/* Compute the intersection of the area of interest, expressed in tile component coordinates */
-	/* with the tile coordinates */
-
-	auto dims = tilec->buf->bounds();
-	uint32_t tcx0 = (uint32_t)dims.x0;
-	uint32_t tcy0 = (uint32_t)dims.y0;
-	uint32_t tcx1 = (uint32_t)dims.x1;
-	uint32_t tcy1 = (uint32_t)dims.y1;
-
-	uint32_t shift = tilec->numresolutions - tilec->resolutions_to_decompress;
-	/* Tolerate small margin within the reduced resolution factor to consider if */
-	/* the whole tile path must be taken */
-	return (tcx0 >= (uint32_t) tilec->x0 && tcy0 >= (uint32_t) tilec->y0
-			&& tcx1 <= (uint32_t) tilec->x1 && tcy1 <= (uint32_t) tilec->y1
-			&& (shift >= 32
-					|| (((tcx0 - (uint32_t) tilec->x0) >> shift) == 0
-							&& ((tcy0 - (uint32_t) tilec->y0) >> shift) == 0
-							&& (((uint32_t) tilec->x1 - tcx1) >> shift) == 0
-							&& (((uint32_t) tilec->y1 - tcy1) >> shift) == 0)));
+	auto window = tilec->buf->window_bounds();
+	// sub-sampled components of edge tiles may be empty
+	uint64_t tile_area = (uint64_t)tilec->width() * tilec->height();
+	GROK_INFO("Tile %u component %u: window covers %u%% of tile at reduction %u,"
+			" %s decode (cost %.0f whole, %.0f window)",
+			m_tile_index, compno,
+			tile_area ? (uint32_t)((window.area() * 100) / tile_area) : 100,
+			tilec->numresolutions - tilec->resolutions_to_decompress,
+			whole ? "whole tile" : "windowed",
+			whole_cost, window_cost);
 
+	return whole;
 }
 
 bool TileProcessor::decompress_tile_t2(ChunkBuffer *src_buf) {
 	m_tcp = m_cp->tcps + m_tile_index;
 
-	// optimization for regions that are close to largest decoded resolution
-	// (currently breaks tests, so disabled)
-	for (uint32_t compno = 0; compno < image->numcomps; compno++) {
-		if (!is_whole_tilecomp_decoding(compno)) {
-			whole_tile_decoding = false;
-			break;
-		}
-	}
-
 	if (!whole_tile_decoding) {
 		/* Compute restricted tile-component and tile-resolution coordinates */
 		/* of the window of interest */
 		for (uint32_t compno = 0; compno < image->numcomps; compno++) {
 			auto tilec = tile->comps + compno;
 
+			/* decode the whole tile and crop, when that is cheaper */
+			if (!current_plugin_tile && is_whole_tilecomp_decoding(compno)) {
+				tilec->whole_tile_decoding = true;
+				tilec->buf->set_whole_tile();
+				continue;
+			}
+
 			/* Compute the intersection of the area of interest, expressed in tile coordinates */
 			/* with the tile coordinates */
 			auto dims = tilec->buf->bounds();
@@ -935,16 +1003,16 @@ bool TileProcessor::decompress_tile_t1(void) {
 			auto tilec = tile->comps + compno;
 			auto tccp = m_tcp->tccps + compno;
 
-			if (!whole_tile_decoding) {
+			if (!tilec->whole_tile_decoding) {
 				try {
-					tilec->alloc_sparse_array(m_resno_decoded[compno] + 1);
+					tilec->alloc_sparse_array(m_resno_decoded[compno] + 1, m_coderPool);
 				} catch (runtime_error &ex) {
 					GROK_ERROR("decompress_tile_t1: %s", ex.what());
 					return false;
 				}
 			}
 			std::vector<decodeBlockInfo*> blocks;
-			auto t1_wrap = std::unique_ptr<Tier1>(new Tier1());
+			auto t1_wrap = std::unique_ptr<Tier1>(new Tier1(m_coderPool));
 			if (!t1_wrap->prepareDecodeCodeblocks(tilec, tccp, &blocks))
 				return false;
 			// !!! assume that code block dimensions do not change over components
@@ -957,6 +1025,8 @@ bool TileProcessor::decompress_tile_t1(void) {
 				if (!Wavelet::decompress(this, tilec,
 						m_resno_decoded[compno] + 1, tccp->qmfbid))
 					return false;
+			if (!whole_tile_decoding)
+				tilec->buf->crop_to_window();
 
 			tilec->release_mem();
 		}
@@ -977,6 +1047,10 @@ void TileProcessor::copy_image_to_tile() {
 		auto tilec = tile->comps + i;
 		auto img_comp = image->comps + i;
 
+		// tile data is supplied separately, by grk_compress_tile
+		if (!img_comp->data)
+			continue;
+
 		uint32_t offset_x = ceildiv<uint32_t>(image->x0, img_comp->dx);
 		uint32_t offset_y = ceildiv<uint32_t>(image->y0, img_comp->dy);
 		uint64_t image_offset = (tilec->x0 - offset_x)
@@ -992,6 +1066,87 @@ void TileProcessor::copy_image_to_tile() {
 	}
 }
 
+/**
+ * Convert a row of raw samples, one or two bytes each, to 32 bit samples
+ *
+ * @param src			first raw sample
+ * @param step			distance in bytes between raw samples
+ * @param dest			destination row
+ * @param w				number of samples
+ */
+template<typename T, bool big_endian> void grk_raw_row_to_tile(
+		const uint8_t *src, size_t step, int32_t *dest, uint32_t w) {
+	for (uint32_t i = 0; i < w; ++i) {
+		uint32_t val = src[0];
+		if (sizeof(T) == 2)
+			val = big_endian ? (val << 8) | src[1] : val | ((uint32_t)src[1] << 8);
+		dest[i] = (T) val;
+		src += step;
+	}
+}
+
+template<typename T, bool big_endian> void grk_raw_to_tile(const uint8_t *src,
+		size_t step, size_t src_stride, int32_t *dest, uint32_t dest_stride,
+		uint32_t w, uint32_t h) {
+	for (uint32_t j = 0; j < h; ++j) {
+		grk_raw_row_to_tile<T, big_endian>(src, step, dest, w);
+		src += src_stride;
+		dest += dest_stride;
+	}
+}
+
+void TileProcessor::copy_raw_frame_to_tile() {
+	auto layout = &m_encoder->m_raw_layout;
+	bool big_endian = layout->big_endian;
+	uint32_t numcomps = image->numcomps;
+	auto plane = m_encoder->m_raw_frame;
+	for (uint32_t i = 0; i < numcomps; ++i) {
+		auto tilec = tile->comps + i;
+		auto img_comp = image->comps + i;
+		size_t sample_size = img_comp->prec <= 8 ? 1 : 2;
+		size_t step = sample_size;
+		size_t src_stride = (size_t) img_comp->w * sample_size;
+		auto src = plane;
+		if (layout->interleaved) {
+			step *= numcomps;
+			src_stride *= numcomps;
+			src += i * sample_size;
+		} else {
+			plane += src_stride * img_comp->h;
+		}
+		uint32_t offset_x = ceildiv<uint32_t>(image->x0, img_comp->dx);
+		uint32_t offset_y = ceildiv<uint32_t>(image->y0, img_comp->dy);
+		src += (tilec->x0 - offset_x) * step
+				+ (uint64_t) (tilec->y0 - offset_y) * src_stride;
+		auto dest = tilec->buf->ptr();
+		uint32_t dest_stride = tilec->buf->stride();
+		uint32_t w = tilec->width();
+		uint32_t h = tilec->height();
+		if (sample_size == 1) {
+			if (img_comp->sgnd)
+				grk_raw_to_tile<int8_t, false>(src, step, src_stride, dest,
+						dest_stride, w, h);
+			else
+				grk_raw_to_tile<uint8_t, false>(src, step, src_stride, dest,
+						dest_stride, w, h);
+		} else if (big_endian) {
+			if (img_comp->sgnd)
+				grk_raw_to_tile<int16_t, true>(src, step, src_stride, dest,
+						dest_stride, w, h);
+			else
+				grk_raw_to_tile<uint16_t, true>(src, step, src_stride, dest,
+						dest_stride, w, h);
+		} else {
+			if (img_comp->sgnd)
+				grk_raw_to_tile<int16_t, false>(src, step, src_stride, dest,
+						dest_stride, w, h);
+			else
+				grk_raw_to_tile<uint16_t, false>(src, step, src_stride, dest,
+						dest_stride, w, h);
+		}
+	}
+}
+
 bool TileProcessor::t2_decode(ChunkBuffer *src_buf,
 		uint64_t *p_data_read) {
 	auto t2 = new T2Decode(this);
@@ -1217,9 +1372,9 @@ void TileProcessor::t1_encode() {
 		mct_norms = (const double*) (tcp->mct_norms);
 	}
 
-	auto t1_wrap = std::unique_ptr<Tier1>(new Tier1());
-
-	t1_wrap->encodeCodeblocks(tcp, tile, mct_norms, mct_numcomps,
+	if (!m_tier1)
+		m_tier1 = new Tier1(m_coderPool);
+	m_tier1->encodeCodeblocks(tcp, tile, mct_norms, mct_numcomps,
 			needs_rate_control());
 }
 
@@ -1455,7 +1610,9 @@ bool TileProcessor::pre_write_tile() {
 				}
 			}
 		}
-		if (!transfer_image_to_tile)
+		if (m_encoder->m_raw_frame)
+			copy_raw_frame_to_tile();
+		else if (!transfer_image_to_tile)
 			copy_image_to_tile();
 	}
 
@@ -1490,7 +1647,6 @@ bool TileProcessor::copy_uncompressed_data_to_tile(uint8_t *p_src,
 
 	if (!p_src || (tile_size != src_length))
 		return false;
-	size_t length_per_component = src_length / image->numcomps;
 	for (uint32_t i = 0; i < image->numcomps; ++i) {
 		auto tilec = tile->comps + i;
 		auto img_comp = image->comps + i;
@@ -1500,6 +1656,7 @@ bool TileProcessor::copy_uncompressed_data_to_tile(uint8_t *p_src,
 		uint32_t w = (uint32_t)tilec->buf->bounds().width();
 		uint32_t h = (uint32_t)tilec->buf->bounds().height();
 		uint32_t stride = tilec->buf->stride();
+		uint64_t length_per_component = tilec->area();
 		switch (size_comp) {
 		case 1:
 			if (img_comp->sgnd) {
@@ -1652,7 +1809,8 @@ bool grk_packet_length_info::operator==(const grk_packet_length_info &rhs) const
 }
 
 grk_pass::grk_pass() :
-		rate(0), distortiondec(0), len(0), term(0), slope(0) {
+		rate(0), distortiondec(0), len(0), term(0), slope(0),
+		skippedBitPlanes(0) {
 }
 grk_layer::grk_layer() :
 		numpasses(0), len(0), disto(0), data(nullptr) {
@@ -1840,6 +1998,7 @@ void grk_cblk_dec::clear(){
 
 grk_cblk_dec::grk_cblk_dec(const grk_cblk_dec &rhs) :
 				grk_cblk(rhs),
+				seg_buffer_padded(false),
 				segs(rhs.segs), numSegments(rhs.numSegments),
 				numSegmentsAllocated(rhs.numSegmentsAllocated)
 {}
@@ -1881,6 +2040,7 @@ void grk_cblk_dec::init() {
 	compressedDataSize = 0;
 	owns_data = false;
 	segs = nullptr;
+	seg_buffer_padded = false;
 	x0 = 0;
 	y0 = 0;
 	x1 = 0;
@@ -1911,6 +2071,7 @@ void grk_cblk_dec::cleanup_seg_buffers(){
 	for (auto& b : seg_buffers)
 		delete b;
 	seg_buffers.clear();
+	seg_buffer_padded = false;
 
 }
 
@@ -54,6 +54,7 @@ struct grk_pass {
 	uint32_t len;
 	uint8_t term;
 	uint16_t slope;  //ln(slope) in 8.8 fixed point
+	uint8_t skippedBitPlanes; // HT: least significant bit planes not coded
 };
 
 //quality layer
@@ -119,6 +120,9 @@ struct grk_cblk_dec: public grk_cblk {
 	size_t getSegBuffersLen();
 	bool copy_to_contiguous_buffer(uint8_t *buffer);
 	std::vector<grk_buf*> seg_buffers;
+	// true if there is a single segment buffer, and its source buffer holds
+	// at least grk_cblk_dec_compressed_data_pad_ht bytes on either side of it
+	bool seg_buffer_padded;
 	grk_seg *segs; /* information on segments */
 	uint32_t numSegments; /* number of segment in block*/
 	uint32_t numSegmentsAllocated; // number of segments allocated for segs array
@@ -175,6 +179,7 @@ struct grk_resolution : public grk_rect_u32 {
 };
 
 struct TileComponent;
+class Tier1;
 
 // tile
 struct grk_tile : public grk_rect_u32 {
@@ -265,6 +270,12 @@ struct TileProcessor {
 
 	void copy_image_to_tile();
 
+	/**
+	 * Convert this tile's samples from the raw frame set by
+	 * compress_raw_frame into the tile component buffers
+	 */
+	void copy_raw_frame_to_tile();
+
 	/** index of tile being currently coded/decoded */
 	uint16_t m_tile_index;
 
@@ -300,6 +311,9 @@ struct TileProcessor {
 	PacketTracker m_packetTracker;
 
 	uint32_t* m_resno_decoded;
+
+	/** T1 coders and scratch buffers shared by all tiles of the codec */
+	CoderPool *m_coderPool;
 private:
 
 	/** position of the tile part flag in progression order*/
@@ -308,8 +322,21 @@ private:
 	/** coding/decoding parameters common to all tiles */
 	TileCodingParams *m_tcp;
 
+	/** T1 coders, kept between frames */
+	Tier1 *m_tier1;
+
+	/** encoder state of code stream: holds raw frame, if any */
+	const EncoderState *m_encoder;
+
+	/** threshold chosen for each layer by feasible rate control
+	 *  for the previous frame (0 if there is no previous frame) */
+	uint16_t m_prev_layer_thresh[100];
+
 	 bool t2_decode(ChunkBuffer *src_buf,	uint64_t *p_data_read);
 
+	 void estimate_decode_cost(uint32_t compno, double *whole_cost,
+			 	 	 	 	 	 double *window_cost);
+
 	 bool is_whole_tilecomp_decoding( uint32_t compno);
 
 	 bool mct_decode();
@@ -335,6 +362,9 @@ private:
 
 	 void makelayer_final(uint32_t layno);
 
+	 uint32_t update_layer(grk_cblk_enc *cblk, grk_layer *layer,
+			 uint32_t cumulative_included_passes_in_block);
+
 	 bool pcrd_bisect_simple(uint32_t *p_data_written);
 
 	 void make_layer_simple(uint32_t layno, double thresh,
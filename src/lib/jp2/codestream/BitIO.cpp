@@ -22,15 +22,59 @@
 
 namespace grk {
 
+/*
+ Lookup tables for decoding packet header codes
+ */
+struct BitIOTables {
+	BitIOTables() {
+		for (uint32_t i = 0; i < 256; ++i) {
+			uint8_t n = 0;
+			while (n < 8 && (i & (0x80 >> n)))
+				n++;
+			leading_ones[i] = n;
+		}
+		for (uint32_t i = 0; i < 512; ++i) {
+			if (!(i & 0x100)) {
+				numpasses[i] = 1;
+				numpasses_len[i] = 1;
+			} else if (!(i & 0x80)) {
+				numpasses[i] = 2;
+				numpasses_len[i] = 2;
+			} else if (((i >> 5) & 3) != 3) {
+				numpasses[i] = (uint8_t) (3 + ((i >> 5) & 3));
+				numpasses_len[i] = 4;
+			} else if ((i & 0x1f) != 0x1f) {
+				numpasses[i] = (uint8_t) (6 + (i & 0x1f));
+				numpasses_len[i] = 9;
+			} else {
+				// 16 bit code : remaining 7 bits follow the 9 bit prefix
+				numpasses[i] = 37;
+				numpasses_len[i] = 0;
+			}
+		}
+	}
+	/* number of leading one bits in a byte */
+	uint8_t leading_ones[256];
+	/* number of passes, indexed by the first 9 bits of a number of passes code */
+	uint8_t numpasses[512];
+	/* code length, indexed by the first 9 bits of a number of passes code,
+	 * or zero if the code is longer than 9 bits */
+	uint8_t numpasses_len[512];
+};
+
+static const BitIOTables bitio_tables;
+
 BitIO::BitIO(uint8_t *bp, uint64_t len, bool isEncoder) :
 		start(bp), offset(0), buf_len(len), buf(0), ct(isEncoder ? 8 : 0), total_bytes(
-				0), sim_out(false), stream(nullptr) {
+				0), sim_out(false), stream(nullptr), is_encoder(isEncoder), acc(
+				0), acc_bits(0) {
 
 }
 
 BitIO::BitIO(IBufferedStream *strm, bool isEncoder) :
 		start(nullptr), offset(0), buf_len(0), buf(0), ct(isEncoder ? 8 : 0), total_bytes(
-				0), sim_out(false), stream(strm) {
+				0), sim_out(false), stream(strm), is_encoder(isEncoder), acc(0), acc_bits(
+				0) {
 }
 
 bool BitIO::byteout() {
@@ -57,12 +101,56 @@ bool BitIO::byteout_stream() {
 	return true;
 }
 
-void BitIO::bytein() {
-	if (offset == buf_len)
-		throw TruncatedStreamException();
-	ct = buf == 0xff ? 7 : 8;
-	buf = start[offset];
-	offset++;
+void BitIO::fill() {
+	while (acc_bits <= 56 && offset < buf_len) {
+		// whole bytes can be copied as long as none of them needs a stuffed bit
+		// removed from the byte that follows it
+		if (buf != 0xff && offset + 8 <= buf_len) {
+			uint64_t word;
+			grk_read<uint64_t>(start + offset, &word);
+			uint32_t nb_bytes = (64 - acc_bits) >> 3;
+			uint64_t not_ff = ~word;
+			if (nb_bytes < 8)
+				not_ff |= ~(uint64_t) 0 >> (nb_bytes << 3);
+			bool has_ff = ((not_ff - 0x0101010101010101ULL) & ~not_ff
+					& 0x8080808080808080ULL) != 0;
+			if (!has_ff) {
+				acc |= (word >> (64 - (nb_bytes << 3)))
+						<< (64 - acc_bits - (nb_bytes << 3));
+				acc_bits += nb_bytes << 3;
+				offset += nb_bytes;
+				buf = start[offset - 1];
+				continue;
+			}
+		}
+		uint8_t b = start[offset++];
+		// byte following 0xFF has its most significant bit stuffed
+		if (buf == 0xff) {
+			acc |= (uint64_t) (b & 0x7f) << (57 - acc_bits);
+			acc_bits += 7;
+		} else {
+			acc |= (uint64_t) b << (56 - acc_bits);
+			acc_bits += 8;
+		}
+		buf = b;
+	}
+}
+
+size_t BitIO::consumed_bytes(uint8_t *last, uint32_t *ct_left) {
+	size_t num_bytes = offset;
+	uint32_t remaining = acc_bits;
+	while (num_bytes) {
+		uint32_t width =
+				(num_bytes > 1 && start[num_bytes - 2] == 0xff) ? 7 : 8;
+		if (remaining < width)
+			break;
+		remaining -= width;
+		num_bytes--;
+	}
+	*last = num_bytes ? start[num_bytes - 1] : 0;
+	*ct_left = remaining;
+
+	return num_bytes;
 }
 
 bool BitIO::putbit(uint8_t b) {
@@ -75,15 +163,12 @@ bool BitIO::putbit(uint8_t b) {
 	return true;
 }
 
-void BitIO::getbit(uint32_t *bits, uint8_t pos) {
-	if (ct == 0)
-		bytein();
-	assert(ct > 0);
-	ct = (uint8_t)(ct-1);
-	*bits |= (uint32_t)(((buf >> ct) & 1) << pos);
-}
-
 size_t BitIO::numbytes() {
+	if (!is_encoder) {
+		uint8_t last;
+		uint32_t ct_left;
+		return total_bytes + consumed_bytes(&last, &ct_left);
+	}
 	return total_bytes + offset;
 }
 
@@ -98,15 +183,14 @@ bool BitIO::write(uint32_t v, uint32_t n) {
 
 void BitIO::read(uint32_t *bits, uint32_t n) {
 	assert(n != 0 && n <= 32U);
-#ifdef GRK_UBSAN_BUILD
-	/* This assert fails for some corrupted images which are gracefully rejected */
-	/* Add this assert only for ubsan build. */
-	/* This is the condition for overflow not to occur below which is needed because of GROK_NOSANITIZE */
-	assert(n <= 32U);
-#endif
-	*bits = 0U;
-	for (int32_t i = (int32_t)(n - 1); i >= 0; i--)
-		getbit(bits, static_cast<uint8_t>(i));
+	if (acc_bits < n) {
+		fill();
+		if (acc_bits < n)
+			throw TruncatedStreamException();
+	}
+	*bits = (uint32_t) (acc >> (64 - n));
+	acc <<= n;
+	acc_bits -= n;
 }
 
 bool BitIO::flush() {
@@ -120,9 +204,18 @@ bool BitIO::flush() {
 }
 
 void BitIO::inalign() {
-	if (buf == 0xff)
-		bytein();
-	ct = 0;
+	uint8_t last;
+	uint32_t ct_left;
+	offset = consumed_bytes(&last, &ct_left);
+	// skip remaining bits of current byte, and the byte following 0xFF
+	if (last == 0xff) {
+		if (offset == buf_len)
+			throw TruncatedStreamException();
+		last = start[offset++];
+	}
+	buf = last;
+	acc = 0;
+	acc_bits = 0;
 }
 
 void BitIO::putcommacode(int32_t n) {
@@ -133,11 +226,27 @@ void BitIO::putcommacode(int32_t n) {
 
 void BitIO::getcommacode(uint32_t *n) {
 	*n = 0;
-	uint32_t temp;
-	read(&temp, 1);
-	while (temp){
-		++*n;
-		read(&temp, 1);
+	while (true) {
+		if (acc_bits < 8) {
+			fill();
+			if (!acc_bits)
+				throw TruncatedStreamException();
+		}
+		uint32_t ones = bitio_tables.leading_ones[acc >> 56];
+		if (ones < acc_bits) {
+			// terminating zero bit is in the accumulator
+			*n += ones;
+			if (ones < 8) {
+				acc <<= ones + 1;
+				acc_bits -= ones + 1;
+				return;
+			}
+		} else {
+			*n += acc_bits;
+			ones = acc_bits;
+		}
+		acc <<= ones;
+		acc_bits -= ones;
 	}
 }
 
@@ -155,6 +264,25 @@ void BitIO::putnumpasses(uint32_t n) {
 }
 
 void BitIO::getnumpasses(uint32_t *numpasses) {
+	if (acc_bits < 9)
+		fill();
+	if (acc_bits >= 9) {
+		uint32_t prefix = (uint32_t) (acc >> 55);
+		uint32_t len = bitio_tables.numpasses_len[prefix];
+		*numpasses = bitio_tables.numpasses[prefix];
+		if (len) {
+			acc <<= len;
+			acc_bits -= len;
+		} else {
+			uint32_t n;
+			acc <<= 9;
+			acc_bits -= 9;
+			read(&n, 7);
+			*numpasses += n;
+		}
+		return;
+	}
+	// fewer than 9 bits remain in packet header
 	uint32_t n = 0;
 	read(&n, 1);
 	if (!n) {
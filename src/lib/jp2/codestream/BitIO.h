@@ -91,17 +91,20 @@ private:
 
 	IBufferedStream *stream;
 
+	bool is_encoder;
+
+	/* decoder : bits that have been read from the buffer but not yet consumed,
+	 * most significant bit first, with stuffed bits removed */
+	uint64_t acc;
+	/* decoder : number of valid bits in acc */
+	uint32_t acc_bits;
+
 	/*
 	 Write a bit
 	 @param bio BIO handle
 	 @param b Bit to write (0 or 1)
 	 */
 	bool putbit(uint8_t b);
-	/*
-	 Read a bit
-	 @param bio BIO handle
-	 */
-	void getbit(uint32_t *bits, uint8_t pos);
 	/*
 	 Write a byte
 	 @param bio BIO handle
@@ -116,10 +119,16 @@ private:
 	 */
 	bool byteout_stream();
 	/*
-	 Read a byte
-	 @param bio BIO handle
+	 Read as many bytes as fit into the bit accumulator
+	 */
+	void fill();
+
+	/*
+	 Number of bytes that bits have been consumed from, when decoding
+	 @param last	last of these bytes, on return
+	 @param ct_left	number of unconsumed bits in last byte, on return
 	 */
-	void bytein();
+	size_t consumed_bytes(uint8_t *last, uint32_t *ct_left);
 
 };
 
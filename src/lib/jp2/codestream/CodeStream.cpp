@@ -126,6 +126,17 @@ static bool j2k_exec(CodeStream *codeStream, std::vector<j2k_procedure> &p_proce
  */
 static bool j2k_update_rates(CodeStream *codeStream, TileProcessor *tileProcessor, BufferedStream *stream);
 
+/**
+ * Caps the layer rates of each tile so that a compressed frame
+ * never exceeds the maximum code stream size.
+ *
+ * @param       codeStream          JPEG 2000 code stream
+ * @param 		tileProcessor		tile processor
+ * @param       stream              buffered stream.
+
+ */
+static bool j2k_apply_frame_budget(CodeStream *codeStream, TileProcessor *tileProcessor, BufferedStream *stream);
+
 /**
  * Copies the decoding tile parameters onto all the tile parameters.
  * Creates also the tile decoder.
@@ -980,7 +991,7 @@ static bool j2k_decompress_tiles(CodeStream *codeStream, TileProcessor *tileProc
 	bool multi_tile = num_tiles_to_decode > 1;
 	std::atomic<bool> success(true);
 	std::atomic<uint32_t> num_tiles_decoded(0);
-	ThreadPool pool(std::min<uint32_t>((uint32_t)ThreadPool::get()->num_threads(), num_tiles_to_decode));
+	ThreadPool pool(std::min<uint32_t>(codeStream->m_cp.tile_threads(), num_tiles_to_decode));
 	std::vector< std::future<int> > results;
 
 	if (multi_tile && codeStream->m_output_image) {
@@ -1458,7 +1469,13 @@ static bool j2k_init_header_writing(CodeStream *codeStream) {
 
 	if (codeStream->cstr_index)
 		codeStream->m_procedure_list.push_back((j2k_procedure) j2k_get_end_header);
-	codeStream->m_procedure_list.push_back((j2k_procedure) j2k_update_rates);
+	// when compressing frames, rates are converted to bytes for the first frame
+	// and then kept for all subsequent frames
+	if (codeStream->m_encoder.m_num_frames == 0) {
+		codeStream->m_procedure_list.push_back((j2k_procedure) j2k_update_rates);
+		if (codeStream->m_encoder.m_frame_mode)
+			codeStream->m_procedure_list.push_back((j2k_procedure) j2k_apply_frame_budget);
+	}
 
 	return true;
 }
@@ -1844,6 +1861,97 @@ static bool j2k_update_rates(CodeStream *codeStream, TileProcessor *tileProcesso
 	return true;
 }
 
+static bool j2k_apply_frame_budget(CodeStream *codeStream, TileProcessor *tileProcessor, BufferedStream *stream) {
+	GRK_UNUSED(tileProcessor);
+	assert(codeStream != nullptr);
+	assert(stream != nullptr);
+
+	auto cp = &(codeStream->m_cp);
+	uint64_t budget = cp->m_coding_params.m_enc.m_max_cs_size;
+	if (!budget)
+		return true;
+	if (!cp->m_coding_params.m_enc.m_disto_alloc) {
+		GROK_WARN("Frame budget of %llu bytes is only enforced for rate/distortion allocation",
+				(unsigned long long)budget);
+		return true;
+	}
+	auto image = codeStream->m_input_image;
+	uint32_t nb_tiles = cp->t_grid_width * cp->t_grid_height;
+
+	// fixed overhead : main header, SOT and SOD markers for every tile part, and EOC.
+	// PLT markers are not reserved: the budget below caps every layer rate,
+	// and PLT generation is disabled for tiles that need rate control
+	uint64_t overhead = stream->tell() - codeStream->m_encoder.m_frame_start + 2;
+	for (uint32_t i = 0; i < nb_tiles; ++i)
+		overhead += 14 * (uint64_t)cp->tcps[i].m_nb_tile_parts;
+	if (overhead >= budget) {
+		GROK_ERROR("Frame budget of %llu bytes cannot hold %llu bytes of marker segments",
+				(unsigned long long)budget, (unsigned long long)overhead);
+		return false;
+	}
+	double packet_budget = (double)(budget - overhead);
+	double area = (double)(image->x1 - image->x0) * (image->y1 - image->y0);
+
+	// share packet budget between tiles in proportion to their area,
+	// and cap every layer of each tile at its share
+	auto tcp = cp->tcps;
+	for (uint32_t i = 0; i < cp->t_grid_height; ++i) {
+		for (uint32_t j = 0; j < cp->t_grid_width; ++j) {
+			uint32_t x0 = std::max<uint32_t>((cp->tx0 + j * cp->t_width),
+					image->x0);
+			uint32_t y0 = std::max<uint32_t>((cp->ty0 + i * cp->t_height),
+					image->y0);
+			uint32_t x1 = std::min<uint32_t>((cp->tx0 + (j + 1) * cp->t_width),
+					image->x1);
+			uint32_t y1 = std::min<uint32_t>((cp->ty0 + (i + 1) * cp->t_height),
+					image->y1);
+			uint64_t numTilePixels = (uint64_t) (x1 - x0) * (y1 - y0);
+			double tile_budget = std::max<double>(floor(packet_budget * (double)numTilePixels / area), 1.0);
+
+			// every packet of a layer costs at least one byte, even if empty,
+			// so reserve room in each layer for the packets of the layers above it
+			uint64_t packets_per_layer = 0;
+			for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+				auto tccp = tcp->tccps + compno;
+				auto comp = image->comps + compno;
+				uint32_t tcx0 = ceildiv<uint32_t>(x0, comp->dx);
+				uint32_t tcy0 = ceildiv<uint32_t>(y0, comp->dy);
+				uint32_t tcx1 = ceildiv<uint32_t>(x1, comp->dx);
+				uint32_t tcy1 = ceildiv<uint32_t>(y1, comp->dy);
+				for (uint32_t resno = 0; resno < tccp->numresolutions; ++resno) {
+					uint32_t level = tccp->numresolutions - 1 - resno;
+					uint32_t rx0 = ceildivpow2<uint32_t>(tcx0, level);
+					uint32_t ry0 = ceildivpow2<uint32_t>(tcy0, level);
+					uint32_t rx1 = ceildivpow2<uint32_t>(tcx1, level);
+					uint32_t ry1 = ceildivpow2<uint32_t>(tcy1, level);
+					if (rx0 == rx1 || ry0 == ry1)
+						continue;
+					uint32_t pdx = tccp->prcw[resno];
+					uint32_t pdy = tccp->prch[resno];
+					uint64_t pw = ceildivpow2<uint32_t>(rx1, pdx) - (rx0 >> pdx);
+					uint64_t ph = ceildivpow2<uint32_t>(ry1, pdy) - (ry0 >> pdy);
+					packets_per_layer += pw * ph;
+				}
+			}
+			uint32_t empty_packet_len = 1;
+			if (tcp->csty & J2K_CP_CSTY_SOP)
+				empty_packet_len += 6;
+			if (tcp->csty & J2K_CP_CSTY_EPH)
+				empty_packet_len += 2;
+			for (uint32_t k = 0; k < tcp->numlayers; ++k) {
+				double reserve = (double)((tcp->numlayers - 1 - k)
+						* packets_per_layer * empty_packet_len);
+				double layer_budget = std::max<double>(tile_budget - reserve, 1.0);
+				if (tcp->rates[k] == 0.0 || tcp->rates[k] > layer_budget)
+					tcp->rates[k] = layer_budget;
+			}
+			++tcp;
+		}
+	}
+
+	return true;
+}
+
 char* j2k_convert_progression_order(GRK_PROG_ORDER prg_order) {
 	j2k_prog_order *po;
 	for (po = j2k_prog_order_list; po->enum_prog != -1; po++) {
@@ -2031,10 +2139,11 @@ bool j2k_end_compress(CodeStream *codeStream, BufferedStream *stream) {
 }
 
 
-CodeStream::CodeStream(bool decode) : m_input_image(nullptr),
+CodeStream::CodeStream(bool decode, CoderPool *pool) : m_input_image(nullptr),
 							m_output_image(nullptr),
 							cstr_index(nullptr),
 							m_tileProcessor(nullptr),
+							m_coderPool(pool),
 							m_tile_ind_to_dec(-1),
 							m_marker_scratch(nullptr),
 							m_marker_scratch_size(0),
@@ -2068,6 +2177,8 @@ CodeStream::~CodeStream(){
 	grk_image_destroy(m_output_image);
 	grk_free(m_marker_scratch);
 	delete m_tileProcessor;
+	for (auto &proc : m_frameProcessors)
+		delete proc;
 }
 
 
@@ -2280,6 +2391,7 @@ void CodeStream::init_decompress(grk_dparameters  *parameters){
 	if (parameters) {
 		m_cp.m_coding_params.m_dec.m_layer = parameters->cp_layer;
 		m_cp.m_coding_params.m_dec.m_reduce = parameters->cp_reduce;
+		m_cp.m_num_threads = parameters->numThreads;
 	}
 }
 
@@ -2473,6 +2585,8 @@ bool CodeStream::init_compress(grk_cparameters  *parameters,grk_image *image){
 	cp->m_coding_params.m_enc.writeTLM = parameters->writeTLM;
 	cp->m_coding_params.m_enc.rateControlAlgorithm =
 			parameters->rateControlAlgorithm;
+	cp->m_coding_params.m_enc.m_max_cs_size = parameters->max_cs_size;
+	cp->m_num_threads = parameters->numThreads;
 
 	/* tiles */
 	cp->t_width = parameters->t_width;
@@ -2772,13 +2886,30 @@ bool CodeStream::compress(grk_plugin_tile* tile,	BufferedStream *stream){
 				"allowed by the standard.", nb_tiles, max_num_tiles);
 		return false;
 	}
-	auto pool_size = std::min<uint32_t>((uint32_t)ThreadPool::get()->num_threads(), nb_tiles);
+	auto pool_size = std::min<uint32_t>(m_cp.tile_threads(), nb_tiles);
 	ThreadPool pool(pool_size);
 	std::vector< std::future<int> > results;
 	std::unique_ptr<TileProcessor*[]> procs = std::make_unique<TileProcessor*[]>(nb_tiles);
 	std::atomic<bool> success(true);
 	bool rc = false;
 
+	// when compressing frames, tile processors are kept for the next frame
+	bool keep = m_encoder.m_frame_mode;
+	if (keep)
+		m_frameProcessors.resize(nb_tiles, nullptr);
+	auto get_processor = [this, keep](uint16_t tile_ind) {
+		if (!keep)
+			return new TileProcessor(this);
+		auto &proc = m_frameProcessors[tile_ind];
+		if (!proc)
+			proc = new TileProcessor(this);
+		return proc;
+	};
+	auto release_processor = [keep](TileProcessor *proc) {
+		if (!keep)
+			delete proc;
+	};
+
 	for (uint16_t i = 0; i < nb_tiles; ++i)
 		procs[i] = nullptr;
 
@@ -2786,14 +2917,14 @@ bool CodeStream::compress(grk_plugin_tile* tile,	BufferedStream *stream){
 		for (uint16_t i = 0; i < nb_tiles; ++i) {
 			uint16_t tile_ind = i;
 			results.emplace_back(
-					pool.enqueue([this,
+					pool.enqueue([&get_processor,
 								  &procs,
 								  tile,
 								  tile_ind,
 								  stream,
 								  &success] {
 						if (success) {
-							auto tileProcessor = new TileProcessor(this);
+							auto tileProcessor = get_processor(tile_ind);
 
 							tileProcessor->m_tile_index = tile_ind;
 							tileProcessor->current_plugin_tile = tile;
@@ -2811,23 +2942,23 @@ bool CodeStream::compress(grk_plugin_tile* tile,	BufferedStream *stream){
 		}
 	} else {
 		for (uint16_t i = 0; i < nb_tiles; ++i) {
-			auto tileProcessor = new TileProcessor(this);
+			auto tileProcessor = get_processor(i);
 
 			tileProcessor->m_tile_index = i;
 			tileProcessor->current_plugin_tile = tile;
 			if (!tileProcessor->pre_write_tile()){
-				delete tileProcessor;
+				release_processor(tileProcessor);
 				goto cleanup;
 			}
 			if (!tileProcessor->do_encode(stream)){
-				delete tileProcessor;
+				release_processor(tileProcessor);
 				goto cleanup;
 			}
 			if (!j2k_post_write_tile(this, tileProcessor, stream)){
-				delete tileProcessor;
+				release_processor(tileProcessor);
 				goto cleanup;
 			}
-			delete tileProcessor;
+			release_processor(tileProcessor);
 		}
 	}
 	if (pool_size > 1) {
@@ -2839,7 +2970,7 @@ bool CodeStream::compress(grk_plugin_tile* tile,	BufferedStream *stream){
 		for (uint16_t i = 0; i < nb_tiles; ++i) {
 			if (!j2k_post_write_tile(this, procs[i], stream))
 				goto cleanup;
-			delete procs[i];
+			release_processor(procs[i]);
 			procs[i] = nullptr;
 		}
 	}
@@ -2847,7 +2978,7 @@ bool CodeStream::compress(grk_plugin_tile* tile,	BufferedStream *stream){
 	rc = true;
 cleanup:
 	for (uint16_t i = 0; i < nb_tiles; ++i)
-		delete procs[i];
+		release_processor(procs[i]);
 
 	return rc;
 }
@@ -2896,6 +3027,142 @@ bool CodeStream::end_compress(BufferedStream *stream){
 	return  j2k_exec(this, m_procedure_list, stream);
 }
 
+bool CodeStream::compress_frame(grk_image *frame, BufferedStream *stream){
+	if (!begin_frame(frame, stream))
+		return false;
+	bool rc = start_compress(stream) && compress(nullptr, stream)
+			&& end_compress(stream);
+	end_frame(stream);
+
+	return rc;
+}
+
+bool CodeStream::compress_raw_frame(const uint8_t *data, uint64_t data_len,
+		const grk_raw_frame_layout *layout, BufferedStream *stream){
+	if (!begin_raw_frame(data, data_len, layout, stream))
+		return false;
+	bool rc = start_compress(stream) && compress(nullptr, stream)
+			&& end_compress(stream);
+	end_frame(stream);
+
+	return rc;
+}
+
+bool CodeStream::begin_frame(grk_image *frame, BufferedStream *stream){
+	assert(stream != nullptr);
+	auto image = m_input_image;
+	if (!frame || !image) {
+		GROK_ERROR("Compressor must be initialized before compressing frames");
+		return false;
+	}
+	if (frame->numcomps != image->numcomps || frame->x0 != image->x0
+			|| frame->y0 != image->y0 || frame->x1 != image->x1
+			|| frame->y1 != image->y1) {
+		GROK_ERROR("Frame dimensions differ from dimensions of initial image");
+		return false;
+	}
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+		auto src = frame->comps + compno;
+		auto dest = image->comps + compno;
+		if (src->w != dest->w || src->h != dest->h || src->dx != dest->dx
+				|| src->dy != dest->dy || src->prec != dest->prec
+				|| src->sgnd != dest->sgnd) {
+			GROK_ERROR("Frame component %u differs from component of initial image",
+					compno);
+			return false;
+		}
+		if (!src->data) {
+			GROK_ERROR("Frame component %u has no data", compno);
+			return false;
+		}
+	}
+	// frame data is borrowed for the duration of the frame
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+		auto dest = image->comps + compno;
+		grk_image_single_component_data_free(dest);
+		dest->data = frame->comps[compno].data;
+		dest->stride = frame->comps[compno].stride;
+		dest->owns_data = false;
+	}
+	start_frame(stream);
+
+	return true;
+}
+
+bool CodeStream::begin_raw_frame(const uint8_t *data, uint64_t data_len,
+		const grk_raw_frame_layout *layout, BufferedStream *stream){
+	assert(stream != nullptr);
+	auto image = m_input_image;
+	if (!data || !layout || !image) {
+		GROK_ERROR("Compressor must be initialized before compressing frames");
+		return false;
+	}
+	uint64_t frame_len = 0;
+	auto comp0 = image->comps;
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+		auto comp = image->comps + compno;
+		if (comp->w != ceildiv<uint32_t>(image->x1, comp->dx)
+						- ceildiv<uint32_t>(image->x0, comp->dx)
+				|| comp->h != ceildiv<uint32_t>(image->y1, comp->dy)
+						- ceildiv<uint32_t>(image->y0, comp->dy)) {
+			GROK_ERROR("Raw frame component %u dimensions are inconsistent "
+					"with image dimensions", compno);
+			return false;
+		}
+		if (comp->prec > 16) {
+			GROK_ERROR("Raw frame component %u: precision %u is greater than 16",
+					compno, comp->prec);
+			return false;
+		}
+		if (layout->interleaved
+				&& (comp->dx != 1 || comp->dy != 1 || comp->prec != comp0->prec
+						|| comp->sgnd != comp0->sgnd)) {
+			GROK_ERROR("Interleaved raw frame components must have the same "
+					"precision and sign, and must not be sub-sampled");
+			return false;
+		}
+		frame_len += (uint64_t) comp->w * comp->h * (comp->prec <= 8 ? 1 : 2);
+	}
+	if (data_len != frame_len) {
+		GROK_ERROR("Raw frame length %llu differs from expected length %llu",
+				(unsigned long long)data_len, (unsigned long long)frame_len);
+		return false;
+	}
+	// samples are converted from the raw frame, tile by tile
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+		grk_image_single_component_data_free(image->comps + compno);
+		image->comps[compno].data = nullptr;
+	}
+	m_encoder.m_raw_frame = data;
+	m_encoder.m_raw_layout = *layout;
+	start_frame(stream);
+
+	return true;
+}
+
+void CodeStream::start_frame(BufferedStream *stream){
+	m_encoder.m_frame_mode = true;
+	m_encoder.m_frame_start = stream->tell();
+
+	// TLM markers are bound to the stream they are written to
+	delete m_cp.tlm_markers;
+	m_cp.tlm_markers = nullptr;
+}
+
+void CodeStream::end_frame(BufferedStream *stream){
+	assert(stream != nullptr);
+	for (uint32_t compno = 0; compno < m_input_image->numcomps; ++compno)
+		m_input_image->comps[compno].data = nullptr;
+	m_encoder.m_raw_frame = nullptr;
+	uint64_t budget = m_cp.m_coding_params.m_enc.m_max_cs_size;
+	uint64_t frame_len = stream->tell() - m_encoder.m_frame_start;
+	if (budget && frame_len > budget)
+		GROK_WARN("Frame %llu length %llu exceeds budget of %llu bytes",
+				(unsigned long long)m_encoder.m_num_frames,
+				(unsigned long long)frame_len, (unsigned long long)budget);
+	m_encoder.m_num_frames++;
+}
+
 bool CodeStream::set_decompress_area(grk_image *output_image,
 		uint32_t start_x, uint32_t start_y, uint32_t end_x, uint32_t end_y) {
 
@@ -160,6 +160,11 @@ struct ICodeStream {
 
    virtual bool end_compress(BufferedStream *stream) = 0;
 
+   virtual bool compress_frame(grk_image *frame, BufferedStream *stream) = 0;
+
+   virtual bool compress_raw_frame(const uint8_t *data, uint64_t data_len,
+		   const grk_raw_frame_layout *layout, BufferedStream *stream) = 0;
+
    virtual void dump(int32_t flag, FILE *out_stream) = 0;
 
    virtual grk_codestream_info_v2* get_cstr_info(void) = 0;
@@ -169,7 +174,11 @@ struct ICodeStream {
 
 struct CodeStream : public ICodeStream {
 
-	CodeStream(bool decode);
+	/**
+	 * @param decode	true for decompression
+	 * @param pool		pool of T1 coders and scratch buffers owned by the codec
+	 */
+	CodeStream(bool decode, CoderPool *pool);
 	~CodeStream();
 
 	/** Main header reading function handler */
@@ -197,6 +206,44 @@ struct CodeStream : public ICodeStream {
 
    bool end_compress(BufferedStream *stream);
 
+   bool compress_frame(grk_image *frame, BufferedStream *stream);
+
+   bool compress_raw_frame(const uint8_t *data, uint64_t data_len,
+		   const grk_raw_frame_layout *layout, BufferedStream *stream);
+
+   /**
+    * Prepare to compress a frame: swap the frame's component data into
+    * the input image, and keep coding state from the previous frame
+    *
+    * @param frame 	frame with same geometry as image passed to init_compress
+    * @param stream	stream for compressed frame
+    *
+    * @return true if successful
+    */
+   bool begin_frame(grk_image *frame, BufferedStream *stream);
+
+   /**
+    * Prepare to compress a raw frame: samples are converted from the
+    * raw frame into each tile as the tile is compressed
+    *
+    * @param data 		raw frame samples
+    * @param data_len	length of raw frame in bytes
+    * @param layout		layout of raw frame
+    * @param stream		stream for compressed frame
+    *
+    * @return true if successful
+    */
+   bool begin_raw_frame(const uint8_t *data, uint64_t data_len,
+		   const grk_raw_frame_layout *layout, BufferedStream *stream);
+
+   /**
+    * Finish compressing a frame: release the frame's component data
+    * and check that the frame fits in the byte budget
+    *
+    * @param stream	stream for compressed frame
+    */
+   void end_frame(BufferedStream *stream);
+
    void dump(int32_t flag, FILE *out_stream);
 
    grk_codestream_info_v2* get_cstr_info(void);
@@ -267,6 +314,13 @@ struct CodeStream : public ICodeStream {
 	/** current TileProcessor **/
 	TileProcessor *m_tileProcessor;
 
+	/** tile processors kept between frames by compress_frame */
+	std::vector<TileProcessor*> m_frameProcessors;
+
+	/** T1 coders and scratch buffers, kept between tiles and images
+	 *  (not owned by code stream) */
+	CoderPool *m_coderPool;
+
 
 	/** index of the tile to decompress (used in get_tile);
 	 *  !!! initialized to -1 !!! */
@@ -274,6 +328,14 @@ struct CodeStream : public ICodeStream {
 
 private:
 
+	/**
+	 * Keep coding state from the previous frame, and record
+	 * where the new frame starts in the stream
+	 *
+	 * @param stream	stream for compressed frame
+	 */
+	void start_frame(BufferedStream *stream);
+
 	uint8_t *m_marker_scratch;
 	uint16_t m_marker_scratch_size;
     /** Only valid for decoding. Whether the whole tile is decoded, or just the region in win_x0/win_y0/win_x1/win_y1 */
@@ -23,6 +23,14 @@
 
 namespace grk {
 
+uint32_t CodingParams::tile_threads() const {
+	auto pool_threads = (uint32_t) ThreadPool::get()->num_threads();
+	if (m_num_threads && m_num_threads < pool_threads)
+		return m_num_threads;
+
+	return pool_threads;
+}
+
 void CodingParams::destroy() {
 	if (tcps != nullptr) {
 		uint32_t nb_tiles = t_grid_height * t_grid_width;
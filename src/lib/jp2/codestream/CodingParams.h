@@ -216,6 +216,8 @@ struct EncodingParams {
 	bool writeTLM;
 	/* rate control algorithm */
 	uint32_t rateControlAlgorithm;
+	/** maximum size of code stream in bytes (0 if unlimited) */
+	uint64_t m_max_cs_size;
 };
 
 struct DecodingParams {
@@ -266,6 +268,15 @@ struct CodingParams {
 	TileLengthMarkers *tlm_markers;
 	PacketLengthMarkers *plm_markers;
 
+	/** maximum number of tiles processed concurrently (0 if unlimited) */
+	uint32_t m_num_threads;
+
+	/**
+	 * Number of threads for concurrent tiles: the library thread pool
+	 * size, capped by m_num_threads
+	 */
+	uint32_t tile_threads() const;
+
 	void destroy();
 
 };
@@ -318,12 +329,33 @@ struct DecoderState {
 
 struct EncoderState {
 
-	EncoderState() : m_total_tile_parts(0) {}
+	EncoderState() : m_total_tile_parts(0),
+					m_frame_mode(false),
+					m_num_frames(0),
+					m_frame_start(0),
+					m_raw_frame(nullptr),
+					m_raw_layout()
+	{}
 
 	/** Total num of tile parts in whole image = num tiles* num tileparts in each tile*/
 	/** used in TLMmarker*/
 	uint16_t m_total_tile_parts; /* totnum_tp */
 
+	/** true once compress_frame has been called: coding state is then kept between frames */
+	bool m_frame_mode;
+
+	/** number of frames compressed by compress_frame */
+	uint64_t m_num_frames;
+
+	/** stream offset of the start of the current frame */
+	uint64_t m_frame_start;
+
+	/** raw frame being compressed by compress_raw_frame, or nullptr */
+	const uint8_t *m_raw_frame;
+
+	/** layout of raw frame */
+	grk_raw_frame_layout m_raw_layout;
+
 };
 
 }
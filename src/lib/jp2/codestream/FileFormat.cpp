@@ -2540,7 +2540,7 @@ bool jp2_decompress_tile(FileFormat *fileFormat,
 	return (fileFormat ? fileFormat->decompress_tile(stream,p_image,tile_index) : false);
 }
 
-FileFormat::FileFormat(bool isDecoder) : codeStream(new CodeStream(isDecoder)),
+FileFormat::FileFormat(bool isDecoder, CoderPool *pool) : codeStream(new CodeStream(isDecoder, pool)),
 										m_validation_list(new std::vector<jp2_procedure>()),
 										m_procedure_list(new std::vector<jp2_procedure>()),
 										w(0),
@@ -3041,6 +3041,27 @@ bool FileFormat::end_compress(BufferedStream *stream){
 	return jp2_exec(this, m_procedure_list, stream);
 }
 
+bool FileFormat::compress_frame(grk_image *frame, BufferedStream *stream){
+	if (!codeStream->begin_frame(frame, stream))
+		return false;
+	bool rc = start_compress(stream) && compress(nullptr, stream)
+			&& end_compress(stream);
+	codeStream->end_frame(stream);
+
+	return rc;
+}
+
+bool FileFormat::compress_raw_frame(const uint8_t *data, uint64_t data_len,
+		const grk_raw_frame_layout *layout, BufferedStream *stream){
+	if (!codeStream->begin_raw_frame(data, data_len, layout, stream))
+		return false;
+	bool rc = start_compress(stream) && compress(nullptr, stream)
+			&& end_compress(stream);
+	codeStream->end_frame(stream);
+
+	return rc;
+}
+
 bool FileFormat::decompress_tile(BufferedStream *stream, grk_image *p_image,
 		uint16_t tile_index) {
 	if (!p_image)
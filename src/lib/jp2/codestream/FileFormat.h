@@ -130,7 +130,7 @@ typedef bool (*jp2_procedure)(FileFormat *fileFormat, BufferedStream*);
  JPEG 2000 file format reader/writer
  */
 struct FileFormat : public ICodeStream {
-	FileFormat(bool isDecoder);
+	FileFormat(bool isDecoder, CoderPool *pool);
 	~FileFormat();
 
 
@@ -176,6 +176,11 @@ struct FileFormat : public ICodeStream {
 
    bool end_compress(BufferedStream *stream);
 
+   bool compress_frame(grk_image *frame, BufferedStream *stream);
+
+   bool compress_raw_frame(const uint8_t *data, uint64_t data_len,
+		   const grk_raw_frame_layout *layout, BufferedStream *stream);
+
 	bool decompress_tile(BufferedStream *stream, grk_image *p_image,
 			uint16_t tile_index);
 
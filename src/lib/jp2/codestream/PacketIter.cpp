@@ -306,315 +306,277 @@ static bool pi_next_rlcp(PacketIter *pi) {
 	return false;
 }
 
-static bool pi_next_rpcl(PacketIter *pi) {
-	grk_pi_comp *comp = nullptr;
-	grk_pi_resolution *res = nullptr;
-	uint64_t index = 0;
-
-	if (!pi->first) {
-		goto LABEL_SKIP;
-	} else {
-		update_pi_dxy(pi);
-	}
-	if (!pi->tp_on) {
-		pi->poc.ty0 = pi->ty0;
-		pi->poc.tx0 = pi->tx0;
-		pi->poc.ty1 = pi->ty1;
-		pi->poc.tx1 = pi->tx1;
-	}
-	for (pi->resno = pi->poc.resno0; pi->resno < pi->poc.resno1; pi->resno++) {
-		for (pi->y = pi->poc.ty0; pi->y < pi->poc.ty1;
-				pi->y += pi->dy - (pi->y % pi->dy)) {
-			for (pi->x = pi->poc.tx0; pi->x < pi->poc.tx1;
-					pi->x += pi->dx - (pi->x % pi->dx)) {
-				for (pi->compno = pi->poc.compno0; pi->compno < pi->poc.compno1;
-						pi->compno++) {
-					uint32_t levelno;
-					uint32_t trx0, try0;
-					uint32_t trx1, try1;
-					uint32_t rpx, rpy;
-					uint32_t prci, prcj;
-					comp = &pi->comps[pi->compno];
-					if (pi->resno >= comp->numresolutions)
-						continue;
-
-					res = &comp->resolutions[pi->resno];
-					levelno = comp->numresolutions - 1 - pi->resno;
-					if (levelno >= GRK_J2K_MAXRLVLS)
-						continue;
-					trx0 = ceildiv<uint64_t>((uint64_t) pi->tx0,
-							((uint64_t) comp->dx << levelno));
-					try0 = ceildiv<uint64_t>((uint64_t) pi->ty0,
-							((uint64_t) comp->dy << levelno));
-					trx1 = ceildiv<uint64_t>((uint64_t) pi->tx1,
-							((uint64_t) comp->dx << levelno));
-					try1 = ceildiv<uint64_t>((uint64_t) pi->ty1,
-							((uint64_t) comp->dy << levelno));
-					rpx = res->pdx + levelno;
-					rpy = res->pdy + levelno;
-					if (!(((uint64_t) pi->y % ((uint64_t) comp->dy << rpy) == 0)
-							|| ((pi->y == pi->ty0)
-									&& (((uint64_t) try0 << levelno)
-											% ((uint64_t) 1 << rpy))))) {
-						continue;
-					}
-					if (!(((uint64_t) pi->x % ((uint64_t) comp->dx << rpx) == 0)
-							|| ((pi->x == pi->tx0)
-									&& (((uint64_t) trx0 << levelno)
-											% ((uint64_t) 1 << rpx))))) {
-						continue;
-					}
-
-					if ((res->pw == 0) || (res->ph == 0))
-						continue;
-
-					if ((trx0 == trx1) || (try0 == try1))
-						continue;
+/**
+ * Precinct of a component resolution, together with the position on the
+ * reference grid at which the position-driven progressions visit it
+ */
+struct pi_precinct {
+	uint32_t y, x;
+	uint32_t compno;
+	uint32_t resno;
+	uint64_t precno;
+	/** precinct index could not be computed from position */
+	bool invalid;
+};
 
-					prci = uint_floordivpow2(
-							ceildiv<uint64_t>((uint64_t) pi->x,
-									((uint64_t) comp->dx << levelno)), res->pdx)
-							- uint_floordivpow2(trx0, res->pdx);
-					prcj = uint_floordivpow2(
-							ceildiv<uint64_t>((uint64_t) pi->y,
-									((uint64_t) comp->dy << levelno)), res->pdy)
-							- uint_floordivpow2(try0, res->pdy);
-					pi->precno = (prci + (uint64_t)prcj * res->pw);
-					//skip precinct numbers greater than total number of precincts
-					// for this resolution
-					if (pi->precno >= (uint64_t)res->pw * res->ph)
-						continue;
-					for (pi->layno = pi->poc.layno0; pi->layno < pi->poc.layno1;
-							pi->layno++) {
-						index = pi->layno * pi->step_l + pi->resno * pi->step_r
-								+ pi->compno * pi->step_c
-								+ pi->precno * pi->step_p;
-						if (!pi->include[index]) {
-							pi->include[index] = true;
-							return true;
-						}
-						LABEL_SKIP: ;
-					}
-				}
-			}
+/**
+ * Get the positions visited by a position-driven progression along one axis,
+ * for one component resolution: the progression steps from v0 to the next multiple
+ * of step, then from multiple to multiple, up to v1, and a precinct starts
+ * at every visited position that is a multiple of the precinct size prc_size,
+ * or at the tile origin t0 if the precinct grid is not aligned with it.
+ *
+ * @param v0		start of range
+ * @param v1		end of range
+ * @param step		step between visited positions
+ * @param t0		tile origin
+ * @param prc_size	precinct size on reference grid
+ * @param unaligned	true if precinct grid is not aligned with tile origin
+ * @param pos		positions, in increasing order, on return
+ */
+static void pi_get_precinct_positions(uint32_t v0, uint32_t v1, uint32_t step,
+		uint32_t t0, uint64_t prc_size, bool unaligned,
+		std::vector<uint32_t> &pos) {
+	pos.clear();
+	auto visited = [v0, step](uint64_t v) {
+		return v == v0 || (step && (v % step) == 0);
+	};
+	bool origin = unaligned && t0 >= v0 && t0 < v1 && visited(t0)
+			&& (t0 % prc_size) != 0;
+	uint64_t m = ((v0 + prc_size - 1) / prc_size) * prc_size;
+	for (; m < v1; m += prc_size) {
+		if (origin && t0 < m) {
+			pos.push_back(t0);
+			origin = false;
 		}
+		if (visited(m))
+			pos.push_back((uint32_t) m);
 	}
-
-	return false;
+	if (origin)
+		pos.push_back(t0);
 }
 
-static bool pi_next_pcrl(PacketIter *pi) {
-	grk_pi_comp *comp = nullptr;
-	grk_pi_resolution *res = nullptr;
-	uint64_t index = 0;
-
-	if (!pi->first) {
-		comp = &pi->comps[pi->compno];
-		goto LABEL_SKIP;
+/**
+ * Get the precincts of one component resolution visited by a position-driven
+ * progression
+ *
+ * @param pi		packet iterator
+ * @param compno	component number
+ * @param resno		resolution number
+ * @param prc		precincts, appended on return
+ */
+static void pi_get_precincts(PacketIter *pi, uint32_t compno, uint32_t resno,
+		std::vector<pi_precinct> &prc) {
+	auto comp = pi->comps + compno;
+	auto res = comp->resolutions + resno;
+	uint32_t levelno = comp->numresolutions - 1 - resno;
+	if (levelno >= GRK_J2K_MAXRLVLS)
+		return;
+	if ((res->pw == 0) || (res->ph == 0))
+		return;
+	uint32_t trx0 = ceildiv<uint64_t>((uint64_t) pi->tx0,
+			((uint64_t) comp->dx << levelno));
+	uint32_t try0 = ceildiv<uint64_t>((uint64_t) pi->ty0,
+			((uint64_t) comp->dy << levelno));
+	uint32_t trx1 = ceildiv<uint64_t>((uint64_t) pi->tx1,
+			((uint64_t) comp->dx << levelno));
+	uint32_t try1 = ceildiv<uint64_t>((uint64_t) pi->ty1,
+			((uint64_t) comp->dy << levelno));
+	if ((trx0 == trx1) || (try0 == try1))
+		return;
+	uint32_t rpx = res->pdx + levelno;
+	uint32_t rpy = res->pdy + levelno;
+
+	std::vector<uint32_t> ys, xs;
+	pi_get_precinct_positions(pi->poc.ty0, pi->poc.ty1, pi->dy, pi->ty0,
+			(uint64_t) comp->dy << rpy,
+			((uint64_t) try0 << levelno) % ((uint64_t) 1 << rpy), ys);
+	if (ys.empty())
+		return;
+	pi_get_precinct_positions(pi->poc.tx0, pi->poc.tx1, pi->dx, pi->tx0,
+			(uint64_t) comp->dx << rpx,
+			((uint64_t) trx0 << levelno) % ((uint64_t) 1 << rpx), xs);
+	uint32_t prc_x0 = uint_floordivpow2(trx0, res->pdx);
+	uint32_t prc_y0 = uint_floordivpow2(try0, res->pdy);
+	for (auto y : ys) {
+		uint32_t py = uint_floordivpow2(
+				ceildiv<uint64_t>((uint64_t) y,
+						((uint64_t) comp->dy << levelno)), res->pdy);
+		for (auto x : xs) {
+			uint32_t px = uint_floordivpow2(
+					ceildiv<uint64_t>((uint64_t) x,
+							((uint64_t) comp->dx << levelno)), res->pdx);
+			pi_precinct p;
+			p.y = y;
+			p.x = x;
+			p.compno = compno;
+			p.resno = resno;
+			p.invalid = px < prc_x0 || py < prc_y0;
+			p.precno = (uint32_t)(px - prc_x0)
+					+ (uint64_t) (uint32_t)(py - prc_y0) * res->pw;
+			//skip precinct numbers greater than total number of precincts
+			// for this resolution
+			if (!p.invalid && p.precno >= (uint64_t) res->pw * res->ph)
+				continue;
+			prc.push_back(p);
+		}
 	}
+}
 
-	update_pi_dxy(pi);
+/**
+ * Generate all packets of a position-driven progression (RPCL, PCRL or CPRL)
+ * that have not been included by a previous progression.
+ *
+ * Rather than stepping across the tile on the finest precinct grid, and testing
+ * every component and resolution at every position, precincts are listed per
+ * component resolution and then sorted by progression order.
+ *
+ * @param pi	packet iterator
+ * @return	false if a precinct index was invalid
+ */
+static bool pi_generate_packets(PacketIter *pi) {
+	if (!pi->packets)
+		pi->packets = new std::vector<grk_pi_packet>();
+	pi->packets->clear();
+	pi->packetno = 0;
 	if (!pi->tp_on) {
 		pi->poc.ty0 = pi->ty0;
 		pi->poc.tx0 = pi->tx0;
 		pi->poc.ty1 = pi->ty1;
 		pi->poc.tx1 = pi->tx1;
 	}
-	for (pi->y = pi->poc.ty0; pi->y < pi->poc.ty1;
-			pi->y += pi->dy - (pi->y % pi->dy)) {
-		for (pi->x = pi->poc.tx0; pi->x < pi->poc.tx1;
-				pi->x += pi->dx - (pi->x % pi->dx)) {
-			for (pi->compno = pi->poc.compno0; pi->compno < pi->poc.compno1;
-					pi->compno++) {
-				comp = &pi->comps[pi->compno];
-				for (pi->resno = pi->poc.resno0;
-						pi->resno
-								< std::min<uint32_t>(pi->poc.resno1,
-										comp->numresolutions); pi->resno++) {
-					uint32_t levelno;
-					uint32_t trx0, try0;
-					uint32_t trx1, try1;
-					uint32_t rpx, rpy;
-					uint32_t prci, prcj;
-					res = &comp->resolutions[pi->resno];
-					levelno = comp->numresolutions - 1 - pi->resno;
-					if (levelno >= GRK_J2K_MAXRLVLS)
-						continue;
-					trx0 = ceildiv<uint64_t>((uint64_t) pi->tx0,
-							((uint64_t) comp->dx << levelno));
-					try0 = ceildiv<uint64_t>((uint64_t) pi->ty0,
-							((uint64_t) comp->dy << levelno));
-					trx1 = ceildiv<uint64_t>((uint64_t) pi->tx1,
-							((uint64_t) comp->dx << levelno));
-					try1 = ceildiv<uint64_t>((uint64_t) pi->ty1,
-							((uint64_t) comp->dy << levelno));
-					rpx = res->pdx + levelno;
-					rpy = res->pdy + levelno;
-					if (!(((uint64_t) pi->y % ((uint64_t) comp->dy << rpy) == 0)
-							|| ((pi->y == pi->ty0)
-									&& (((uint64_t) try0 << levelno)
-											% ((uint64_t) 1 << rpy))))) {
-						continue;
-					}
-					if (!(((uint64_t) pi->x % ((uint64_t) comp->dx << rpx) == 0)
-							|| ((pi->x == pi->tx0)
-									&& (((uint64_t) trx0 << levelno)
-											% ((uint64_t) 1 << rpx))))) {
-						continue;
-					}
-
-					if ((res->pw == 0) || (res->ph == 0))
-						continue;
-
-					if ((trx0 == trx1) || (try0 == try1))
-						continue;
-
-					prci = uint_floordivpow2(
-							ceildiv<uint64_t>((uint64_t) pi->x,
-									((uint64_t) comp->dx << levelno)), res->pdx)
-							- uint_floordivpow2(trx0, res->pdx);
-					prcj = uint_floordivpow2(
-							ceildiv<uint64_t>((uint64_t) pi->y,
-									((uint64_t) comp->dy << levelno)), res->pdy)
-							- uint_floordivpow2(try0, res->pdy);
-					pi->precno = (prci + (uint64_t)prcj * res->pw);
-					//skip precinct numbers greater than total number of precincts
-					// for this resolution
-					if (pi->precno >= (uint64_t)res->pw * res->ph)
-						continue;
-					for (pi->layno = pi->poc.layno0; pi->layno < pi->poc.layno1;
-							pi->layno++) {
-						index = pi->layno * pi->step_l + pi->resno * pi->step_r
-								+ pi->compno * pi->step_c
-								+ pi->precno * pi->step_p;
-						if (!pi->include[index]) {
-							pi->include[index] = true;
-							return true;
-						}
-						LABEL_SKIP: ;
-					}
+	auto emit = [pi](const pi_precinct &p) {
+		for (uint32_t layno = pi->poc.layno0; layno < pi->poc.layno1; layno++) {
+			uint64_t index = layno * pi->step_l + p.resno * pi->step_r
+					+ p.compno * pi->step_c + p.precno * pi->step_p;
+			if (!pi->include[index]) {
+				pi->include[index] = true;
+				grk_pi_packet packet;
+				packet.precno = p.precno;
+				packet.compno = (uint16_t) p.compno;
+				packet.layno = (uint16_t) layno;
+				packet.resno = (uint8_t) p.resno;
+				pi->packets->push_back(packet);
+			}
+		}
+	};
+	std::vector<pi_precinct> prc;
+	switch (pi->poc.prg) {
+	case GRK_RPCL:
+		update_pi_dxy(pi);
+		for (uint32_t resno = pi->poc.resno0; resno < pi->poc.resno1; resno++) {
+			prc.clear();
+			for (uint32_t compno = pi->poc.compno0; compno < pi->poc.compno1;
+					compno++) {
+				if (resno < pi->comps[compno].numresolutions)
+					pi_get_precincts(pi, compno, resno, prc);
+			}
+			std::sort(prc.begin(), prc.end(),
+					[](const pi_precinct &a, const pi_precinct &b) {
+						if (a.y != b.y)
+							return a.y < b.y;
+						if (a.x != b.x)
+							return a.x < b.x;
+						return a.compno < b.compno;
+					});
+			for (auto &p : prc) {
+				if (!p.invalid)
+					emit(p);
+			}
+		}
+		break;
+	case GRK_PCRL:
+		update_pi_dxy(pi);
+		for (uint32_t compno = pi->poc.compno0; compno < pi->poc.compno1;
+				compno++) {
+			uint32_t resno1 = std::min<uint32_t>(pi->poc.resno1,
+					pi->comps[compno].numresolutions);
+			for (uint32_t resno = pi->poc.resno0; resno < resno1; resno++)
+				pi_get_precincts(pi, compno, resno, prc);
+		}
+		std::sort(prc.begin(), prc.end(),
+				[](const pi_precinct &a, const pi_precinct &b) {
+					if (a.y != b.y)
+						return a.y < b.y;
+					if (a.x != b.x)
+						return a.x < b.x;
+					if (a.compno != b.compno)
+						return a.compno < b.compno;
+					return a.resno < b.resno;
+				});
+		for (auto &p : prc) {
+			if (!p.invalid)
+				emit(p);
+		}
+		break;
+	case GRK_CPRL:
+		for (uint32_t compno = pi->poc.compno0; compno < pi->poc.compno1;
+				compno++) {
+			auto comp = pi->comps + compno;
+			pi->dx = 0;
+			pi->dy = 0;
+			update_pi_dxy_for_comp(pi, comp);
+			prc.clear();
+			uint32_t resno1 = std::min<uint32_t>(pi->poc.resno1,
+					comp->numresolutions);
+			for (uint32_t resno = pi->poc.resno0; resno < resno1; resno++)
+				pi_get_precincts(pi, compno, resno, prc);
+			std::sort(prc.begin(), prc.end(),
+					[](const pi_precinct &a, const pi_precinct &b) {
+						if (a.y != b.y)
+							return a.y < b.y;
+						if (a.x != b.x)
+							return a.x < b.x;
+						return a.resno < b.resno;
+					});
+			for (auto &p : prc) {
+				if (p.invalid) {
+					GROK_ERROR("Precinct index invalid");
+					return false;
 				}
+				emit(p);
 			}
 		}
+		break;
+	default:
+		assert(false);
+		break;
 	}
+	pi->first = 0;
 
-	return false;
+	return true;
 }
 
-static bool pi_next_cprl(PacketIter *pi) {
-	grk_pi_comp *comp = nullptr;
-	grk_pi_resolution *res = nullptr;
-	uint64_t index = 0;
-
-	if (!pi->first) {
-		comp = &pi->comps[pi->compno];
-		goto LABEL_SKIP;
-	}
-
-	pi->first = 0;
-	for (pi->compno = pi->poc.compno0; pi->compno < pi->poc.compno1;
-			pi->compno++) {
-		comp = &pi->comps[pi->compno];
-		pi->dx = 0;
-		pi->dy = 0;
-		update_pi_dxy_for_comp(pi, comp);
-		if (!pi->tp_on) {
-			pi->poc.ty0 = pi->ty0;
-			pi->poc.tx0 = pi->tx0;
-			pi->poc.ty1 = pi->ty1;
-			pi->poc.tx1 = pi->tx1;
-		}
-		for (pi->y = pi->poc.ty0; pi->y < pi->poc.ty1;
-				pi->y += pi->dy - (pi->y % pi->dy)) {
-			for (pi->x = pi->poc.tx0; pi->x < pi->poc.tx1;
-					pi->x += pi->dx - (pi->x % pi->dx)) {
-				for (pi->resno = pi->poc.resno0;
-						pi->resno
-								< std::min<uint32_t>(pi->poc.resno1,
-										comp->numresolutions); pi->resno++) {
-					uint32_t levelno;
-					uint32_t trx0, try0;
-					uint32_t trx1, try1;
-					uint32_t rpx, rpy;
-					uint32_t prci, prcj;
-					uint32_t temp1, temp2;
-					res = &comp->resolutions[pi->resno];
-					levelno = comp->numresolutions - 1 - pi->resno;
-					if (levelno >= GRK_J2K_MAXRLVLS)
-						continue;
-					trx0 = ceildiv<uint64_t>((uint64_t) pi->tx0,
-							((uint64_t) comp->dx << levelno));
-					try0 = ceildiv<uint64_t>((uint64_t) pi->ty0,
-							((uint64_t) comp->dy << levelno));
-					trx1 = ceildiv<uint64_t>((uint64_t) pi->tx1,
-							((uint64_t) comp->dx << levelno));
-					try1 = ceildiv<uint64_t>((uint64_t) pi->ty1,
-							((uint64_t) comp->dy << levelno));
-					rpx = res->pdx + levelno;
-					rpy = res->pdy + levelno;
-					if (!(((uint64_t) pi->y % ((uint64_t) comp->dy << rpy) == 0)
-							|| ((pi->y == pi->ty0)
-									&& (((uint64_t) try0 << levelno)
-											% ((uint64_t) 1 << rpy))))) {
-						continue;
-					}
-					if (!(((uint64_t) pi->x % ((uint64_t) comp->dx << rpx) == 0)
-							|| ((pi->x == pi->tx0)
-									&& (((uint64_t) trx0 << levelno)
-											% ((uint64_t) 1 << rpx))))) {
-						continue;
-					}
-
-					if ((res->pw == 0) || (res->ph == 0))
-						continue;
+/**
+ Get next packet from packets generated for a position-driven progression
+ @param pi packet iterator to modify
+ @return returns false if pi pointed to the last packet or else returns true
+ */
+static bool pi_next_generated(PacketIter *pi) {
+	// on error, packets preceding the invalid precinct are still iterated
+	if (pi->first && !pi_generate_packets(pi))
+		pi->first = 0;
+	if (!pi->packets || pi->packetno >= pi->packets->size())
+		return false;
+	auto packet = pi->packets->data() + pi->packetno++;
+	pi->compno = packet->compno;
+	pi->resno = packet->resno;
+	pi->precno = packet->precno;
+	pi->layno = packet->layno;
 
-					if ((trx0 == trx1) || (try0 == try1))
-						continue;
+	return true;
+}
 
-					temp1 = uint_floordivpow2(
-							ceildiv<uint64_t>((uint64_t) pi->x,
-									((uint64_t) comp->dx << levelno)),
-							res->pdx);
+static bool pi_next_rpcl(PacketIter *pi) {
+	return pi_next_generated(pi);
+}
 
-					temp2 = uint_floordivpow2(trx0, res->pdx);
-					if (temp2 > temp1) {
-						GROK_ERROR("Precinct index invalid");
-						return false;
-					}
-					prci = temp1 - temp2;
-
-					temp1 = uint_floordivpow2(
-							ceildiv<uint64_t>((uint64_t) pi->y,
-									((uint64_t) comp->dy << levelno)),
-							res->pdy);
-					temp2 = uint_floordivpow2(try0, res->pdy);
-					if (temp2 > temp1) {
-						GROK_ERROR("Precinct index invalid");
-						return false;
-					}
-					prcj = temp1 - temp2;
-					pi->precno = prci + (uint64_t)prcj * res->pw;
-					//skip precinct numbers greater than total number of precincts
-					// for this resolution
-					if (pi->precno >= (uint64_t)res->pw * res->ph)
-						continue;
-					for (pi->layno = pi->poc.layno0; pi->layno < pi->poc.layno1;
-							pi->layno++) {
-						index = pi->layno * pi->step_l + pi->resno * pi->step_r
-								+ pi->compno * pi->step_c
-								+ pi->precno * pi->step_p;
-						if (!pi->include[index]) {
-							pi->include[index] = true;
-							return true;
-						}
-						LABEL_SKIP: ;
-					}
-				}
-			}
-		}
-	}
+static bool pi_next_pcrl(PacketIter *pi) {
+	return pi_next_generated(pi);
+}
 
-	return false;
+static bool pi_next_cprl(PacketIter *pi) {
+	return pi_next_generated(pi);
 }
 
 static void grk_get_encoding_parameters(const grk_image *p_image,
@@ -1544,6 +1506,7 @@ void pi_destroy(PacketIter *p_pi, uint32_t nb_elements) {
 				}
 				grk_free(current_pi->comps);
 			}
+			delete current_pi->packets;
 		}
 		grk_free(p_pi);
 	}
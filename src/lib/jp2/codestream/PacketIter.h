@@ -51,6 +51,16 @@ struct grk_pi_resolution {
 	uint32_t pw, ph;
 };
 
+/**
+ * Packet in progression order
+ */
+struct grk_pi_packet {
+	uint64_t precno;
+	uint16_t compno;
+	uint16_t layno;
+	uint8_t resno;
+};
+
 /**
  * Packet iterator component
  */
@@ -99,6 +109,11 @@ struct PacketIter {
 	uint32_t x, y;
 	/** packet subsampling factors */
 	uint32_t dx, dy;
+	/** for position-driven progressions (RPCL, PCRL and CPRL): all packets of the
+	 *  progression, generated on the first call to pi_next */
+	std::vector<grk_pi_packet> *packets;
+	/** index of next packet in packets */
+	uint64_t packetno;
 };
 
 /** @name Exported functions */
@@ -19,71 +19,47 @@
  *
  */
 
+
 #include "grok_includes.h"
 #include  <stdexcept>
 
 namespace grk {
 
 TagTree::TagTree(uint64_t mynumleafsh, uint64_t mynumleafsv) :
-		numleafsh(mynumleafsh), numleafsv(mynumleafsv), numnodes(0), nodes(
-				nullptr), nodes_size(0) {
-	int64_t nplh[32];
-	int64_t nplv[32];
-	uint64_t i;
-	int64_t j, k;
-	uint64_t numlvls;
-	uint64_t n;
-
-	numlvls = 0;
-	nplh[0] = (int64_t) numleafsh;
-	nplv[0] = (int64_t) numleafsv;
-	numnodes = 0;
-	do {
-		n = (uint64_t) (nplh[numlvls] * nplv[numlvls]);
-		nplh[numlvls + 1] = (nplh[numlvls] + 1) / 2;
-		nplv[numlvls + 1] = (nplv[numlvls] + 1) / 2;
-		numnodes += n;
-		++numlvls;
-	} while (n > 1);
-
-	if (numnodes == 0) {
+		numleafsh(0), numleafsv(0), numnodes(0), numlevels(0), values(
+				nullptr), lows(nullptr), known(nullptr), nodes_capacity(0) {
+	if (!init(mynumleafsh, mynumleafsv)) {
 		GROK_WARN("tgt_create numnodes == 0, no tree created.");
 		throw std::runtime_error("tgt_create numnodes == 0, no tree created");
 	}
+}
 
-	nodes = new TagTreeNode[numnodes];
-	nodes_size = numnodes * sizeof(TagTreeNode);
+TagTree::~TagTree() {
+	delete[] values;
+	delete[] lows;
+	delete[] known;
+}
 
-	auto node = nodes;
-	auto parent_node = &nodes[numleafsh * numleafsv];
-	auto parent_node0 = parent_node;
+bool TagTree::layout(uint64_t num_leafs_h, uint64_t num_leafs_v) {
+	uint64_t w = num_leafs_h;
+	uint64_t h = num_leafs_v;
+	uint64_t n;
 
-	for (i = 0; i < numlvls - 1; ++i) {
-		for (j = 0; j < nplv[i]; ++j) {
-			k = nplh[i];
-			while (--k >= 0) {
-				node->parent = parent_node;
-				++node;
-				if (--k >= 0) {
-					node->parent = parent_node;
-					++node;
-				}
-				++parent_node;
-			}
-			if ((j & 1) || j == nplv[i] - 1) {
-				parent_node0 = parent_node;
-			} else {
-				parent_node = parent_node0;
-				parent_node0 += nplh[i];
-			}
-		}
-	}
-	node->parent = 0;
-	reset();
-}
+	numlevels = 0;
+	numnodes = 0;
+	do {
+		if (numlevels == max_levels)
+			return false;
+		n = w * h;
+		level_offset[numlevels] = numnodes;
+		level_width[numlevels] = w;
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+		numnodes += n;
+		++numlevels;
+	} while (n > 1);
 
-TagTree::~TagTree() {
-	delete[] nodes;
+	return numnodes != 0;
 }
 
 /**
@@ -94,113 +70,74 @@ TagTree::~TagTree() {
  * @return      a new tag tree if successful, nullptr otherwise
  */
 bool TagTree::init(uint64_t num_leafs_h, uint64_t num_leafs_v) {
-
-	int64_t nplh[32];
-	int64_t nplv[32];
-
-	if ((numleafsh != num_leafs_h) || (numleafsv != num_leafs_v)) {
+	if ((numleafsh != num_leafs_h) || (numleafsv != num_leafs_v)
+			|| !numnodes) {
+		if (!layout(num_leafs_h, num_leafs_v))
+			return false;
 		numleafsh = num_leafs_h;
 		numleafsv = num_leafs_v;
-
-		uint64_t num_levels = 0;
-		nplh[0] = (int64_t) num_leafs_h;
-		nplv[0] = (int64_t) num_leafs_v;
-		numnodes = 0;
-		uint64_t n;
-		do {
-			n = (uint64_t) (nplh[num_levels] * nplv[num_levels]);
-			nplh[num_levels + 1] = (nplh[num_levels] + 1) / 2;
-			nplv[num_levels + 1] = (nplv[num_levels] + 1) / 2;
-			numnodes += n;
-			++num_levels;
-		} while (n > 1);
-
-		if (numnodes == 0) {
-			return false;
-		}
-		uint64_t node_size = numnodes * sizeof(TagTreeNode);
-
-		if (node_size > nodes_size) {
-			auto new_nodes = new TagTreeNode[numnodes];
-			for (uint64_t i = 0; i < nodes_size / sizeof(TagTreeNode); ++i)
-				new_nodes[i] = nodes[i];
-			delete[] nodes;
-			nodes = new_nodes;
-			nodes_size = node_size;
-		}
-		auto node = nodes;
-		auto parent_node = &nodes[numleafsh * numleafsv];
-		auto parent_node0 = parent_node;
-
-		for (uint64_t i = 0; i < num_levels - 1; ++i) {
-			for (int64_t j = 0; j < nplv[i]; ++j) {
-				int64_t k = nplh[i];
-				while (--k >= 0) {
-					node->parent = parent_node;
-					++node;
-					if (--k >= 0) {
-						node->parent = parent_node;
-						++node;
-					}
-					++parent_node;
-				}
-				if ((j & 1) || j == nplv[i] - 1) {
-					parent_node0 = parent_node;
-				} else {
-					parent_node = parent_node0;
-					parent_node0 += nplh[i];
-				}
-			}
+		if (numnodes > nodes_capacity) {
+			delete[] values;
+			delete[] lows;
+			delete[] known;
+			values = new uint16_t[numnodes];
+			lows = new uint16_t[numnodes];
+			known = new uint8_t[numnodes];
+			nodes_capacity = numnodes;
 		}
-		node->parent = 0;
 	}
 	reset();
 	return true;
 }
 
 void TagTree::reset() {
-	for (uint64_t i = 0; i < numnodes; ++i) {
-		auto current_node = nodes + i;
-		current_node->value = tag_tree_uninitialized_node_value;
-		current_node->low = 0;
-		current_node->known = 0;
+	std::fill(values, values + numnodes,
+			(uint16_t) tag_tree_uninitialized_node_value);
+	memset(lows, 0, numnodes * sizeof(uint16_t));
+	memset(known, 0, numnodes);
+}
+
+void TagTree::getPath(uint64_t leafno, uint64_t *path) const {
+	uint64_t x = leafno % numleafsh;
+	uint64_t y = leafno / numleafsh;
+	for (uint32_t level = 0; level < numlevels; ++level) {
+		path[level] = level_offset[level] + y * level_width[level] + x;
+		x >>= 1;
+		y >>= 1;
 	}
 }
 
 void TagTree::setvalue(uint64_t leafno, int64_t value) {
-	auto node = &nodes[leafno];
-
-	while (node && node->value > value) {
-		node->value = value;
-		node = node->parent;
+	uint64_t x = leafno % numleafsh;
+	uint64_t y = leafno / numleafsh;
+	for (uint32_t level = 0; level < numlevels; ++level) {
+		auto node = level_offset[level] + y * level_width[level] + x;
+		if (values[node] <= value)
+			break;
+		values[node] = (uint16_t) value;
+		x >>= 1;
+		y >>= 1;
 	}
 }
 
 bool TagTree::compress(BitIO *bio, uint64_t leafno, int64_t threshold) {
-	TagTreeNode *stk[31];
-	TagTreeNode **stkptr;
-	int64_t low;
-
-	stkptr = stk;
-	auto node = &nodes[leafno];
-	while (node->parent) {
-		*stkptr++ = node;
-		node = node->parent;
-	}
-
-	low = 0;
-	while (true) {
-		if (low > node->low)
-			node->low = low;
+	uint64_t path[max_levels];
+	getPath(leafno, path);
+
+	int64_t low = 0;
+	for (int32_t level = (int32_t) numlevels - 1; level >= 0; --level) {
+		auto node = path[level];
+		if (low > lows[node])
+			lows[node] = (uint16_t) low;
 		else
-			low = node->low;
+			low = lows[node];
 
 		while (low < threshold) {
-			if (low >= node->value) {
-				if (!node->known) {
+			if (low >= values[node]) {
+				if (!known[node]) {
 					if (!bio->write(1, 1))
 						return false;
-					node->known = 1;
+					known[node] = 1;
 				}
 				break;
 			}
@@ -209,10 +146,7 @@ bool TagTree::compress(BitIO *bio, uint64_t leafno, int64_t threshold) {
 			++low;
 		}
 
-		node->low = low;
-		if (stkptr == stk)
-			break;
-		node = *--stkptr;
+		lows[node] = (uint16_t) low;
 	}
 	return true;
 }
@@ -226,37 +160,30 @@ void TagTree::decompress(BitIO *bio, uint64_t leafno, int64_t threshold,
 
 void TagTree::decodeValue(BitIO *bio, uint64_t leafno, int64_t threshold,
 		uint64_t *value) {
-	TagTreeNode *stk[31];
-	TagTreeNode **stkptr;
-	int64_t low;
+	uint64_t path[max_levels];
+	getPath(leafno, path);
 
 	*value = tag_tree_uninitialized_node_value;
-	stkptr = stk;
-	auto node = &nodes[leafno];
-	while (node->parent) {
-		*stkptr++ = node;
-		node = node->parent;
-	}
-	low = 0;
-	for (;;) {
-		if (low > node->low)
-			node->low = low;
+	int64_t low = 0;
+	for (int32_t level = (int32_t) numlevels - 1; level >= 0; --level) {
+		auto node = path[level];
+		if (low > lows[node])
+			lows[node] = (uint16_t) low;
 		else
-			low = node->low;
-		while (low < threshold && low < node->value) {
+			low = lows[node];
+		int64_t node_value = values[node];
+		while (low < threshold && low < node_value) {
 			uint32_t temp = 0;
 			bio->read(&temp, 1);
 			if (temp)
-				node->value = low;
+				node_value = low;
 			else
 				++low;
 		}
-		node->low = low;
-		if (stkptr == stk)
-			break;
-		node = *--stkptr;
+		values[node] = (uint16_t) node_value;
+		lows[node] = (uint16_t) low;
 	}
-	*value = (uint64_t) node->value;
+	*value = values[path[0]];
 }
 
 }
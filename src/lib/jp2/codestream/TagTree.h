@@ -19,29 +19,19 @@
  *
  */
 
+
 #pragma once
 
 namespace grk {
 
 const uint32_t tag_tree_uninitialized_node_value = 999;
 
-/**
- Tag node
- */
-struct TagTreeNode {
-
-	TagTreeNode() :
-			parent(nullptr), value(0), low(0), known(0) {
-	}
-
-	TagTreeNode *parent;
-	int64_t value;
-	int64_t low;
-	uint32_t known;
-};
-
 /**
  Tag tree
+
+ Nodes are stored level by level in flat arrays, starting with the leaves,
+ and row by row within each level. The parent of node (x,y) is
+ node (x/2,y/2) of the next level, so no parent pointers are stored.
  */
 class TagTree {
 
@@ -104,14 +94,37 @@ public:
 			uint64_t *value);
 
 private:
+	static const uint32_t max_levels = 32;
+
+	/**
+	 Calculate level layout for given leaf dimensions
+	 @return false if tree has no nodes
+	 */
+	bool layout(uint64_t num_leafs_h, uint64_t num_leafs_v);
+
+	/**
+	 Get indices of nodes from a leaf up to the root
+	 @param leafno Number that identifies the leaf
+	 @param path node indices, leaf first, on return
+	 */
+	void getPath(uint64_t leafno, uint64_t *path) const;
 
 	uint64_t numleafsh;
 	uint64_t numleafsv;
 	uint64_t numnodes;
-	TagTreeNode *nodes;
-	uint64_t nodes_size; /* maximum size taken by nodes */
+	uint32_t numlevels;
+	/* index of first node of each level */
+	uint64_t level_offset[max_levels];
+	/* width of each level */
+	uint64_t level_width[max_levels];
+
+	/* node values, and lower bounds on node values */
+	uint16_t *values;
+	uint16_t *lows;
+	/* encoder : 1 if node value has been signalled */
+	uint8_t *known;
+	uint64_t nodes_capacity; /* maximum number of nodes */
 
 };
 
 }
-
@@ -28,6 +28,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 #endif
 #include <fcntl.h>
 #include "grok_includes.h"
@@ -41,8 +42,31 @@ struct grk_codec_private {
 	 grk_stream  *m_stream;
 	/** Flag to indicate if the codec is used to decompress or compress*/
 	bool is_decompressor;
+	GRK_CODEC_FORMAT m_format;
+	/** T1 coders and scratch buffers, kept until codec is destroyed */
+	CoderPool *m_coderPool;
+	/** decompress parameters, kept when codec is reset */
+	 grk_dparameters  m_dparameters;
+	bool m_has_dparameters;
 };
 
+static ICodeStream* grk_create_code_stream(grk_codec_private *codec){
+	try {
+		switch (codec->m_format) {
+		case GRK_CODEC_J2K:
+			return new CodeStream(codec->is_decompressor, codec->m_coderPool);
+		case GRK_CODEC_JP2:
+			return new FileFormat(codec->is_decompressor, codec->m_coderPool);
+		case GRK_CODEC_UNKNOWN:
+		default:
+			break;
+		}
+	} catch (std::exception &ex) {
+		GROK_ERROR("%s", ex.what());
+	}
+	return nullptr;
+}
+
 ThreadPool* ThreadPool::singleton = nullptr;
 std::mutex ThreadPool::singleton_mutex;
 
@@ -101,6 +125,51 @@ static size_t grk_write_to_file(void *p_buffer, size_t nb_bytes,
 		FILE *p_file) {
 	return fwrite(p_buffer, 1, nb_bytes, p_file);
 }
+static size_t grk_writev_to_file(const grk_stream_vec *vec, size_t count,
+		FILE *p_file) {
+	size_t written = 0;
+#ifdef _WIN32
+	for (size_t i = 0; i < count; ++i)
+		written += fwrite(vec[i].buf, 1, vec[i].len, p_file);
+#else
+	// drain stdio buffer, then gather segments straight to the descriptor
+	if (fflush(p_file))
+		return 0;
+	const int max_iov = 1024;
+	struct iovec iov[max_iov];
+	int fd = fileno(p_file);
+	size_t i = 0;
+	while (i < count) {
+		int n = 0;
+		for (; n < max_iov && i + (size_t)n < count; ++n) {
+			iov[n].iov_base = (void*) vec[i + (size_t)n].buf;
+			iov[n].iov_len = vec[i + (size_t)n].len;
+		}
+		int first = 0;
+		while (first < n) {
+			auto rc = writev(fd, iov + first, n - first);
+			if (rc < 0) {
+				if (errno == EINTR)
+					continue;
+				return written;
+			}
+			written += (size_t) rc;
+			// skip fully written segments, and adjust partially written one
+			size_t remaining = (size_t) rc;
+			while (first < n && remaining >= iov[first].iov_len) {
+				remaining -= iov[first].iov_len;
+				first++;
+			}
+			if (first < n) {
+				iov[first].iov_base = (uint8_t*) iov[first].iov_base + remaining;
+				iov[first].iov_len -= remaining;
+			}
+		}
+		i += (size_t)n;
+	}
+#endif
+	return written;
+}
 static bool grok_seek_in_file(int64_t nb_bytes, FILE *p_user_data) {
 	return GROK_FSEEK(p_user_data, nb_bytes, SEEK_SET) ? false : true;
 }
@@ -147,16 +216,11 @@ const char* GRK_CALLCONV grk_version(void) {
 	}
 	codec->is_decompressor = 1;
 	codec->m_stream = stream;
-
-	switch (p_format) {
-	case GRK_CODEC_J2K:
-		codec->m_codeStreamBase = new CodeStream(true);
-		break;
-	case GRK_CODEC_JP2:
-		codec->m_codeStreamBase = new FileFormat(true);
-		break;
-	case GRK_CODEC_UNKNOWN:
-	default:
+	codec->m_format = p_format;
+	codec->m_coderPool = new CoderPool();
+	codec->m_codeStreamBase = grk_create_code_stream(codec);
+	if (!codec->m_codeStreamBase) {
+		delete codec->m_coderPool;
 		grk_free(codec);
 		return nullptr;
 	}
@@ -173,6 +237,8 @@ bool GRK_CALLCONV grk_init_decompress( grk_codec p_codec,
 	if (p_codec && parameters) {
 		auto codec = (grk_codec_private*) p_codec;
 		assert(codec->is_decompressor);
+		codec->m_dparameters = *parameters;
+		codec->m_has_dparameters = true;
 		codec->m_codeStreamBase->init_decompress(parameters);
 		return true;
 	}
@@ -238,16 +304,11 @@ bool GRK_CALLCONV grk_decompress_tile( grk_codec p_codec,
 	}
 	codec->m_stream = stream;
 	codec->is_decompressor = 0;
-
-	switch (p_format) {
-	case GRK_CODEC_J2K:
-		codec->m_codeStreamBase = new CodeStream(false);
-		break;
-	case GRK_CODEC_JP2:
-		codec->m_codeStreamBase = new FileFormat(false);
-		break;
-	case GRK_CODEC_UNKNOWN:
-	default:
+	codec->m_format = p_format;
+	codec->m_coderPool = new CoderPool();
+	codec->m_codeStreamBase = grk_create_code_stream(codec);
+	if (!codec->m_codeStreamBase) {
+		delete codec->m_coderPool;
 		grk_free(codec);
 		return nullptr;
 	}
@@ -330,6 +391,30 @@ bool GRK_CALLCONV grk_end_compress( grk_codec p_codec) {
 	}
 	return false;
 }
+bool GRK_CALLCONV grk_compress_frame( grk_codec p_codec, grk_image *frame,
+		grk_stream *p_stream) {
+	if (p_codec && frame) {
+		auto codec = (grk_codec_private*) p_codec;
+		auto stream = (BufferedStream*) (p_stream ? p_stream : codec->m_stream);
+		assert(!codec->is_decompressor);
+		if (!codec->is_decompressor && stream)
+			return codec->m_codeStreamBase->compress_frame(frame, stream);
+	}
+	return false;
+}
+bool GRK_CALLCONV grk_compress_raw_frame(grk_codec p_codec,
+		const uint8_t *data, uint64_t data_len,
+		const grk_raw_frame_layout *layout, grk_stream *p_stream) {
+	if (p_codec && data && layout) {
+		auto codec = (grk_codec_private*) p_codec;
+		auto stream = (BufferedStream*) (p_stream ? p_stream : codec->m_stream);
+		assert(!codec->is_decompressor);
+		if (!codec->is_decompressor && stream)
+			return codec->m_codeStreamBase->compress_raw_frame(data, data_len,
+					layout, stream);
+	}
+	return false;
+}
 bool GRK_CALLCONV grk_end_decompress( grk_codec p_codec) {
 	if (p_codec) {
 		auto codec = (grk_codec_private*) p_codec;
@@ -384,9 +469,26 @@ void GRK_CALLCONV grk_destroy_codec( grk_codec p_codec) {
 		auto codec = (grk_codec_private*) p_codec;
 		delete codec->m_codeStreamBase;
 		codec->m_codeStreamBase = nullptr;
+		delete codec->m_coderPool;
 		grk_free(codec);
 	}
 }
+bool GRK_CALLCONV grk_reset_codec( grk_codec p_codec, grk_stream *stream) {
+	if (!p_codec)
+		return false;
+	auto codec = (grk_codec_private*) p_codec;
+	auto codeStream = grk_create_code_stream(codec);
+	if (!codeStream)
+		return false;
+	delete codec->m_codeStreamBase;
+	codec->m_codeStreamBase = codeStream;
+	if (stream)
+		codec->m_stream = stream;
+	if (codec->is_decompressor && codec->m_has_dparameters)
+		codeStream->init_decompress(&codec->m_dparameters);
+
+	return true;
+}
 
 /* ---------------------------------------------------------------------- */
 
@@ -467,6 +569,8 @@ static void grok_free_file(void *p_user_data) {
 			(grk_stream_read_fn) grk_read_from_file);
 	grk_stream_set_write_function(stream,
 			(grk_stream_write_fn) grk_write_to_file);
+	grk_stream_set_writev_function(stream,
+			(grk_stream_writev_fn) grk_writev_to_file);
 	grk_stream_set_seek_function(stream,
 			(grk_stream_seek_fn) grok_seek_in_file);
 	return stream;
@@ -417,11 +417,31 @@ typedef struct _grk_raw_cparameters {
 	uint32_t prec;
 	/** signed/unsigned raw image */
 	bool sgnd;
+	/** components are interleaved sample by sample, instead of planar */
+	bool interleaved;
 	/** raw components parameters */
 	grk_raw_comp_cparameters *comps;
 	/*@}*/
 } grk_raw_cparameters;
 
+/**
+ * Layout of a raw frame passed to grk_compress_raw_frame.
+ *
+ * Component dimensions, sub-sampling, precision and sign are taken from
+ * the image passed to grk_init_compress. Samples of precision 8 or less
+ * are stored in one byte, and samples of higher precision in two bytes,
+ * right justified. Rows are not padded.
+ */
+typedef struct _grk_raw_frame_layout {
+	/** true if components are interleaved sample by sample (packed),
+	 * false if they are stored one after the other (planar).
+	 * Interleaved components must all have the same precision and sign,
+	 * and must not be sub-sampled */
+	bool interleaved;
+	/** true if two byte samples are big endian */
+	bool big_endian;
+} grk_raw_frame_layout;
+
 /**
  * Compress parameters
  * */
@@ -539,6 +559,8 @@ typedef struct _grk_cparameters {
 
 	// 0: bisect with all truncation points,  1: bisect with only feasible truncation points
 	uint32_t rateControlAlgorithm;
+	/* maximum number of tiles compressed concurrently,
+	 * or zero for the size of the library thread pool */
 	uint32_t numThreads;
 	int32_t deviceId;
 	uint32_t duration; //seconds
@@ -705,6 +727,9 @@ typedef struct _grk_dparameters {
 	/** Number of tiles to decompress */
 	uint32_t nb_tile_to_decode;
 	uint32_t flags;
+	/** maximum number of tiles decompressed concurrently,
+	 * or zero for the size of the library thread pool */
+	uint32_t numThreads;
 } grk_dparameters;
 
 /**
@@ -768,6 +793,11 @@ typedef struct _grk_decompress_params {
 	// compression "quality". Meaning of "quality" depends
 	// on file format we are writing to
 	uint32_t compressionLevel;
+	/* write tiled TIFF with the code stream's tile dimensions */
+	bool tiff_tiles_from_codestream;
+	/* TIFF tile dimensions, or zero to write TIFF strips */
+	uint32_t tiff_tile_width;
+	uint32_t tiff_tile_height;
 	int32_t deviceId;
 	uint32_t duration; //seconds
 	uint32_t kernelBuildOptions;
@@ -803,6 +833,21 @@ typedef size_t (*grk_stream_zero_copy_read_fn)(void **p_buffer, size_t nb_bytes,
 typedef size_t (*grk_stream_write_fn)(void *p_buffer, size_t nb_bytes,
 		void *user_data);
 
+/*
+ * Segment of data passed to vectored write function
+ */
+typedef struct _grk_stream_vec {
+	const uint8_t *buf;
+	size_t len;
+} grk_stream_vec;
+
+/*
+ * Callback function prototype for vectored (gather) write function.
+ * Segments must be written in order; returns total number of bytes written
+ */
+typedef size_t (*grk_stream_writev_fn)(const grk_stream_vec *vec, size_t count,
+		void *user_data);
+
 /*
  * Callback function prototype for (absolute) seek function.
  */
@@ -1370,6 +1415,18 @@ GRK_API void GRK_CALLCONV grk_stream_set_zero_copy_read_function(
 GRK_API void GRK_CALLCONV grk_stream_set_write_function(grk_stream *stream,
 		grk_stream_write_fn p_function);
 
+/**
+ * Set the given function to be used as a vectored write function.
+ * When set, tile part packet data is handed to this function as a list of
+ * segments referencing library memory, rather than being copied through
+ * the stream buffer.
+ *
+ * @param		stream	the stream to modify
+ * @param		p_function	the function to use as vectored write function.
+ */
+GRK_API void GRK_CALLCONV grk_stream_set_writev_function(grk_stream *stream,
+		grk_stream_writev_fn p_function);
+
 /**
  * Set the given function to be used as a seek function, the stream is then seekable.
  *
@@ -1478,6 +1535,25 @@ GRK_API bool GRK_CALLCONV grk_set_error_handler(grk_msg_callback p_callback,
  */
 GRK_API void GRK_CALLCONV grk_destroy_codec(grk_codec codec);
 
+/**
+ * Reset codec, so that it can be used to compress or decompress
+ * another image.
+ *
+ * All state belonging to the previous image is discarded, while
+ * T1 coders and wavelet scratch buffers are kept, so that they can be reused
+ * for the next image. Decompression parameters set with grk_init_decompress
+ * are also kept.
+ *
+ * After reset, a decompressor is ready for grk_read_header, and a compressor
+ * is ready for grk_init_compress.
+ *
+ * @param	codec		codec handle
+ * @param	stream		stream for next image, or nullptr to keep the current stream
+ *
+ * @return	true if successful
+ */
+GRK_API bool GRK_CALLCONV grk_reset_codec(grk_codec codec, grk_stream *stream);
+
 /**
  * Create J2K/JP2 decompression structure
  *
@@ -1671,6 +1747,51 @@ GRK_API bool GRK_CALLCONV grk_compress_with_plugin(grk_codec codec,
  */
 GRK_API bool GRK_CALLCONV grk_end_compress(grk_codec codec);
 
+/**
+ * Compress one frame of a sequence of frames into a complete code stream.
+ * This method should be called after grk_init_compress, in place of
+ * grk_start_compress, grk_compress and grk_end_compress.
+ *
+ * Coding parameters, tile processors and T1 coders are kept from one frame
+ * to the next, and the feasible truncation point rate control
+ * (rateControlAlgorithm == 1) starts its threshold search for each layer
+ * from the threshold chosen for the previous frame.
+ * If max_cs_size was set in the compression parameters, then layer rates
+ * are capped so that each frame fits in max_cs_size bytes.
+ *
+ * @param	codec		compressor handle
+ * @param	frame		frame with the same dimensions, precision and
+ * 						number of components as the image passed to
+ * 						grk_init_compress. Component data is used as scratch
+ * 						space during compression; it is not freed.
+ * @param	stream		stream to write frame to, or nullptr to use
+ * 						the stream passed to grk_create_compress
+ *
+ * @return	true if the frame was compressed
+ */
+GRK_API bool GRK_CALLCONV grk_compress_frame(grk_codec codec, grk_image *frame,
+		grk_stream *stream);
+
+/**
+ * Compress one raw frame of a sequence of frames into a complete code stream.
+ * This method behaves like grk_compress_frame, except that samples are
+ * converted from the raw frame directly into tile buffers, tile by tile,
+ * without an intermediate image. The raw frame may be a memory mapped file.
+ *
+ * @param	codec		compressor handle
+ * @param	data		raw frame samples
+ * @param	data_len	length of raw frame in bytes: must equal
+ * 						the sum over components of w * h * sample size
+ * @param	layout		layout of raw frame
+ * @param	stream		stream to write frame to, or nullptr to use
+ * 						the stream passed to grk_create_compress
+ *
+ * @return	true if the frame was compressed
+ */
+GRK_API bool GRK_CALLCONV grk_compress_raw_frame(grk_codec codec,
+		const uint8_t *data, uint64_t data_len,
+		const grk_raw_frame_layout *layout, grk_stream *stream);
+
 
 /**
  Destroy Codestream information after compression or decompression
@@ -172,6 +172,7 @@ static inline long grok_lrintf(float f) {
 #include "SIZMarker.h"
 #include "PPMMarker.h"
 #include "SOTMarker.h"
+#include "CoderPool.h"
 #include "CodeStream.h"
 #include "markers.h"
 #include <Dump.h>
@@ -188,6 +189,7 @@ static inline long grok_lrintf(float f) {
 #include "dwt_utils.h"
 #include "dwt.h"
 #include "sparse_array.h"
+#include "PacketBuffer.h"
 #include "T2Encode.h"
 #include "T2Decode.h"
 #include "mct.h"
@@ -23,21 +23,34 @@ namespace grk {
 
 T1Decoder::T1Decoder(TileCodingParams *tcp,
 					uint16_t blockw,
-					uint16_t blockh) :
+					uint16_t blockh,
+					CoderPool *pool) :
+		isHT(tcp->isHT),
 		codeblock_width((uint16_t) (blockw ? (uint32_t) 1 << blockw : 0)),
 		codeblock_height((uint16_t) (blockh ? (uint32_t) 1 << blockh : 0)),
+		m_pool(pool),
 		success(true),
 		decodeBlocks(nullptr){
-	for (auto i = 0U; i < ThreadPool::get()->num_threads(); ++i) {
-		threadStructs.push_back(
-				T1Factory::get_t1(false, tcp, codeblock_width,
-						codeblock_height));
+	if (m_pool) {
+		m_pool->acquire_t1(false, tcp, codeblock_width, codeblock_height,
+				&threadStructs);
+	} else {
+		for (auto i = 0U; i < ThreadPool::get()->num_threads(); ++i) {
+			threadStructs.push_back(
+					T1Factory::get_t1(false, tcp, codeblock_width,
+							codeblock_height));
+		}
 	}
 }
 
 T1Decoder::~T1Decoder() {
-	for (auto &t : threadStructs) {
-		delete t;
+	if (m_pool) {
+		m_pool->release_t1(false, isHT, codeblock_width, codeblock_height,
+				&threadStructs);
+	} else {
+		for (auto &t : threadStructs) {
+			delete t;
+		}
 	}
 }
 
@@ -24,15 +24,20 @@ namespace grk {
 
 struct decodeBlockInfo;
 class T1Interface;
+class CoderPool;
 
 class T1Decoder {
 public:
-	T1Decoder(TileCodingParams *tcp, uint16_t blockw, uint16_t blockh);
+	T1Decoder(TileCodingParams *tcp, uint16_t blockw, uint16_t blockh,
+			CoderPool *pool);
 	~T1Decoder();
 	bool decompress(std::vector<decodeBlockInfo*> *blocks);
 
 private:
+	bool isHT;
 	uint16_t codeblock_width, codeblock_height;  //nominal dimensions of block
+	// coders are acquired from, and returned to, this pool
+	CoderPool *m_pool;
 	std::vector<T1Interface*> threadStructs;
 	std::atomic_bool success;
 
@@ -22,19 +22,33 @@
 namespace grk {
 
 T1Encoder::T1Encoder(TileCodingParams *tcp, grk_tile *tile, uint32_t encodeMaxCblkW,
-		uint32_t encodeMaxCblkH, bool needsRateControl) :
+		uint32_t encodeMaxCblkH, bool needsRateControl, CoderPool *pool) :
+		isHT(tcp->isHT),
 		tile(tile),
+		maxCblkW(encodeMaxCblkW),
+		maxCblkH(encodeMaxCblkH),
+		m_pool(pool),
 		needsRateControl(needsRateControl),
 		encodeBlocks(nullptr),
 		blockCount(-1)
 {
-	for (auto i = 0U; i < ThreadPool::get()->num_threads(); ++i)
-		threadStructs.push_back(
-				T1Factory::get_t1(true, tcp, encodeMaxCblkW, encodeMaxCblkH));
+	if (m_pool) {
+		m_pool->acquire_t1(true, tcp, encodeMaxCblkW, encodeMaxCblkH,
+				&threadStructs);
+	} else {
+		for (auto i = 0U; i < ThreadPool::get()->num_threads(); ++i)
+			threadStructs.push_back(
+					T1Factory::get_t1(true, tcp, encodeMaxCblkW, encodeMaxCblkH));
+	}
+	threadDistortion.resize(threadStructs.size());
 }
 T1Encoder::~T1Encoder() {
-	for (auto &t : threadStructs)
-		delete t;
+	if (m_pool) {
+		m_pool->release_t1(true, isHT, maxCblkW, maxCblkH, &threadStructs);
+	} else {
+		for (auto &t : threadStructs)
+			delete t;
+	}
 }
 void T1Encoder::compress(std::vector<encodeBlockInfo*> *blocks) {
 	if (!blocks || blocks->size() == 0)
@@ -43,19 +57,24 @@ void T1Encoder::compress(std::vector<encodeBlockInfo*> *blocks) {
 	size_t num_threads = ThreadPool::get()->num_threads();
 	if (num_threads == 1){
 		auto impl = threadStructs[0];
+		double dist = 0;
 		for (auto iter = blocks->begin(); iter != blocks->end(); ++iter){
-			compress(impl, *iter);
+			dist += compress(impl, *iter);
 			delete *iter;
 		}
+		if (needsRateControl)
+			tile->distotile += dist;
 		return;
 	}
 
 
 	auto maxBlocks = blocks->size();
+	blockCount = -1;
 	encodeBlocks = new encodeBlockInfo*[maxBlocks];
 	for (uint64_t i = 0; i < maxBlocks; ++i)
 		encodeBlocks[i] = blocks->operator[](i);
 	blocks->clear();
+	std::fill(threadDistortion.begin(), threadDistortion.end(), 0.0);
     std::vector< std::future<int> > results;
     for(size_t i = 0; i < num_threads; ++i) {
           results.emplace_back(
@@ -72,6 +91,10 @@ void T1Encoder::compress(std::vector<encodeBlockInfo*> *blocks) {
         result.get();
     }
 	delete[] encodeBlocks;
+	if (needsRateControl) {
+		for (auto &dist : threadDistortion)
+			tile->distotile += dist;
+	}
 }
 bool T1Encoder::compress(size_t threadId, uint64_t maxBlocks) {
 	auto impl = threadStructs[threadId];
@@ -79,19 +102,16 @@ bool T1Encoder::compress(size_t threadId, uint64_t maxBlocks) {
 	if (index >= maxBlocks)
 		return false;
 	encodeBlockInfo *block = encodeBlocks[index];
-	compress(impl,block);
+	threadDistortion[threadId] += compress(impl,block);
 	delete block;
 
 	return true;
 }
-void T1Encoder::compress(T1Interface *impl, encodeBlockInfo *block){
+double T1Encoder::compress(T1Interface *impl, encodeBlockInfo *block){
 	uint32_t max = 0;
 	impl->preEncode(block, tile, max);
-	auto dist = impl->compress(block, tile, max, needsRateControl);
-	if (needsRateControl) {
-		std::unique_lock<std::mutex> lk(distortion_mutex);
-		tile->distotile += dist;
-	}
+
+	return impl->compress(block, tile, max, needsRateControl);
 }
 
 }
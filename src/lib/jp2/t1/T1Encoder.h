@@ -24,17 +24,23 @@ namespace grk {
 class T1Encoder {
 public:
 	T1Encoder(TileCodingParams *tcp, grk_tile *tile, uint32_t encodeMaxCblkW,
-			uint32_t encodeMaxCblkH, bool needsRateControl);
+			uint32_t encodeMaxCblkH, bool needsRateControl, CoderPool *pool);
 	~T1Encoder();
 	void compress(std::vector<encodeBlockInfo*> *blocks);
 
 private:
 	bool compress(size_t threadId, uint64_t maxBlocks);
-	void compress(T1Interface *impl, encodeBlockInfo *block);
+	double compress(T1Interface *impl, encodeBlockInfo *block);
 
+	bool isHT;
 	grk_tile *tile;
+	uint32_t maxCblkW;
+	uint32_t maxCblkH;
+	// coders are acquired from, and returned to, this pool
+	CoderPool *m_pool;
 	std::vector<T1Interface*> threadStructs;
-	mutable std::mutex distortion_mutex;
+	// per-thread distortion, summed into tile once all blocks are compressed
+	std::vector<double> threadDistortion;
 	bool needsRateControl;
 	mutable std::mutex block_mutex;
 	encodeBlockInfo** encodeBlocks;
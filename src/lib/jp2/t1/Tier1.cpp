@@ -21,6 +21,13 @@
 
 namespace grk {
 
+Tier1::Tier1(CoderPool *pool) : m_pool(pool), encoder(nullptr){
+}
+
+Tier1::~Tier1(){
+	delete encoder;
+}
+
 void Tier1::encodeCodeblocks(TileCodingParams *tcp,
 							grk_tile *tile,
 							const double *mct_norms,
@@ -66,7 +73,8 @@ void Tier1::encodeCodeblocks(TileCodingParams *tcp,
 						block->stepsize = band->stepsize;
 						block->mct_norms = mct_norms;
 						block->mct_numcomps = mct_numcomps;
-						block->k_msbs = (uint8_t)(band->numbps - cblk->numbps);
+						// nothing has been coded yet: all bit planes are missing
+						block->k_msbs = (uint8_t)band->numbps;
 						blocks.push_back(block);
 
 					}
@@ -74,8 +82,9 @@ void Tier1::encodeCodeblocks(TileCodingParams *tcp,
 			}
 		}
 	}
-	T1Encoder encoder(tcp, tile, maxCblkW, maxCblkH, doRateControl);
-	encoder.compress(&blocks);
+	if (!encoder)
+		encoder = new T1Encoder(tcp, tile, maxCblkW, maxCblkH, doRateControl, m_pool);
+	encoder->compress(&blocks);
 }
 
 bool Tier1::prepareDecodeCodeblocks(TileComponent *tilec, TileComponentCodingParams *tccp,
@@ -139,7 +148,7 @@ bool Tier1::prepareDecodeCodeblocks(TileComponent *tilec, TileComponentCodingPar
 bool Tier1::decodeCodeblocks(TileCodingParams *tcp,
 		                    uint16_t blockw, uint16_t blockh,
 		                    std::vector<decodeBlockInfo*> *blocks) {
-	T1Decoder decoder(tcp, blockw, blockh);
+	T1Decoder decoder(tcp, blockw, blockh, m_pool);
 	return decoder.decompress(blocks);
 }
 
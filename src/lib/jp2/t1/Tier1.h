@@ -23,8 +23,16 @@
 
 namespace grk {
 
+class T1Encoder;
+class CoderPool;
+
 class Tier1 {
 public:
+	/**
+	 * @param pool	pool of T1 coders (may be null)
+	 */
+	explicit Tier1(CoderPool *pool);
+	~Tier1();
 
 	void encodeCodeblocks(	TileCodingParams *tcp,
 							grk_tile *tile,
@@ -39,6 +47,10 @@ public:
 							uint16_t blockh,
 							std::vector<decodeBlockInfo*> *blocks);
 
+private:
+	CoderPool *m_pool;
+	// encoder is kept so that its T1 coders can be reused by the next frame
+	T1Encoder *encoder;
 };
 
 }
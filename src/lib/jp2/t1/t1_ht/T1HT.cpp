@@ -29,8 +29,6 @@ using namespace ojph::local;
 #include <algorithm>
 using namespace std;
 
-const uint8_t grk_cblk_dec_compressed_data_pad_left_ht = 8;
-
 
 namespace grk {
 namespace t1_ht {
@@ -44,11 +42,12 @@ T1HT::T1HT(bool isEncoder,
 				unencoded_data_size(maxCblkW*maxCblkH),
 				unencoded_data(new int32_t[unencoded_data_size]),
 				allocator( new mem_fixed_allocator),
-				elastic_alloc(new mem_elastic_allocator(1048576))
+				elastic_alloc(new mem_elastic_allocator(1048576)),
+				decode_codeblock(ojph_get_decode_codeblock())
 {
 	(void) tcp;
 	if (!isEncoder)
-		memset(coded_data,0,grk_cblk_dec_compressed_data_pad_left_ht);
+		memset(coded_data,0,grk_cblk_dec_compressed_data_pad_ht);
 }
 T1HT::~T1HT() {
    delete[] coded_data;
@@ -106,20 +105,18 @@ void T1HT::preEncode(encodeBlockInfo *block, grk_tile *tile,
 }
 double T1HT::compress(encodeBlockInfo *block, grk_tile *tile, uint32_t maximum,
 		bool doRateControl) {
-	(void)doRateControl;
-	(void)tile;
 	(void)maximum;
 
 	 coded_lists *next_coded = nullptr;
 	int pass_length[2] = {0,0};
 	auto cblk = block->cblk;
 	cblk->numbps = 0;
-	// optimization below was causing errors in encoding
-	//if (maximum >= (uint32_t)1<<(31 - (block->k_msbs+1)))
-	{
 	uint16_t w =  (uint16_t)(cblk->x1 - cblk->x0);
 	uint16_t h =  (uint16_t)(cblk->y1 - cblk->y0);
 
+	// coded data of the previous block has been copied to its code block
+	elastic_alloc->restart();
+	if (!doRateControl) {
 	 ojph_encode_codeblock(unencoded_data, block->k_msbs,1,
 							   w, h, w,
 							   pass_length,
@@ -130,31 +127,138 @@ double T1HT::compress(encodeBlockInfo *block, grk_tile *tile, uint32_t maximum,
 	 assert(pass_length[0] >= 0);
 	 cblk->passes[0].len = (uint16_t)pass_length[0];
 	 cblk->passes[0].rate = (uint16_t)pass_length[0];
+	 cblk->passes[0].skippedBitPlanes = 0;
 	 cblk->numbps = 1;
 	 assert(cblk->paddedCompressedData);
 	 memcpy(cblk->paddedCompressedData, next_coded->buf, (size_t)pass_length[0]);
+
+	 return 0;
+	}
+
+	// Truncation points: the cleanup pass is coded once for each number s
+	// of skipped least significant bit planes, from the coarsest to s = 0,
+	// and the candidates are stored one after the other in the code block
+	// buffer. Only one of them is kept when layers are formed, and its
+	// number of skipped bit planes is signalled through the zero bit plane
+	// count. A pass's rate is the length of its candidate.
+	uint32_t area = (uint32_t)w * h;
+	int32_t p = 30 - block->k_msbs;
+	uint32_t max_mag = 0;
+	for (uint32_t i = 0; i < area; ++i)
+		max_mag = max(max_mag, ((uint32_t)unencoded_data[i] & 0x7FFFFFFF) >> p);
+	uint32_t max_skip = max_mag ? floorlog2<uint32_t>(max_mag) : 0;
+	if (block->k_msbs)
+		max_skip = min<uint32_t>(max_skip, block->k_msbs - 1U);
+	else
+		max_skip = 0;
+	uint32_t num_candidates = max_skip + 1;
+
+	// Distortion decrease of each candidate, in squared quantization steps.
+	// Irreversible samples keep their fraction below bit plane p, and the
+	// decoder reconstructs significant samples at the centre of their bin,
+	// except for reversible samples coded down to the last bit plane.
+	double candidate_dd[32];
+	memset(candidate_dd, 0, sizeof(candidate_dd));
+	double inv_scale = 1.0 / (double)(1U << p);
+	double finest_offset = block->qmfbid == 1 ? 0 : 0.5;
+	for (uint32_t i = 0; i < area; ++i) {
+		uint32_t val = (uint32_t)unencoded_data[i] & 0x7FFFFFFF;
+		uint32_t mag = val >> p;
+		if (!mag)
+			continue;
+		double x = (double)val * inv_scale;
+		for (uint32_t s = 0; s < num_candidates; ++s) {
+			uint32_t q = mag >> s;
+			if (!q)
+				break;
+			double rec = (double)(q << s)
+					+ (s ? (double)(1U << (s - 1)) : finest_offset);
+			candidate_dd[s] += x * x - (x - rec) * (x - rec);
+		}
+	}
+	double w1 = 1;
+	if (block->mct_norms && block->compno < block->mct_numcomps)
+		w1 = block->mct_norms[block->compno];
+	uint32_t level = (tile->comps + block->compno)->numresolutions - 1
+			- block->resno;
+	double w2 = block->qmfbid == 1 ?
+			dwt_utils::getnorm_53(level, block->bandno) :
+			dwt_utils::getnorm_97(level, block->bandno);
+	double weight = w1 * w2 * block->stepsize;
+	weight *= weight;
+
+	coded_lists *candidates[32];
+	uint32_t num_passes = 0;
+	for (uint32_t n = 0; n < num_candidates; ++n) {
+		uint32_t s = num_candidates - 1 - n;
+		coded_lists *coded = nullptr;
+		ojph_encode_codeblock(unencoded_data, (int)(block->k_msbs - s), 1,
+							   w, h, w,
+							   pass_length,
+							   elastic_alloc,
+							   coded);
+		assert(pass_length[0] >= 0);
+		uint32_t len = (uint32_t)pass_length[0];
+		// a coarser candidate that is not shorter is never worth sending
+		while (num_passes && cblk->passes[num_passes - 1].rate >= len)
+			num_passes--;
+		auto pass = cblk->passes + num_passes;
+		pass->rate = len;
+		pass->distortiondec = weight * candidate_dd[s];
+		pass->term = 1;
+		pass->skippedBitPlanes = (uint8_t)s;
+		candidates[num_passes++] = coded;
+	}
+	// convex hull and slope calculations work with rate increments
+	uint32_t total_len = 0;
+	for (uint32_t n = 0; n < num_passes; ++n) {
+		auto pass = cblk->passes + n;
+		pass->len = n ? pass->rate - (pass - 1)->rate : pass->rate;
+		total_len += pass->rate;
 	}
+	if (total_len > cblk->compressedDataSize)
+		cblk->alloc_data((total_len + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+	assert(cblk->paddedCompressedData);
+	uint32_t offset = 0;
+	for (uint32_t n = 0; n < num_passes; ++n) {
+		memcpy(cblk->paddedCompressedData + offset, candidates[n]->buf,
+				cblk->passes[n].rate);
+		offset += cblk->passes[n].rate;
+	}
+	cblk->numPassesTotal = num_passes;
+	cblk->numbps = 1;
 
-  return 0;
+	return cblk->passes[num_passes - 1].distortiondec;
 }
 bool T1HT::decompress(decodeBlockInfo *block) {
 	auto cblk = block->cblk;
-	if (cblk->seg_buffers.empty())
+	if (cblk->seg_buffers.empty()) {
+		// block not included in any layer: postDecode writes zeros
+		memset(unencoded_data, 0,
+				(cblk->x1 - cblk->x0) * (cblk->y1 - cblk->y0) * sizeof(int32_t));
 		return true;
-
-	size_t total_seg_len = grk_cblk_dec_compressed_data_pad_left_ht + cblk->getSegBuffersLen();
-	if (coded_data_size < total_seg_len) {
-		delete[] coded_data;
-		coded_data = new uint8_t[total_seg_len];
-		coded_data_size = (uint32_t)total_seg_len;
-		memset(coded_data,0,grk_cblk_dec_compressed_data_pad_left_ht);
 	}
-	uint8_t *actual_coded_data =
-			coded_data + grk_cblk_dec_compressed_data_pad_left_ht;
+
+	uint8_t *actual_coded_data = nullptr;
 	size_t offset = 0;
-	for (auto& b : cblk->seg_buffers) {
-		memcpy(actual_coded_data + offset, b->buf, b->len);
-		offset += b->len;
+	if (cblk->seg_buffer_padded) {
+		// decode in place: the block decoder only reads its coded data
+		actual_coded_data = cblk->seg_buffers[0]->buf;
+		offset = cblk->seg_buffers[0]->len;
+	} else {
+		size_t total_seg_len = 2 * grk_cblk_dec_compressed_data_pad_ht
+				+ cblk->getSegBuffersLen();
+		if (coded_data_size < total_seg_len) {
+			delete[] coded_data;
+			coded_data = new uint8_t[total_seg_len];
+			coded_data_size = (uint32_t)total_seg_len;
+			memset(coded_data, 0, grk_cblk_dec_compressed_data_pad_ht);
+		}
+		actual_coded_data = coded_data + grk_cblk_dec_compressed_data_pad_ht;
+		for (auto& b : cblk->seg_buffers) {
+			memcpy(actual_coded_data + offset, b->buf, b->len);
+			offset += b->len;
+		}
 	}
 
 	size_t num_passes = 0;
@@ -164,7 +268,7 @@ bool T1HT::decompress(decodeBlockInfo *block) {
 	}
 
    if (num_passes)
-	   ojph_decode_codeblock(actual_coded_data,
+	   decode_codeblock(actual_coded_data,
 							   unencoded_data,
 							   block->k_msbs,
 							   (int)num_passes,
@@ -215,7 +319,9 @@ void T1HT::postDecode(decodeBlockInfo *block) {
 	}
 
 	if (block->qmfbid == 1) {
-		int32_t shift = 31 - (block->k_msbs + 1);
+		// k_msbs + numbps is the band's bit plane count, whatever number of
+		// least significant bit planes the encoder chose to skip
+		int32_t shift = 31 - (block->k_msbs + (int32_t)cblk->numbps);
 		int32_t *GRK_RESTRICT tile_data = dest;
 		for (auto j = 0U; j < cblk_h; ++j) {
 			int32_t *GRK_RESTRICT tile_row_data = tile_data;
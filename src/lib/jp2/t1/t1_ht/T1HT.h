@@ -51,6 +51,7 @@ private:
 
     mem_fixed_allocator *allocator;
     mem_elastic_allocator *elastic_alloc;
+    decode_codeblock_fn decode_codeblock;
 };
 }
 }
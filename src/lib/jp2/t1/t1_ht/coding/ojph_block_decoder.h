@@ -51,6 +51,29 @@ namespace ojph {
       ojph_decode_codeblock(ui8* coded_data, si32* decoded_data,
         int missing_msbs, int num_passes, int lengths1, int lengths2,
         int width, int height, int stride);
+
+    //////////////////////////////////////////////////////////////////////////
+    //same as ojph_decode_codeblock, with MagSgn and MagRef decoding
+    // vectorized for SSSE3 and AVX2 respectively; when the library is
+    // built for a platform without these instruction sets, they fall
+    // back to ojph_decode_codeblock
+    void
+      ojph_decode_codeblock_ssse3(ui8* coded_data, si32* decoded_data,
+        int missing_msbs, int num_passes, int lengths1, int lengths2,
+        int width, int height, int stride);
+    void
+      ojph_decode_codeblock_avx2(ui8* coded_data, si32* decoded_data,
+        int missing_msbs, int num_passes, int lengths1, int lengths2,
+        int width, int height, int stride);
+
+    //////////////////////////////////////////////////////////////////////////
+    typedef void (*decode_codeblock_fn)(ui8* coded_data, si32* decoded_data,
+        int missing_msbs, int num_passes, int lengths1, int lengths2,
+        int width, int height, int stride);
+
+    //////////////////////////////////////////////////////////////////////////
+    //returns the fastest block decoder supported by the CPU
+    decode_codeblock_fn ojph_get_decode_codeblock();
   }
 }
 
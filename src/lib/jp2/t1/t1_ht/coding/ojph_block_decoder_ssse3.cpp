@@ -0,0 +1,261 @@
+//***************************************************************************/
+// This software is released under the 2-Clause BSD license, included
+// below.
+//
+// Copyright (c) 2019, Aous Naman 
+// Copyright (c) 2019, Kakadu Software Pty Ltd, Australia
+// Copyright (c) 2019, The University of New South Wales, Australia
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// 
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//***************************************************************************/
+// This file is part of the OpenJPH software implementation.
+// File: ojph_block_decoder_ssse3.cpp
+//***************************************************************************/
+
+#include "ojph_block_decoder_impl.h"
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace ojph {
+  namespace local {
+
+#if defined(__SSSE3__)
+
+  namespace {
+
+    /////////////////////////////////////////////////////////////////////////
+    // expands the low bits of src to the positions of the bits set in
+    // mask, in the order of increasing position
+    static inline ui32 expand_bits(ui32 src, ui32 mask)
+    {
+      ui32 dst = 0;
+      while (mask)
+      {
+        ui32 lowest = mask & (0 - mask);
+        dst |= (src & 1) ? lowest : 0;
+        src >>= 1;
+        mask ^= lowest;
+      }
+      return dst;
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // SSSE3 MagSgn and MagRef decoding
+    /////////////////////////////////////////////////////////////////////////
+    struct quad_decoder_ssse3 {
+
+      ///////////////////////////////////////////////////////////////////////
+      // same as quad_decoder_scalar::decode_quad; the bits of all four
+      // samples are taken from the MagSgn bit buffer at once, provided
+      // that they are all in the buffer, they are fewer than 64 bits
+      // (frwd_advance cannot shift by 64), and no sample is longer than
+      // 24 bits
+      static inline
+      void decode_quad(frwd_struct *magsgn, ui32 qinf, int U_q, int p,
+                       si32 *sp, int stride, int locs, ui32 *v_n)
+      {
+        locs &= 0xF;
+        if ((qinf & 0xF0) == 0)
+        {
+          if (locs == 0xF)
+          {
+            sp[0] = sp[1] = 0;
+            sp[stride] = sp[stride + 1] = 0;
+          }
+          else
+            quad_decoder_scalar::decode_quad(magsgn, qinf, U_q, p, sp,
+                                             stride, locs, v_n);
+          return;
+        }
+        if (magsgn->bits <= 32)
+          frwd_read<0xFF>(magsgn);
+
+        const __m128i one = _mm_set1_epi32(1);
+        __m128i q = _mm_set1_epi32((int)qinf);
+
+        // lanes hold all ones for significant samples, with e_k set, and
+        // with e_1 set
+        __m128i sig_bits = _mm_set_epi32(0x80, 0x40, 0x20, 0x10);
+        __m128i sig = _mm_cmpeq_epi32(_mm_and_si128(q, sig_bits), sig_bits);
+        __m128i ek_bits = _mm_slli_epi32(sig_bits, 8);
+        __m128i ek = _mm_cmpeq_epi32(_mm_and_si128(q, ek_bits), ek_bits);
+        __m128i e1_bits = _mm_slli_epi32(sig_bits, 4);
+        __m128i e1 = _mm_cmpeq_epi32(_mm_and_si128(q, e1_bits), e1_bits);
+
+        // m_n, and bit offset of each sample in the MagSgn buffer
+        __m128i m_n = _mm_and_si128(_mm_add_epi32(_mm_set1_epi32(U_q), ek),
+                                    sig);
+        __m128i inc_sum = _mm_add_epi32(m_n, _mm_slli_si128(m_n, 4));
+        inc_sum = _mm_add_epi32(inc_sum, _mm_slli_si128(inc_sum, 8));
+        int total_mn = _mm_cvtsi128_si32(_mm_shuffle_epi32(inc_sum, 0xFF));
+        __m128i too_long = _mm_cmpgt_epi32(m_n, _mm_set1_epi32(24));
+        if (total_mn > magsgn->bits || total_mn >= 64 ||
+            _mm_movemask_epi8(too_long))
+        {
+          quad_decoder_scalar::decode_quad(magsgn, qinf, U_q, p, sp,
+                                           stride, locs, v_n);
+          return;
+        }
+        __m128i ex_sum = _mm_slli_si128(inc_sum, 4);
+
+        // gather four bytes starting at the byte holding the first bit
+        // of each sample
+        __m128i buf = _mm_loadl_epi64((__m128i*)&magsgn->tmp);
+        __m128i byte_idx = _mm_srli_epi32(ex_sum, 3);
+        byte_idx = _mm_shuffle_epi8(byte_idx,
+          _mm_set_epi32(0x0C0C0C0C, 0x08080808, 0x04040404, 0x00000000));
+        byte_idx = _mm_add_epi32(byte_idx, _mm_set1_epi32(0x03020100));
+        __m128i ms_vec = _mm_shuffle_epi8(buf, byte_idx);
+
+        // shift each lane right by the remaining bit offset, by
+        // multiplying with 2^(7 - offset) and shifting right by 7
+        __m128i bit_idx = _mm_and_si128(ex_sum, _mm_set1_epi32(7));
+        bit_idx = _mm_or_si128(bit_idx, _mm_set1_epi32((int)0x80808000));
+        __m128i mul = _mm_shuffle_epi8(
+          _mm_set_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 4, 8, 16, 32, 64, -128),
+          bit_idx);
+        __m128i even = _mm_mul_epu32(ms_vec, mul);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(ms_vec, 32),
+                                    _mm_srli_epi64(mul, 32));
+        even = _mm_and_si128(_mm_srli_epi64(even, 7),
+                             _mm_set_epi32(0, -1, 0, -1));
+        odd = _mm_slli_epi64(_mm_srli_epi64(odd, 7), 32);
+        ms_vec = _mm_or_si128(even, odd);
+
+        // 2^m_n, from the exponent of a float
+        __m128i two_mn = _mm_slli_epi32(
+          _mm_add_epi32(m_n, _mm_set1_epi32(127)), 23);
+        two_mn = _mm_cvttps_epi32(_mm_castsi128_ps(two_mn));
+
+        __m128i vn = _mm_and_si128(ms_vec, _mm_sub_epi32(two_mn, one));
+        vn = _mm_or_si128(vn, _mm_and_si128(e1, two_mn));
+        vn = _mm_or_si128(vn, one); //center of bin
+        __m128i val = _mm_add_epi32(vn, _mm_set1_epi32(2));
+        val = _mm_sll_epi32(val, _mm_cvtsi32_si128(p - 1));
+        val = _mm_or_si128(val, _mm_slli_epi32(ms_vec, 31));
+        val = _mm_and_si128(val, sig);
+        frwd_advance(magsgn, total_mn);
+
+        // lanes 1 and 3 hold the bottom samples; v_n is zero for
+        // insignificant samples
+        __m128i bottom = _mm_shuffle_epi32(_mm_and_si128(vn, sig),
+                                           _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storel_epi64((__m128i*)v_n, bottom);
+        // rows of quad: samples 0, 2 and 1, 3
+        val = _mm_shuffle_epi32(val, _MM_SHUFFLE(3, 1, 2, 0));
+        if (locs == 0xF)
+        {
+          _mm_storel_epi64((__m128i*)sp, val);
+          _mm_storel_epi64((__m128i*)(sp + stride), _mm_srli_si128(val, 8));
+        }
+        else
+        {
+          ui32 sig_mask = (qinf >> 4) | (ui32)locs;
+          si32 s[4];
+          _mm_storeu_si128((__m128i*)s, val);
+          if (sig_mask & 1) sp[0] = s[0];
+          if (sig_mask & 4) sp[1] = s[1];
+          if (sig_mask & 2) sp[stride] = s[2];
+          if (sig_mask & 8) sp[stride + 1] = s[3];
+        }
+      }
+
+      ///////////////////////////////////////////////////////////////////////
+      // magnitude refinement pass for one stripe; the refinement bit of
+      // each significant sample is first moved to the sample's position
+      // in sig, then four columns of a row are refined at once
+      static inline
+      void decode_magref(rev_struct *magref, ui32 *cur_sig, si32 *dpp,
+                         int width, int stride, int p)
+      {
+        const __m128i flip = _mm_set1_epi32(1 << (p - 1));
+        const __m128i half = _mm_set1_epi32(1 << (p - 2));
+        const __m128i col_bits = _mm_set_epi32(1 << 12, 1 << 8, 1 << 4, 1);
+        for (int i = 0; i < width; i += 8)
+        {
+          ui32 cwd = rev_fetch_mrp(magref);
+          ui32 sig = *cur_sig++;
+          if (sig)
+          {
+            if (i + 8 <= width)
+            {
+              ui32 sym = expand_bits(cwd, sig);
+              for (int r = 0; r < 4; ++r)
+              {
+                if ((sig & (0x11111111u << r)) == 0)
+                  continue;
+                si32 *dp = dpp + i + r * stride;
+                for (int n = 0; n < 8; n += 4)
+                {
+                  __m128i bits = _mm_slli_epi32(col_bits, 4 * n + r);
+                  __m128i s = _mm_and_si128(_mm_set1_epi32((int)sig), bits);
+                  s = _mm_cmpeq_epi32(s, bits);
+                  __m128i y = _mm_and_si128(_mm_set1_epi32((int)sym), bits);
+                  y = _mm_cmpeq_epi32(y, bits);
+                  __m128i d = _mm_loadu_si128((__m128i*)(dp + n));
+                  d = _mm_xor_si128(d, _mm_and_si128(_mm_andnot_si128(y, s),
+                                                     flip));
+                  d = _mm_or_si128(d, _mm_and_si128(s, half));
+                  _mm_storeu_si128((__m128i*)(dp + n), d);
+                }
+              }
+            }
+            else
+              quad_decoder_scalar::decode_magref_columns(cwd, sig, dpp + i,
+                                                         stride, p);
+          }
+          rev_advance_mrp(magref, population_count(sig));
+        }
+      }
+    };
+  }
+
+    /////////////////////////////////////////////////////////////////////////
+    void ojph_decode_codeblock_ssse3(ui8* coded_data, si32* decoded_data,
+                                     int missing_msbs, int num_passes,
+                                     int lengths1, int lengths2,
+                                     int width, int height, int stride)
+    {
+      decode_codeblock<quad_decoder_ssse3>(coded_data, decoded_data,
+        missing_msbs, num_passes, lengths1, lengths2, width, height, stride);
+    }
+
+#else
+
+    /////////////////////////////////////////////////////////////////////////
+    void ojph_decode_codeblock_ssse3(ui8* coded_data, si32* decoded_data,
+                                     int missing_msbs, int num_passes,
+                                     int lengths1, int lengths2,
+                                     int width, int height, int stride)
+    {
+      ojph_decode_codeblock(coded_data, decoded_data, missing_msbs,
+        num_passes, lengths1, lengths2, width, height, stride);
+    }
+
+#endif
+
+  }
+}
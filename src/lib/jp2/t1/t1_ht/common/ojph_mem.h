@@ -196,16 +196,26 @@ namespace ojph {
 
     void get_buffer(int needed_bytes, coded_lists*& p);
 
+    // makes all memory available again, invalidating buffers obtained
+    // from get_buffer; allocated chunks are kept for reuse
+    void restart();
+
   private:
     struct stores_list
     {
       stores_list(int chunk_size)
       {
         this->next_store = NULL;
-        this->available = chunk_size - (int)sizeof(stores_list);
+        this->size = chunk_size;
+        restart();
+      }
+      void restart()
+      {
+        this->available = size - (int)sizeof(stores_list);
         this->data = (char*)this + sizeof(stores_list);
       }
       stores_list *next_store;
+      int size;
       int available;
       char* data;
     };
@@ -104,12 +104,16 @@ namespace ojph {
       total_allocated += bytes;
     }
 
-    if (cur_store->available < extended_bytes)
+    while (cur_store->available < extended_bytes)
     {
-      int bytes = ojph_max(extended_bytes, chunk_size);
-      cur_store->next_store = (stores_list*)malloc(bytes);
-      cur_store = new (cur_store->next_store) stores_list(bytes);
-      total_allocated += bytes;
+      if (cur_store->next_store == NULL)
+      {
+        int bytes = ojph_max(extended_bytes, chunk_size);
+        cur_store->next_store = (stores_list*)malloc(bytes);
+        new (cur_store->next_store) stores_list(bytes);
+        total_allocated += bytes;
+      }
+      cur_store = cur_store->next_store;
     }
 
     p = new (cur_store->data) coded_lists(needed_bytes);
@@ -118,4 +122,12 @@ namespace ojph {
     cur_store->data += extended_bytes;
   }
 
+  ////////////////////////////////////////////////////////////////////////////
+  void mem_elastic_allocator::restart()
+  {
+    for (stores_list* s = store; s; s = s->next_store)
+      s->restart();
+    cur_store = store;
+  }
+
 }
@@ -150,6 +150,8 @@ bool T1Part1::decompress(decodeBlockInfo *block) {
 		t1->cblkdatabuffer = new_block;
 		t1->cblkdatabuffersize = (uint32_t)total_seg_len;
 	}
+	// MQ decoder writes a marker after the coded data,
+	// so it can't decode from the shared packet data
 	size_t offset = 0;
 	for (auto& b : cblk->seg_buffers) {
 		memcpy(t1->cblkdatabuffer + offset, b->buf, b->len);
@@ -169,16 +171,16 @@ bool T1Part1::decompress(decodeBlockInfo *block) {
 	assert(cblk->width() > 0);
 	assert(cblk->height() > 0);
 	cblkexp.real_num_segs = cblk->numSegments;
-	auto segs = new seg[cblk->numSegments];
+	if (segs.size() < cblk->numSegments)
+		segs.resize(cblk->numSegments);
 	for (uint32_t i = 0; i < cblk->numSegments; ++i){
-		auto segp = segs + i;
-		memset(segp, 0, sizeof(seg));
+		auto segp = segs.data() + i;
 		auto sgrk = cblk->segs + i;
 		segp->len = sgrk->len;
 		assert(segp->len <= total_seg_len);
 		segp->real_num_passes = sgrk->numpasses;
 	}
-	cblkexp.segs = segs;
+	cblkexp.segs = segs.data();
 	// subtract roishift as it was added when packet was parsed
 	// and exp uses subtracted value
 	cblkexp.numbps = cblk->numbps - block->roishift;
@@ -189,7 +191,6 @@ bool T1Part1::decompress(decodeBlockInfo *block) {
 					block->roishift,
 					block->cblk_sty);
 
-	delete[] segs;
 	return ret;
 }
 
@@ -44,6 +44,8 @@ public:
 
 private:
 	t1_info *t1;
+	// decoder segments, reused from one code block to the next
+	std::vector<seg> segs;
 
 	void post_decode(t1_info *t1, cblk_dec *cblk,decodeBlockInfo *block);
 };
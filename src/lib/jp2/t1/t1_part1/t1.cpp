@@ -50,11 +50,11 @@ static INLINE void 		t1_dec_sigpass_step_raw(t1_info *t1, grk_flag *flagsp,
 static INLINE void 		t1_dec_sigpass_step_mqc(t1_info *t1, grk_flag *flagsp,
 												int32_t *datap, int32_t oneplushalf, uint32_t ci,
 												uint32_t flags_stride, uint32_t vsc);
-static void 			t1_enc_sigpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,
-										uint8_t type, uint32_t cblksty);
+template<bool doDistortion> void t1_enc_sigpass(t1_info *t1, int32_t bpno,
+										int32_t *nmsedec, uint8_t type, uint32_t cblksty);
 static void 			t1_dec_sigpass_raw(t1_info *t1, int32_t bpno, int32_t cblksty);
-static void 			t1_enc_refpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,
-										uint8_t type);
+template<bool doDistortion> void t1_enc_refpass(t1_info *t1, int32_t bpno,
+										int32_t *nmsedec, uint8_t type);
 static void 			t1_dec_refpass_raw(t1_info *t1, int32_t bpno);
 static INLINE void 		t1_dec_refpass_step_raw(t1_info *t1, grk_flag *flagsp,
 												int32_t *datap, int32_t poshalf, uint32_t ci);
@@ -62,8 +62,13 @@ static INLINE void 		t1_dec_refpass_step_mqc(t1_info *t1, grk_flag *flagsp,
 												int32_t *datap, int32_t poshalf, uint32_t ci);
 static void 			t1_dec_clnpass_step(t1_info *t1, grk_flag *flagsp, int32_t *datap,
 											int32_t oneplushalf, uint32_t ciorig, uint32_t ci, uint32_t vsc);
-static void 			t1_enc_clnpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,
-										uint32_t cblksty);
+template<bool doDistortion> void t1_enc_clnpass(t1_info *t1, int32_t bpno,
+										int32_t *nmsedec, uint32_t cblksty);
+template<bool doDistortion> double t1_encode_cblk(t1_info *t1, cblk_enc *cblk,
+										uint32_t max, uint8_t orient, uint32_t compno,
+										uint32_t level, uint32_t qmfbid, double stepsize,
+										uint32_t cblksty, const double *mct_norms,
+										uint32_t mct_numcomps);
 static bool 			t1_code_block_enc_allocate(cblk_enc *p_code_block);
 static double 			t1_getwmsedec(int32_t nmsedec, uint32_t compno, uint32_t level,
 										uint8_t orient, int32_t bpno,
@@ -345,7 +350,7 @@ static int t1_enc_is_term_pass(cblk_enc *cblk, uint32_t cblksty,
 			uint32_t lu = t1_getctxtno_sc_or_spb_index(*flagsp, flagsp[-1],	flagsp[1], ci); \
 			uint32_t ctxt2 = t1_getctxno_sc(lu); \
 			v = smr_sign(*datap); \
-			if (nmsedec) \
+			if (doDistortion) \
 				*nmsedec += t1_getnmsedec_sig((uint32_t) smr_abs(*datap),(uint32_t) bpno); \
 			curctx = mqc->ctxs + ctxt2; \
 			if (type == T1_TYPE_RAW) { \
@@ -360,8 +365,8 @@ static int t1_enc_is_term_pass(cblk_enc *cblk, uint32_t cblksty,
 	} \
 }
 
-static void t1_enc_sigpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,
-							uint8_t type, uint32_t cblksty) {
+template<bool doDistortion> void t1_enc_sigpass(t1_info *t1, int32_t bpno,
+							int32_t *nmsedec, uint8_t type, uint32_t cblksty) {
 	uint32_t i, k;
 	int32_t const one = 1 << (bpno + T1_NMSEDEC_FRACBITS);
 	auto flagsp = &T1_FLAGS(0, 0);
@@ -369,7 +374,7 @@ static void t1_enc_sigpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,
 	DOWNLOAD_MQC_VARIABLES(mqc);
 	uint32_t w = t1->w;
 	uint32_t const extra = 2;
-	if (nmsedec)
+	if (doDistortion)
 		*nmsedec = 0;
 
 	for (k = 0; k < (t1->h & ~3U); k += 4) {
@@ -412,7 +417,7 @@ static void t1_enc_sigpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,
 	uint32_t const shift_flags = (*flagsp >> (ci));  \
 	if ((shift_flags & (T1_SIGMA_THIS | T1_PI_THIS)) == T1_SIGMA_THIS) { \
 		uint32_t ctxt = t1_getctxno_mag(shift_flags);  \
-		if (nmsedec) \
+		if (doDistortion) \
 			*nmsedec += t1_getnmsedec_ref((uint32_t) smr_abs(*datap), (uint32_t) bpno);  \
 		v = !!(smr_abs(*datap) & one);  \
 		curctx = mqc->ctxs + ctxt; \
@@ -426,15 +431,15 @@ static void t1_enc_sigpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,
 	} \
 }
 
-static void t1_enc_refpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,
-		uint8_t type) {
+template<bool doDistortion> void t1_enc_refpass(t1_info *t1, int32_t bpno,
+		int32_t *nmsedec, uint8_t type) {
 	uint32_t i, k;
 	const int32_t one = 1 << (bpno + T1_NMSEDEC_FRACBITS);
 	auto flagsp = &T1_FLAGS(0, 0);
 	auto mqc = &(t1->mqc);
 	DOWNLOAD_MQC_VARIABLES(mqc);
 	const uint32_t extra = 2U;
-	if (nmsedec)
+	if (doDistortion)
 		*nmsedec = 0;
 	for (k = 0; k < (t1->h & ~3U); k += 4) {
 		for (i = 0; i < t1->w; ++i) {
@@ -472,12 +477,13 @@ static void t1_enc_refpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,
 	UPLOAD_MQC_VARIABLES(mqc,curctx);
 }
 
-static void t1_enc_clnpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,	uint32_t cblksty) {
+template<bool doDistortion> void t1_enc_clnpass(t1_info *t1, int32_t bpno,
+		int32_t *nmsedec,	uint32_t cblksty) {
 	const int32_t one = 1 << (bpno + T1_NMSEDEC_FRACBITS);
 	auto mqc = &(t1->mqc);
 	DOWNLOAD_MQC_VARIABLES(mqc);
-	if (nmsedec)
-	  *nmsedec = 0;
+	if (doDistortion)
+		*nmsedec = 0;
 	grk_flag *f = &T1_FLAGS(0, 0);
 	uint32_t k;
 	for (k = 0; k < (t1->h & ~3U); k += 4, f+=2) {
@@ -537,7 +543,7 @@ static void t1_enc_clnpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,	uint32_t
 				if (goto_PARTIAL) {
 					uint32_t lu = t1_getctxtno_sc_or_spb_index(*f,
 							*(f-1), *(f+1), ci);
-					if (nmsedec)
+					if (doDistortion)
 						*nmsedec += t1_getnmsedec_sig((uint32_t) smr_abs(*datap),
 							(uint32_t) bpno);
 					uint32_t ctxt2 = t1_getctxno_sc(lu);
@@ -594,7 +600,7 @@ static void t1_enc_clnpass(t1_info *t1, int32_t bpno, int32_t *nmsedec,	uint32_t
 				if (goto_PARTIAL) {
 					uint32_t lu = t1_getctxtno_sc_or_spb_index(*f,
 							*(f-1), *(f+1), ci);
-					if (nmsedec)
+					if (doDistortion)
 						*nmsedec += t1_getnmsedec_sig((uint32_t) smr_abs(*datap),
 							(uint32_t) bpno);
 					uint32_t ctxt2 = t1_getctxno_sc(lu);
@@ -619,6 +625,20 @@ double t1_encode_cblk(t1_info *t1, cblk_enc *cblk, uint32_t max,
 					uint8_t orient, uint32_t compno, uint32_t level, uint32_t qmfbid,
 					double stepsize, uint32_t cblksty,
 					const double *mct_norms, uint32_t mct_numcomps, bool doRateControl) {
+	// without rate control, distortion is never consumed, so select
+	// the pass coders that skip the nmsedec LUT lookups altogether
+	if (doRateControl)
+		return t1_encode_cblk<true>(t1, cblk, max, orient, compno, level,
+				qmfbid, stepsize, cblksty, mct_norms, mct_numcomps);
+
+	return t1_encode_cblk<false>(t1, cblk, max, orient, compno, level,
+			qmfbid, stepsize, cblksty, mct_norms, mct_numcomps);
+}
+
+template<bool doDistortion> double t1_encode_cblk(t1_info *t1, cblk_enc *cblk,
+					uint32_t max, uint8_t orient, uint32_t compno, uint32_t level,
+					uint32_t qmfbid, double stepsize, uint32_t cblksty,
+					const double *mct_norms, uint32_t mct_numcomps) {
 	if (!t1_code_block_enc_allocate(cblk))
 		return 0;
 
@@ -629,7 +649,6 @@ double t1_encode_cblk(t1_info *t1, cblk_enc *cblk, uint32_t max,
 	int32_t bpno;
 	uint32_t passtype;
 	int32_t nmsedec = 0;
-	int32_t *p_nmsdedec = doRateControl ? &nmsedec : nullptr;
 	double tempwmsedec;
 
 	mqc->lut_ctxno_zc_orient = lut_ctxno_zc + (orient << 9);
@@ -669,19 +688,19 @@ double t1_encode_cblk(t1_info *t1, cblk_enc *cblk, uint32_t max,
 
 		switch (passtype) {
 		case 0:
-			t1_enc_sigpass(t1, bpno, p_nmsdedec, type, cblksty);
+			t1_enc_sigpass<doDistortion>(t1, bpno, &nmsedec, type, cblksty);
 			break;
 		case 1:
-			t1_enc_refpass(t1, bpno, p_nmsdedec, type);
+			t1_enc_refpass<doDistortion>(t1, bpno, &nmsedec, type);
 			break;
 		case 2:
-			t1_enc_clnpass(t1, bpno,p_nmsdedec, cblksty);
+			t1_enc_clnpass<doDistortion>(t1, bpno, &nmsedec, cblksty);
 			if (cblksty & GRK_CBLKSTY_SEGSYM)
 				mqc_segmark_enc(mqc);
 			break;
 		}
 
-		if (doRateControl) {
+		if (doDistortion) {
 			tempwmsedec = t1_getwmsedec(nmsedec, compno, level, orient, bpno,
 					qmfbid, stepsize, mct_norms, mct_numcomps);
 			cumwmsedec += tempwmsedec;
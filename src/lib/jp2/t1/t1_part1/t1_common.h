@@ -35,6 +35,8 @@
 // decode
 /**< Space for a fake FFFF marker */
 const uint8_t grk_cblk_dec_compressed_data_pad_right = 2;
+/**< HT block decoder reads whole words, on both sides of the coded data */
+const uint8_t grk_cblk_dec_compressed_data_pad_ht = 8;
 
 // encode
 const uint8_t grk_cblk_enc_compressed_data_pad_left = 2;
@@ -0,0 +1,106 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "grok_includes.h"
+
+namespace grk {
+
+PacketBuffer::PacketBuffer() : body_len(0) {
+}
+
+void PacketBuffer::clear(void){
+	header.clear();
+	segments.clear();
+	body_len = 0;
+}
+
+void PacketBuffer::push_segment(const uint8_t *data, size_t len){
+	if (!len)
+		return;
+	segments.push_back({data, len});
+	body_len += len;
+}
+
+uint64_t PacketBuffer::length(void){
+	return header.size() + body_len;
+}
+
+void PacketBuffer::append_to(std::vector<grk_stream_vec> &vec){
+	if (!header.empty())
+		vec.push_back({header.data(), header.size()});
+	vec.insert(vec.end(), segments.begin(), segments.end());
+}
+
+bool PacketBuffer::write_byte(uint8_t value){
+	header.push_back(value);
+	return true;
+}
+
+bool PacketBuffer::write_short(uint16_t value){
+	uint8_t temp[2];
+	grk_write<uint16_t>(temp, value);
+
+	return write_bytes(temp, 2) == 2;
+}
+
+bool PacketBuffer::write_24(uint32_t value){
+	uint8_t temp[3];
+	grk_write<uint32_t>(temp, value, 3);
+
+	return write_bytes(temp, 3) == 3;
+}
+
+bool PacketBuffer::write_int(uint32_t value){
+	uint8_t temp[4];
+	grk_write<uint32_t>(temp, value);
+
+	return write_bytes(temp, 4) == 4;
+}
+
+size_t PacketBuffer::write_bytes(const uint8_t *p_buffer, size_t p_size){
+	header.insert(header.end(), p_buffer, p_buffer + p_size);
+
+	return p_size;
+}
+
+bool PacketBuffer::flush(){
+	return true;
+}
+
+bool PacketBuffer::skip(int64_t p_size){
+	(void)p_size;
+	return false;
+}
+
+uint64_t PacketBuffer::tell(void){
+	return header.size();
+}
+
+uint64_t PacketBuffer::get_number_byte_left(void){
+	return header.max_size() - header.size();
+}
+
+bool PacketBuffer::seek(uint64_t offset){
+	(void)offset;
+	return false;
+}
+
+bool PacketBuffer::has_seek(){
+	return false;
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <vector>
+
+namespace grk {
+
+/**
+ Encoded packet held in memory.
+
+ Marker and header bytes are stored in an internal scratch buffer,
+ while packet body segments reference code block compressed data,
+ so that the packet can be passed to a vectored write without
+ copying the body.
+ */
+struct PacketBuffer: public IBufferedStream {
+
+	PacketBuffer();
+
+	/**
+	 Discard header bytes and body segments, keeping allocated storage
+	 */
+	void clear(void);
+
+	/**
+	 Append a body segment. Data is referenced, not copied.
+	 */
+	void push_segment(const uint8_t *data, size_t len);
+
+	/**
+	 Total length of packet (header plus body)
+	 */
+	uint64_t length(void);
+
+	/**
+	 Append header bytes followed by body segments to list of segments,
+	 for vectored write
+	 */
+	void append_to(std::vector<grk_stream_vec> &vec);
+
+	// IBufferedStream interface: writes are appended to header
+	bool write_byte(uint8_t value);
+	bool write_short(uint16_t value);
+	bool write_24(uint32_t value);
+	bool write_int(uint32_t value);
+	size_t write_bytes(const uint8_t *p_buffer, size_t p_size);
+	bool flush();
+	bool skip(int64_t p_size);
+	uint64_t tell(void);
+	uint64_t get_number_byte_left(void);
+	bool seek(uint64_t offset);
+	bool has_seek();
+
+	std::vector<uint8_t> header;
+	std::vector<grk_stream_vec> segments;
+private:
+	uint64_t body_len;
+};
+
+}
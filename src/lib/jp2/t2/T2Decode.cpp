@@ -505,6 +505,10 @@ bool T2Decode::read_packet_header(TileCodingParams *p_tcp, PacketIter *p_pi,
 
 bool T2Decode::read_packet_data(grk_resolution *res, PacketIter *p_pi,
 		ChunkBuffer *src_buf, uint64_t *p_data_read) {
+	auto tilec = tileProcessor->tile->comps + p_pi->compno;
+	// plugins consume the segments of every code block
+	bool filter_blocks = !tilec->whole_tile_decoding
+			&& !tileProcessor->current_plugin_tile;
 	for (uint32_t bandno = 0; bandno < res->numbands; ++bandno) {
 		auto band = res->bands + bandno;
 		auto prc = &band->precincts[p_pi->precno];
@@ -515,6 +519,13 @@ bool T2Decode::read_packet_data(grk_resolution *res, PacketIter *p_pi,
 				++cblk;
 				continue;
 			}
+			/* segment state is always tracked, since subsequent packet headers */
+			/* depend on it, but only code blocks that influence the window of */
+			/* interest keep references to their segment data */
+			bool keep_data = !filter_blocks
+					|| tilec->is_subband_area_of_interest(p_pi->resno,
+							band->bandno, cblk->x0, cblk->y0, cblk->x1,
+							cblk->y1);
 			grk_seg *seg = nullptr;
 			if (!cblk->numSegments) {
 				seg = cblk->segs;
@@ -547,8 +558,16 @@ bool T2Decode::read_packet_data(grk_resolution *res, PacketIter *p_pi,
 
 				// only add segment to seg_buffers if length is greater than zero
 				if (seg->numBytesInPacket) {
-					cblk->seg_buffers.push_back(new grk_buf(src_buf->get_global_ptr(),
-							seg->numBytesInPacket, false));
+					if (keep_data) {
+						cblk->seg_buffer_padded = cblk->seg_buffers.empty()
+								&& src_buf->get_cur_chunk_offset()
+										>= grk_cblk_dec_compressed_data_pad_ht
+								&& src_buf->get_cur_chunk_len()
+										>= seg->numBytesInPacket
+												+ grk_cblk_dec_compressed_data_pad_ht;
+						cblk->seg_buffers.push_back(new grk_buf(src_buf->get_global_ptr(),
+								seg->numBytesInPacket, false));
+					}
 					*(p_data_read) += seg->numBytesInPacket;
 					src_buf->incr_cur_chunk_offset(seg->numBytesInPacket);
 					cblk->compressedDataSize += seg->numBytesInPacket;
@@ -22,6 +22,9 @@
 #include "grok_includes.h"
 #include "testing.h"
 #include <memory>
+#include <map>
+#include <tuple>
+#include <atomic>
 
 //#define DEBUG_ENCODE_PACKETS
 
@@ -55,21 +58,92 @@ bool T2Encode::encode_packets(uint16_t tile_no, uint32_t max_layers,
 		GROK_ERROR("encode_packets: Unknown progression order");
 		return false;
 	}
+	// 1. gather packets in progression order
+	std::vector<EncodePacket*> packets;
+	auto tracker = &tileProcessor->m_packetTracker;
 	while (pi_next(current_pi)) {
 		if (current_pi->layno < max_layers) {
-			uint32_t nb_bytes = 0;
-			if (!encode_packet(tcp, current_pi, stream, &nb_bytes)) {
-				pi_destroy(pi, nb_pocs);
-				return false;
+			if (!tracker->is_packet_encoded(current_pi->compno, current_pi->resno,
+					current_pi->precno, current_pi->layno)) {
+				tracker->packet_encoded(current_pi->compno, current_pi->resno,
+						current_pi->precno, current_pi->layno);
+				auto packet = new EncodePacket();
+				packet->compno = current_pi->compno;
+				packet->resno = current_pi->resno;
+				packet->precno = current_pi->precno;
+				packet->layno = current_pi->layno;
+				packet->packno = p_tile->packno;
+				packets.push_back(packet);
 			}
-			*p_data_written += nb_bytes;
 			/* << INDEX */
 			++p_tile->packno;
 		}
 	}
 	pi_destroy(pi, nb_pocs);
 
-	return true;
+	// 2. encode packets
+	bool rc = true;
+	if (ThreadPool::get()->num_threads() > 1 && packets.size() > 1) {
+		rc = encode_packets_concurrent(tcp, packets);
+	} else {
+		for (auto packet : packets) {
+			rc = encode_packet(tcp, packet);
+			if (!rc)
+				break;
+		}
+	}
+
+	// 3. gather packets in progression order, and write them to stream
+	if (rc) {
+		std::vector<grk_stream_vec> segments;
+		for (auto packet : packets) {
+			packet->buffer.append_to(segments);
+			*p_data_written += (uint32_t)packet->buffer.length();
+		}
+		rc = stream->write_vectored(segments.data(), segments.size());
+	}
+	for (auto packet : packets)
+		delete packet;
+
+	return rc;
+}
+
+bool T2Encode::encode_packets_concurrent(TileCodingParams *tcp,
+		std::vector<EncodePacket*> &packets){
+	std::map<std::tuple<uint32_t, uint32_t, uint64_t>,
+				std::vector<EncodePacket*> > precinctPackets;
+	for (auto packet : packets)
+		precinctPackets[std::make_tuple(packet->compno, packet->resno,
+				packet->precno)].push_back(packet);
+	std::vector<std::vector<EncodePacket*>*> precincts;
+	for (auto &prc : precinctPackets)
+		precincts.push_back(&prc.second);
+
+	std::atomic<size_t> nextPrecinct(0);
+	std::atomic<bool> success(true);
+	size_t num_threads = std::min<size_t>(ThreadPool::get()->num_threads(),
+			precincts.size());
+	std::vector<std::future<int> > results;
+	for (size_t i = 0; i < num_threads; ++i) {
+		results.emplace_back(
+			ThreadPool::get()->enqueue([this, tcp, &precincts, &nextPrecinct, &success] {
+				size_t index;
+				while (success && (index = nextPrecinct++) < precincts.size()) {
+					for (auto packet : *precincts[index]) {
+						if (!encode_packet(tcp, packet)) {
+							success = false;
+							break;
+						}
+					}
+				}
+				return 0;
+			})
+		);
+	}
+	for (auto &result : results)
+		result.get();
+
+	return success;
 }
 
 bool T2Encode::encode_packets_simulate(uint16_t tile_no, uint32_t max_layers,
@@ -137,22 +211,15 @@ bool T2Encode::encode_packets_simulate(uint16_t tile_no, uint32_t max_layers,
 }
 
 //--------------------------------------------------------------------------------------------------
-bool T2Encode::encode_packet(TileCodingParams *tcp, PacketIter *pi,
-		BufferedStream *stream, uint32_t *packet_bytes_written) {
-	assert(stream);
-	uint32_t compno = pi->compno;
-	uint32_t resno = pi->resno;
-	uint64_t precno = pi->precno;
-	uint32_t layno = pi->layno;
+bool T2Encode::encode_packet(TileCodingParams *tcp, EncodePacket *packet) {
+	uint32_t compno = packet->compno;
+	uint32_t resno = packet->resno;
+	uint64_t precno = packet->precno;
+	uint32_t layno = packet->layno;
 	auto tile = tileProcessor->tile;
 	auto tilec = &tile->comps[compno];
 	auto res = &tilec->resolutions[resno];
-	size_t stream_start = stream->tell();
-
-	if (tileProcessor->m_packetTracker.is_packet_encoded(compno, resno, precno,
-			layno))
-		return true;
-	tileProcessor->m_packetTracker.packet_encoded(compno, resno, precno, layno);
+	auto stream = &packet->buffer;
 
 #ifdef DEBUG_ENCODE_PACKETS
     GROK_INFO("encode packet compono=%u, resno=%u, precno=%u, layno=%u",
@@ -170,7 +237,7 @@ bool T2Encode::encode_packet(TileCodingParams *tcp, PacketIter *pi,
 		if (!stream->write_byte(4))
 			return false;
 		/* packno is uint32_t modulo 65536, in big endian format */
-		uint16_t packno = (uint16_t) (tile->packno % 0x10000);
+		uint16_t packno = (uint16_t) (packet->packno % 0x10000);
 		if (!stream->write_byte((uint8_t) (packno >> 8)))
 			return false;
 		if (!stream->write_byte((uint8_t) (packno & 0xff)))
@@ -275,6 +342,19 @@ bool T2Encode::encode_packet(TileCodingParams *tcp, PacketIter *pi,
 				if (!rc)
 					return false;
 			}
+			/* HT: the selected cleanup pass candidate is sent as a single pass */
+			if (tcp->isHT) {
+				bio->putnumpasses(1);
+				increment = (uint32_t) std::max<int32_t>(0,
+						floorlog2<int32_t>((int32_t) layer->len) + 1
+								- (int32_t) cblk->numlenbits);
+				bio->putcommacode((int32_t) increment);
+				cblk->numlenbits += increment;
+				if (!bio->write(layer->len, cblk->numlenbits))
+					return false;
+				++cblk;
+				continue;
+			}
 			/* number of coding passes included */
 			bio->putnumpasses(layer->numpasses);
 			uint32_t nb_passes = cblk->numPassesInPacket
@@ -358,15 +438,11 @@ bool T2Encode::encode_packet(TileCodingParams *tcp, PacketIter *pi,
 				continue;
 			}
 
-			if (cblk_layer->len) {
-				if (!stream->write_bytes(cblk_layer->data, cblk_layer->len))
-					return false;
-			}
+			stream->push_segment(cblk_layer->data, cblk_layer->len);
 			cblk->numPassesInPacket += cblk_layer->numpasses;
 			++cblk;
 		}
 	}
-	*packet_bytes_written += (uint32_t)(stream->tell() - stream_start);
 
 #ifdef DEBUG_LOSSLESS_T2
 		auto originalDataBytes = *packet_bytes_written - numHeaderBytes;
@@ -655,6 +731,18 @@ bool T2Encode::encode_packet_simulate(TileCodingParams *tcp, PacketIter *pi,
 					return false;
 			}
 
+			/* HT: the selected cleanup pass candidate is sent as a single pass */
+			if (tcp->isHT) {
+				bio->putnumpasses(1);
+				increment = (uint32_t) std::max<int32_t>(0,
+						floorlog2<int32_t>((int32_t) layer->len) + 1
+								- (int32_t) cblk->numlenbits);
+				bio->putcommacode((int32_t) increment);
+				cblk->numlenbits += increment;
+				if (!bio->write(layer->len, cblk->numlenbits))
+					return false;
+				continue;
+			}
 			/* number of coding passes included */
 			bio->putnumpasses(layer->numpasses);
 			nb_passes = cblk->numPassesInPacket
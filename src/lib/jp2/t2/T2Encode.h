@@ -73,16 +73,36 @@ private:
 	TileProcessor *tileProcessor;
 
 	/**
-	 Encode a packet of a tile to a destination buffer
+	 Packet scheduled for encoding
+	 */
+	struct EncodePacket {
+		uint32_t compno;
+		uint32_t resno;
+		uint64_t precno;
+		uint32_t layno;
+		/** packet number, written to SOP marker */
+		uint64_t packno;
+		PacketBuffer buffer;
+	};
+
+	/**
+	 Encode packets concurrently. Packets belonging to the same precinct
+	 share tag trees and code block state, so each precinct is encoded
+	 in layer order by a single thread.
 	 @param tcp 			Tile coding parameters
-	 @param pi 				packet iterator
-	 @param stream 			stream
-	 @param p_data_written  amount of data written
-	 @param cstr_info Codestream information structure
-	 @return
+	 @param packets 		packets, in progression order
+	 @return true if successful
+	 */
+	bool encode_packets_concurrent(TileCodingParams *tcp,
+			std::vector<EncodePacket*> &packets);
+
+	/**
+	 Encode a packet of a tile to the packet's buffer
+	 @param tcp 			Tile coding parameters
+	 @param packet 			packet to encode
+	 @return true if successful
 	 */
-	bool encode_packet(TileCodingParams *tcp, PacketIter *pi,
-			BufferedStream *stream, uint32_t *p_data_written);
+	bool encode_packet(TileCodingParams *tcp, EncodePacket *packet);
 
 	/**
 	 Encode a packet of a tile to a destination buffer
@@ -77,8 +77,11 @@ template <typename T, typename S> struct decode_job{
 
 /** Number of columns that we can process in parallel in the vertical pass */
 #define PLL_COLS_53     (2*VREG_INT_COUNT)
+/** Number of columns processed together in the partial (windowed) vertical 5/3 pass */
+#define PLL_COLS_PARTIAL_53     VREG_INT_COUNT
 template <typename T> struct dwt_data {
 	dwt_data() : mem(nullptr),
+				 pool(nullptr),
 		         dn(0),
 				 sn(0),
 				 cas(0),
@@ -89,6 +92,7 @@ template <typename T> struct dwt_data {
 	{}
 
 	dwt_data(const dwt_data& rhs) : mem(nullptr),
+									pool(rhs.pool),
 									dn ( rhs.dn),
 									sn ( rhs.sn),
 									cas ( rhs.cas),
@@ -114,14 +118,22 @@ template <typename T> struct dwt_data {
 	        GROK_ERROR("data size overflow");
 	        return false;
 	    }
-		mem = (T*)grk_aligned_malloc(len * sizeof(T));
+		if (pool)
+			mem = (T*)pool->acquire_scratch(len * sizeof(T));
+		else
+			mem = (T*)grk_aligned_malloc(len * sizeof(T));
 		return mem != nullptr;
 	}
 	void release(){
-		grk_aligned_free(mem);
+		if (pool)
+			pool->release_scratch(mem);
+		else
+			grk_aligned_free(mem);
 		mem = nullptr;
 	}
     T* mem;
+    /* scratch buffers are taken from, and returned to, this pool (may be null) */
+    CoderPool *pool;
     uint32_t dn;   /* number of elements in high pass band */
     uint32_t sn;   /* number of elements in low pass band */
     int32_t cas;  /* 0 = start on even coord, 1 = start on odd coord */
@@ -406,17 +418,6 @@ static void decode_v_cas1_mcols_SSE2_OR_AVX2_53(int32_t* buf,
     decode_v_final_memcpy_53(buf, total_height, dest, strideDest);
 }
 
-#undef VREG
-#undef LOAD_CST
-#undef LOADU
-#undef LOAD
-#undef STORE
-#undef STOREU
-#undef ADD
-#undef ADD3
-#undef SUB
-#undef SAR
-
 #endif /* (defined(__SSE2__) || defined(__AVX2__)) */
 
 /** Vertical inverse 5x3 wavelet transform for one column, when top-most
@@ -793,7 +794,7 @@ static bool decode_v_mt_53(uint32_t num_threads,
 /* <summary>                            */
 /* Inverse wavelet transform in 2-D.    */
 /* </summary>                           */
-static bool decode_tile_53( TileComponent* tilec, uint32_t numres){
+static bool decode_tile_53( TileComponent* tilec, uint32_t numres, CoderPool *pool){
     if (numres == 1U)
         return true;
 
@@ -813,6 +814,8 @@ static bool decode_tile_53( TileComponent* tilec, uint32_t numres){
     /* we process PLL_COLS_53 columns at a time */
     dwt_data<int32_t> horiz;
     dwt_data<int32_t> vert;
+    horiz.pool = pool;
+    vert.pool = pool;
     data_size *= PLL_COLS_53 * sizeof(int32_t);
     bool rc = true;
     uint32_t res = 1;
@@ -1349,7 +1352,7 @@ static bool decode_v_mt_97(uint32_t num_threads,
 /* Inverse 9-7 wavelet transform in 2-D. */
 /* </summary>                            */
 static
-bool decode_tile_97(TileComponent* GRK_RESTRICT tilec,uint32_t numres){
+bool decode_tile_97(TileComponent* GRK_RESTRICT tilec,uint32_t numres, CoderPool *pool){
     if (numres == 1U)
         return true;
 
@@ -1360,6 +1363,8 @@ bool decode_tile_97(TileComponent* GRK_RESTRICT tilec,uint32_t numres){
     size_t data_size = dwt_utils::max_resolution(tr, numres);
     dwt_data<vec4f> horiz;
     dwt_data<vec4f> vert;
+    horiz.pool = pool;
+    vert.pool = pool;
     if (!horiz.alloc(data_size)) {
         GROK_ERROR("Out of memory");
         return false;
@@ -1464,8 +1469,8 @@ static void interleave_partial_v_53(dwt_data<int32_t> *vert,
 	uint32_t win_l_y1 = vert->win_l_x1;
     bool ret = sa->read(sa_col, win_l_y0,
 					   sa_col + nb_cols, win_l_y1,
-					   dest + cas * 4 + 2 * 4 * win_l_y0,
-					   1, 2 * 4, true);
+					   dest + cas * PLL_COLS_PARTIAL_53 + 2 * PLL_COLS_PARTIAL_53 * win_l_y0,
+					   1, 2 * PLL_COLS_PARTIAL_53, true);
     assert(ret);
 
 	uint32_t sn = vert->sn;
@@ -1473,8 +1478,8 @@ static void interleave_partial_v_53(dwt_data<int32_t> *vert,
 	uint32_t win_h_y1 = vert->win_h_x1;
 	ret = sa->read( sa_col, sn + win_h_y0,
 					  sa_col + nb_cols, sn + win_h_y1,
-					  dest + (1 - cas) * 4 + 2 * 4 * win_h_y0,
-					  1, 2 * 4, true);
+					  dest + (1 - cas) * PLL_COLS_PARTIAL_53 + 2 * PLL_COLS_PARTIAL_53 * win_h_y0,
+					  1, 2 * PLL_COLS_PARTIAL_53, true);
     assert(ret);
     GRK_UNUSED(ret);
 }
@@ -1558,8 +1563,8 @@ static void decode_partial_h_53(dwt_data<int32_t> *horiz){
     }
 }
 
-#define GRK_S_off(i,off) a[(uint32_t)(i)*2*4+off]
-#define GRK_D_off(i,off) a[(1+(uint32_t)(i)*2)*4+off]
+#define GRK_S_off(i,off) a[(uint32_t)(i)*2*PLL_COLS_PARTIAL_53+off]
+#define GRK_D_off(i,off) a[(1+(uint32_t)(i)*2)*PLL_COLS_PARTIAL_53+off]
 #define GRK_S__off(i,off) ((i)<0?GRK_S_off(0,off):((i)>=sn?GRK_S_off(sn-1,off):GRK_S_off(i,off)))
 #define GRK_D__off(i,off) ((i)<0?GRK_D_off(0,off):((i)>=dn?GRK_D_off(dn-1,off):GRK_D_off(i,off)))
 #define GRK_SS__off(i,off) ((i)<0?GRK_S_off(0,off):((i)>=dn?GRK_S_off(dn-1,off):GRK_S_off(i,off)))
@@ -1594,41 +1599,39 @@ static void decode_partial_v_53(dwt_data<int32_t> *vert){
                 int32_t i_max;
 
                 /* Left-most case */
-                for (off = 0; off < 4; off++)
+                for (off = 0; off < PLL_COLS_PARTIAL_53; off++)
                     GRK_S_off(i, off) -= (GRK_D__off(i - 1, off) + GRK_D__off(i, off) + 2) >> 2;
                 i ++;
 
                 i_max = win_l_x1;
                 if (i_max > dn)
                     i_max = dn;
-#ifdef __SSE2__
+#if (defined(__SSE2__) || defined(__AVX2__))
                 if (i + 1 < i_max) {
-                    const __m128i two = _mm_set1_epi32(2);
-                    __m128i Dm1 = _mm_load_si128((__m128i *)(a + 4 + (i - 1) * 8));
+                    const VREG two = LOAD_CST(2);
+                    VREG Dm1 = LOAD(&GRK_D_off(i - 1, 0));
                     for (; i + 1 < i_max; i += 2) {
                         /* No bound checking */
-                        __m128i S = _mm_load_si128((__m128i *)(a + i * 8));
-                        __m128i D = _mm_load_si128((__m128i *)(a + 4 + i * 8));
-                        __m128i S1 = _mm_load_si128((__m128i *)(a + (i + 1) * 8));
-                        __m128i D1 = _mm_load_si128((__m128i *)(a + 4 + (i + 1) * 8));
-                        S = _mm_sub_epi32(S,
-                                          _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(Dm1, D), two), 2));
-                        S1 = _mm_sub_epi32(S1,
-                                           _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(D, D1), two), 2));
-                        _mm_store_si128((__m128i*)(a + i * 8), S);
-                        _mm_store_si128((__m128i*)(a + (i + 1) * 8), S1);
+                        VREG S = LOAD(&GRK_S_off(i, 0));
+                        VREG D = LOAD(&GRK_D_off(i, 0));
+                        VREG S1 = LOAD(&GRK_S_off(i + 1, 0));
+                        VREG D1 = LOAD(&GRK_D_off(i + 1, 0));
+                        S = SUB(S, SAR(ADD3(Dm1, D, two), 2));
+                        S1 = SUB(S1, SAR(ADD3(D, D1, two), 2));
+                        STORE(&GRK_S_off(i, 0), S);
+                        STORE(&GRK_S_off(i + 1, 0), S1);
                         Dm1 = D1;
                     }
                 }
 #endif
                 for (; i < i_max; i++) {
                     /* No bound checking */
-                    for (off = 0; off < 4; off++)
+                    for (off = 0; off < PLL_COLS_PARTIAL_53; off++)
                         GRK_S_off(i, off) -= (GRK_D_off(i - 1, off) + GRK_D_off(i, off) + 2) >> 2;
                 }
                 for (; i < win_l_x1; i++) {
                     /* Right-most case */
-                    for (off = 0; off < 4; off++)
+                    for (off = 0; off < PLL_COLS_PARTIAL_53; off++)
                         GRK_S_off(i, off) -= (GRK_D__off(i - 1, off) + GRK_D__off(i, off) + 2) >> 2;
                 }
             }
@@ -1637,47 +1640,47 @@ static void decode_partial_v_53(dwt_data<int32_t> *vert){
                 int32_t i_max = win_h_x1;
                 if (i_max >= sn)
                     i_max = sn - 1;
-#ifdef __SSE2__
+#if (defined(__SSE2__) || defined(__AVX2__))
                 if (i + 1 < i_max) {
-                    __m128i S =  _mm_load_si128((__m128i *)(a + i * 8));
+                    VREG S = LOAD(&GRK_S_off(i, 0));
                     for (; i + 1 < i_max; i += 2) {
                         /* No bound checking */
-                        __m128i D = _mm_load_si128((__m128i *)(a + 4 + i * 8));
-                        __m128i S1 = _mm_load_si128((__m128i *)(a + (i + 1) * 8));
-                        __m128i D1 = _mm_load_si128((__m128i *)(a + 4 + (i + 1) * 8));
-                        __m128i S2 = _mm_load_si128((__m128i *)(a + (i + 2) * 8));
-                        D = _mm_add_epi32(D, _mm_srai_epi32(_mm_add_epi32(S, S1), 1));
-                        D1 = _mm_add_epi32(D1, _mm_srai_epi32(_mm_add_epi32(S1, S2), 1));
-                        _mm_store_si128((__m128i*)(a + 4 + i * 8), D);
-                        _mm_store_si128((__m128i*)(a + 4 + (i + 1) * 8), D1);
+                        VREG D = LOAD(&GRK_D_off(i, 0));
+                        VREG S1 = LOAD(&GRK_S_off(i + 1, 0));
+                        VREG D1 = LOAD(&GRK_D_off(i + 1, 0));
+                        VREG S2 = LOAD(&GRK_S_off(i + 2, 0));
+                        D = ADD(D, SAR(ADD(S, S1), 1));
+                        D1 = ADD(D1, SAR(ADD(S1, S2), 1));
+                        STORE(&GRK_D_off(i, 0), D);
+                        STORE(&GRK_D_off(i + 1, 0), D1);
                         S = S2;
                     }
                 }
 #endif
                 for (; i < i_max; i++) {
                     /* No bound checking */
-                    for (off = 0; off < 4; off++)
+                    for (off = 0; off < PLL_COLS_PARTIAL_53; off++)
                         GRK_D_off(i, off) += (GRK_S_off(i, off) + GRK_S_off(i + 1, off)) >> 1;
                 }
                 for (; i < win_h_x1; i++) {
                     /* Right-most case */
-                    for (off = 0; off < 4; off++)
+                    for (off = 0; off < PLL_COLS_PARTIAL_53; off++)
                         GRK_D_off(i, off) += (GRK_S__off(i, off) + GRK_S__off(i + 1, off)) >> 1;
                 }
             }
         }
     } else {
         if (!sn  && dn == 1) {        /* NEW :  CASE ONE ELEMENT */
-            for (off = 0; off < 4; off++)
+            for (off = 0; off < PLL_COLS_PARTIAL_53; off++)
                 GRK_S_off(0, off) /= 2;
         } else {
             for (i = win_l_x0; i < win_l_x1; i++) {
-                for (off = 0; off < 4; off++)
+                for (off = 0; off < PLL_COLS_PARTIAL_53; off++)
                     GRK_D_off(i, off) -=
                     		(GRK_SS__off(i, off) + GRK_SS__off(i + 1, off) + 2) >> 2;
             }
             for (i = win_h_x0; i < win_h_x1; i++) {
-                for (off = 0; off < 4; off++)
+                for (off = 0; off < PLL_COLS_PARTIAL_53; off++)
                     GRK_S_off(i, off) +=
                     		(GRK_DD__off(i, off) + GRK_DD__off(i - 1, off)) >> 1;
             }
@@ -1685,6 +1688,19 @@ static void decode_partial_v_53(dwt_data<int32_t> *vert){
     }
 }
 
+#if (defined(__SSE2__) || defined(__AVX2__))
+#undef VREG
+#undef LOAD_CST
+#undef LOADU
+#undef LOAD
+#undef STORE
+#undef STOREU
+#undef ADD
+#undef ADD3
+#undef SUB
+#undef SAR
+#endif
+
 static void segment_grow(uint32_t filter_width,
 						 uint32_t max_size,
 						 uint32_t* start,
@@ -1721,25 +1737,24 @@ static void interleave_partial_h_97(dwt_data<vec4f>* dwt,
 									sparse_array* sa,
 									uint32_t sa_line,
 									uint32_t num_rows){
-    for (uint32_t i = 0; i < num_rows; i++) {
-        bool ret = sa->read(dwt->win_l_x0,
-						  sa_line + i,
-						  dwt->win_l_x1,
-						  sa_line + i + 1,
-						  /* Nasty cast from float* to int32* */
-						  (int32_t*)(dwt->mem + dwt->cas + 2 * dwt->win_l_x0) + i,
-						  8, 0, true);
-        assert(ret);
-        ret = sa->read(dwt->sn + dwt->win_h_x0,
-						  sa_line + i,
-						  dwt->sn + dwt->win_h_x1,
-						  sa_line + i + 1,
-						  /* Nasty cast from float* to int32* */
-						  (int32_t*)(dwt->mem + 1 - dwt->cas + 2 * dwt->win_h_x0) + i,
-						  8, 0, true);
-        assert(ret);
-        GRK_UNUSED(ret);
-    }
+	/* read all rows at once: rows are adjacent in each vec4f */
+	bool ret = sa->read(dwt->win_l_x0,
+					  sa_line,
+					  dwt->win_l_x1,
+					  sa_line + num_rows,
+					  /* Nasty cast from float* to int32* */
+					  (int32_t*)(dwt->mem + dwt->cas + 2 * dwt->win_l_x0),
+					  8, 1, true);
+	assert(ret);
+	ret = sa->read(dwt->sn + dwt->win_h_x0,
+					  sa_line,
+					  dwt->sn + dwt->win_h_x1,
+					  sa_line + num_rows,
+					  /* Nasty cast from float* to int32* */
+					  (int32_t*)(dwt->mem + 1 - dwt->cas + 2 * dwt->win_h_x0),
+					  8, 1, true);
+	assert(ret);
+	GRK_UNUSED(ret);
 }
 
 
@@ -1786,17 +1801,21 @@ public:
 };
 
 /* FILTER_WIDTH value matches the maximum left/right extension given in tables */
-/* F.2 and F.3 of the standard. Note: in TileComponent::is_subband_area_of_interest() */
-/* we currently use 3. */
+/* F.2 and F.3 of the standard. It bounds the per-level margins used by */
+/* TileComponent::is_subband_area_of_interest() to select code blocks, so */
+/* that samples read outside of those blocks never reach the window. */
 template <typename T, uint32_t HORIZ_STEP, uint32_t VERT_STEP, uint32_t FILTER_WIDTH, typename D>
-   bool decode_partial_tile(TileComponent* GRK_RESTRICT tilec, uint32_t numres, sparse_array *sa) {
+   bool decode_partial_tile(TileComponent* GRK_RESTRICT tilec, uint32_t numres, sparse_array *sa, CoderPool *pool) {
     auto tr = tilec->resolutions;
     auto tr_max = &(tilec->resolutions[numres - 1]);
     if (tr_max->width() == 0 || tr_max->height() == 0)
         return true;
 
+    grk_rect_u32 win_bounds(tr_max->win_bounds.x0 - tr_max->x0,
+    						tr_max->win_bounds.y0 - tr_max->y0,
+    						tr_max->win_bounds.x1 - tr_max->x0,
+    						tr_max->win_bounds.y1 - tr_max->y0);
     if (numres == 1U) {
-        auto win_bounds = tr_max->win_bounds.pan(-tr_max->x0,-tr_max->y0);
     	bool ret = sa->read(win_bounds,
 					   tilec->buf->ptr(),
                        1,
@@ -1812,18 +1831,21 @@ template <typename T, uint32_t HORIZ_STEP, uint32_t VERT_STEP, uint32_t FILTER_W
     /* height of the resolution level computed */
     uint32_t rh = tr->height();
 
-    // in 53 vertical pass, we process 4 vertical columns at a time
-    const uint32_t data_multiplier = (sizeof(T) == 4) ? 4 : 1;
+    // in 53 vertical pass, we process VERT_STEP vertical columns at a time
+    const uint32_t data_multiplier = (sizeof(T) == 4) ? VERT_STEP : 1;
     size_t data_size = dwt_utils::max_resolution(tr, numres) * data_multiplier;
 	dwt_data<T> horiz;
+	horiz.pool = pool;
     if (!horiz.alloc(data_size)) {
         GROK_ERROR("Out of memory");
         return false;
     }
 	dwt_data<T> vert;
+	vert.pool = pool;
     vert.mem = horiz.mem;
     D decoder;
     size_t num_threads = ThreadPool::get()->num_threads();
+    bool direct_write = false;
 
     for (uint32_t resno = 1; resno < numres; resno ++) {
         horiz.sn = (int32_t)rw;
@@ -1938,7 +1960,8 @@ template <typename T, uint32_t HORIZ_STEP, uint32_t VERT_STEP, uint32_t FILTER_W
 			uint32_t num_cols = bounds[k][1] - bounds[k][0] + 1;
 			if (num_cols < num_jobs)
 				num_jobs = num_cols;
-			uint32_t step_j = num_jobs ? ( num_cols / num_jobs) : 0;
+			// keep strips aligned on multiples of the row step
+			uint32_t step_j = num_jobs ? ( num_cols / num_jobs) / HORIZ_STEP * HORIZ_STEP : 0;
 			if (num_threads == 1 ||step_j < HORIZ_STEP){
 		     uint32_t j;
 			 for (j = bounds[k][0]; j + HORIZ_STEP-1 < bounds[k][1]; j += HORIZ_STEP) {
@@ -2034,24 +2057,50 @@ template <typename T, uint32_t HORIZ_STEP, uint32_t VERT_STEP, uint32_t FILTER_W
         vert.win_h_x0 = win_lh_y0;
         vert.win_h_x1 = win_lh_y1;
 
+        /* At the highest resolution, the vertical pass writes straight into
+         * the tile buffer rather than making a round trip through
+         * the sparse array, provided that it covers the window */
+        if (resno == numres - 1)
+        	direct_write = win_bounds.x0 >= win_tr_x0 && win_bounds.x1 <= win_tr_x1 &&
+        					win_bounds.y0 >= win_tr_y0 && win_bounds.y1 <= win_tr_y1;
+        auto write_v = [&](dwt_data<T> *data, uint32_t x0, uint32_t x1){
+        	auto src = (int32_t*)data->mem;
+        	if (!direct_write)
+        		return sa->write(x0,
+								  win_tr_y0,
+								  x1,
+								  win_tr_y1,
+								  src + VERT_STEP * win_tr_y0,
+								  1,
+								  VERT_STEP,
+								  true);
+        	uint32_t dx0 = max<uint32_t>(x0, win_bounds.x0);
+        	uint32_t dx1 = min<uint32_t>(x1, win_bounds.x1);
+        	if (dx0 >= dx1)
+        		return true;
+        	auto dest = tilec->buf->ptr() + (dx0 - win_bounds.x0);
+        	size_t stride = tilec->buf->stride();
+        	src += (size_t)VERT_STEP * win_bounds.y0 + (dx0 - x0);
+        	for (uint32_t y = win_bounds.y0; y < win_bounds.y1; ++y) {
+        		memcpy(dest, src, (dx1 - dx0) * sizeof(int32_t));
+        		dest += stride;
+        		src += VERT_STEP;
+        	}
+        	return true;
+        };
+
         uint32_t num_jobs = (uint32_t)num_threads;
         uint32_t num_cols = win_tr_x1 - win_tr_x0 + 1;
 		if (num_cols < num_jobs)
 			num_jobs = num_cols;
-		uint32_t step_j = num_jobs ? ( num_cols / num_jobs) : 0;
+		// keep strips aligned on multiples of the column step
+		uint32_t step_j = num_jobs ? ( num_cols / num_jobs) / VERT_STEP * VERT_STEP : 0;
 		if (num_threads == 1 || step_j < VERT_STEP){
 	        uint32_t j;
 			for (j = win_tr_x0; j + VERT_STEP < win_tr_x1; j += VERT_STEP) {
 				decoder.interleave_partial_v(&vert, sa, j, VERT_STEP);
 				decoder.decode_v(&vert);
-				if (!sa->write(j,
-							  win_tr_y0,
-							  j + VERT_STEP,
-							  win_tr_y1,
-							  (int32_t*)vert.mem + VERT_STEP * win_tr_y0,
-							  1,
-							  VERT_STEP,
-							  true)) {
+				if (!write_v(&vert, j, j + VERT_STEP)) {
 					GROK_ERROR("Sparse array write failure");
 					horiz.release();
 					return false;
@@ -2060,14 +2109,7 @@ template <typename T, uint32_t HORIZ_STEP, uint32_t VERT_STEP, uint32_t FILTER_W
 			if (j < win_tr_x1) {
 				decoder.interleave_partial_v(&vert, sa, j, win_tr_x1 - j);
 				decoder.decode_v(&vert);
-				if (!sa->write( j,
-								  win_tr_y0,
-								  win_tr_x1,
-								  win_tr_y1,
-								  (int32_t*)vert.mem + VERT_STEP * win_tr_y0,
-								  1,
-								  VERT_STEP,
-								  true)) {
+				if (!write_v(&vert, j, win_tr_x1)) {
 					GROK_ERROR("Sparse array write failure");
 					horiz.release();
 					return false;
@@ -2085,19 +2127,12 @@ template <typename T, uint32_t HORIZ_STEP, uint32_t VERT_STEP, uint32_t FILTER_W
 					return false;
 				}
 				results.emplace_back(
-					ThreadPool::get()->enqueue([job,sa, win_tr_y0, win_tr_y1, &decoder] {
+					ThreadPool::get()->enqueue([job,sa, &write_v, &decoder] {
 					 uint32_t j;
 					 for (j = job->min_j; j + VERT_STEP-1 < job->max_j; j += VERT_STEP) {
 						decoder.interleave_partial_v(&job->data, sa, j, VERT_STEP);
 						decoder.decode_v(&job->data);
-						if (!sa->write(j,
-									  win_tr_y0,
-									  j + VERT_STEP,
-									  win_tr_y1,
-									  (int32_t*)job->data.mem + VERT_STEP * win_tr_y0,
-									  1,
-									  VERT_STEP,
-									  true)) {
+						if (!write_v(&job->data, j, j + VERT_STEP)) {
 							GROK_ERROR("Sparse array write failure");
 							job->data.release();
 							return 0;
@@ -2106,14 +2141,7 @@ template <typename T, uint32_t HORIZ_STEP, uint32_t VERT_STEP, uint32_t FILTER_W
 					 if (j <  job->max_j) {
 						decoder.interleave_partial_v(&job->data, sa, j,  job->max_j - j);
 						decoder.decode_v(&job->data);
-						if (!sa->write(			  j,
-												  win_tr_y0,
-												  job->max_j,
-												  win_tr_y1,
-												  (int32_t*)job->data.mem + VERT_STEP * win_tr_y0,
-												  1,
-												  VERT_STEP,
-												  true)) {
+						if (!write_v(&job->data, j, job->max_j)) {
 							GROK_ERROR("Sparse array write failure");
 							job->data.release();
 							return 0;
@@ -2131,14 +2159,15 @@ template <typename T, uint32_t HORIZ_STEP, uint32_t VERT_STEP, uint32_t FILTER_W
 		}
     }
     //final read into tile buffer
-    auto win_bounds = tr_max->win_bounds.pan(-tr_max->x0,-tr_max->y0);
-	bool ret = sa->read(win_bounds,
-					   tilec->buf->ptr(),
-					   1,
-					   tilec->buf->stride(),
-					   true);
-assert(ret);
-	GRK_UNUSED(ret);
+    if (!direct_write) {
+		bool ret = sa->read(win_bounds,
+						   tilec->buf->ptr(),
+						   1,
+						   tilec->buf->stride(),
+						   true);
+		assert(ret);
+		GRK_UNUSED(ret);
+    }
     horiz.release();
 
     return true;
@@ -2150,19 +2179,21 @@ assert(ret);
 bool decode_53(TileProcessor *p_tcd, TileComponent* tilec,
                         uint32_t numres)
 {
-    if (p_tcd->whole_tile_decoding)
-        return decode_tile_53(tilec,numres);
+    if (tilec->whole_tile_decoding)
+        return decode_tile_53(tilec,numres, p_tcd->m_coderPool);
     else
-        return decode_partial_tile<int32_t, 1, 4,2, Partial53>(tilec, numres, tilec->m_sa);
+        return decode_partial_tile<int32_t, 1, PLL_COLS_PARTIAL_53, 2, Partial53>(tilec, numres, tilec->m_sa,
+        		p_tcd->m_coderPool);
 }
 
 bool decode_97(TileProcessor *p_tcd,
                 TileComponent* GRK_RESTRICT tilec,
                 uint32_t numres){
-    if (p_tcd->whole_tile_decoding)
-        return decode_tile_97(tilec, numres);
+    if (tilec->whole_tile_decoding)
+        return decode_tile_97(tilec, numres, p_tcd->m_coderPool);
     else
-        return decode_partial_tile<vec4f,4,4,4, Partial97>(tilec, numres, tilec->m_sa);
+        return decode_partial_tile<vec4f,4,4,4, Partial97>(tilec, numres, tilec->m_sa,
+        		p_tcd->m_coderPool);
 }
 
 }
@@ -59,17 +59,55 @@ using namespace std;
 namespace grk {
 
 
+/** Transpose a 4x4 tile of 32 bit samples
+ *
+ * @param src first row of tile
+ * @param src_stride spacing (in elements) between source rows
+ * @param dest first row of transposed tile
+ * @param dest_stride spacing (in elements) between destination rows
+ */
+static inline void transpose_4x4(const int32_t* GRK_RESTRICT src,
+								size_t src_stride,
+								int32_t* GRK_RESTRICT dest,
+								size_t dest_stride){
+#ifdef __SSE2__
+	__m128i r0 = _mm_loadu_si128((const __m128i*)src);
+	__m128i r1 = _mm_loadu_si128((const __m128i*)(src + src_stride));
+	__m128i r2 = _mm_loadu_si128((const __m128i*)(src + 2 * src_stride));
+	__m128i r3 = _mm_loadu_si128((const __m128i*)(src + 3 * src_stride));
+	__m128i t0 = _mm_unpacklo_epi32(r0, r1);
+	__m128i t1 = _mm_unpacklo_epi32(r2, r3);
+	__m128i t2 = _mm_unpackhi_epi32(r0, r1);
+	__m128i t3 = _mm_unpackhi_epi32(r2, r3);
+	_mm_storeu_si128((__m128i*)dest, _mm_unpacklo_epi64(t0, t1));
+	_mm_storeu_si128((__m128i*)(dest + dest_stride), _mm_unpackhi_epi64(t0, t1));
+	_mm_storeu_si128((__m128i*)(dest + 2 * dest_stride), _mm_unpacklo_epi64(t2, t3));
+	_mm_storeu_si128((__m128i*)(dest + 3 * dest_stride), _mm_unpackhi_epi64(t2, t3));
+#else
+	for (uint32_t i = 0; i < 4; ++i) {
+		for (uint32_t j = 0; j < 4; ++j)
+			dest[i * dest_stride + j] = src[j * src_stride + i];
+	}
+#endif
+}
+
 sparse_array::sparse_array(uint32_t width,
 							uint32_t height,
 							uint32_t block_width,
-							uint32_t block_height) :
+							uint32_t block_height,
+							CoderPool *pool) :
 									width(width),
 									height(height),
 									block_width(block_width),
-									block_height(block_height)
+									block_height(block_height),
+									pool(pool),
+									slab_ptr(nullptr),
+									slab_free_blocks(0)
 {
     if (width == 0 || height == 0 || block_width == 0 || block_height == 0)
     	throw std::runtime_error("invalid region for sparse array");
+    if (block_width > UINT_MAX / block_height / sizeof(int32_t))
+    	throw std::runtime_error("invalid block size for sparse array");
     block_count_hor = ceildiv<uint32_t>(width, block_width);
     block_count_ver = ceildiv<uint32_t>(height, block_height);
     data_blocks = (int32_t**) grk_calloc((uint64_t)block_count_hor * block_count_ver,sizeof(int32_t*));
@@ -81,11 +119,54 @@ sparse_array::sparse_array(uint32_t width,
 
 sparse_array::~sparse_array()
 {
-	for (uint64_t i = 0; i < (uint64_t)block_count_hor * block_count_ver; i++)
-		grk_free(data_blocks[i]);
+	for (auto &slab : slabs) {
+		if (pool)
+			pool->release_slab(slab);
+		else
+			grk_aligned_free(slab);
+	}
+	for (auto &block : large_blocks)
+		grk_free(block);
 	grk_free(data_blocks);
 }
 
+int32_t* sparse_array::alloc_block(void){
+	size_t block_len = (size_t)block_width * block_height;
+	size_t block_bytes = block_len * sizeof(int32_t);
+	int32_t *block = nullptr;
+	if (block_bytes > sparse_array_slab_size) {
+		block = (int32_t*) grk_calloc(block_len, sizeof(int32_t));
+		if (block)
+			large_blocks.push_back(block);
+		return block;
+	}
+	if (!slab_free_blocks) {
+		uint32_t blocks_per_slab = (uint32_t)(sparse_array_slab_size / block_bytes);
+		int32_t *slab = nullptr;
+		if (pool) {
+			slab = (int32_t*)pool->acquire_slab();
+		} else {
+			// without a pool, there is no point in allocating more
+			// blocks than the array can hold
+			blocks_per_slab = (uint32_t)min<uint64_t>(blocks_per_slab,
+					(uint64_t)block_count_hor * block_count_ver);
+			slab = (int32_t*)grk_aligned_malloc(blocks_per_slab * block_bytes);
+		}
+		if (!slab)
+			return nullptr;
+		slabs.push_back(slab);
+		slab_ptr = slab;
+		slab_free_blocks = blocks_per_slab;
+	}
+	block = slab_ptr;
+	slab_ptr += block_len;
+	slab_free_blocks--;
+	// slabs are recycled, so blocks must be cleared
+	memset(block, 0, block_bytes);
+
+	return block;
+}
+
 bool sparse_array::is_region_valid(
         uint32_t x0,
         uint32_t y0,
@@ -115,8 +196,7 @@ bool sparse_array::alloc(             uint32_t x0,
             x_incr = min<uint32_t>(x_incr, x1 - x);
             auto src_block = data_blocks[(uint64_t)block_y * block_count_hor + block_x];
 			if (src_block == NULL) {
-				src_block = (int32_t*) grk_calloc((uint64_t)block_width * block_height,
-													 sizeof(int32_t));
+				src_block = alloc_block();
 				if (!src_block) {
 					GROK_ERROR("Out of memory");
 					return false;
@@ -218,6 +298,29 @@ bool sparse_array::read_or_write(uint32_t x0,
                             }
                             for (; k < x_incr; k++)
                                 dest_ptr[k * col_stride] = src_ptr[k];
+                        } else if (line_stride == 1 && col_stride >= 4 && y_incr >= 4) {
+                            /* Interleaved layout of the 9/7 horizontal pass: */
+                            /* rows are adjacent, columns are col_stride apart. */
+                            /* Transpose 4x4 tiles */
+                            uint32_t j = 0;
+                            for (; j < (y_incr & ~3U); j += 4) {
+                                uint32_t k = 0;
+                                for (; k < (x_incr & ~3U); k += 4)
+                                    transpose_4x4(src_ptr + k, block_width,
+                                                  dest_ptr + k * col_stride, col_stride);
+                                for (; k < x_incr; k++) {
+                                    for (uint32_t r = 0; r < 4; r++)
+                                        dest_ptr[k * col_stride + r] = src_ptr[r * block_width + k];
+                                }
+                                dest_ptr += 4;
+                                src_ptr  += 4 * (size_t)block_width;
+                            }
+                            for (; j < y_incr; j++) {
+                                for (uint32_t k = 0; k < x_incr; k++)
+                                    dest_ptr[k * col_stride] = src_ptr[k];
+                                dest_ptr += 1;
+                                src_ptr  += block_width;
+                            }
                         } else if (x_incr >= 8 && col_stride == 8) {
                             for (uint32_t j = 0; j < y_incr; j++) {
                                 uint32_t k;
@@ -278,6 +381,28 @@ bool sparse_array::read_or_write(uint32_t x0,
                             src_ptr  += line_stride;
                             dest_ptr += block_width;
                         }
+                    } else if (line_stride == 1 && col_stride >= 4 && y_incr >= 4) {
+                        /* Interleaved layout of the 9/7 horizontal pass: */
+                        /* transpose 4x4 tiles */
+                        uint32_t j = 0;
+                        for (; j < (y_incr & ~3U); j += 4) {
+                            uint32_t k = 0;
+                            for (; k < (x_incr & ~3U); k += 4)
+                                transpose_4x4(src_ptr + k * col_stride, col_stride,
+                                              dest_ptr + k, block_width);
+                            for (; k < x_incr; k++) {
+                                for (uint32_t r = 0; r < 4; r++)
+                                    dest_ptr[r * block_width + k] = src_ptr[k * col_stride + r];
+                            }
+                            src_ptr  += 4;
+                            dest_ptr += 4 * (size_t)block_width;
+                        }
+                        for (; j < y_incr; j++) {
+                            for (uint32_t k = 0; k < x_incr; k++)
+                                dest_ptr[k] = src_ptr[k * col_stride];
+                            src_ptr  += 1;
+                            dest_ptr += block_width;
+                        }
                     } else if (x_incr >= 8 && col_stride == 8) {
                         for (uint32_t j = 0; j < y_incr; j++) {
                             uint32_t k;
@@ -60,6 +60,10 @@ for blocks of the array that are set. The minimum memory allocation unit is a
 a block. There is a trade-off to pick up an appropriate dimension for blocks.
 If it is too big, and pixels set are far from each other, too much memory will
 be used. If blocks are too small, the book-keeping costs of blocks will rise.
+
+Block storage is carved out of large slabs rather than allocated block by block.
+When a CoderPool is supplied, slabs are taken from, and returned to, the pool,
+so that they are recycled from one tile to the next.
 */
 
 /** @defgroup SPARSE_ARRAY SPARSE ARRAYS - Sparse arrays */
@@ -77,13 +81,15 @@ public:
 	 * @param height total height of the array
 	 * @param block_width width of a block.
 	 * @param block_height height of a block.
+	 * @param pool pool that slabs are acquired from and released to (may be null)
 	 *
 	 * @return a new sparse array instance, or NULL in case of failure.
 	 */
 	sparse_array(uint32_t width,
 					uint32_t height,
 					uint32_t block_width,
-					uint32_t block_height);
+					uint32_t block_height,
+					CoderPool *pool = nullptr);
 
 	/** Frees a sparse array.
 	 *
@@ -187,6 +193,11 @@ private:
 							uint32_t x1,
 							uint32_t y1);
 
+	/** Returns zeroed storage for one block, carved from the current slab
+	 * @return block, or nullptr if out of memory
+	 */
+	int32_t* alloc_block(void);
+
 	bool read_or_write(uint32_t x0,
 						uint32_t y0,
 						uint32_t x1,
@@ -204,6 +215,16 @@ private:
     uint32_t block_count_hor;
     uint32_t block_count_ver;
     int32_t** data_blocks;
+
+    CoderPool *pool;
+    // slabs that blocks are carved from
+    std::vector<int32_t*> slabs;
+    // blocks larger than a slab
+    std::vector<int32_t*> large_blocks;
+    // next free block in current slab
+    int32_t *slab_ptr;
+    // number of free blocks left in current slab
+    uint32_t slab_free_blocks;
 };
 
 }
@@ -32,7 +32,7 @@ BufferedStream::BufferedStream(uint8_t *buffer, size_t buffer_size,
 		bool is_input) :
 		m_user_data(nullptr), m_free_user_data_fn(nullptr), m_user_data_length(
 				0), m_read_fn(nullptr), m_zero_copy_read_fn(nullptr), m_write_fn(
-				nullptr), m_seek_fn(nullptr), m_status(
+				nullptr), m_writev_fn(nullptr), m_seek_fn(nullptr), m_status(
 				is_input ?
 				GROK_STREAM_STATUS_INPUT :
 								GROK_STREAM_STATUS_OUTPUT), m_buf(nullptr), m_buffered_bytes(
@@ -260,6 +260,34 @@ size_t BufferedStream::write_bytes(const uint8_t *p_buffer, size_t p_size) {
 
 	return write_nb_bytes;
 }
+bool BufferedStream::write_vectored(const grk_stream_vec *vec, size_t count) {
+	if (m_status & GROK_STREAM_STATUS_ERROR)
+		return false;
+
+	if (!m_writev_fn || isMemStream()) {
+		for (size_t i = 0; i < count; ++i) {
+			if (vec[i].len && write_bytes(vec[i].buf, vec[i].len) != vec[i].len)
+				return false;
+		}
+		return true;
+	}
+
+	size_t total = 0;
+	for (size_t i = 0; i < count; ++i)
+		total += vec[i].len;
+	if (!total)
+		return true;
+	if (!flush())
+		return false;
+	if (m_writev_fn(vec, count, m_user_data) != total) {
+		m_status |= GROK_STREAM_STATUS_ERROR;
+		GROK_ERROR("Error on writing stream.");
+		return false;
+	}
+	m_stream_offset += total;
+
+	return true;
+}
 void BufferedStream::write_increment(size_t p_size) {
 	m_buf->incr_offset((ptrdiff_t) p_size);
 	if (!isMemStream())
@@ -449,6 +477,14 @@ void GRK_CALLCONV grk_stream_set_write_function(grk_stream *stream,
 
 	streamImpl->m_write_fn = p_function;
 }
+void GRK_CALLCONV grk_stream_set_writev_function(grk_stream *stream,
+		grk_stream_writev_fn p_function) {
+	auto streamImpl = (grk::BufferedStream*) stream;
+	if ((!streamImpl) || (!(streamImpl->m_status & GROK_STREAM_STATUS_OUTPUT)))
+		return;
+
+	streamImpl->m_writev_fn = p_function;
+}
 
 void GRK_CALLCONV grk_stream_set_user_data(grk_stream *stream, void *p_data,
 		grk_stream_free_user_data_fn p_function) {
@@ -74,6 +74,11 @@ struct BufferedStream: public IBufferedStream {
 	 */
 	grk_stream_write_fn m_write_fn;
 
+	/**
+	 * Pointer to actual vectored write function (nullptr at initialization).
+	 */
+	grk_stream_writev_fn m_writev_fn;
+
 	/**
 	 * Pointer to actual seek function (if available).
 	 */
@@ -114,6 +119,18 @@ struct BufferedStream: public IBufferedStream {
 	 */
 	size_t write_bytes(const uint8_t *p_buffer, size_t p_size);
 
+	/**
+	 * Write list of segments to stream (no correction for endian!).
+	 * If a vectored write function is set, buffered bytes are flushed and
+	 * segments are passed directly to it, otherwise they are
+	 * written with write_bytes.
+	 * @param		vec		segments
+	 * @param		count	number of segments
+	 *
+	 * @return		true if all segments were written, otherwise false
+	 */
+	bool write_vectored(const grk_stream_vec *vec, size_t count);
+
 	/**
 	 * Flush stream to disk
 	 
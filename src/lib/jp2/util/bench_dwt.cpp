@@ -194,7 +194,8 @@ int main(int argc, char** argv)
 	if (threadScalingArg.isSet())
 		begin = 1;
 
-	CodeStream codeStream(!forwardArg.isSet());
+	CoderPool pool;
+	CodeStream codeStream(!forwardArg.isSet(), &pool);
 	codeStream.m_input_image = &image;
 
    for (size_t k = begin; k <= end; ++k) {
@@ -0,0 +1,207 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+
+/*
+ * Benchmark of the HT block decoders
+ *
+ * Random code blocks are encoded with the HT block encoder, then decoded
+ * with each of the block decoders supported by the CPU. Decoded blocks
+ * are checked against the output of the scalar decoder.
+ */
+#include "ojph_arch.h"
+#include "ojph_mem.h"
+#include "ojph_block_decoder.h"
+#include "ojph_block_encoder.h"
+#include "grok_includes.h"
+
+#include <chrono>  // for high_resolution_clock
+#include <random>
+#define TCLAP_NAMESTARTSTRING "-"
+#include "tclap/CmdLine.h"
+using namespace TCLAP;
+
+using namespace ojph;
+using namespace ojph::local;
+
+namespace {
+
+const uint32_t pad_left = 8;
+const uint32_t pad_right = 8;
+
+struct coded_block {
+	std::vector<uint8_t> data;
+	int length;
+};
+
+void usage(void) {
+	printf("bench_ht_block [-size value] [-num_blocks val] [-bits val]\n");
+	printf("[-zeros val] [-repeat val]\n");
+}
+
+class GrokOutput: public StdOutput {
+public:
+	virtual void usage(CmdLineInterface &c) {
+		(void) c;
+		::usage();
+	}
+};
+
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t size = 64;
+	uint32_t num_blocks = 256;
+	uint32_t bits = 12;
+	uint32_t zeros = 50;
+	uint32_t repeat = 20;
+
+	CmdLine cmd("bench_ht_block command line", ' ', grk_version());
+
+	// set the output
+	GrokOutput output;
+	cmd.setOutput(&output);
+
+	ValueArg<uint32_t> sizeArg("s", "size",
+			"Width and height of code blocks", false, 0, "unsigned integer", cmd);
+	ValueArg<uint32_t> numBlocksArg("n", "num_blocks",
+			"Number of code blocks", false, 0, "unsigned integer", cmd);
+	ValueArg<uint32_t> bitsArg("b", "bits",
+			"Number of magnitude bit planes", false, 0, "unsigned integer", cmd);
+	ValueArg<uint32_t> zerosArg("z", "zeros",
+			"Percentage of zero samples", false, 0, "unsigned integer", cmd);
+	ValueArg<uint32_t> repeatArg("r", "repeat",
+			"Number of times each block is decoded", false, 0, "unsigned integer", cmd);
+
+	cmd.parse(argc, argv);
+
+	if (sizeArg.isSet())
+		size = sizeArg.getValue();
+	if (numBlocksArg.isSet())
+		num_blocks = numBlocksArg.getValue();
+	if (bitsArg.isSet())
+		bits = bitsArg.getValue();
+	if (zerosArg.isSet())
+		zeros = zerosArg.getValue();
+	if (repeatArg.isSet())
+		repeat = repeatArg.getValue();
+	if (size < 4 || size > 64 || (size & (size - 1))) {
+		fprintf(stderr, "Invalid value for size: should be a power of two "
+				"between 4 and 64\n");
+		return 1;
+	}
+	if (bits == 0 || bits > 20) {
+		fprintf(stderr, "Invalid value for bits: should be between 1 and 20\n");
+		return 1;
+	}
+	if (zeros > 100 || num_blocks == 0 || repeat == 0) {
+		fprintf(stderr, "Invalid arguments\n");
+		return 1;
+	}
+
+	// encode random blocks, with geometrically distributed magnitudes
+	int missing_msbs = (int)bits - 1;
+	int p = 30 - missing_msbs;
+	uint32_t area = size * size;
+	std::mt19937 rng(0);
+	std::vector<si32> samples(area);
+	std::vector<coded_block> blocks(num_blocks);
+	uint64_t coded_bytes = 0;
+	{
+		mem_elastic_allocator elastic(1048576);
+		for (auto &b : blocks) {
+			for (auto &s : samples) {
+				if (rng() % 100 < zeros) {
+					s = 0;
+					continue;
+				}
+				uint32_t mag = (uint32_t)(rng() & ((1U << bits) - 1));
+				mag >>= rng() % bits;
+				s = (si32)(((rng() & 1) ? 0x80000000 : 0) | (mag << p));
+			}
+			int lengths[2] = { 0, 0 };
+			coded_lists *coded = nullptr;
+			ojph_encode_codeblock(samples.data(), missing_msbs, 1,
+					(int)size, (int)size, (int)size, lengths, &elastic, coded);
+			b.length = lengths[0];
+			b.data.assign(pad_left + (size_t)b.length + pad_right, 0);
+			size_t offset = pad_left;
+			for (auto c = coded; c && offset < pad_left + (size_t)b.length;
+					c = c->next_list) {
+				size_t len = std::min<size_t>(
+						(size_t)(c->buf_size - c->avail_size),
+						pad_left + (size_t)b.length - offset);
+				memcpy(b.data.data() + offset, c->buf, len);
+				offset += len;
+			}
+			coded_bytes += (uint64_t)b.length;
+		}
+	}
+
+	struct decoder {
+		const char *name;
+		decode_codeblock_fn fn;
+		bool supported;
+	} decoders[] = {
+		{ "scalar", ojph_decode_codeblock, true },
+		{ "ssse3", ojph_decode_codeblock_ssse3, cpu_ext_level() >= 5 },
+		{ "avx2", ojph_decode_codeblock_avx2, cpu_ext_level() >= 8 },
+	};
+
+	printf("%u blocks of %ux%u, %u bit planes, %u%% zeros, %.2f bits per sample\n",
+			num_blocks, size, size, bits, zeros,
+			(double)coded_bytes * 8 / ((double)area * num_blocks));
+	std::vector<si32> reference((size_t)area * num_blocks);
+	std::vector<si32> decoded(area);
+	int rc = 0;
+	for (auto &d : decoders) {
+		if (!d.supported) {
+			printf("%-8s not supported by CPU\n", d.name);
+			continue;
+		}
+		bool is_reference = d.fn == ojph_decode_codeblock;
+		uint32_t mismatches = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t r = 0; r < repeat; ++r) {
+			for (uint32_t i = 0; i < num_blocks; ++i) {
+				auto &b = blocks[i];
+				d.fn(b.data.data() + pad_left, decoded.data(), missing_msbs, 1,
+						b.length, 0, (int)size, (int)size, (int)size);
+				si32 *ref = reference.data() + (size_t)i * area;
+				if (r == 0) {
+					if (is_reference)
+						memcpy(ref, decoded.data(), area * sizeof(si32));
+					else if (memcmp(ref, decoded.data(), area * sizeof(si32)))
+						mismatches++;
+				}
+			}
+		}
+		std::chrono::duration<double> elapsed =
+				std::chrono::high_resolution_clock::now() - start;
+		double ns_per_sample = elapsed.count() * 1e9
+				/ ((double)area * num_blocks * repeat);
+		printf("%-8s %8.3f ms  %6.3f ns/sample", d.name,
+				elapsed.count() * 1000, ns_per_sample);
+		if (mismatches) {
+			printf("  %u mismatched blocks", mismatches);
+			rc = 1;
+		}
+		printf("\n");
+	}
+
+	return rc;
+}
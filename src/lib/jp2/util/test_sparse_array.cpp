@@ -133,6 +133,8 @@ int main()
         assert(buffer[i] == 0);
     }
 
+    ret = sa->alloc(4, 5, 4 + 1, 5 + 1);
+    assert(ret);
     buffer[0] = 1;
     ret = sa->write(4, 5, 4 + 1, 5 + 1, buffer, 1, 1,
                                        false);
@@ -203,6 +205,8 @@ int main()
 
     buffer[0] = 1;
     buffer[2] = 3;
+    ret = sa->alloc(0, 0, 2, 1);
+    assert(ret);
     ret = sa->write(0, 0, 2, 1, buffer, 2, 4, false);
     assert(ret);
 
@@ -215,5 +219,36 @@ int main()
 
     delete sa;
 
+    /* interleaved layout with adjacent rows, straddling block boundaries */
+    sa = new sparse_array(99, 101, 15, 17);
+    w = 37;
+    h = 11;
+    for (i = 0; i < w; i++) {
+        for (j = 0; j < h; j++)
+            buffer[i * 12 + j] = (int32_t)(j * w + i);
+    }
+    ret = sa->alloc(5, 13, 5 + w, 13 + h);
+    assert(ret);
+    ret = sa->write(5, 13, 5 + w, 13 + h, buffer, 12, 1, false);
+    assert(ret);
+
+    memset(buffer, 0xFF, sizeof(buffer));
+    ret = sa->read(5, 13, 5 + w, 13 + h, buffer, 1, w, false);
+    assert(ret);
+    for (j = 0; j < h; j++) {
+        for (i = 0; i < w; i++)
+            assert(buffer[j * w + i] == (int32_t)(j * w + i));
+    }
+
+    memset(buffer, 0xFF, sizeof(buffer));
+    ret = sa->read(5, 13, 5 + w, 13 + h, buffer, 12, 1, false);
+    assert(ret);
+    for (i = 0; i < w; i++) {
+        for (j = 0; j < h; j++)
+            assert(buffer[i * 12 + j] == (int32_t)(j * w + i));
+    }
+
+    delete sa;
+
     return 0;
 }
@@ -94,6 +94,11 @@ template<typename T> struct grk_rectangle {
     }
 
 
+    bool operator== (const grk_rectangle<T> &rhs) const
+    {
+    	return x0 == rhs.x0 && y0 == rhs.y0 && x1 == rhs.x1 && y1 == rhs.y1;
+    }
+
     grk_rectangle<T>& operator- (const grk_rectangle<T> &rhs)
     {
         x0 -= rhs.x0;
@@ -0,0 +1,246 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Checks the pixel pack/unpack and interleave/deinterleave conversions
+ * against straightforward reference implementations.
+ *
+ * Usage: test_convert [perf]
+ *
+ * With "perf", also reports the throughput of each conversion.
+ */
+#include "grk_apps_config.h"
+#include "grok.h"
+#include "convert.h"
+#include "common.h"
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static std::mt19937 rng(42);
+
+static std::vector<int32_t> random_samples(size_t length, uint32_t prec) {
+	std::uniform_int_distribution<int32_t> dist(0, (int32_t) ((1U << prec) - 1));
+	std::vector<int32_t> samples(length);
+	for (auto &s : samples)
+		s = dist(rng);
+
+	return samples;
+}
+
+/**
+ * Reference packer: most significant bit first, last byte zero padded,
+ * except for 16 bit TIFF samples, which are in machine byte order
+ */
+static std::vector<uint8_t> pack(const std::vector<int32_t> &samples,
+		uint32_t prec, bool nativeEndian16) {
+	std::vector<uint8_t> packed((samples.size() * prec + 7) / 8);
+	if (prec == 16 && nativeEndian16) {
+		for (size_t i = 0; i < samples.size(); ++i) {
+			auto val = (uint16_t) samples[i];
+			memcpy(packed.data() + 2 * i, &val, sizeof(val));
+		}
+		return packed;
+	}
+	size_t bit = 0;
+	for (auto s : samples) {
+		for (int32_t b = (int32_t) prec - 1; b >= 0; --b, ++bit) {
+			if ((s >> b) & 1)
+				packed[bit >> 3] = (uint8_t) (packed[bit >> 3] | (0x80 >> (bit & 7)));
+		}
+	}
+
+	return packed;
+}
+
+static const size_t lengths[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 11, 12, 13, 15, 16,
+		17, 23, 24, 25, 31, 32, 33, 63, 64, 65, 1000, 1021 };
+
+static bool check_to32(cvtTo32 cvt, uint32_t prec, bool nativeEndian16,
+		const char *name) {
+	for (auto length : lengths) {
+		for (int inv = 0; inv < 2; ++inv) {
+			auto samples = random_samples(length, prec);
+			/* exact size, so that over-reads are caught by memory checkers */
+			auto packed = pack(samples, prec, nativeEndian16);
+			std::vector<int32_t> out(length + 1, -1);
+			cvt(packed.data(), out.data(), length, inv != 0);
+			int32_t mask = inv ? (int32_t) ((1U << prec) - 1) : 0;
+			for (size_t i = 0; i < length; ++i) {
+				if (out[i] != (samples[i] ^ mask)) {
+					spdlog::error("{} {} bit: sample {} of {} is {}, expected {}",
+							name, prec, i, length, out[i], samples[i] ^ mask);
+					return false;
+				}
+			}
+			if (out[length] != -1) {
+				spdlog::error("{} {} bit: wrote past {} samples", name, prec,
+						length);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool check_from32(cvtFrom32 cvt, uint32_t prec, bool nativeEndian16,
+		const char *name) {
+	const uint8_t guard = 0xA5;
+	for (auto length : lengths) {
+		auto samples = random_samples(length, prec);
+		auto expected = pack(samples, prec, nativeEndian16);
+		std::vector<uint8_t> out(expected.size() + 16, guard);
+		cvt(samples.data(), out.data(), length);
+		if (!expected.empty()
+				&& memcmp(out.data(), expected.data(), expected.size()) != 0) {
+			spdlog::error("{} {} bit: packing of {} samples differs", name, prec,
+					length);
+			return false;
+		}
+		for (size_t i = expected.size(); i < out.size(); ++i) {
+			if (out[i] != guard) {
+				spdlog::error("{} {} bit: wrote past {} samples", name, prec,
+						length);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool check_interleave(uint32_t numcomps) {
+	for (auto length : lengths) {
+		std::vector<std::vector<int32_t>> planes;
+		std::vector<int32_t*> dest;
+		std::vector<const int32_t*> src;
+		for (uint32_t k = 0; k < numcomps; ++k)
+			planes.push_back(random_samples(length, 16));
+		for (auto &p : planes)
+			src.push_back(p.data());
+		int32_t adjust = (int32_t) (length & 1) * -32768;
+		std::vector<int32_t> interleaved(numcomps * length + 1, -1);
+		cvtPlanarToInterleaved_LUT[numcomps](src.data(), interleaved.data(),
+				length, adjust);
+		for (size_t i = 0; i < length; ++i) {
+			for (uint32_t k = 0; k < numcomps; ++k) {
+				if (interleaved[i * numcomps + k] != planes[k][i] + adjust) {
+					spdlog::error("interleave {} channels: sample {} of channel {} differs",
+							numcomps, i, k);
+					return false;
+				}
+			}
+		}
+		if (interleaved[numcomps * length] != -1) {
+			spdlog::error("interleave {} channels: wrote past {} samples",
+					numcomps, length);
+			return false;
+		}
+
+		std::vector<std::vector<int32_t>> planar(numcomps,
+				std::vector<int32_t>(length + 1, -1));
+		for (auto &p : planar)
+			dest.push_back(p.data());
+		cvtInterleavedToPlanar_LUT[numcomps](interleaved.data(), dest.data(),
+				length);
+		for (uint32_t k = 0; k < numcomps; ++k) {
+			for (size_t i = 0; i < length; ++i) {
+				if (planar[k][i] != planes[k][i] + adjust) {
+					spdlog::error("deinterleave {} channels: sample {} of channel {} differs",
+							numcomps, i, k);
+					return false;
+				}
+			}
+			if (planar[k][length] != -1) {
+				spdlog::error("deinterleave {} channels: wrote past {} samples",
+						numcomps, length);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+template<typename F> static void report(const char *name, uint32_t param,
+		size_t samples, F f) {
+	const uint32_t iterations = 50;
+	f();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < iterations; ++i)
+		f();
+	std::chrono::duration<double> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+	spdlog::info("{} {}: {:.1f} MSamples/s", name, param,
+			(double) samples * iterations / elapsed.count() / 1e6);
+}
+
+static void perf(void) {
+	const size_t length = 1 << 20;
+	std::vector<int32_t> samples32(length * 4);
+	std::vector<uint8_t> packed(length * 2);
+	for (uint32_t prec = 1; prec <= 16; ++prec) {
+		auto samples = random_samples(length, prec);
+		report("pack", prec, length, [&]() {
+			cvtTifFrom32_LUT[prec](samples.data(), packed.data(), length);
+		});
+		report("unpack", prec, length, [&]() {
+			cvtTifTo32_LUT[prec](packed.data(), samples32.data(), length, false);
+		});
+	}
+	std::vector<std::vector<int32_t>> planes(4, random_samples(length, 8));
+	std::vector<const int32_t*> src;
+	std::vector<int32_t*> dest;
+	for (auto &p : planes) {
+		src.push_back(p.data());
+		dest.push_back(p.data());
+	}
+	for (uint32_t numcomps = 1; numcomps <= 4; ++numcomps) {
+		report("interleave", numcomps, length * numcomps, [&]() {
+			cvtPlanarToInterleaved_LUT[numcomps](src.data(), samples32.data(),
+					length, 0);
+		});
+		report("deinterleave", numcomps, length * numcomps, [&]() {
+			cvtInterleavedToPlanar_LUT[numcomps](samples32.data(), dest.data(),
+					length);
+		});
+	}
+}
+
+int main(int argc, char *argv[]) {
+	bool rc = true;
+	for (uint32_t prec = 1; prec <= 16; ++prec) {
+		rc = rc && check_to32(cvtTifTo32_LUT[prec], prec, true, "tif unpack");
+		rc = rc && check_from32(cvtTifFrom32_LUT[prec], prec, true, "tif pack");
+		if (prec <= 8 && cvtTo32_LUT[prec]) {
+			rc = rc && check_to32(cvtTo32_LUT[prec], prec, false, "unpack");
+			rc = rc && check_from32(cvtFrom32_LUT[prec], prec, false, "pack");
+		}
+	}
+	rc = rc && check_to32(convert_16u32s_C1R, 16, false, "unpack");
+	rc = rc && check_from32(convert_32s16u_C1R, 16, false, "pack");
+	for (uint32_t numcomps = 1; numcomps <= 9; ++numcomps)
+		rc = rc && check_interleave(numcomps);
+	if (!rc)
+		return EXIT_FAILURE;
+	if (argc > 1 && !strcmp(argv[1], "perf"))
+		perf();
+
+	return EXIT_SUCCESS;
+}